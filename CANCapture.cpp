@@ -0,0 +1,236 @@
+#include "CANCapture.h"
+
+CANCapture::Channel::Channel(CANSource *source, DWORD ringSize)
+	: Source(source), Ring(ringSize), ReadBatch(CAN_CAPTURE_BATCH), ReadHostTimes(CAN_CAPTURE_BATCH),
+	  Pending(CAN_CAPTURE_BATCH), PendingHostTimes(CAN_CAPTURE_BATCH), PendingIndex(0), PendingCount(0),
+	  Frames(0), Bursts(0), LastError(PCAN_ERROR_OK), LateFrames(0)
+{
+}
+
+CANCapture::CANCapture(TimestampService *clock, UINT64 ReorderWindow, DWORD RingSize)
+	: m_Running(false)
+{
+	m_Clock = clock;
+	m_ReorderWindow = ReorderWindow;
+	m_RingSize = RingSize;
+	m_DataSignaled = false;
+	m_LastMerged = 0;
+}
+
+CANCapture::~CANCapture()
+{
+	Stop();
+}
+
+DWORD CANCapture::AddChannel(CANSource *Source)
+{
+	m_Channels.push_back(std::unique_ptr<Channel>(new Channel(Source, m_RingSize)));
+
+	return (DWORD)m_Channels.size() - 1;
+}
+
+TPCANStatus CANCapture::Start()
+{
+	if (m_Running.load())
+		return PCAN_ERROR_ILLOPERATION;
+	if (m_Channels.empty())
+		return PCAN_ERROR_ILLPARAMVAL;
+
+	m_Running.store(true);
+	m_LastMerged = 0;
+	for (size_t i = 0; i < m_Channels.size(); i++)
+	{
+		Channel *channel = m_Channels[i].get();
+
+		channel->Ring.Clear();
+		channel->Ring.ResetStatistics();
+		channel->Align.Reset();
+		channel->LastError.store(PCAN_ERROR_OK);
+		channel->Reader = std::thread(&CANCapture::ReaderThreadFunc, this, channel);
+	}
+
+	return PCAN_ERROR_OK;
+}
+
+void CANCapture::Stop()
+{
+	if (!m_Running.exchange(false))
+		return;
+
+	for (size_t i = 0; i < m_Channels.size(); i++)
+	{
+		m_Channels[i]->Source->CancelWait();
+		if (m_Channels[i]->Reader.joinable())
+			m_Channels[i]->Reader.join();
+	}
+
+	// Wakes up the consumer so it can flush what is left
+	//
+	{
+		std::lock_guard<std::mutex> lock(m_WaitMutex);
+		m_DataSignaled = true;
+	}
+	m_WaitCondition.notify_all();
+}
+
+void CANCapture::ReaderThreadFunc(Channel *channel)
+{
+	TPCANStatus stsResult;
+	DWORD dwCount;
+
+	while (m_Running.load(std::memory_order_relaxed))
+	{
+		// Sleeps until the source has data or the capture is stopped
+		//
+		stsResult = channel->Source->WaitForMessages(CAN_WAIT_INFINITE);
+		if (stsResult == PCAN_ERROR_QRCVEMPTY)
+			continue;
+		if (stsResult != PCAN_ERROR_OK)
+		{
+			channel->LastError.store(stsResult);
+			break;
+		}
+
+		// Drains the source, exactly as the single channel reader does
+		//
+		do
+		{
+			stsResult = channel->Source->ReadBatch(&channel->ReadBatch[0], (DWORD)channel->ReadBatch.size(), &dwCount);
+			if (dwCount > 0)
+			{
+				channel->Align.AddSample(channel->ReadBatch[dwCount - 1].Timestamp, m_Clock->Now());
+				for (DWORD i = 0; i < dwCount; i++)
+					channel->ReadHostTimes[i] = channel->Align.ToHost(channel->ReadBatch[i].Timestamp);
+
+				channel->Ring.Push(&channel->ReadBatch[0], &channel->ReadHostTimes[0], dwCount);
+				channel->Frames.fetch_add(dwCount, std::memory_order_relaxed);
+				channel->Bursts.fetch_add(1, std::memory_order_relaxed);
+
+				{
+					std::lock_guard<std::mutex> lock(m_WaitMutex);
+					m_DataSignaled = true;
+				}
+				m_WaitCondition.notify_one();
+			}
+		} while (stsResult == PCAN_ERROR_OK && m_Running.load(std::memory_order_relaxed));
+
+		if (stsResult != PCAN_ERROR_OK && !(stsResult & PCAN_ERROR_QRCVEMPTY))
+		{
+			channel->LastError.store(stsResult);
+			break;
+		}
+	}
+}
+
+void CANCapture::WaitForMessages(DWORD Timeout)
+{
+	std::unique_lock<std::mutex> lock(m_WaitMutex);
+
+	if (Timeout == CAN_WAIT_INFINITE)
+		m_WaitCondition.wait(lock, [this] { return m_DataSignaled; });
+	else
+		m_WaitCondition.wait_for(lock, std::chrono::milliseconds(Timeout), [this] { return m_DataSignaled; });
+	m_DataSignaled = false;
+}
+
+bool CANCapture::Refill(Channel *channel)
+{
+	if (channel->PendingIndex < channel->PendingCount)
+		return true;
+
+	channel->PendingIndex = 0;
+	channel->PendingCount = channel->Ring.Pop(&channel->Pending[0], &channel->PendingHostTimes[0], (DWORD)channel->Pending.size());
+
+	return channel->PendingCount > 0;
+}
+
+DWORD CANCapture::ReadMerged(CANCaptureEntry *Entries, DWORD MaxCount)
+{
+	DWORD dwRead = 0;
+	bool flush = !m_Running.load();
+	UINT64 now = m_Clock->Now();
+
+	while (dwRead < MaxCount)
+	{
+		Channel *oldest = NULL;
+		DWORD oldestIndex = 0;
+		bool complete = true;
+
+		// k-way merge. The channels are few, so the oldest head is
+		// found with a linear scan rather than a heap
+		//
+		for (size_t i = 0; i < m_Channels.size(); i++)
+		{
+			Channel *channel = m_Channels[i].get();
+
+			if (!Refill(channel))
+			{
+				complete = false;
+				continue;
+			}
+			if (oldest == NULL || channel->PendingHostTimes[channel->PendingIndex] < oldest->PendingHostTimes[oldest->PendingIndex])
+			{
+				oldest = channel;
+				oldestIndex = (DWORD)i;
+			}
+		}
+
+		if (oldest == NULL)
+			break;
+
+		// With a silent channel, a message could still arrive there that
+		// is older than the oldest head; it is waited for during the
+		// reorder window only
+		//
+		UINT64 hostTime = oldest->PendingHostTimes[oldest->PendingIndex];
+		if (!complete && !flush && hostTime + m_ReorderWindow > now)
+			break;
+
+		CANCaptureEntry &entry = Entries[dwRead++];
+		entry.Entry = oldest->Pending[oldest->PendingIndex];
+		entry.HostTime = hostTime;
+		entry.Channel = oldestIndex;
+		oldest->PendingIndex++;
+
+		if (hostTime < m_LastMerged)
+			oldest->LateFrames++;
+		else
+			m_LastMerged = hostTime;
+
+		CANIdStats &idStats = oldest->IdTable[CAN_ID_KEY(entry.Entry.Msg)];
+		idStats.Count++;
+		idStats.LastHostTime = hostTime;
+	}
+
+	return dwRead;
+}
+
+DWORD CANCapture::GetChannelCount() const
+{
+	return (DWORD)m_Channels.size();
+}
+
+CANChannelStats CANCapture::GetChannelStatistics(DWORD Channel) const
+{
+	const CANCapture::Channel *channel = m_Channels[Channel].get();
+	CANChannelStats stats;
+
+	stats.Frames = channel->Frames.load(std::memory_order_relaxed);
+	stats.Bursts = channel->Bursts.load(std::memory_order_relaxed);
+	stats.Overflows = channel->Ring.GetOverflows();
+	stats.LateFrames = channel->LateFrames;
+	stats.RingHighWater = channel->Ring.GetHighWaterMark();
+	stats.LastError = channel->LastError.load();
+
+	return stats;
+}
+
+ClockAlignmentStats CANCapture::GetClockStatistics(DWORD Channel) const
+{
+	return m_Channels[Channel]->Align.GetStatistics();
+}
+
+const std::unordered_map<UINT64, CANIdStats>& CANCapture::GetIdTable(DWORD Channel) const
+{
+	return m_Channels[Channel]->IdTable;
+}
@@ -0,0 +1,192 @@
+//  CANCapture.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Concurrent capture of several CAN channels. Every channel gets its
+//  own reader thread, SPSC ring and clock estimator; a single consumer
+//  merges the channels into one stream ordered by host reception time
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __CANCAPTUREH_
+#define __CANCAPTUREH_
+
+#include "CANSource.h"
+#include "CANRing.h"
+#include "ClockAlignment.h"
+#include "TimestampService.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Default capacity of the ring of each channel
+//
+#define CAN_CAPTURE_RING_SIZE		8192
+
+// Number of messages moved per read or merge step
+//
+#define CAN_CAPTURE_BATCH			256
+
+// Default reorder window: how long the merge waits for a silent
+// channel before it emits the messages of the others (5 ms)
+//
+#define CAN_CAPTURE_REORDER_WINDOW	5000000ULL
+
+// A merged message, tagged with its channel
+//
+typedef struct tagCANCaptureEntry
+{
+	TPCANMsgFDEntry Entry;     // The message and its adapter timestamp
+	UINT64          HostTime;  // De-jittered host reception time in nanoseconds
+	DWORD           Channel;   // Index of the channel, as returned by AddChannel
+} CANCaptureEntry;
+
+// Statistics of a channel
+//
+typedef struct tagCANChannelStats
+{
+	UINT64      Frames;         // Messages read from the source
+	UINT64      Bursts;         // Non-empty reads of the source
+	UINT64      Overflows;      // Messages dropped because the ring was full
+	UINT64      LateFrames;     // Messages merged after a newer one of another channel
+	DWORD       RingHighWater;  // Highest ring depth seen
+	TPCANStatus LastError;      // Error that stopped the reader, PCAN_ERROR_OK otherwise
+} CANChannelStats;
+
+// Entry of the ID table of a channel
+//
+typedef struct tagCANIdStats
+{
+	UINT64 Count;         // Messages received with this ID and type
+	UINT64 LastHostTime;  // Host time of the last of them
+} CANIdStats;
+
+// Key of the ID tables: message type in the high word, ID in the low one
+//
+#define CAN_ID_KEY(msg)		(((UINT64)(msg).MSGTYPE << 32) | (msg).ID)
+
+// Multi-channel capture with a k-way merge
+//
+class CANCapture
+{
+	private:
+		// State of one channel
+		//
+		struct Channel
+		{
+			CANSource *Source;
+			CANRing Ring;
+			ClockAlignment Align;
+			std::thread Reader;
+
+			// Reader side buffers
+			//
+			std::vector<TPCANMsgFDEntry> ReadBatch;
+			std::vector<UINT64> ReadHostTimes;
+
+			// Merge side: messages popped from the ring not merged yet
+			//
+			std::vector<TPCANMsgFDEntry> Pending;
+			std::vector<UINT64> PendingHostTimes;
+			DWORD PendingIndex;
+			DWORD PendingCount;
+
+			// Statistics and ID table
+			//
+			std::atomic<UINT64> Frames;
+			std::atomic<UINT64> Bursts;
+			std::atomic<TPCANStatus> LastError;
+			UINT64 LateFrames;
+			std::unordered_map<UINT64, CANIdStats> IdTable;
+
+			Channel(CANSource *source, DWORD ringSize);
+		};
+
+		TimestampService *m_Clock;
+		UINT64 m_ReorderWindow;
+		DWORD m_RingSize;
+		std::vector<std::unique_ptr<Channel>> m_Channels;
+
+		// Reader threads state and consumer wake-up
+		//
+		std::atomic<bool> m_Running;
+		std::mutex m_WaitMutex;
+		std::condition_variable m_WaitCondition;
+		bool m_DataSignaled;
+
+		// Host time of the last merged message
+		//
+		UINT64 m_LastMerged;
+
+		// Reader thread of a channel
+		//
+		void ReaderThreadFunc(Channel *channel);
+
+		// Moves messages from the ring of a channel to its pending buffer
+		//
+		bool Refill(Channel *channel);
+
+		CANCapture(const CANCapture&);
+		CANCapture& operator=(const CANCapture&);
+
+	public:
+		// CANCapture constructor. The clock is owned by the caller
+		//
+		CANCapture(TimestampService *clock, UINT64 ReorderWindow = CAN_CAPTURE_REORDER_WINDOW, DWORD RingSize = CAN_CAPTURE_RING_SIZE);
+		// CANCapture destructor. Stops the capture
+		//
+		~CANCapture();
+
+		/// <summary>
+		/// Adds an initialized source to the capture. Only allowed while stopped
+		/// </summary>
+		/// <param name="Source">"The source, owned by the caller"</param>
+		/// <returns>"The index of the channel"</returns>
+		DWORD AddChannel(CANSource *Source);
+
+		/// <summary>
+		/// Starts one reader thread per channel
+		/// </summary>
+		/// <returns>"A TPCANStatus error code"</returns>
+		TPCANStatus Start();
+
+		/// <summary>
+		/// Stops and joins the reader threads. Messages already read stay
+		/// available to ReadMerged
+		/// </summary>
+		void Stop();
+
+		/// <summary>
+		/// Blocks until a reader stores messages, Stop is called or the
+		/// timeout elapses (consumer side)
+		/// </summary>
+		/// <param name="Timeout">"Maximum waiting time in milliseconds, or CAN_WAIT_INFINITE"</param>
+		void WaitForMessages(DWORD Timeout);
+
+		/// <summary>
+		/// Gets merged messages in host time order (consumer side). A message
+		/// is held back until every channel has a newer one, or until it is
+		/// older than the reorder window; once stopped everything is flushed
+		/// </summary>
+		/// <param name="Entries">"Buffer for the merged messages"</param>
+		/// <param name="MaxCount">"Capacity of Entries"</param>
+		/// <returns>"The number of messages stored in Entries"</returns>
+		DWORD ReadMerged(CANCaptureEntry *Entries, DWORD MaxCount);
+
+		// Channel information
+		//
+		DWORD GetChannelCount() const;
+		CANChannelStats GetChannelStatistics(DWORD Channel) const;
+		ClockAlignmentStats GetClockStatistics(DWORD Channel) const;
+
+		/// <summary>
+		/// Gets the ID table of a channel, keyed by CAN_ID_KEY (consumer side)
+		/// </summary>
+		const std::unordered_map<UINT64, CANIdStats>& GetIdTable(DWORD Channel) const;
+};
+#endif
@@ -0,0 +1,127 @@
+#include "CANRing.h"
+
+#include <string.h>
+
+CANRing::CANRing(DWORD Capacity)
+{
+	DWORD size = 1;
+
+	while (size < Capacity && size < 0x80000000)
+		size <<= 1;
+
+	m_Buffer.resize(size);
+	m_HostTimes.resize(size);
+	m_Mask = size - 1;
+	m_Head.store(0);
+	m_Tail.store(0);
+	m_HighWaterMark.store(0);
+	m_Overflows.store(0);
+}
+
+DWORD CANRing::Push(const TPCANMsgFDEntry* Entries, const UINT64* HostTimes, DWORD Count)
+{
+	DWORD head, tail, space, stored, index, first;
+
+	// Only the producer writes the head, the tail is
+	// acquired to see the slots released by the consumer
+	//
+	head = m_Head.load(std::memory_order_relaxed);
+	tail = m_Tail.load(std::memory_order_acquire);
+	space = (DWORD)m_Buffer.size() - (head - tail);
+
+	stored = Count < space ? Count : space;
+	if (stored > 0)
+	{
+		// Copies in at most two pieces, before and after the wrap
+		//
+		index = head & m_Mask;
+		first = (DWORD)m_Buffer.size() - index;
+		if (first > stored)
+			first = stored;
+		memcpy(&m_Buffer[index], Entries, first * sizeof(TPCANMsgFDEntry));
+		memcpy(&m_HostTimes[index], HostTimes, first * sizeof(UINT64));
+		if (stored > first)
+		{
+			memcpy(&m_Buffer[0], Entries + first, (stored - first) * sizeof(TPCANMsgFDEntry));
+			memcpy(&m_HostTimes[0], HostTimes + first, (stored - first) * sizeof(UINT64));
+		}
+
+		m_Head.store(head + stored, std::memory_order_release);
+
+		if ((head + stored - tail) > m_HighWaterMark.load(std::memory_order_relaxed))
+			m_HighWaterMark.store(head + stored - tail, std::memory_order_relaxed);
+	}
+
+	if (stored < Count)
+		m_Overflows.fetch_add(Count - stored, std::memory_order_relaxed);
+
+	return stored;
+}
+
+DWORD CANRing::Pop(TPCANMsgFDEntry* Entries, UINT64* HostTimes, DWORD MaxCount)
+{
+	DWORD head, tail, available, read, index, first;
+
+	// Only the consumer writes the tail, the head is
+	// acquired to see the messages stored by the producer
+	//
+	tail = m_Tail.load(std::memory_order_relaxed);
+	head = m_Head.load(std::memory_order_acquire);
+	available = head - tail;
+
+	read = MaxCount < available ? MaxCount : available;
+	if (read > 0)
+	{
+		index = tail & m_Mask;
+		first = (DWORD)m_Buffer.size() - index;
+		if (first > read)
+			first = read;
+		memcpy(Entries, &m_Buffer[index], first * sizeof(TPCANMsgFDEntry));
+		memcpy(HostTimes, &m_HostTimes[index], first * sizeof(UINT64));
+		if (read > first)
+		{
+			memcpy(Entries + first, &m_Buffer[0], (read - first) * sizeof(TPCANMsgFDEntry));
+			memcpy(HostTimes + first, &m_HostTimes[0], (read - first) * sizeof(UINT64));
+		}
+
+		m_Tail.store(tail + read, std::memory_order_release);
+	}
+
+	return read;
+}
+
+void CANRing::Clear()
+{
+	m_Tail.store(m_Head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+void CANRing::ResetStatistics()
+{
+	// A push running at the same time may raise the mark again,
+	// which is what a fresh measurement would show anyway
+	//
+	m_HighWaterMark.store(0, std::memory_order_relaxed);
+	m_Overflows.store(0, std::memory_order_relaxed);
+}
+
+DWORD CANRing::GetCapacity() const
+{
+	return (DWORD)m_Buffer.size();
+}
+
+DWORD CANRing::GetDepth() const
+{
+	DWORD tail = m_Tail.load(std::memory_order_acquire);
+
+	return m_Head.load(std::memory_order_acquire) - tail;
+}
+
+DWORD CANRing::GetHighWaterMark() const
+{
+	return m_HighWaterMark.load(std::memory_order_relaxed);
+}
+
+UINT64 CANRing::GetOverflows() const
+{
+	return m_Overflows.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,97 @@
+//  CANRing.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Bounded lock-free single-producer/single-consumer ring of received
+//  CAN messages. The reader thread only copies frames into the ring; the
+//  processing stage drains it on its own thread, so the reader never has
+//  to wait for locks held by the display
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __CANRINGH_
+#define __CANRINGH_
+
+#include "CANTypes.h"
+
+#include <atomic>
+#include <vector>
+
+// Size of a cache line, used to keep the producer and consumer
+// indexes from sharing one
+//
+#define CAN_RING_CACHE_LINE		64
+
+// SPSC ring of TPCANMsgFDEntry
+//
+class CANRing
+{
+	private:
+		// Message storage, its capacity is a power of two. Each message
+		// is paired with its reception time on the host clock
+		//
+		std::vector<TPCANMsgFDEntry> m_Buffer;
+		std::vector<UINT64> m_HostTimes;
+		DWORD m_Mask;
+
+		// Write index, only modified by the producer
+		//
+		std::atomic<DWORD> m_Head;
+		char m_HeadPad[CAN_RING_CACHE_LINE - sizeof(std::atomic<DWORD>)];
+
+		// Read index, only modified by the consumer
+		//
+		std::atomic<DWORD> m_Tail;
+		char m_TailPad[CAN_RING_CACHE_LINE - sizeof(std::atomic<DWORD>)];
+
+		// Statistics, written by the producer
+		//
+		std::atomic<DWORD> m_HighWaterMark;
+		std::atomic<UINT64> m_Overflows;
+
+		CANRing(const CANRing&);
+		CANRing& operator=(const CANRing&);
+
+	public:
+		// CANRing constructor. The capacity is rounded up to
+		// the next power of two
+		//
+		explicit CANRing(DWORD Capacity);
+
+		/// <summary>
+		/// Copies messages into the ring (producer side only)
+		/// </summary>
+		/// <param name="Entries">Messages to be stored</param>
+		/// <param name="HostTimes">Host reception time of each message</param>
+		/// <param name="Count">Number of messages in Entries</param>
+		/// <returns>The number of messages stored. Messages that do not
+		/// fit are dropped and counted as overflows</returns>
+		DWORD Push(const TPCANMsgFDEntry* Entries, const UINT64* HostTimes, DWORD Count);
+
+		/// <summary>
+		/// Moves messages out of the ring (consumer side only)
+		/// </summary>
+		/// <param name="Entries">Buffer for the messages read</param>
+		/// <param name="HostTimes">Buffer for their host reception times</param>
+		/// <param name="MaxCount">Capacity of Entries and HostTimes</param>
+		/// <returns>The number of messages read</returns>
+		DWORD Pop(TPCANMsgFDEntry* Entries, UINT64* HostTimes, DWORD MaxCount);
+
+		/// <summary>
+		/// Discards all stored messages (consumer side only)
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Resets the high-water mark and the overflow counter
+		/// </summary>
+		void ResetStatistics();
+
+		// Counters, safe to read from any thread
+		//
+		DWORD GetCapacity() const;
+		DWORD GetDepth() const;
+		DWORD GetHighWaterMark() const;
+		UINT64 GetOverflows() const;
+};
+#endif
@@ -0,0 +1,95 @@
+//  CANSource.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Abstract source of received CAN messages. The capture pipeline reads
+//  through this interface so the PCAN hardware can be exchanged for a
+//  SocketCAN interface or a recorded trace without touching the
+//  message processing
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __CANSOURCEH_
+#define __CANSOURCEH_
+
+#include "CANTypes.h"
+
+// Timeout value making WaitForMessages block until data or CancelWait
+//
+#define CAN_WAIT_INFINITE	0xFFFFFFFF
+
+// CAN message source interface
+//
+class CANSource
+{
+	public:
+		// CANSource destructor
+		//
+		virtual ~CANSource() {}
+
+		/// <summary>
+		/// Opens the source with the configuration given at construction
+		/// </summary>
+		/// <returns>"A TPCANStatus error code"</returns>
+		virtual TPCANStatus Initialize() = 0;
+
+		/// <summary>
+		/// Closes the source. Pending messages are discarded
+		/// </summary>
+		/// <returns>"A TPCANStatus error code"</returns>
+		virtual TPCANStatus Uninitialize() = 0;
+
+		/// <summary>
+		/// Reads CAN messages until the source has no more pending messages
+		/// or the given buffer is full
+		/// </summary>
+		/// <param name="EntryBuffer">"A preallocated TPCANMsgFDEntry array to store 
+		/// the CAN messages and their reception time in microseconds"</param>
+		/// <param name="MaxCount">"The number of entries available in EntryBuffer"</param>
+		/// <param name="Count">"Receives the number of entries stored in EntryBuffer"</param>
+		/// <returns>"The TPCANStatus error code of the last read. PCAN_ERROR_QRCVEMPTY 
+		/// when the source was drained, PCAN_ERROR_OK when the buffer was filled first"</returns>
+		virtual TPCANStatus ReadBatch(TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count) = 0;
+
+		/// <summary>
+		/// Configures the reception filter. The filter is expanded with every call
+		/// </summary>
+		/// <param name="FromID">"The lowest CAN ID to be received"</param>
+		/// <param name="ToID">"The highest CAN ID to be received"</param>
+		/// <param name="Mode">"Message type, Standard (11-bit identifier) or 
+		/// Extended (29-bit identifier)"</param>
+		/// <returns>"A TPCANStatus error code"</returns>
+		virtual TPCANStatus FilterMessages(DWORD FromID, DWORD ToID, TPCANMode Mode) = 0;
+
+		/// <summary>
+		/// Gets how many disjoint ranges per identifier length the filter can
+		/// hold exactly. Sources that widen their filter to a single range
+		/// with every FilterMessages call return 1. The limit applies to the
+		/// standard and to the extended IDs each, so a source can be given
+		/// twice that many ranges in all
+		/// </summary>
+		virtual DWORD GetMaxFilterRanges() const = 0;
+
+		/// <summary>
+		/// Blocks the calling thread until the source has messages pending,
+		/// the timeout elapses or CancelWait is called
+		/// </summary>
+		/// <param name="Timeout">"Maximum waiting time in milliseconds, or
+		/// CAN_WAIT_INFINITE"</param>
+		/// <returns>"PCAN_ERROR_OK when messages are pending, PCAN_ERROR_QRCVEMPTY
+		/// on timeout or cancellation"</returns>
+		virtual TPCANStatus WaitForMessages(DWORD Timeout) = 0;
+
+		/// <summary>
+		/// Wakes up a thread blocked in WaitForMessages. It can be called
+		/// from any thread; a call made while nobody waits makes the next
+		/// wait return at once
+		/// </summary>
+		virtual void CancelWait() = 0;
+
+		/// <summary>
+		/// Gets a short name describing the source, used in logs
+		/// </summary>
+		virtual const char* GetName() const = 0;
+};
+#endif
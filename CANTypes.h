@@ -0,0 +1,181 @@
+//  CANTypes.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Portable access to the PCAN-Basic message types, shared by the CAN
+//  sources and the processing stages that do not depend on MFC
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __CANTYPESH_
+#define __CANTYPESH_
+
+// Windows base types used by PCANBasic.h. On Windows they come from the
+// SDK; elsewhere they are mapped on the fixed-size integer types
+//
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <stdint.h>
+typedef uint8_t  BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int16_t  INT16;
+typedef int32_t  INT32;
+typedef uint64_t UINT64;
+typedef int64_t  INT64;
+typedef char*    LPSTR;
+#define __stdcall
+#endif
+
+#include <string.h>
+
+// Inclusion of the PCANBasic.h header file
+//
+#ifndef __PCANBASICH__
+#include "PCANBasic.h"
+#endif
+
+// Represents a received PCAN message together with its reception
+// time, as stored by PCANBasicClass::ReadBatch
+//
+typedef struct tagTPCANMsgEntry
+{
+	TPCANMsg          Msg;       // The received CAN message
+	TPCANTimestamp    Timestamp; // Reception time of the message
+} TPCANMsgEntry;
+
+// Represents a received PCAN FD message together with its reception
+// time, as stored by PCANBasicClass::ReadBatchFD and the CAN sources
+//
+typedef struct tagTPCANMsgFDEntry
+{
+	TPCANMsgFD        Msg;       // The received CAN FD message
+	TPCANTimestampFD  Timestamp; // Reception time of the message (microseconds)
+} TPCANMsgFDEntry;
+
+/// <summary>
+/// Convert a CAN DLC value into the actual data length of the CAN/CAN-FD frame.
+/// </summary>
+/// <param name="dlc">A value between 0 and 15 (CAN and FD DLC range)</param>
+/// <param name="isSTD">A value indicating if the msg is a standard CAN (FD Flag not checked)</param>
+/// <returns>The length represented by the DLC</returns>
+inline int GetLengthFromDLC(int dlc, bool isSTD)
+{
+    if (dlc <= 8)
+        return dlc;
+
+     if (isSTD)
+        return 8;
+
+     switch (dlc)
+     {
+        case 9: return 12;
+        case 10: return 16;
+        case 11: return 20;
+        case 12: return 24;
+        case 13: return 32;
+        case 14: return 48;
+        case 15: return 64;
+        default: return dlc;
+    }
+}
+
+/// <summary>
+/// Convert a CAN/CAN-FD data length into the smallest DLC able to hold it.
+/// </summary>
+/// <param name="length">A data length between 0 and 64</param>
+/// <returns>The DLC representing the length</returns>
+inline int GetDLCFromLength(int length)
+{
+    if (length <= 8)
+        return length;
+    if (length <= 12)
+        return 9;
+    if (length <= 16)
+        return 10;
+    if (length <= 20)
+        return 11;
+    if (length <= 24)
+        return 12;
+    if (length <= 32)
+        return 13;
+    if (length <= 48)
+        return 14;
+    return 15;
+}
+
+/// <summary>
+/// Converts the reception time of a standard CAN message into microseconds.
+/// </summary>
+/// <param name="timestamp">The reception time of the standard CAN message</param>
+/// <returns>The reception time in microseconds</returns>
+inline TPCANTimestampFD GetTimestampFD(const TPCANTimestamp &timestamp)
+{
+	return (timestamp.micros + 1000 * (TPCANTimestampFD)timestamp.millis + 0x100000000ULL * 1000 * timestamp.millis_overflow);
+}
+
+/// <summary>
+/// Widens a standard CAN message and its timestamp into their CAN-FD counterparts.
+/// Only the 8 data bytes of the standard message are written, the rest of
+/// msgFD->DATA is left untouched since nothing reads past the DLC
+/// </summary>
+/// <param name="msg">The standard CAN message</param>
+/// <param name="timestamp">The reception time of the standard CAN message</param>
+/// <param name="msgFD">Receives the CAN-FD message</param>
+/// <param name="timestampFD">Receives the reception time in microseconds</param>
+inline void ConvertToMsgFD(const TPCANMsg &msg, const TPCANTimestamp &timestamp, TPCANMsgFD *msgFD, TPCANTimestampFD *timestampFD)
+{
+	msgFD->ID = msg.ID;
+	msgFD->MSGTYPE = msg.MSGTYPE;
+	msgFD->DLC = (msg.LEN > 8) ? 8 : msg.LEN;
+	memcpy(msgFD->DATA, msg.DATA, 8);
+
+	*timestampFD = GetTimestampFD(timestamp);
+}
+
+// Read-only view on a standard or FD message. The processing stages work
+// on it, so standard messages are handled without being widened
+//
+typedef struct tagCANFrameView
+{
+	DWORD             ID;      // 11/29-bit message identifier
+	TPCANMessageType  MSGTYPE; // Type of the message
+	BYTE              DLC;     // Data Length Code of the message
+	BYTE              LEN;     // Number of data bytes, derived from the DLC
+	const BYTE       *DATA;    // Data of the message, owned by the viewed message, 8 bytes at least
+} CANFrameView;
+
+/// <summary>
+/// Gets a view on a standard CAN message.
+/// </summary>
+inline CANFrameView MakeFrameView(const TPCANMsg &msg)
+{
+	CANFrameView view;
+
+	view.ID = msg.ID;
+	view.MSGTYPE = msg.MSGTYPE;
+	view.DLC = msg.LEN;
+	view.LEN = (msg.LEN > 8) ? 8 : msg.LEN;
+	view.DATA = msg.DATA;
+
+	return view;
+}
+
+/// <summary>
+/// Gets a view on a CAN-FD message.
+/// </summary>
+inline CANFrameView MakeFrameView(const TPCANMsgFD &msg)
+{
+	CANFrameView view;
+
+	view.ID = msg.ID;
+	view.MSGTYPE = msg.MSGTYPE;
+	view.DLC = msg.DLC;
+	view.LEN = (BYTE)GetLengthFromDLC(msg.DLC, !(msg.MSGTYPE & PCAN_MESSAGE_FD));
+	view.DATA = msg.DATA;
+
+	return view;
+}
+
+#endif
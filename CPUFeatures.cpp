@@ -0,0 +1,82 @@
+#include "CPUFeatures.h"
+#include "CANTypes.h"
+
+#ifdef CPU_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef CPU_X86
+static void GetCPUID(int Leaf, int Regs[4])
+{
+#ifdef _MSC_VER
+	__cpuidex(Regs, Leaf, 0);
+#else
+	unsigned int a, b, c, d;
+
+	__cpuid_count(Leaf, 0, a, b, c, d);
+	Regs[0] = (int)a;
+	Regs[1] = (int)b;
+	Regs[2] = (int)c;
+	Regs[3] = (int)d;
+#endif
+}
+
+// State components enabled by the system (XCR0)
+//
+static UINT64 GetEnabledState()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int low, high;
+
+	__asm__ __volatile__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+	return ((UINT64)high << 32) | low;
+#endif
+}
+
+static int DetectPath()
+{
+	int regs[4];
+	int path = CPU_VECTOR_SCALAR;
+
+	GetCPUID(0, regs);
+	if (regs[0] < 1)
+		return path;
+
+	GetCPUID(1, regs);
+	if (regs[2] & (1 << 9))
+		path = CPU_VECTOR_SSSE3;
+
+	// AVX2 needs the system to save the YMM registers
+	//
+	if ((regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && (GetEnabledState() & 0x6) == 0x6)
+	{
+		GetCPUID(0, regs);
+		if (regs[0] >= 7)
+		{
+			GetCPUID(7, regs);
+			if (regs[1] & (1 << 5))
+				path = CPU_VECTOR_AVX2;
+		}
+	}
+
+	return path;
+}
+#else
+static int DetectPath()
+{
+	return CPU_VECTOR_SCALAR;
+}
+#endif
+
+int GetCPUVectorPath()
+{
+	static const int path = DetectPath();
+
+	return path;
+}
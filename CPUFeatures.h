@@ -0,0 +1,39 @@
+//  CPUFeatures.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Vector instruction sets of the processor, detected once at run time,
+//  for the modules that have SSSE3 and AVX2 paths next to a scalar one
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __CPUFEATURESH_
+#define __CPUFEATURESH_
+
+// Vector paths, each one including the ones before
+//
+#define CPU_VECTOR_SCALAR		0
+#define CPU_VECTOR_SSSE3		1
+#define CPU_VECTOR_AVX2			2
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CPU_X86
+#endif
+
+// The vector functions are compiled for their instruction set only,
+// the other ones stay usable on any processor
+//
+#if defined(_MSC_VER)
+#define CPU_TARGET_SSSE3
+#define CPU_TARGET_AVX2
+#else
+#define CPU_TARGET_SSSE3		__attribute__((target("ssse3")))
+#define CPU_TARGET_AVX2			__attribute__((target("avx2")))
+#endif
+
+/// <summary>
+/// Gets the fastest vector path of the processor. AVX2 is only given
+/// when the system saves the YMM registers
+/// </summary>
+int GetCPUVectorPath();
+#endif
@@ -0,0 +1,152 @@
+#include "ClockAlignment.h"
+
+#include <math.h>
+#include <string.h>
+
+// Nominal ratio between the two domains: nanoseconds per microsecond
+//
+#define CLOCK_ALIGN_NOMINAL_SLOPE	1000.0
+
+ClockAlignment::ClockAlignment(DWORD WindowSize, DWORD IntervalUs)
+{
+	if (WindowSize < 2)
+		WindowSize = 2;
+	m_Interval = IntervalUs;
+
+	m_Adapter.resize(WindowSize);
+	m_Host.resize(WindowSize);
+	memset(&m_Stats, 0, sizeof(m_Stats));
+	Reset();
+}
+
+void ClockAlignment::Reset()
+{
+	m_Next = 0;
+	m_Count = 0;
+	m_IntervalStart = 0;
+	m_LastAdapter = 0;
+	m_HasCandidate = false;
+	m_AdapterRef = 0;
+	m_HostRef = 0;
+	m_Offset = 0;
+	m_Slope = CLOCK_ALIGN_NOMINAL_SLOPE;
+
+	std::lock_guard<std::mutex> lock(m_StatsLock);
+	DWORD resets = m_Stats.Resets;
+	memset(&m_Stats, 0, sizeof(m_Stats));
+	m_Stats.Resets = resets;
+}
+
+void ClockAlignment::AddSample(TPCANTimestampFD AdapterTime, UINT64 HostTime)
+{
+	// An adapter clock going backwards means the channel was reset
+	// (or a replay restarted); the old samples are useless then
+	//
+	if (m_Count > 0 && AdapterTime < m_LastAdapter)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_StatsLock);
+			m_Stats.Resets++;
+		}
+		Reset();
+	}
+	m_LastAdapter = AdapterTime;
+
+	// The pair with the smallest apparent delay is the one closest
+	// to the true reception time
+	//
+	INT64 delay = (INT64)(HostTime - AdapterTime * (UINT64)CLOCK_ALIGN_NOMINAL_SLOPE);
+	if (!m_HasCandidate || delay < m_CandidateDelay)
+	{
+		m_CandidateAdapter = AdapterTime;
+		m_CandidateHost = HostTime;
+		m_CandidateDelay = delay;
+		m_HasCandidate = true;
+	}
+
+	// One pair per interval enters the window; the very first one
+	// at once, so conversions are possible from the start
+	//
+	if (m_Count > 0 && AdapterTime - m_IntervalStart < m_Interval)
+		return;
+
+	m_Adapter[m_Next] = m_CandidateAdapter;
+	m_Host[m_Next] = m_CandidateHost;
+	m_Next = (m_Next + 1) % (DWORD)m_Adapter.size();
+	if (m_Count < m_Adapter.size())
+		m_Count++;
+	m_IntervalStart = AdapterTime;
+	m_HasCandidate = false;
+
+	Fit();
+}
+
+void ClockAlignment::Fit()
+{
+	DWORD size = (DWORD)m_Adapter.size();
+	DWORD first = (m_Next + size - m_Count) % size;
+	double sx = 0, sy = 0, sxx = 0, sxy = 0;
+	double residual, sumSquares = 0, maxResidual = 0;
+
+	// Coordinates are taken relative to the oldest sample, so the
+	// sums keep their precision in double
+	//
+	m_AdapterRef = m_Adapter[first];
+	m_HostRef = m_Host[first];
+
+	for (DWORD i = 0; i < m_Count; i++)
+	{
+		DWORD j = (first + i) % size;
+		double x = (double)(m_Adapter[j] - m_AdapterRef);
+		double y = (double)(INT64)(m_Host[j] - m_HostRef);
+
+		sx += x;
+		sy += y;
+		sxx += x * x;
+		sxy += x * y;
+	}
+
+	// With a single sample, or samples all taken at the same adapter
+	// time, only the offset can be estimated
+	//
+	double n = (double)m_Count;
+	double denominator = n * sxx - sx * sx;
+	if (m_Count < 2 || denominator <= 0)
+		m_Slope = CLOCK_ALIGN_NOMINAL_SLOPE;
+	else
+		m_Slope = (n * sxy - sx * sy) / denominator;
+	m_Offset = (sy - m_Slope * sx) / n;
+
+	for (DWORD i = 0; i < m_Count; i++)
+	{
+		DWORD j = (first + i) % size;
+		double x = (double)(m_Adapter[j] - m_AdapterRef);
+		double y = (double)(INT64)(m_Host[j] - m_HostRef);
+
+		residual = y - (m_Offset + m_Slope * x);
+		sumSquares += residual * residual;
+		if (fabs(residual) > maxResidual)
+			maxResidual = fabs(residual);
+	}
+
+	std::lock_guard<std::mutex> lock(m_StatsLock);
+	m_Stats.Samples = m_Count;
+	m_Stats.TotalSamples++;
+	m_Stats.DriftPpm = (CLOCK_ALIGN_NOMINAL_SLOPE / m_Slope - 1.0) * 1e6;
+	m_Stats.ResidualRms = sqrt(sumSquares / n);
+	m_Stats.ResidualMax = maxResidual;
+}
+
+UINT64 ClockAlignment::ToHost(TPCANTimestampFD AdapterTime) const
+{
+	double x = (double)(INT64)(AdapterTime - m_AdapterRef);
+
+	return m_HostRef + (UINT64)(INT64)llround(m_Offset + m_Slope * x);
+}
+
+ClockAlignmentStats ClockAlignment::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_StatsLock);
+
+	return m_Stats;
+}
@@ -0,0 +1,113 @@
+//  ClockAlignment.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Online estimator of the offset and drift between the timestamp domain
+//  of a CAN adapter (microseconds) and the host monotonic clock
+//  (nanoseconds). A linear regression over a sliding window of
+//  (adapter, host) pairs maps every adapter timestamp onto the host
+//  clock, removing the USB and scheduling jitter of the host samples.
+//  Within each sampling interval only the least delayed pair is kept,
+//  so the fit follows the lower envelope of the reception latency
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __CLOCKALIGNMENTH_
+#define __CLOCKALIGNMENTH_
+
+#include "CANTypes.h"
+
+#include <mutex>
+#include <vector>
+
+// Default number of samples the regression is computed on
+//
+#define CLOCK_ALIGN_WINDOW		256
+
+// Default sampling interval of the window, in adapter microseconds
+//
+#define CLOCK_ALIGN_INTERVAL	10000
+
+// Statistics of the current fit
+//
+typedef struct tagClockAlignmentStats
+{
+	DWORD  Samples;        // Number of samples in the window
+	UINT64 TotalSamples;   // Number of samples since the last reset
+	DWORD  Resets;         // Number of discontinuities detected in the adapter clock
+	double DriftPpm;       // Adapter clock drift relative to the host clock, in ppm
+	double ResidualRms;    // RMS of the host samples around the fit, in nanoseconds
+	double ResidualMax;    // Largest absolute residual in the window, in nanoseconds
+} ClockAlignmentStats;
+
+// Adapter to host clock estimator
+//
+class ClockAlignment
+{
+	private:
+		// Sample window, used as a circular buffer
+		//
+		std::vector<TPCANTimestampFD> m_Adapter;
+		std::vector<UINT64> m_Host;
+		DWORD m_Next;
+		DWORD m_Count;
+
+		// Least delayed pair of the running interval
+		//
+		TPCANTimestampFD m_Interval;
+		TPCANTimestampFD m_IntervalStart;
+		TPCANTimestampFD m_LastAdapter;
+		TPCANTimestampFD m_CandidateAdapter;
+		UINT64 m_CandidateHost;
+		INT64 m_CandidateDelay;
+		bool m_HasCandidate;
+
+		// Current fit: host = m_HostRef + m_Offset + m_Slope * (adapter - m_AdapterRef)
+		//
+		TPCANTimestampFD m_AdapterRef;
+		UINT64 m_HostRef;
+		double m_Offset;
+		double m_Slope;
+
+		// Statistics, guarded by m_StatsLock since they are read by other threads
+		//
+		ClockAlignmentStats m_Stats;
+		mutable std::mutex m_StatsLock;
+
+		// Recomputes the fit over the current window
+		//
+		void Fit();
+
+		ClockAlignment(const ClockAlignment&);
+		ClockAlignment& operator=(const ClockAlignment&);
+
+	public:
+		// ClockAlignment constructor
+		//
+		explicit ClockAlignment(DWORD WindowSize = CLOCK_ALIGN_WINDOW, DWORD IntervalUs = CLOCK_ALIGN_INTERVAL);
+
+		/// <summary>
+		/// Forgets all the samples, as needed when the adapter changes
+		/// </summary>
+		void Reset();
+
+		/// <summary>
+		/// Adds a pair of timestamps taken for the same event. The host time
+		/// should be taken as close as possible after the reception
+		/// </summary>
+		/// <param name="AdapterTime">"Adapter timestamp in microseconds"</param>
+		/// <param name="HostTime">"Host monotonic time in nanoseconds"</param>
+		void AddSample(TPCANTimestampFD AdapterTime, UINT64 HostTime);
+
+		/// <summary>
+		/// Converts an adapter timestamp into host monotonic nanoseconds
+		/// </summary>
+		/// <param name="AdapterTime">"Adapter timestamp in microseconds"</param>
+		UINT64 ToHost(TPCANTimestampFD AdapterTime) const;
+
+		/// <summary>
+		/// Gets a copy of the statistics of the current fit
+		/// </summary>
+		ClockAlignmentStats GetStatistics() const;
+};
+#endif
@@ -0,0 +1,248 @@
+#include "DbcLoader.h"
+
+#include <fstream>
+#include <sstream>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ID of the pseudo message holding the signals of no message
+//
+#define DBC_INDEPENDENT_ID		0xC0000000UL
+
+// Cursor over one line of the text
+//
+typedef struct tagDbcLine
+{
+	const char *Pos;
+	const char *End;
+} DbcLine;
+
+static void SkipSpaces(DbcLine *Line)
+{
+	while (Line->Pos < Line->End && (*Line->Pos == ' ' || *Line->Pos == '\t'))
+		Line->Pos++;
+}
+
+// Reads a word ending at a space or a colon
+//
+static bool ReadWord(DbcLine *Line, std::string *Word)
+{
+	const char *start;
+
+	SkipSpaces(Line);
+	start = Line->Pos;
+	while (Line->Pos < Line->End && *Line->Pos != ' ' && *Line->Pos != '\t' && *Line->Pos != ':')
+		Line->Pos++;
+	Word->assign(start, Line->Pos);
+
+	return !Word->empty();
+}
+
+static bool ReadChar(DbcLine *Line, char Expected)
+{
+	SkipSpaces(Line);
+	if (Line->Pos >= Line->End || *Line->Pos != Expected)
+		return false;
+
+	Line->Pos++;
+	return true;
+}
+
+// The numbers are read in place, the text being zero-terminated
+//
+static bool ReadUnsigned(DbcLine *Line, unsigned long *Value)
+{
+	char *next;
+
+	SkipSpaces(Line);
+	if (Line->Pos >= Line->End || *Line->Pos < '0' || *Line->Pos > '9')
+		return false;
+
+	*Value = strtoul(Line->Pos, &next, 10);
+	Line->Pos = next;
+	return Line->Pos <= Line->End;
+}
+
+static bool ReadDouble(DbcLine *Line, double *Value)
+{
+	char *next;
+
+	SkipSpaces(Line);
+	if (Line->Pos >= Line->End)
+		return false;
+
+	*Value = strtod(Line->Pos, &next);
+	if (next == Line->Pos)
+		return false;
+	Line->Pos = next;
+	return Line->Pos <= Line->End;
+}
+
+// Tells if a line starts with a keyword followed by a space
+//
+static bool IsKeyword(const DbcLine &Line, const char *Keyword)
+{
+	size_t length = strlen(Keyword);
+
+	return (size_t)(Line.End - Line.Pos) > length && strncmp(Line.Pos, Keyword, length) == 0
+		&& (Line.Pos[length] == ' ' || Line.Pos[length] == '\t');
+}
+
+// Reads "BO_ <id> <name>: <dlc> <transmitter>"
+//
+static bool ParseMessage(DbcLine *Line, DWORD *ID)
+{
+	unsigned long id;
+	std::string name;
+
+	Line->Pos += 3;
+	if (!ReadUnsigned(Line, &id) || !ReadWord(Line, &name) || !ReadChar(Line, ':'))
+		return false;
+
+	*ID = (DWORD)id;
+	return true;
+}
+
+// Reads "SG_ <name> [<mux>] : <start>|<length>@<order><sign> (<scale>,<offset>)
+// [<min>|<max>] "<unit>" <receivers>". Returns the multiplexing word, if any
+//
+static bool ParseSignal(DbcLine *Line, SignalDescriptor *Signal, std::string *Multiplexing)
+{
+	unsigned long start, length;
+	double minimum, maximum;
+	const char *unit;
+	std::string word;
+
+	Line->Pos += 3;
+	if (!ReadWord(Line, &Signal->Name))
+		return false;
+	Multiplexing->clear();
+	SkipSpaces(Line);
+	if (Line->Pos < Line->End && *Line->Pos != ':' && !ReadWord(Line, Multiplexing))
+		return false;
+
+	if (!ReadChar(Line, ':') || !ReadUnsigned(Line, &start) || !ReadChar(Line, '|') || !ReadUnsigned(Line, &length) || !ReadChar(Line, '@'))
+		return false;
+	if (Line->Pos + 2 > Line->End || (Line->Pos[0] != '0' && Line->Pos[0] != '1') || (Line->Pos[1] != '+' && Line->Pos[1] != '-'))
+		return false;
+	Signal->StartBit = (int)start;
+	Signal->Length = (int)length;
+	Signal->ByteOrder = (Line->Pos[0] == '0') ? SIGNAL_BIG_ENDIAN : SIGNAL_LITTLE_ENDIAN;
+	Signal->Signed = (Line->Pos[1] == '-');
+	Line->Pos += 2;
+
+	if (!ReadChar(Line, '(') || !ReadDouble(Line, &Signal->Scale) || !ReadChar(Line, ',') || !ReadDouble(Line, &Signal->Offset) || !ReadChar(Line, ')'))
+		return false;
+	if (!ReadChar(Line, '[') || !ReadDouble(Line, &minimum) || !ReadChar(Line, '|') || !ReadDouble(Line, &maximum) || !ReadChar(Line, ']'))
+		return false;
+
+	if (!ReadChar(Line, '"'))
+		return false;
+	unit = Line->Pos;
+	while (Line->Pos < Line->End && *Line->Pos != '"')
+		Line->Pos++;
+	if (Line->Pos >= Line->End)
+		return false;
+	Signal->Unit.assign(unit, Line->Pos);
+
+	return true;
+}
+
+bool ParseDbcText(const std::string &Text, std::vector<SignalDescriptor> *Signals, DbcLoadStats *Stats, std::string *Error)
+{
+	const char *text = Text.c_str();
+	const char *end = text + Text.size();
+	const char *next;
+	DbcLoadStats stats = { 0, 0, 0, 0 };
+	SignalDescriptor signal;
+	std::string multiplexing;
+	DbcLine line;
+	DWORD id = 0;
+	bool inMessage = false;
+	int lineNumber = 0;
+	char message[64];
+
+	Signals->clear();
+
+	for (; text < end; text = next)
+	{
+		next = (const char*)memchr(text, '\n', end - text);
+		next = (next == NULL) ? end : next + 1;
+		lineNumber++;
+
+		line.Pos = text;
+		line.End = next;
+		while (line.End > line.Pos && (line.End[-1] == '\n' || line.End[-1] == '\r'))
+			line.End--;
+		SkipSpaces(&line);
+
+		if (IsKeyword(line, "BO_"))
+		{
+			if (!ParseMessage(&line, &id))
+			{
+				snprintf(message, sizeof(message), "Line %d: malformed message", lineNumber);
+				*Error = message;
+				return false;
+			}
+			inMessage = (id != DBC_INDEPENDENT_ID);
+			if (inMessage)
+				stats.Messages++;
+		}
+		else if (IsKeyword(line, "SG_"))
+		{
+			if (!ParseSignal(&line, &signal, &multiplexing))
+			{
+				snprintf(message, sizeof(message), "Line %d: malformed signal", lineNumber);
+				*Error = message;
+				return false;
+			}
+			if (!inMessage)
+				continue;
+
+			// Only the multiplexor itself ("M") is decoded, the signals
+			// depending on its value ("m<n>") are not
+			//
+			if (!multiplexing.empty() && multiplexing != "M")
+			{
+				stats.Multiplexed++;
+				continue;
+			}
+
+			signal.ID = id;
+			if (!PrepareSignal(&signal))
+			{
+				stats.Unsupported++;
+				continue;
+			}
+			Signals->push_back(signal);
+			stats.Signals++;
+		}
+		else if (line.Pos < line.End)
+		{
+			// Any other section ends the signals of the message
+			//
+			inMessage = false;
+		}
+	}
+
+	if (Stats != NULL)
+		*Stats = stats;
+	return true;
+}
+
+bool LoadDbcFile(const std::string &FileName, std::vector<SignalDescriptor> *Signals, DbcLoadStats *Stats, std::string *Error)
+{
+	std::ifstream file(FileName.c_str(), std::ifstream::in | std::ifstream::binary);
+	std::ostringstream text;
+
+	if (!file.is_open())
+	{
+		*Error = "Cannot open " + FileName;
+		return false;
+	}
+
+	text << file.rdbuf();
+	return ParseDbcText(text.str(), Signals, Stats, Error);
+}
@@ -0,0 +1,53 @@
+//  DbcLoader.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Loader of the signals described in a DBC file. Only the messages
+//  (BO_) and their signals (SG_) are read, in one pass over the text;
+//  the other sections are skipped
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __DBCLOADERH_
+#define __DBCLOADERH_
+
+#include "SignalDecoder.h"
+
+#include <string>
+#include <vector>
+
+// Flag of the extended IDs in a DBC file
+//
+#define DBC_ID_EXTENDED			0x80000000UL
+
+// Statistics of a DBC file load
+//
+typedef struct tagDbcLoadStats
+{
+	int Messages;         // Messages read
+	int Signals;          // Signals kept
+	int Multiplexed;      // Multiplexed signals skipped
+	int Unsupported;      // Signals longer than SIGNAL_MAX_LENGTH skipped
+} DbcLoadStats;
+
+/// <summary>
+/// Reads the signals of a DBC text. The IDs keep the DBC_ID_EXTENDED
+/// flag of the extended frames, and every signal is prepared
+/// </summary>
+/// <param name="Text">"Text of the DBC file"</param>
+/// <param name="Signals">"Signals read"</param>
+/// <param name="Stats">"Counts of the load, may be NULL"</param>
+/// <param name="Error">"Line and cause of the first error"</param>
+/// <returns>"false if a message or a signal is malformed"</returns>
+bool ParseDbcText(const std::string &Text, std::vector<SignalDescriptor> *Signals, DbcLoadStats *Stats, std::string *Error);
+
+/// <summary>
+/// Reads the signals of a DBC file
+/// </summary>
+/// <param name="FileName">"Path of the DBC file"</param>
+/// <param name="Signals">"Signals read"</param>
+/// <param name="Stats">"Counts of the load, may be NULL"</param>
+/// <param name="Error">"Cause of the failure"</param>
+/// <returns>"false if the file cannot be read or is malformed"</returns>
+bool LoadDbcFile(const std::string &FileName, std::vector<SignalDescriptor> *Signals, DbcLoadStats *Stats, std::string *Error);
+#endif
@@ -0,0 +1,39 @@
+#include "DirtySet.h"
+
+void DirtySet::Mark(int Index)
+{
+	size_t word = (size_t)Index >> 6;
+	UINT64 bit = 1ULL << (Index & 63);
+
+	if (word >= m_Bits.size())
+		m_Bits.resize(word + 1, 0);
+	if (m_Bits[word] & bit)
+		return;
+
+	m_Bits[word] |= bit;
+	m_Indexes.push_back(Index);
+}
+
+bool DirtySet::IsMarked(int Index) const
+{
+	size_t word = (size_t)Index >> 6;
+
+	return word < m_Bits.size() && (m_Bits[word] & (1ULL << (Index & 63))) != 0;
+}
+
+const std::vector<int>& DirtySet::GetIndexes() const
+{
+	return m_Indexes;
+}
+
+int DirtySet::GetCount() const
+{
+	return (int)m_Indexes.size();
+}
+
+void DirtySet::Clear()
+{
+	for (size_t i = 0; i < m_Indexes.size(); i++)
+		m_Bits[(size_t)m_Indexes[i] >> 6] = 0;
+	m_Indexes.clear();
+}
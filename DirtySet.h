@@ -0,0 +1,50 @@
+//  DirtySet.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Set of the slots of a table changed since it was last drained. A
+//  bitmap keeps each slot from being listed twice and the list of the
+//  marked slots lets the consumer visit only them, so draining costs the
+//  number of changed slots whatever the size of the table
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __DIRTYSETH_
+#define __DIRTYSETH_
+
+#include "CANTypes.h"
+
+#include <vector>
+
+// Dirty set of table slots
+//
+class DirtySet
+{
+	private:
+		std::vector<UINT64> m_Bits;
+		std::vector<int> m_Indexes;
+
+	public:
+		/// <summary>
+		/// Marks a slot as changed. Does nothing if it is already marked
+		/// </summary>
+		void Mark(int Index);
+
+		/// <summary>
+		/// Tells if a slot is marked
+		/// </summary>
+		bool IsMarked(int Index) const;
+
+		/// <summary>
+		/// Gets the marked slots, in the order they were first marked
+		/// </summary>
+		const std::vector<int>& GetIndexes() const;
+
+		int GetCount() const;
+
+		/// <summary>
+		/// Unmarks every slot, in time proportional to their number
+		/// </summary>
+		void Clear();
+};
+#endif
@@ -0,0 +1,168 @@
+#include "DisplayModel.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+DisplayModel::DisplayModel()
+	: m_Acknowledged(0), m_Published(0), m_Overwritten(0), m_RowsPublished(0), m_Acquired(0), m_Idle(0)
+{
+	std::shared_ptr<DisplaySnapshot> snapshot = std::make_shared<DisplaySnapshot>();
+
+	m_Sequence = 0;
+	m_Generation = 0;
+	m_NextPublish = 0;
+	m_XbowPackets = 0;
+	m_PublishedXbowPackets = 0;
+	memset(m_XbowPacket, 0, sizeof(m_XbowPacket));
+
+	snapshot->Sequence = 0;
+	snapshot->Generation = 0;
+	snapshot->RowCount = 0;
+	snapshot->XbowPackets = 0;
+	memset(snapshot->XbowPacket, 0, sizeof(snapshot->XbowPacket));
+	m_Snapshot = snapshot;
+}
+
+void DisplayModel::Store(const MessageTable<MessageStatus> &Table, UINT64 Acknowledged)
+{
+	std::shared_ptr<DisplaySnapshot> snapshot = std::make_shared<DisplaySnapshot>();
+	std::vector<int> rows;
+
+	// Snapshots rendered by the display are forgotten. The rows of the
+	// others are those whose last change they carry
+	//
+	while (!m_Pending.empty() && m_Pending.front().Sequence <= Acknowledged)
+		m_Pending.pop_front();
+	for (std::deque<PendingRows>::const_iterator i = m_Pending.begin(); i != m_Pending.end(); ++i)
+		for (std::vector<int>::const_iterator j = i->Rows.begin(); j != i->Rows.end(); ++j)
+			if (m_RowVersions[*j] == i->Sequence)
+				rows.push_back(*j);
+	std::sort(rows.begin(), rows.end());
+
+	snapshot->Sequence = m_Sequence;
+	snapshot->Generation = m_Generation;
+	snapshot->RowCount = Table.GetCount();
+	snapshot->Rows.reserve(rows.size());
+	for (std::vector<int>::const_iterator i = rows.begin(); i != rows.end(); ++i)
+		snapshot->Rows.push_back(Table[*i]);
+	snapshot->XbowPackets = m_XbowPackets;
+	memcpy(snapshot->XbowPacket, m_XbowPacket, sizeof(m_XbowPacket));
+	m_PublishedXbowPackets = m_XbowPackets;
+
+	m_Published++;
+	m_RowsPublished += snapshot->Rows.size();
+	std::atomic_store(&m_Snapshot, std::shared_ptr<const DisplaySnapshot>(snapshot));
+}
+
+void DisplayModel::MarkChanged(int Row)
+{
+	m_Dirty.Mark(Row);
+}
+
+bool DisplayModel::Publish(const MessageTable<MessageStatus> &Table, UINT64 Now)
+{
+	UINT64 acknowledged;
+	PendingRows pending;
+
+	if (Now < m_NextPublish)
+		return false;
+	m_NextPublish = Now + DISPLAY_PUBLISH_INTERVAL;
+
+	if (m_Dirty.GetCount() == 0 && m_XbowPackets == m_PublishedXbowPackets)
+		return false;
+
+	// The marked rows get the number of the new snapshot
+	//
+	pending.Sequence = ++m_Sequence;
+	pending.Rows = m_Dirty.GetIndexes();
+	m_Dirty.Clear();
+	for (std::vector<int>::const_iterator i = pending.Rows.begin(); i != pending.Rows.end(); ++i)
+	{
+		if (*i >= (int)m_RowVersions.size())
+			m_RowVersions.resize(*i + 1, 0);
+		m_RowVersions[*i] = pending.Sequence;
+	}
+	m_Pending.push_back(pending);
+
+	// While the display does not acknowledge, the oldest pending rows
+	// are moved to the next snapshot, which carries them anyway
+	//
+	while (m_Pending.size() > DISPLAY_MAX_PENDING)
+	{
+		PendingRows &oldest = m_Pending[0];
+		PendingRows &next = m_Pending[1];
+
+		for (std::vector<int>::const_iterator i = oldest.Rows.begin(); i != oldest.Rows.end(); ++i)
+		{
+			if (m_RowVersions[*i] == oldest.Sequence)
+			{
+				m_RowVersions[*i] = next.Sequence;
+				next.Rows.push_back(*i);
+			}
+		}
+		m_Pending.pop_front();
+	}
+
+	// A snapshot the display did not take yet is replaced. The new one
+	// also carries its rows, since they are newer than the acknowledged one
+	//
+	acknowledged = m_Acknowledged.load();
+	if (m_Sequence - 1 > acknowledged)
+		m_Overwritten++;
+	Store(Table, acknowledged);
+
+	return true;
+}
+
+void DisplayModel::SetXbowPacket(const BYTE *Packet)
+{
+	memcpy(m_XbowPacket, Packet, sizeof(m_XbowPacket));
+	m_XbowPackets++;
+}
+
+void DisplayModel::Reset()
+{
+	MessageTable<MessageStatus> empty;
+
+	m_Dirty.Clear();
+	m_RowVersions.clear();
+	m_Pending.clear();
+	m_Generation++;
+	m_NextPublish = 0;
+	m_Sequence++;
+	Store(empty, m_Acknowledged.load());
+}
+
+std::shared_ptr<const DisplaySnapshot> DisplayModel::Acquire()
+{
+	std::shared_ptr<const DisplaySnapshot> snapshot = std::atomic_load(&m_Snapshot);
+
+	if (snapshot->Sequence <= m_Acknowledged.load())
+	{
+		m_Idle++;
+		return std::shared_ptr<const DisplaySnapshot>();
+	}
+
+	m_Acquired++;
+	return snapshot;
+}
+
+void DisplayModel::Acknowledge(UINT64 Sequence)
+{
+	if (Sequence > m_Acknowledged.load())
+		m_Acknowledged.store(Sequence);
+}
+
+DisplayModelStats DisplayModel::GetStatistics() const
+{
+	DisplayModelStats stats;
+
+	stats.Published = m_Published.load();
+	stats.Overwritten = m_Overwritten.load();
+	stats.RowsPublished = m_RowsPublished.load();
+	stats.Acquired = m_Acquired.load();
+	stats.Idle = m_Idle.load();
+
+	return stats;
+}
@@ -0,0 +1,157 @@
+//  DisplayModel.h
+//
+//  ~~~~~~~~~~~~
+//
+//  View model between the processing pipeline and the message lists.
+//  The pipeline publishes, at a fixed rate, an immutable snapshot of the
+//  rows that changed since the display last rendered one, and swaps it
+//  in atomically. The display takes the latest snapshot without any lock
+//  shared with the pipeline, so painting the lists never holds up the
+//  processing of new messages
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __DISPLAYMODELH_
+#define __DISPLAYMODELH_
+
+#include "CANTypes.h"
+#include "DirtySet.h"
+#include "MessageStatus.h"
+#include "MessageTable.h"
+#include "XbowTypes.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Minimum time between two snapshots, in nanoseconds of the host clock
+// (the display timer runs at 10 Hz)
+//
+#define DISPLAY_PUBLISH_INTERVAL	100000000ULL
+
+// Published snapshots whose rows are remembered until the display
+// acknowledges them. Older ones are folded into the next one
+//
+#define DISPLAY_MAX_PENDING			16
+
+// Rows to render, as published by the pipeline
+//
+typedef struct tagDisplaySnapshot
+{
+	UINT64 Sequence;                       // Number of the snapshot, 1 for the first one
+	UINT64 Generation;                     // Changes when the rows are cleared
+	int RowCount;                          // Rows of the table when published
+	std::vector<MessageStatus> Rows;       // Rows new or changed since the last acknowledged snapshot, by position
+	UINT64 XbowPackets;                    // Valid Xbow packets received so far
+	BYTE XbowPacket[XBOW_PACKET_SIZE];     // Last of them
+} DisplaySnapshot;
+
+// Counters of the exchanges between the pipeline and the display.
+// Neither side ever waits for the other
+//
+typedef struct tagDisplayModelStats
+{
+	UINT64 Published;        // Snapshots published
+	UINT64 Overwritten;      // Snapshots replaced before the display took them
+	UINT64 RowsPublished;    // Rows copied into the snapshots
+	UINT64 Acquired;         // Snapshots taken by the display
+	UINT64 Idle;             // Display refreshes finding no new snapshot
+} DisplayModelStats;
+
+// Double-buffered display model
+//
+class DisplayModel
+{
+	private:
+		// Rows changed by one published snapshot
+		//
+		typedef struct tagPendingRows
+		{
+			UINT64 Sequence;
+			std::vector<int> Rows;
+		} PendingRows;
+
+		// Pipeline side, serialized by the caller. A row's version is
+		// the number of the last snapshot carrying its change, and the
+		// pending snapshots list those rows until acknowledged
+		//
+		DirtySet m_Dirty;
+		std::vector<UINT64> m_RowVersions;
+		std::deque<PendingRows> m_Pending;
+		UINT64 m_Sequence;
+		UINT64 m_Generation;
+		UINT64 m_NextPublish;
+		UINT64 m_XbowPackets;
+		UINT64 m_PublishedXbowPackets;
+		BYTE m_XbowPacket[XBOW_PACKET_SIZE];
+
+		// Latest snapshot, swapped atomically
+		//
+		std::shared_ptr<const DisplaySnapshot> m_Snapshot;
+
+		// Last snapshot rendered by the display
+		//
+		std::atomic<UINT64> m_Acknowledged;
+
+		std::atomic<UINT64> m_Published;
+		std::atomic<UINT64> m_Overwritten;
+		std::atomic<UINT64> m_RowsPublished;
+		std::atomic<UINT64> m_Acquired;
+		std::atomic<UINT64> m_Idle;
+
+		// Builds and swaps in a snapshot
+		//
+		void Store(const MessageTable<MessageStatus> &Table, UINT64 Acknowledged);
+
+		DisplayModel(const DisplayModel&);
+		DisplayModel& operator=(const DisplayModel&);
+
+	public:
+		// DisplayModel constructor
+		//
+		DisplayModel();
+
+		/// <summary>
+		/// Marks a row of the table as new or changed. Pipeline side
+		/// </summary>
+		void MarkChanged(int Row);
+
+		/// <summary>
+		/// Publishes the rows new or changed since the last snapshot acknowledged
+		/// by the display, if DISPLAY_PUBLISH_INTERVAL elapsed and there is
+		/// something new. Only the rows marked since are visited. Pipeline side
+		/// </summary>
+		/// <param name="Table">"Message table, its positions being the rows"</param>
+		/// <param name="Now">"Current time on the host clock, in nanoseconds"</param>
+		/// <returns>"true if a snapshot was published"</returns>
+		bool Publish(const MessageTable<MessageStatus> &Table, UINT64 Now);
+
+		/// <summary>
+		/// Records the last valid Xbow packet. Pipeline side
+		/// </summary>
+		void SetXbowPacket(const BYTE *Packet);
+
+		/// <summary>
+		/// Forgets every row, after the table was cleared, and publishes an
+		/// empty snapshot of a new generation at once. Pipeline side
+		/// </summary>
+		void Reset();
+
+		/// <summary>
+		/// Takes the latest snapshot. Display side
+		/// </summary>
+		/// <returns>"The snapshot, or NULL if none was published since the last acknowledged one"</returns>
+		std::shared_ptr<const DisplaySnapshot> Acquire();
+
+		/// <summary>
+		/// Tells that a snapshot was rendered, so the next ones only carry the
+		/// rows changed after it. Display side
+		/// </summary>
+		void Acknowledge(UINT64 Sequence);
+
+		// Exchange counters, safe from any thread
+		//
+		DisplayModelStats GetStatistics() const;
+};
+#endif
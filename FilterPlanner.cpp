@@ -0,0 +1,105 @@
+#include "FilterPlanner.h"
+
+#include <algorithm>
+
+FilterPlanner::FilterPlanner()
+{
+	m_RecordAll = false;
+}
+
+void FilterPlanner::Subscribe(DWORD FromID, DWORD ToID, TPCANMode Mode)
+{
+	std::vector<std::pair<DWORD, DWORD> > &ranges = (Mode == PCAN_MODE_EXTENDED) ? m_Extended : m_Standard;
+
+	if (FromID <= ToID)
+		ranges.push_back(std::make_pair(FromID, ToID));
+}
+
+void FilterPlanner::Clear()
+{
+	m_Standard.clear();
+	m_Extended.clear();
+}
+
+void FilterPlanner::SetRecordAll(bool Value)
+{
+	m_RecordAll = Value;
+}
+
+bool FilterPlanner::GetRecordAll() const
+{
+	return m_RecordAll;
+}
+
+void FilterPlanner::PlanMode(std::vector<std::pair<DWORD, DWORD> > subscribed, TPCANMode Mode, DWORD MaxRanges, std::vector<CANFilterRange> &Ranges)
+{
+	std::vector<CANFilterRange> runs;
+
+	// Overlapping and adjacent ranges collapse into one
+	//
+	std::sort(subscribed.begin(), subscribed.end());
+	for (size_t i = 0; i < subscribed.size(); i++)
+	{
+		if (!runs.empty() && (unsigned long long)runs.back().ToID + 1 >= subscribed[i].first)
+			runs.back().ToID = std::max(runs.back().ToID, subscribed[i].second);
+		else
+		{
+			CANFilterRange range = { subscribed[i].first, subscribed[i].second, Mode };
+			runs.push_back(range);
+		}
+	}
+
+	// Closes the smallest gaps until the source can hold the ranges
+	//
+	if (MaxRanges < 1)
+		MaxRanges = 1;
+	while (runs.size() > MaxRanges)
+	{
+		size_t smallest = 0;
+		for (size_t i = 1; i + 1 < runs.size(); i++)
+			if (runs[i + 1].FromID - runs[i].ToID < runs[smallest + 1].FromID - runs[smallest].ToID)
+				smallest = i;
+
+		runs[smallest].ToID = runs[smallest + 1].ToID;
+		runs.erase(runs.begin() + smallest + 1);
+	}
+
+	Ranges.insert(Ranges.end(), runs.begin(), runs.end());
+}
+
+std::vector<CANFilterRange> FilterPlanner::Plan(DWORD MaxRanges) const
+{
+	std::vector<CANFilterRange> ranges;
+
+	if (m_RecordAll)
+	{
+		CANFilterRange standard = { 0, 0x7FF, PCAN_MODE_STANDARD };
+		CANFilterRange extended = { 0, 0x1FFFFFFF, PCAN_MODE_EXTENDED };
+		ranges.push_back(standard);
+		ranges.push_back(extended);
+		return ranges;
+	}
+
+	PlanMode(m_Standard, PCAN_MODE_STANDARD, MaxRanges, ranges);
+	PlanMode(m_Extended, PCAN_MODE_EXTENDED, MaxRanges, ranges);
+
+	return ranges;
+}
+
+TPCANStatus FilterPlanner::Apply(CANSource *Source, std::vector<CANFilterRange> *Ranges) const
+{
+	std::vector<CANFilterRange> plan = Plan(Source->GetMaxFilterRanges());
+	TPCANStatus stsResult;
+
+	if (Ranges != NULL)
+		*Ranges = plan;
+
+	for (size_t i = 0; i < plan.size(); i++)
+	{
+		stsResult = Source->FilterMessages(plan[i].FromID, plan[i].ToID, plan[i].Mode);
+		if (stsResult != PCAN_ERROR_OK)
+			return stsResult;
+	}
+
+	return PCAN_ERROR_OK;
+}
@@ -0,0 +1,89 @@
+//  FilterPlanner.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Computes the reception filter of a CAN source from the IDs that the
+//  decoders and the recorder actually consume, so unrelated traffic is
+//  dropped by the hardware (or the kernel) instead of the host
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __FILTERPLANNERH_
+#define __FILTERPLANNERH_
+
+#include "CANSource.h"
+
+#include <utility>
+#include <vector>
+
+// A range of IDs as given to CANSource::FilterMessages
+//
+typedef struct tagCANFilterRange
+{
+	DWORD     FromID;  // The lowest CAN ID to be received
+	DWORD     ToID;    // The highest CAN ID to be received
+	TPCANMode Mode;    // Standard (11-bit) or Extended (29-bit) identifiers
+} CANFilterRange;
+
+// Reception filter planner
+//
+class FilterPlanner
+{
+	private:
+		// Subscribed ID ranges, per identifier length. They may overlap,
+		// the plan normalizes them
+		//
+		std::vector<std::pair<DWORD, DWORD> > m_Standard;
+		std::vector<std::pair<DWORD, DWORD> > m_Extended;
+
+		// Overrides the plan with fully opened filters
+		//
+		bool m_RecordAll;
+
+		// Appends the ranges of one identifier length, merged down to MaxRanges
+		//
+		static void PlanMode(std::vector<std::pair<DWORD, DWORD> > subscribed, TPCANMode Mode, DWORD MaxRanges, std::vector<CANFilterRange> &Ranges);
+
+	public:
+		// FilterPlanner constructor
+		//
+		FilterPlanner();
+
+		/// <summary>
+		/// Adds the IDs from FromID to ToID to the subscribed set
+		/// </summary>
+		void Subscribe(DWORD FromID, DWORD ToID, TPCANMode Mode);
+
+		/// <summary>
+		/// Removes all the subscribed IDs
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Makes the plan open the filters completely, so everything is recorded
+		/// </summary>
+		void SetRecordAll(bool Value);
+		bool GetRecordAll() const;
+
+		/// <summary>
+		/// Computes the smallest list of ranges covering exactly the subscribed
+		/// IDs. When a source cannot hold that many ranges, the ranges separated
+		/// by the smallest gaps are merged first, so the extra IDs let through
+		/// are as few as possible. The standard and the extended IDs are
+		/// planned apart, each within MaxRanges: the list holds up to twice
+		/// MaxRanges ranges when both are subscribed
+		/// </summary>
+		/// <param name="MaxRanges">"Maximum number of ranges per identifier length, as
+		/// given by CANSource::GetMaxFilterRanges"</param>
+		std::vector<CANFilterRange> Plan(DWORD MaxRanges) const;
+
+		/// <summary>
+		/// Configures the filter of a source, expected to be freshly opened,
+		/// with the plan computed for its range capacity
+		/// </summary>
+		/// <param name="Source">"The source to configure"</param>
+		/// <param name="Ranges">"Receives the ranges applied, may be NULL"</param>
+		/// <returns>"A TPCANStatus error code"</returns>
+		TPCANStatus Apply(CANSource *Source, std::vector<CANFilterRange> *Ranges = NULL) const;
+};
+#endif
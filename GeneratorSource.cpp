@@ -0,0 +1,182 @@
+﻿#include "GeneratorSource.h"
+
+GeneratorSource::GeneratorSource(TimestampService *clock, const TrafficConfig &Config, bool Paced)
+	: m_Generator(Config)
+{
+	m_Clock = clock;
+	m_Paced = Paced;
+	m_Open = false;
+	m_Start = 0;
+	m_FilterCustom = false;
+	m_FilterFrom[0] = m_FilterFrom[1] = 1;
+	m_FilterTo[0] = m_FilterTo[1] = 0;
+	m_WakePending = false;
+}
+
+TPCANStatus GeneratorSource::Initialize()
+{
+	std::lock_guard<std::mutex> lock(m_WaitMutex);
+
+	if (m_Open)
+		return PCAN_ERROR_HWINUSE;
+
+	m_Generator.Reset();
+	m_Start = m_Clock->Now();
+	m_Open = true;
+
+	return PCAN_ERROR_OK;
+}
+
+TPCANStatus GeneratorSource::Uninitialize()
+{
+	std::lock_guard<std::mutex> lock(m_WaitMutex);
+
+	m_Open = false;
+
+	return PCAN_ERROR_OK;
+}
+
+UINT64 GeneratorSource::GetTrafficTime() const
+{
+	if (!m_Paced)
+		return (UINT64)-1;
+
+	return (m_Clock->Now() - m_Start) / 1000;
+}
+
+TPCANStatus GeneratorSource::ReadBatch(TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count)
+{
+	std::lock_guard<std::mutex> lock(m_WaitMutex);
+	UINT64 until = GetTrafficTime();
+	DWORD dwRead = 0, dwGenerated;
+
+	*Count = 0;
+	if (!m_Open)
+		return PCAN_ERROR_INITIALIZE;
+
+	// Generates the frames due by now, dropping the ones
+	// the filter rejects
+	//
+	while (dwRead < MaxCount)
+	{
+		dwGenerated = m_Generator.GenerateCAN(until, &EntryBuffer[dwRead], MaxCount - dwRead);
+		if (dwGenerated == 0)
+		{
+			*Count = dwRead;
+			return PCAN_ERROR_QRCVEMPTY;
+		}
+
+		for (DWORD i = dwRead; i < dwRead + dwGenerated; i++)
+			if (IsAccepted(EntryBuffer[i].Msg))
+				EntryBuffer[(*Count)++] = EntryBuffer[i];
+		dwRead = *Count;
+	}
+
+	return PCAN_ERROR_OK;
+}
+
+TPCANStatus GeneratorSource::FilterMessages(DWORD FromID, DWORD ToID, TPCANMode Mode)
+{
+	std::lock_guard<std::mutex> lock(m_WaitMutex);
+	int i = (Mode == PCAN_MODE_EXTENDED) ? 1 : 0;
+
+	if (FromID > ToID)
+		return PCAN_ERROR_ILLPARAMVAL;
+
+	// As with the PCAN hardware, the filter is expanded with every call
+	//
+	if (!m_FilterCustom || m_FilterFrom[i] > m_FilterTo[i])
+	{
+		m_FilterFrom[i] = FromID;
+		m_FilterTo[i] = ToID;
+	}
+	else
+	{
+		m_FilterFrom[i] = FromID < m_FilterFrom[i] ? FromID : m_FilterFrom[i];
+		m_FilterTo[i] = ToID > m_FilterTo[i] ? ToID : m_FilterTo[i];
+	}
+	m_FilterCustom = true;
+
+	return PCAN_ERROR_OK;
+}
+
+DWORD GeneratorSource::GetMaxFilterRanges() const
+{
+	// One range per identifier length, the standard and the extended
+	// ones being filtered apart
+	//
+	return 1;
+}
+
+TPCANStatus GeneratorSource::WaitForMessages(DWORD Timeout)
+{
+	std::unique_lock<std::mutex> lock(m_WaitMutex);
+	UINT64 next, now, deadline;
+
+	// Sleeps until the next frame is due, in steps bounded by the timeout
+	//
+	deadline = m_Clock->Now() + (UINT64)Timeout * NS_PER_MS;
+	while (!m_WakePending)
+	{
+		next = m_Generator.GetNextCANTime();
+		if (m_Open && next != (UINT64)-1)
+		{
+			next = m_Paced ? m_Start + next * 1000 : 0;
+			now = m_Clock->Now();
+			if (now >= next)
+				return PCAN_ERROR_OK;
+		}
+		else
+		{
+			now = m_Clock->Now();
+			next = (UINT64)-1;
+		}
+
+		if (Timeout != CAN_WAIT_INFINITE)
+		{
+			if (now >= deadline)
+				return PCAN_ERROR_QRCVEMPTY;
+			if (next > deadline)
+				next = deadline;
+		}
+
+		if (next == (UINT64)-1)
+			m_WaitCondition.wait(lock);
+		else
+			m_WaitCondition.wait_for(lock, std::chrono::nanoseconds(next - now));
+	}
+	m_WakePending = false;
+
+	return PCAN_ERROR_QRCVEMPTY;
+}
+
+void GeneratorSource::CancelWait()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_WaitMutex);
+		m_WakePending = true;
+	}
+	m_WaitCondition.notify_all();
+}
+
+const char* GeneratorSource::GetName() const
+{
+	return "Traffic generator";
+}
+
+TrafficStats GeneratorSource::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_WaitMutex);
+
+	return m_Generator.GetStatistics();
+}
+
+bool GeneratorSource::IsAccepted(const TPCANMsgFD &msg) const
+{
+	int i = (msg.MSGTYPE & PCAN_MESSAGE_EXTENDED) ? 1 : 0;
+
+	if (!m_FilterCustom)
+		return true;
+
+	return msg.ID >= m_FilterFrom[i] && msg.ID <= m_FilterTo[i];
+}
@@ -0,0 +1,71 @@
+//  GeneratorSource.h
+//
+//  ~~~~~~~~~~~~
+//
+//  CAN source delivering the synthetic traffic of a TrafficGenerator,
+//  either paced by the host clock as a real bus would be or as fast
+//  as the reader takes it
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __GENERATORSOURCEH_
+#define __GENERATORSOURCEH_
+
+#include "CANSource.h"
+#include "TimestampService.h"
+#include "TrafficGenerator.h"
+
+#include <condition_variable>
+#include <mutex>
+
+// Synthetic traffic backed CAN source
+//
+class GeneratorSource : public CANSource
+{
+	private:
+		TimestampService *m_Clock;
+		TrafficGenerator m_Generator;
+		bool m_Paced;
+		bool m_Open;
+		UINT64 m_Start;
+
+		// Reception filter, fully opened until FilterMessages is called
+		//
+		bool m_FilterCustom;
+		DWORD m_FilterFrom[2];
+		DWORD m_FilterTo[2];
+
+		// Guards the generator and lets WaitForMessages sleep until
+		// the next frame is due
+		//
+		mutable std::mutex m_WaitMutex;
+		std::condition_variable m_WaitCondition;
+		bool m_WakePending;
+
+		// Checks an entry against the reception filter
+		//
+		bool IsAccepted(const TPCANMsgFD &msg) const;
+
+		// Gets the current time of the traffic, in microseconds
+		//
+		UINT64 GetTrafficTime() const;
+
+	public:
+		// GeneratorSource constructor. The clock is owned by the caller
+		//
+		GeneratorSource(TimestampService *clock, const TrafficConfig &Config, bool Paced = true);
+
+		TPCANStatus Initialize();
+		TPCANStatus Uninitialize();
+		TPCANStatus ReadBatch(TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count);
+		TPCANStatus FilterMessages(DWORD FromID, DWORD ToID, TPCANMode Mode);
+		DWORD GetMaxFilterRanges() const;
+		TPCANStatus WaitForMessages(DWORD Timeout);
+		void CancelWait();
+		const char* GetName() const;
+
+		// Gets the counters of the generated traffic
+		//
+		TrafficStats GetStatistics() const;
+};
+#endif
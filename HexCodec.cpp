@@ -0,0 +1,290 @@
+#include "HexCodec.h"
+#include "CPUFeatures.h"
+
+#ifdef CPU_X86
+#include <immintrin.h>
+#endif
+
+const char HexDigitPairs[256 * 2 + 1] =
+	"000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+	"202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+	"404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+	"606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+	"808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+	"A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+	"C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+	"E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+const signed char HexDigitValues[256] =
+{
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+// Digits of the nibbles
+//
+static const char HexDigits[] = "0123456789ABCDEF";
+
+static int g_HexEncodePath = GetCPUVectorPath();
+
+size_t HexEncode(const BYTE *Data, size_t Count, char *Text)
+{
+	for (size_t i = 0; i < Count; i++)
+		HexEncodeByte(Data[i], &Text[2 * i]);
+	Text[2 * Count] = '\0';
+
+	return 2 * Count;
+}
+
+static void EncodeSpacedScalar(const BYTE *Data, size_t First, size_t Count, char *Text)
+{
+	for (size_t i = First; i < Count; i++)
+	{
+		HexEncodeByte(Data[i], &Text[3 * i]);
+		Text[3 * i + 2] = ' ';
+	}
+}
+
+#ifdef CPU_X86
+// Of 16 bytes, the one whose high digit, or low digit, goes to each of
+// the 48 characters "XX XX ..", 16 at a time; -1 if none does
+//
+static const signed char SpacedHigh[3][16] =
+{
+	{  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1,  5 },
+	{ -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10, -1 },
+	{ -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1 }
+};
+
+static const signed char SpacedLow[3][16] =
+{
+	{ -1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1 },
+	{  5, -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10 },
+	{ -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1 }
+};
+
+static const signed char SpacedBlank[3][16] =
+{
+	{  0,  0, 32,  0,  0, 32,  0,  0, 32,  0,  0, 32,  0,  0, 32,  0 },
+	{  0, 32,  0,  0, 32,  0,  0, 32,  0,  0, 32,  0,  0, 32,  0,  0 },
+	{ 32,  0,  0, 32,  0,  0, 32,  0,  0, 32,  0,  0, 32,  0,  0, 32 }
+};
+
+CPU_TARGET_SSSE3
+static void EncodeSpacedSSSE3(const BYTE *Data, size_t Count, char *Text)
+{
+	__m128i digits = _mm_loadu_si128((const __m128i*)HexDigits);
+	__m128i mask = _mm_set1_epi8(0x0F);
+	__m128i value, high, low;
+	size_t i;
+
+	// 16 bytes to 48 characters at a time. The digit of each nibble is
+	// looked up by a shuffle, then put in place by two more
+	//
+	for (i = 0; i + 16 <= Count; i += 16)
+	{
+		value = _mm_loadu_si128((const __m128i*)&Data[i]);
+		high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(value, 4), mask));
+		low = _mm_shuffle_epi8(digits, _mm_and_si128(value, mask));
+		for (int j = 0; j < 3; j++)
+		{
+			value = _mm_or_si128(
+				_mm_shuffle_epi8(high, _mm_loadu_si128((const __m128i*)SpacedHigh[j])),
+				_mm_shuffle_epi8(low, _mm_loadu_si128((const __m128i*)SpacedLow[j])));
+			value = _mm_or_si128(value, _mm_loadu_si128((const __m128i*)SpacedBlank[j]));
+			_mm_storeu_si128((__m128i*)&Text[3 * i + 16 * j], value);
+		}
+	}
+	EncodeSpacedScalar(Data, i, Count, Text);
+}
+
+CPU_TARGET_AVX2
+static void EncodeSpacedAVX2(const BYTE *Data, size_t Count, char *Text)
+{
+	__m256i digits = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)HexDigits));
+	__m256i mask = _mm256_set1_epi8(0x0F);
+	__m256i value, high, low, orderHigh[3], orderLow[3], blank[3];
+	size_t i;
+
+	for (int j = 0; j < 3; j++)
+	{
+		orderHigh[j] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)SpacedHigh[j]));
+		orderLow[j] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)SpacedLow[j]));
+		blank[j] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)SpacedBlank[j]));
+	}
+
+	// 32 bytes to 96 characters at a time. The shuffles stay within the
+	// 128-bit halves, so each half gives 16 characters of its own 48
+	//
+	for (i = 0; i + 32 <= Count; i += 32)
+	{
+		value = _mm256_loadu_si256((const __m256i*)&Data[i]);
+		high = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(value, 4), mask));
+		low = _mm256_shuffle_epi8(digits, _mm256_and_si256(value, mask));
+		for (int j = 0; j < 3; j++)
+		{
+			value = _mm256_or_si256(_mm256_shuffle_epi8(high, orderHigh[j]), _mm256_shuffle_epi8(low, orderLow[j]));
+			value = _mm256_or_si256(value, blank[j]);
+			_mm_storeu_si128((__m128i*)&Text[3 * i + 16 * j], _mm256_castsi256_si128(value));
+			_mm_storeu_si128((__m128i*)&Text[3 * i + 48 + 16 * j], _mm256_extracti128_si256(value, 1));
+		}
+	}
+
+	// 16 bytes more with the low halves, still encoded for AVX so as not
+	// to mix with the SSE encoding
+	//
+	if (i + 16 <= Count)
+	{
+		__m128i value128 = _mm_loadu_si128((const __m128i*)&Data[i]);
+		__m128i high128 = _mm_shuffle_epi8(_mm256_castsi256_si128(digits), _mm_and_si128(_mm_srli_epi16(value128, 4), _mm256_castsi256_si128(mask)));
+		__m128i low128 = _mm_shuffle_epi8(_mm256_castsi256_si128(digits), _mm_and_si128(value128, _mm256_castsi256_si128(mask)));
+
+		for (int j = 0; j < 3; j++)
+		{
+			value128 = _mm_or_si128(
+				_mm_shuffle_epi8(high128, _mm256_castsi256_si128(orderHigh[j])),
+				_mm_shuffle_epi8(low128, _mm256_castsi256_si128(orderLow[j])));
+			value128 = _mm_or_si128(value128, _mm256_castsi256_si128(blank[j]));
+			_mm_storeu_si128((__m128i*)&Text[3 * i + 16 * j], value128);
+		}
+		i += 16;
+	}
+	EncodeSpacedScalar(Data, i, Count, Text);
+}
+#endif
+
+size_t HexEncodeSpaced(const BYTE *Data, size_t Count, char *Text)
+{
+	if (Count == 0)
+	{
+		Text[0] = '\0';
+		return 0;
+	}
+
+	// The short buffers, as the data of a frame, do not fill a vector
+	//
+	switch ((Count < 16) ? CPU_VECTOR_SCALAR : g_HexEncodePath)
+	{
+#ifdef CPU_X86
+	case CPU_VECTOR_AVX2:
+		EncodeSpacedAVX2(Data, Count, Text);
+		break;
+	case CPU_VECTOR_SSSE3:
+		EncodeSpacedSSSE3(Data, Count, Text);
+		break;
+#endif
+	default:
+		EncodeSpacedScalar(Data, 0, Count, Text);
+		break;
+	}
+
+	// The space after the last byte ends the text
+	//
+	Text[3 * Count - 1] = '\0';
+
+	return 3 * Count - 1;
+}
+
+size_t HexEncodeValue(DWORD Value, int Digits, char *Text)
+{
+	int length = 1;
+
+	while (length < 8 && (Value >> (4 * length)) != 0)
+		length++;
+	if (length < Digits)
+		length = Digits;
+
+	Text[length] = '\0';
+	for (int i = length - 1; i >= 0; i--)
+	{
+		Text[i] = HexDigits[Value & 0x0F];
+		Value >>= 4;
+	}
+
+	return length;
+}
+
+int HexDecodeValue(const char *Text, size_t Length, DWORD *Value)
+{
+	DWORD result = 0;
+	int digit;
+
+	if (Length == 0)
+		return HEX_ERROR_EMPTY;
+	if (Length > 8)
+		return HEX_ERROR_RANGE;
+
+	for (size_t i = 0; i < Length; i++)
+	{
+		digit = HexDigitValues[(BYTE)Text[i]];
+		if (digit < 0)
+			return HEX_ERROR_DIGIT;
+		result = (result << 4) | (DWORD)digit;
+	}
+	*Value = result;
+
+	return HEX_OK;
+}
+
+int HexDecodeBytes(const char *Text, size_t Length, BYTE *Data, size_t Size, size_t *Count)
+{
+	size_t i = 0, count = 0;
+	int high, low, result = HEX_OK;
+
+	while (i < Length)
+	{
+		if (Text[i] == ' ')
+		{
+			i++;
+			continue;
+		}
+
+		high = HexDigitValues[(BYTE)Text[i]];
+		low = (i + 1 < Length) ? HexDigitValues[(BYTE)Text[i + 1]] : -1;
+		if (high < 0)
+			result = HEX_ERROR_DIGIT;
+		else if (i + 1 >= Length || Text[i + 1] == ' ')
+			result = HEX_ERROR_PAIR;
+		else if (low < 0)
+			result = HEX_ERROR_DIGIT;
+		else if (count == Size)
+			result = HEX_ERROR_RANGE;
+		if (result != HEX_OK)
+			break;
+
+		Data[count++] = (BYTE)((high << 4) | low);
+		i += 2;
+	}
+
+	*Count = count;
+	if (result == HEX_OK && count == 0)
+		result = HEX_ERROR_EMPTY;
+
+	return result;
+}
+
+void SetHexEncodePath(int Path)
+{
+	g_HexEncodePath = (Path < GetCPUVectorPath()) ? Path : GetCPUVectorPath();
+	if (g_HexEncodePath < CPU_VECTOR_SCALAR)
+		g_HexEncodePath = CPU_VECTOR_SCALAR;
+}
+
+int GetHexEncodePath()
+{
+	return g_HexEncodePath;
+}
@@ -0,0 +1,99 @@
+//  HexCodec.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Hexadecimal text of values and data bytes, in upper case. The digits
+//  come from lookup tables, and long buffers are written in the spaced
+//  form "XX XX" with SSSE3 or AVX2 shuffles when the processor has them.
+//  The decoding is strict: any character other than the ones expected is
+//  reported, instead of giving a partial or a zero value
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __HEXCODECH_
+#define __HEXCODECH_
+
+#include "CANTypes.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// Results of the decoding
+//
+#define HEX_OK					0
+#define HEX_ERROR_EMPTY			1     // No digit
+#define HEX_ERROR_DIGIT			2     // Character other than a digit or a separator
+#define HEX_ERROR_RANGE			3     // More digits than the value or the buffer holds
+#define HEX_ERROR_PAIR			4     // Byte given with a single digit
+
+// Two digits of each byte value, "000102..FF"
+//
+extern const char HexDigitPairs[256 * 2 + 1];
+
+// Value of each character as a digit, -1 if it is not one
+//
+extern const signed char HexDigitValues[256];
+
+// Writes the two digits of a byte, returning the position after them
+//
+inline char* HexEncodeByte(BYTE Value, char *Text)
+{
+	memcpy(Text, &HexDigitPairs[Value * 2], 2);
+	return Text + 2;
+}
+
+/// <summary>
+/// Writes data bytes as digits without separators, "0102"
+/// </summary>
+/// <param name="Data">"Bytes to write"</param>
+/// <param name="Count">"Number of bytes"</param>
+/// <param name="Text">"Buffer of 2 * Count + 1 characters"</param>
+/// <returns>"The number of characters written, without the terminating null"</returns>
+size_t HexEncode(const BYTE *Data, size_t Count, char *Text);
+
+/// <summary>
+/// Writes data bytes separated by spaces, "01 02"
+/// </summary>
+/// <param name="Data">"Bytes to write"</param>
+/// <param name="Count">"Number of bytes"</param>
+/// <param name="Text">"Buffer of 3 * Count characters, 1 if there is no byte"</param>
+/// <returns>"The number of characters written, without the terminating null"</returns>
+size_t HexEncodeSpaced(const BYTE *Data, size_t Count, char *Text);
+
+/// <summary>
+/// Writes a value with at least a number of digits, as "%0*X" does
+/// </summary>
+/// <param name="Value">"Value to write"</param>
+/// <param name="Digits">"Minimum number of digits, zeros added in front"</param>
+/// <param name="Text">"Buffer of 9 characters, or Digits + 1 if more"</param>
+/// <returns>"The number of characters written, without the terminating null"</returns>
+size_t HexEncodeValue(DWORD Value, int Digits, char *Text);
+
+/// <summary>
+/// Reads a value of up to 8 digits, without prefix or separators
+/// </summary>
+/// <param name="Text">"Digits, upper or lower case"</param>
+/// <param name="Length">"Number of characters"</param>
+/// <param name="Value">"Value read, left unchanged on error"</param>
+/// <returns>"HEX_OK or the error found"</returns>
+int HexDecodeValue(const char *Text, size_t Length, DWORD *Value);
+
+/// <summary>
+/// Reads data bytes given as pairs of digits, with or without spaces
+/// between the pairs
+/// </summary>
+/// <param name="Text">"Pairs of digits"</param>
+/// <param name="Length">"Number of characters"</param>
+/// <param name="Data">"Bytes read"</param>
+/// <param name="Size">"Number of bytes Data holds"</param>
+/// <param name="Count">"Number of bytes read, up to the error if any"</param>
+/// <returns>"HEX_OK or the error found"</returns>
+int HexDecodeBytes(const char *Text, size_t Length, BYTE *Data, size_t Size, size_t *Count);
+
+/// <summary>
+/// Chooses the path of HexEncodeSpaced, limited to the supported one.
+/// The fastest one is used by default
+/// </summary>
+void SetHexEncodePath(int Path);
+int GetHexEncodePath();
+#endif
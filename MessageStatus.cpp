@@ -0,0 +1,141 @@
+﻿#include "MessageStatus.h"
+#include "HexCodec.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Copies a text into a buffer, truncating it if needed. Returns the
+// length copied
+//
+static size_t AppendText(char *Buffer, size_t Size, size_t Length, const char *Text)
+{
+	while (*Text && Length + 1 < Size)
+		Buffer[Length++] = *Text++;
+	if (Size > 0)
+		Buffer[Length] = '\0';
+
+	return Length;
+}
+
+// Copies the data of a message. The 8 bytes of a standard message are
+// copied as a whole, which is much cheaper than a copy of a variable
+// length; the ones past its length are not used
+//
+static inline void CopyData(BYTE *Data, const CANFrameView &canMsg)
+{
+	if (canMsg.LEN <= 8)
+		memcpy(Data, canMsg.DATA, 8);
+	else
+		memcpy(Data, canMsg.DATA, canMsg.LEN);
+}
+
+MessageStatus::MessageStatus(const CANFrameView &canMsg, TPCANTimestampFD canTimestamp, int listIndex)
+{
+	m_ID = canMsg.ID;
+	m_MsgType = canMsg.MSGTYPE;
+	m_Length = canMsg.LEN;
+	CopyData(m_Data, canMsg);
+	m_TimeStamp = canTimestamp;
+	m_oldTimeStamp = canTimestamp;
+	m_iIndex = listIndex;
+	m_Count = 1;
+	m_bShowPeriod = true;
+}
+
+void MessageStatus::Update(const CANFrameView &canMsg, TPCANTimestampFD canTimestamp)
+{
+	// ID and type are the same, only the payload may change
+	//
+	m_Length = canMsg.LEN;
+	CopyData(m_Data, canMsg);
+	m_oldTimeStamp = m_TimeStamp;
+	m_TimeStamp = canTimestamp;
+	m_Count += 1;
+}
+
+bool MessageStatus::SetShowingPeriod(bool value)
+{
+	if (m_bShowPeriod == value)
+		return false;
+
+	m_bShowPeriod = value;
+	return true;
+}
+
+size_t MessageStatus::FormatType(char *Buffer, size_t Size) const
+{
+	size_t length = 0;
+
+	if ((m_MsgType & PCAN_MESSAGE_STATUS) != 0)
+		return AppendText(Buffer, Size, length, "STATUS");
+
+	length = AppendText(Buffer, Size, length, ((m_MsgType & PCAN_MESSAGE_EXTENDED) != 0) ? "EXT" : "STD");
+
+	if ((m_MsgType & PCAN_MESSAGE_RTR) == PCAN_MESSAGE_RTR)
+		length = AppendText(Buffer, Size, length, "/RTR");
+	else if (m_MsgType > PCAN_MESSAGE_EXTENDED)
+	{
+		length = AppendText(Buffer, Size, length, " [ ");
+		if (m_MsgType & PCAN_MESSAGE_FD)
+			length = AppendText(Buffer, Size, length, " FD");
+		if (m_MsgType & PCAN_MESSAGE_BRS)
+			length = AppendText(Buffer, Size, length, " BRS");
+		if (m_MsgType & PCAN_MESSAGE_ESI)
+			length = AppendText(Buffer, Size, length, " ESI");
+		length = AppendText(Buffer, Size, length, " ]");
+	}
+
+	return length;
+}
+
+size_t MessageStatus::FormatID(char *Buffer, size_t Size) const
+{
+	int length;
+
+	if ((m_MsgType & PCAN_MESSAGE_EXTENDED) != 0)
+		length = snprintf(Buffer, Size, "%08Xh", (unsigned)m_ID);
+	else
+		length = snprintf(Buffer, Size, "%03Xh", (unsigned)m_ID);
+
+	if (length < 0 || Size == 0)
+		return 0;
+	return ((size_t)length < Size) ? (size_t)length : Size - 1;
+}
+
+size_t MessageStatus::FormatData(char *Buffer, size_t Size) const
+{
+	size_t count = m_Length;
+
+	if ((m_MsgType & PCAN_MESSAGE_RTR) == PCAN_MESSAGE_RTR)
+		return AppendText(Buffer, Size, 0, "Remote Request");
+
+	// Written in place, 3 characters per byte, the bytes that do not fit
+	// being left out
+	//
+	if (Size < 3 * count + 1)
+		count = (Size > 0) ? (Size - 1) / 3 : 0;
+	if (count == 0)
+	{
+		if (Size > 0)
+			Buffer[0] = '\0';
+		return 0;
+	}
+
+	Buffer[0] = ' ';
+	return 1 + HexEncodeSpaced(m_Data, count, &Buffer[1]);
+}
+
+size_t MessageStatus::FormatTime(char *Buffer, size_t Size) const
+{
+	double fTime;
+	int length;
+
+	fTime = (m_TimeStamp / 1000.0);
+	if (m_bShowPeriod)
+		fTime -= (m_oldTimeStamp / 1000.0);
+	length = snprintf(Buffer, Size, "%.1f", fTime);
+
+	if (length < 0 || Size == 0)
+		return 0;
+	return ((size_t)length < Size) ? (size_t)length : Size - 1;
+}
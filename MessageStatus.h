@@ -0,0 +1,93 @@
+//  MessageStatus.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Last status of a received message, as shown in the message list. The
+//  record only keeps the raw fields of the message, so it is trivially
+//  copyable and recording a frame allocates nothing. Its text is rendered
+//  on request, into a buffer given by the caller
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __MESSAGESTATUSH_
+#define __MESSAGESTATUSH_
+
+#include "CANTypes.h"
+
+#include <stddef.h>
+
+// Buffer sizes, terminating zero included, fitting any text rendered
+// by MessageStatus
+//
+#define MSG_TYPE_TEXT_SIZE		24
+#define MSG_ID_TEXT_SIZE		12
+#define MSG_DATA_TEXT_SIZE		(64 * 3 + 1)
+#define MSG_TIME_TEXT_SIZE		32
+
+// Message Status record used to show CAN Messages in a ListView
+//
+class MessageStatus
+{
+	private:
+		// Only the bytes given by the DLC are kept from the message
+		//
+		TPCANTimestampFD m_TimeStamp;
+		TPCANTimestampFD m_oldTimeStamp;
+		DWORD m_ID;
+		int m_iIndex;
+		int m_Count;
+		TPCANMessageType m_MsgType;
+		BYTE m_Length;
+		bool m_bShowPeriod;
+		BYTE m_Data[64];
+
+	public:
+		MessageStatus(const CANFrameView &canMsg, TPCANTimestampFD canTimestamp, int listIndex);
+		void Update(const CANFrameView &canMsg, TPCANTimestampFD canTimestamp);
+
+		DWORD GetID() const { return m_ID; }
+		TPCANMessageType GetMsgType() const { return m_MsgType; }
+		int GetLength() const { return m_Length; }
+		const BYTE* GetData() const { return m_Data; }
+		TPCANTimestampFD GetTimestamp() const { return m_TimeStamp; }
+		int GetPosition() const { return m_iIndex; }
+		int GetCount() const { return m_Count; }
+		bool GetShowingPeriod() const { return m_bShowPeriod; }
+
+		// Returns true if the display mode changed
+		//
+		bool SetShowingPeriod(bool value);
+
+		/// <summary>
+		/// Renders the type of the message ("STD", "EXT/RTR", "STD [  FD BRS ]"...)
+		/// </summary>
+		/// <param name="Buffer">"Buffer for the text, MSG_TYPE_TEXT_SIZE is enough"</param>
+		/// <param name="Size">"Size of Buffer"</param>
+		/// <returns>"The length of the text"</returns>
+		size_t FormatType(char *Buffer, size_t Size) const;
+
+		/// <summary>
+		/// Renders the ID in hexadecimal followed by 'h', on 3 or 8 digits
+		/// </summary>
+		/// <param name="Buffer">"Buffer for the text, MSG_ID_TEXT_SIZE is enough"</param>
+		/// <param name="Size">"Size of Buffer"</param>
+		/// <returns>"The length of the text"</returns>
+		size_t FormatID(char *Buffer, size_t Size) const;
+
+		/// <summary>
+		/// Renders the data as " XX" per byte, or "Remote Request"
+		/// </summary>
+		/// <param name="Buffer">"Buffer for the text, MSG_DATA_TEXT_SIZE is enough"</param>
+		/// <param name="Size">"Size of Buffer"</param>
+		/// <returns>"The length of the text"</returns>
+		size_t FormatData(char *Buffer, size_t Size) const;
+
+		/// <summary>
+		/// Renders the period or the timestamp of the message in milliseconds
+		/// </summary>
+		/// <param name="Buffer">"Buffer for the text, MSG_TIME_TEXT_SIZE is enough"</param>
+		/// <param name="Size">"Size of Buffer"</param>
+		/// <returns>"The length of the text"</returns>
+		size_t FormatTime(char *Buffer, size_t Size) const;
+};
+#endif
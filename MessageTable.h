@@ -0,0 +1,221 @@
+//  MessageTable.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Table of the last status of every received message, keyed by CAN ID
+//  and message type. The entries are kept by value in one contiguous
+//  array, in the order they were first received. Standard IDs are found
+//  through a table indexed by the ID itself, the others through an
+//  open-addressing hash, so a lookup costs the same with 5 or 2000
+//  distinct IDs on the bus
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __MESSAGETABLEH_
+#define __MESSAGETABLEH_
+
+#include "CANTypes.h"
+
+#include <vector>
+
+// Number of 11-bit identifiers, the size of the direct index
+//
+#define MSG_TABLE_STANDARD_IDS	0x800
+
+// Initial number of slots of the hash of the other identifiers. It is
+// a power of two and is doubled whenever it gets half full
+//
+#define MSG_TABLE_HASH_SIZE		64
+
+// Marks an unused slot of the indexes
+//
+#define MSG_TABLE_NONE			(-1)
+
+// Message table, T being the status kept for each message
+//
+template <class T>
+class MessageTable
+{
+	private:
+		// Key of an entry and the next entry sharing its standard ID
+		//
+		typedef struct tagEntryKey
+		{
+			DWORD ID;
+			TPCANMessageType MsgType;
+			int Next;
+		} EntryKey;
+
+		// Entries and their keys, in reception order
+		//
+		std::vector<T> m_Entries;
+		std::vector<EntryKey> m_Keys;
+
+		// First entry of each standard ID. The few messages using the
+		// same ID with another type (RTR, FD) are chained from it
+		//
+		std::vector<int> m_Standard;
+
+		// Open-addressing hash, linearly probed, of the other entries
+		//
+		std::vector<int> m_Hash;
+		DWORD m_HashCount;
+
+		// Standard IDs go to the direct index. Status messages and any
+		// out of range ID go to the hash with the extended ones
+		//
+		static bool IsStandard(DWORD ID, TPCANMessageType MsgType)
+		{
+			return (MsgType & (PCAN_MESSAGE_EXTENDED | PCAN_MESSAGE_STATUS)) == 0 && ID < MSG_TABLE_STANDARD_IDS;
+		}
+
+		// Spreads the key over the hash slots
+		//
+		static DWORD Hash(DWORD ID, TPCANMessageType MsgType)
+		{
+			DWORD value = (ID ^ ((DWORD)MsgType << 29)) * 0x9E3779B1UL;
+
+			return value ^ (value >> 15);
+		}
+
+		// Gets the hash slot holding a key, or the free slot where it
+		// would go
+		//
+		DWORD FindSlot(DWORD ID, TPCANMessageType MsgType) const
+		{
+			DWORD mask = (DWORD)m_Hash.size() - 1;
+			DWORD slot = Hash(ID, MsgType) & mask;
+
+			while (m_Hash[slot] != MSG_TABLE_NONE)
+			{
+				const EntryKey &key = m_Keys[m_Hash[slot]];
+				if (key.ID == ID && key.MsgType == MsgType)
+					break;
+				slot = (slot + 1) & mask;
+			}
+
+			return slot;
+		}
+
+		// Doubles the hash and places the entries again
+		//
+		void GrowHash()
+		{
+			std::vector<int> old;
+
+			old.swap(m_Hash);
+			m_Hash.assign(old.size() * 2, MSG_TABLE_NONE);
+			for (size_t i = 0; i < old.size(); i++)
+				if (old[i] != MSG_TABLE_NONE)
+					m_Hash[FindSlot(m_Keys[old[i]].ID, m_Keys[old[i]].MsgType)] = old[i];
+		}
+
+	public:
+		// MessageTable constructor
+		//
+		MessageTable()
+			: m_Standard(MSG_TABLE_STANDARD_IDS, MSG_TABLE_NONE), m_Hash(MSG_TABLE_HASH_SIZE, MSG_TABLE_NONE)
+		{
+			m_HashCount = 0;
+		}
+
+		/// <summary>
+		/// Gets the position of a message in the table
+		/// </summary>
+		/// <param name="ID">"CAN ID of the message"</param>
+		/// <param name="MsgType">"Type of the message"</param>
+		/// <returns>"The index of its entry, or MSG_TABLE_NONE if it was never added"</returns>
+		int Find(DWORD ID, TPCANMessageType MsgType) const
+		{
+			int index;
+
+			if (IsStandard(ID, MsgType))
+			{
+				for (index = m_Standard[ID]; index != MSG_TABLE_NONE; index = m_Keys[index].Next)
+					if (m_Keys[index].MsgType == MsgType)
+						break;
+				return index;
+			}
+
+			return m_Hash[FindSlot(ID, MsgType)];
+		}
+
+		/// <summary>
+		/// Appends the entry of a message not yet in the table. References
+		/// to the entries are only valid until the next call
+		/// </summary>
+		/// <param name="ID">"CAN ID of the message"</param>
+		/// <param name="MsgType">"Type of the message"</param>
+		/// <param name="Entry">"Its status"</param>
+		/// <returns>"The index of the new entry"</returns>
+		int Add(DWORD ID, TPCANMessageType MsgType, const T &Entry)
+		{
+			int index = (int)m_Entries.size();
+			EntryKey key;
+
+			key.ID = ID;
+			key.MsgType = MsgType;
+			key.Next = MSG_TABLE_NONE;
+
+			if (IsStandard(ID, MsgType))
+			{
+				// Appended to the chain of its ID
+				//
+				int *link = &m_Standard[ID];
+				while (*link != MSG_TABLE_NONE)
+					link = &m_Keys[*link].Next;
+				*link = index;
+			}
+			else
+			{
+				if ((m_HashCount + 1) * 2 > m_Hash.size())
+					GrowHash();
+				m_Hash[FindSlot(ID, MsgType)] = index;
+				m_HashCount++;
+			}
+
+			m_Keys.push_back(key);
+			m_Entries.push_back(Entry);
+
+			return index;
+		}
+
+		/// <summary>
+		/// Removes all the entries
+		/// </summary>
+		void Clear()
+		{
+			m_Entries.clear();
+			m_Keys.clear();
+			m_Standard.assign(MSG_TABLE_STANDARD_IDS, MSG_TABLE_NONE);
+			m_Hash.assign(MSG_TABLE_HASH_SIZE, MSG_TABLE_NONE);
+			m_HashCount = 0;
+		}
+
+		/// <summary>
+		/// Preallocates the storage of a number of entries
+		/// </summary>
+		void Reserve(int Count)
+		{
+			m_Entries.reserve(Count);
+			m_Keys.reserve(Count);
+		}
+
+		int GetCount() const
+		{
+			return (int)m_Entries.size();
+		}
+
+		// Entries by index, in reception order
+		//
+		T& operator[](int Index)
+		{
+			return m_Entries[Index];
+		}
+
+		const T& operator[](int Index) const
+		{
+			return m_Entries[Index];
+		}
+};
+#endif
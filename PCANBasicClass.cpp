@@ -195,6 +195,60 @@ TPCANStatus PCANBasicClass::ReadFD(
 	return (TPCANStatus)m_pReadFD(Channel, MessageBuffer, TimestampBuffer);  
 }
 
+TPCANStatus PCANBasicClass::ReadBatch(
+	TPCANHandle Channel, 
+	TPCANMsgEntry* EntryBuffer, 
+	DWORD MaxCount, 
+	DWORD* Count)
+{
+	TPCANStatus stsResult = PCAN_ERROR_OK;
+	DWORD dwRead = 0;
+
+	*Count = 0;
+	if(!m_bWasLoaded)
+		return PCAN_ERROR_UNKNOWN;
+
+	// Drains the queue into the caller's buffer, one entry per message
+	//
+	while(dwRead < MaxCount)
+	{
+		stsResult = (TPCANStatus)m_pRead(Channel, &EntryBuffer[dwRead].Msg, &EntryBuffer[dwRead].Timestamp);
+		if(stsResult != PCAN_ERROR_OK)
+			break;
+		dwRead++;
+	}
+
+	*Count = dwRead;
+	return stsResult;
+}
+
+TPCANStatus PCANBasicClass::ReadBatchFD(
+	TPCANHandle Channel, 
+	TPCANMsgFDEntry* EntryBuffer, 
+	DWORD MaxCount, 
+	DWORD* Count)
+{
+	TPCANStatus stsResult = PCAN_ERROR_OK;
+	DWORD dwRead = 0;
+
+	*Count = 0;
+	if(!m_bWasLoaded)
+		return PCAN_ERROR_UNKNOWN;
+
+	// Drains the queue into the caller's buffer, one entry per message
+	//
+	while(dwRead < MaxCount)
+	{
+		stsResult = (TPCANStatus)m_pReadFD(Channel, &EntryBuffer[dwRead].Msg, &EntryBuffer[dwRead].Timestamp);
+		if(stsResult != PCAN_ERROR_OK)
+			break;
+		dwRead++;
+	}
+
+	*Count = dwRead;
+	return stsResult;
+}
+
 TPCANStatus PCANBasicClass::Write(
         TPCANHandle Channel, 
         TPCANMsg* MessageBuffer)
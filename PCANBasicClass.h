@@ -19,11 +19,9 @@
 #ifndef __PCANBASICCLASSH_
 #define __PCANBASICCLASSH_
 
-// Inclusion of the PCANBasic.h header file
+// Inclusion of the portable PCAN-Basic types
 //
-#ifndef __PCANBASICH__
-#include "PCANBasic.h"
-#endif
+#include "CANTypes.h"
 
 // Function pointers
 //
@@ -176,6 +174,32 @@ class PCANBasicClass
 		/// <returns>"A TPCANStatus error code"</returns>
 		TPCANStatus ReadFD(TPCANHandle Channel, TPCANMsgFD* MessageBuffer, TPCANTimestampFD *TimestampBuffer);
 
+		/// <summary>
+		/// Reads CAN messages from the receive queue of a PCAN Channel until
+		/// the queue is empty or the given buffer is full
+		/// </summary>
+		/// <param name="Channel">"The handle of a PCAN Channel"</param>
+		/// <param name="EntryBuffer">"A preallocated TPCANMsgEntry array to store 
+		/// the CAN messages and their reception time"</param>
+		/// <param name="MaxCount">"The number of entries available in EntryBuffer"</param>
+		/// <param name="Count">"Receives the number of entries stored in EntryBuffer"</param>
+		/// <returns>"The TPCANStatus error code of the last read. PCAN_ERROR_QRCVEMPTY 
+		/// when the queue was drained, PCAN_ERROR_OK when the buffer was filled first"</returns>
+		TPCANStatus ReadBatch(TPCANHandle Channel, TPCANMsgEntry* EntryBuffer, DWORD MaxCount, DWORD* Count);
+
+		/// <summary>
+		/// Reads CAN messages from the receive queue of a FD capable PCAN Channel 
+		/// until the queue is empty or the given buffer is full
+		/// </summary>
+		/// <param name="Channel">"The handle of a FD capable PCAN Channel"</param>
+		/// <param name="EntryBuffer">"A preallocated TPCANMsgFDEntry array to store 
+		/// the CAN messages and their reception time"</param>
+		/// <param name="MaxCount">"The number of entries available in EntryBuffer"</param>
+		/// <param name="Count">"Receives the number of entries stored in EntryBuffer"</param>
+		/// <returns>"The TPCANStatus error code of the last read. PCAN_ERROR_QRCVEMPTY 
+		/// when the queue was drained, PCAN_ERROR_OK when the buffer was filled first"</returns>
+		TPCANStatus ReadBatchFD(TPCANHandle Channel, TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count);
+
 		/// <summary>
 		/// Transmits a CAN message 
 		/// </summary>
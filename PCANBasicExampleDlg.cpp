@@ -99,181 +99,6 @@ int clsCritical::GetRecursionCount()
 }
 #pragma endregion
 
-/// <summary>
-/// Convert a CAN DLC value into the actual data length of the CAN/CAN-FD frame.
-/// </summary>
-/// <param name="dlc">A value between 0 and 15 (CAN and FD DLC range)</param>
-/// <param name="isSTD">A value indicating if the msg is a standard CAN (FD Flag not checked)</param>
-/// <returns>The length represented by the DLC</returns>
-static int GetLengthFromDLC(int dlc, bool isSTD)
-{
-    if (dlc <= 8)
-        return dlc;
-
-     if (isSTD)
-        return 8;
-
-     switch (dlc)
-     {
-        case 9: return 12;
-        case 10: return 16;
-        case 11: return 20;
-        case 12: return 24;
-        case 13: return 32;
-        case 14: return 48;
-        case 15: return 64;
-        default: return dlc;
-    }
-}
-
-
-//////////////////////////////////////////////////////////////////////////////////////////////
-// MessageStatus class
-//
-#pragma region Message Status class
-MessageStatus::MessageStatus(TPCANMsgFD canMsg, TPCANTimestampFD canTimestamp, int listIndex)
-{
-    m_Msg = canMsg;
-    m_TimeStamp = canTimestamp;
-    m_oldTimeStamp = canTimestamp;
-    m_iIndex = listIndex;
-    m_Count = 1;
-    m_bShowPeriod = true;
-	m_bWasChanged = false;
-}
-
-void MessageStatus::Update(TPCANMsgFD canMsg, TPCANTimestampFD canTimestamp)
-{
-    m_Msg = canMsg;
-    m_oldTimeStamp = m_TimeStamp;
-    m_TimeStamp = canTimestamp;
-    m_bWasChanged = true;
-    m_Count += 1;
-}
-
-TPCANMsgFD MessageStatus::GetCANMsg()
-{
-	return m_Msg;
-}
-
-TPCANTimestampFD MessageStatus::GetTimestamp()
-{
-	return m_TimeStamp;
-}
-
-int MessageStatus::GetPosition()
-{
-	return m_iIndex;
-}
-
-CString MessageStatus::GetTypeString()
-{
-	CString strTemp;
-
-	// Add the new ListView Item with the type of the message
-	//
-    if ((m_Msg.MSGTYPE & PCAN_MESSAGE_STATUS) != 0)
-        return "STATUS";
-
-	if((m_Msg.MSGTYPE & PCAN_MESSAGE_EXTENDED) != 0)
-		strTemp = "EXT";
-	else
-		strTemp = "STD";
-
-	if((m_Msg.MSGTYPE & PCAN_MESSAGE_RTR) == PCAN_MESSAGE_RTR)
-		strTemp = (strTemp + "/RTR");
-	else
-		if(m_Msg.MSGTYPE > PCAN_MESSAGE_EXTENDED)
-		{
-			strTemp.Append(" [ ");
-            if (m_Msg.MSGTYPE & PCAN_MESSAGE_FD)
-                strTemp.Append(" FD");
-            if (m_Msg.MSGTYPE & PCAN_MESSAGE_BRS)
-                strTemp.Append(" BRS");
-            if (m_Msg.MSGTYPE & PCAN_MESSAGE_ESI)
-                strTemp.Append(" ESI");
-            strTemp.Append(" ]");
-		}
-
-	return strTemp;
-}
-
-CString MessageStatus::GetIdString()
-{
-	CString strTemp;
-
-	// We format the ID of the message and show it
-	//
-	if((m_Msg.MSGTYPE & PCAN_MESSAGE_EXTENDED) != 0)
-		strTemp.Format("%08Xh",m_Msg.ID);
-	else
-		strTemp.Format("%03Xh",m_Msg.ID);
-
-	return strTemp;
-}
-
-CString MessageStatus::GetDataString()
-{
-	CString strTemp, strTemp2;
-
-	strTemp = "";
-	strTemp2 = "";
-
-	if((m_Msg.MSGTYPE & PCAN_MESSAGE_RTR) == PCAN_MESSAGE_RTR)
-		return "Remote Request";
-	else
-		for(int i=0; i < GetLengthFromDLC(m_Msg.DLC, !(m_Msg.MSGTYPE & PCAN_MESSAGE_FD)); i++)
-		{
-			strTemp.Format("%s %02X", strTemp2, m_Msg.DATA[i]);
-			strTemp2 = strTemp;
-		}
-
-	return strTemp2;
-}
-
-CString MessageStatus::GetTimeString()
-{
-	double fTime;
-	CString str;
-
-    fTime = (m_TimeStamp / 1000.0);
-    if (m_bShowPeriod)
-        fTime -= (m_oldTimeStamp / 1000.0);
-	str.Format("%.1f", fTime);
-
-	return str;
-}
-
-int MessageStatus::GetCount()
-{
-	return m_Count;
-}
-
-bool MessageStatus::GetShowingPeriod()
-{
-	return m_bShowPeriod;
-}
-
-bool MessageStatus::GetMarkedAsUpdated()
-{
-	return m_bWasChanged;
-}
-
-void MessageStatus::SetShowingPeriod(bool value)
-{
-    if (m_bShowPeriod ^ value)
-    {
-        m_bShowPeriod = value;
-        m_bWasChanged = true;
-    }
-}
-
-void MessageStatus::SetMarkedAsUpdated(bool value)
-{
-	m_bWasChanged = value;
-}
-#pragma endregion
-
 //////////////////////////////////////////////////////////////////////////////////////////////
 // PCANBasicExampleDlg dialog
 //
@@ -569,19 +394,40 @@ void CPCANBasicExampleDlg::InitializeControls(void)
 	// PCAN Basic Class instance to use it
 	//
 	m_objPCANBasic = new PCANBasicClass();
+
+	// The CAN source is created when a channel is connected
+	//
+	m_objCANSource = NULL;
 	
 	// We set the variable to know which reading mode is
 	// currently selected (Event by default)
 	//
 	m_ActiveReadingMode = 1;
 
-	// Create a list to store the displayed messages
+	// Preallocates the table storing the displayed messages
+	//
+	m_LastMsgsTable.Reserve(MSG_TABLE_STANDARD_IDS);
+	m_DisplayGeneration = 0;
+	m_DisplayXbowPackets = 0;
+
+	// Preallocates the buffer used to drain the receive queue
 	//
-	m_LastMsgsList = new CPtrList();
+	m_ReadBatchFD.resize(CAN_READ_BATCH);
+	m_ReadHostTimes.resize(CAN_READ_BATCH);
 
-	// Create Event to use Received-event
+	// Create the ring between the reader and the processing thread
+	//
+	m_objRxRing = new CANRing(CAN_RING_SIZE);
+	m_ProcessBatch.resize(CAN_READ_BATCH);
+	m_ProcessHostTimes.resize(CAN_READ_BATCH);
+	m_hRingEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_hProcessThread = NULL;
+	m_ProcessTerminated = 0;
+
+	// A recorded trial can be replayed instead of the hardware
 	//
-	m_hEvent = CreateEvent(NULL, FALSE, FALSE, "");
+	m_objReplay = new SessionReplay(&m_Clock);
+	ParseCommandLine();
 
 	// Prepares the PCAN-Basic's debug-Log file
 	//
@@ -609,8 +455,17 @@ void CPCANBasicExampleDlg::InitializeControls(void)
 	chbFilterExtended.SetCheck(1);
 	rdbFilterCustom.SetCheck(1);
 	rdbReadingEvent.SetCheck(1);
+
+	// The GPS decoder consumes 0x301 to 0x305, sent either as
+	// standard or as extended frames depending on the VBOX setup
+	//
+	m_FilterPlanner.Clear();
+	m_FilterPlanner.Subscribe(0x301, 0x305, PCAN_MODE_STANDARD);
+	m_FilterPlanner.Subscribe(0x301, 0x305, PCAN_MODE_EXTENDED);
+	LoadSignalPlan();
 	rdbParameterActive.SetCheck(1);
 	chbReadingTimeStamp.SetCheck(1);
+	m_ShowPeriod = true;
 
 	// Set default connection status
 	SetConnectionStatus(false);
@@ -633,6 +488,8 @@ void CPCANBasicExampleDlg::InitializeControls(void)
 		m_Shutter_Time = 0;
 		m_Shutter_Time_Constant = m_Shutter_Time;
 		m_Shutter_Duration = 0;
+		StartClockSession();
+		m_Shutter_CPUTIME_BEGIN = m_Clock.Now();
 
 		txtFilterSubs = "s01";
 		txtFilterTrials = "t01";
@@ -709,9 +566,7 @@ void CPCANBasicExampleDlg::OnTimer(UINT_PTR nIDEvent)
 		DisplayMessages();
 	if (nIDEvent == 2 && !btnShutterApply.IsWindowEnabled())
 	{
-		boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
-		boost::posix_time::time_duration diff = now - m_Shutter_CPUTIME_BEGIN;
-		m_Shutter_Duration = diff.total_milliseconds();
+		m_Shutter_Duration = (long double)((m_Clock.Now() - m_Shutter_CPUTIME_BEGIN) / NS_PER_MS);
 		m_Shutter_Duration /= 1000.0f;
 
 		txtLC2Value.Format("%f", ((double)m_Shutter_Duration));
@@ -730,10 +585,7 @@ void CPCANBasicExampleDlg::OnTimer(UINT_PTR nIDEvent)
 				{
 					SetShutterGlass();
 					
-					boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
-					boost::posix_time::time_duration diff = now - time_t_epoch;
-
-					std::pair<__int64, std::string> temp(diff.total_milliseconds(), "OFF");
+					std::pair<__int64, std::string> temp(m_Clock.GetRecordTime(), "OFF");
 					m_Shutter_Time_Rec.push_back(temp);
 				}
 				if (m_Shutter_Duration >= m_Shutter_Time)
@@ -742,10 +594,7 @@ void CPCANBasicExampleDlg::OnTimer(UINT_PTR nIDEvent)
 
 					PlaySound(TEXT("alert.wav"), NULL, SND_FILENAME | SND_ASYNC);
 
-					boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
-					boost::posix_time::time_duration diff = now - time_t_epoch;
-
-					std::pair<__int64, std::string> temp(diff.total_milliseconds(), "LC");
+					std::pair<__int64, std::string> temp(m_Clock.GetRecordTime(), "LC");
 					m_Shutter_Time_Rec.push_back(temp);
 				}
 
@@ -769,10 +618,7 @@ void CPCANBasicExampleDlg::OnTimer(UINT_PTR nIDEvent)
 
 					PlaySound(TEXT("low.wav"), NULL, SND_FILENAME | SND_ASYNC);
 
-					boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
-					boost::posix_time::time_duration diff = now - time_t_epoch;
-
-					std::pair<__int64, std::string> temp(diff.total_milliseconds(), "Alarm");
+					std::pair<__int64, std::string> temp(m_Clock.GetRecordTime(), "Alarm");
 					m_Shutter_Time_Rec.push_back(temp);
 				}
 
@@ -890,17 +736,34 @@ void CPCANBasicExampleDlg::OnBnClickedBtninit()
 
 	UpdateData(TRUE);
 
+	// A new recording session starts with the connection
+	//
+	StartClockSession();
+
+	// A recorded trial given on the command line replaces the hardware
+	//
+	if (!m_ReplayTraceFile.empty() || !m_ReplayXbowFile.empty())
+	{
+		StartReplay();
+		return;
+	}
+
 	// Parse IO and Interrupt
 	//
 	selectedIO = HexTextToInt(GetComboBoxSelectedLabel(&cbbIO));
 	selectedInterrupt = atoi(GetComboBoxSelectedLabel(&cbbInterrupt));
 
-	// Connects a selected PCAN-Basic channel
+	// Connects a selected PCAN-Basic channel through a PCAN source,
+	// or the traffic generator when simulating
 	//
-	if (m_IsFD)
-		stsResult = m_objPCANBasic->InitializeFD(m_PcanHandle, txtBitrate.GetBuffer());
+	delete m_objCANSource;
+	if (m_Simulate)
+		m_objCANSource = new GeneratorSource(&m_Clock, m_SimConfig);
+	else if (m_IsFD)
+		m_objCANSource = new PCANSource(m_objPCANBasic, m_PcanHandle, txtBitrate.GetBuffer());
 	else
-		stsResult = m_objPCANBasic->Initialize(m_PcanHandle, m_Baudrate, m_HwType, selectedIO, selectedInterrupt);
+		m_objCANSource = new PCANSource(m_objPCANBasic, m_PcanHandle, m_Baudrate, m_HwType, selectedIO, selectedInterrupt);
+	stsResult = m_objCANSource->Initialize();
 
 	if (stsResult != PCAN_ERROR_OK)
 		if (stsResult != PCAN_ERROR_CAUTION)
@@ -912,11 +775,19 @@ void CPCANBasicExampleDlg::OnBnClickedBtninit()
             IncludeTextMessage("******************************************************");
             stsResult = PCAN_ERROR_OK;
 		}
-	else
+	else if (!m_Simulate)
         // Prepares the PCAN-Basic's PCAN-Trace file
         //
 		ConfigureTraceFile();
 
+	// The processing thread must be running before the reading starts
+	//
+	if (stsResult == PCAN_ERROR_OK)
+	{
+		ApplyFilterPlan(m_objCANSource);
+		StartProcessing();
+	}
+
 	// Sets the connection status of the main-form
 	//
 	SetConnectionStatus(stsResult == PCAN_ERROR_OK);
@@ -926,8 +797,11 @@ void CPCANBasicExampleDlg::OnBnClickedBtninit()
 		if (stsResult == PCAN_ERROR_OK)
 		{
 			InitGPSConfig();
-			cbbParameter.SetCurSel(7);
-			OnBnClickedButtonparamset();
+			if (!m_Simulate)
+			{
+				cbbParameter.SetCurSel(7);
+				OnBnClickedButtonparamset();
+			}
 
 //			cbbParameter.SetCurSel(3);	//default:Listen-Only Mode
 //			OnBnClickedButtonparamset();
@@ -937,7 +811,21 @@ void CPCANBasicExampleDlg::OnBnClickedBtninit()
 // 
   		InitCrossXbow();
 		btnRefreshCom.EnableWindow(FALSE);
-		if (ccbHwXbow.GetCount() > 0)
+		if (m_Simulate && stsResult == PCAN_ERROR_OK)
+		{
+			// The synthetic Xbow takes the place of the serial reader
+			//
+			if (m_SimConfig.XbowRate > 0)
+			{
+				InterlockedExchange(&m_XbowTerminated, 0);
+				m_Xbow_hThread = CreateThread(NULL, NULL, CPCANBasicExampleDlg::CallSimXbowThreadFunc, (LPVOID)this, NULL, NULL);
+			}
+			SetTimerDisplay(true);
+			btnInit.EnableWindow(FALSE);
+			btnRelease.EnableWindow(TRUE);
+			ccbHwXbow.EnableWindow(FALSE);
+		}
+		else if (ccbHwXbow.GetCount() > 0)
 		{
 			ConnectCrossXbow();
 			SetTimerDisplay(true);
@@ -958,17 +846,27 @@ void CPCANBasicExampleDlg::OnBnClickedBtnrelease()
 	if(m_hThread != NULL)
 	{
 		m_Terminated = true;
+		m_objCANSource->CancelWait();
 		WaitForSingleObject(m_hThread,-1);
 		m_hThread = NULL;
 	}
 
+	// Terminate a replay in progress
+	//
+	StopReplay();
+
 	// We stop to read from the CAN queue
 	//
 	SetTimerRead(false);
 
+	// Processes what is left in the ring and stops the processing thread
+	//
+	StopProcessing();
+
 	// Releases a current connected PCAN-Basic channel
 	//
-	m_objPCANBasic->Uninitialize(m_PcanHandle);
+	if (m_objCANSource != NULL)
+		m_objCANSource->Uninitialize();
 
 	// Sets the connection status of the main-form
 	//
@@ -1069,9 +967,7 @@ void CPCANBasicExampleDlg::OnBnClickedRdbevent()
 }
 void CPCANBasicExampleDlg::OnBnClickedChbtimestamp()
 {
-	MessageStatus* msgStsCurrentMessage;
 	CString str;	
-	POSITION pos;
 	BOOL bChecked;
 
 	// According with the check-value of this checkbox,
@@ -1083,13 +979,11 @@ void CPCANBasicExampleDlg::OnBnClickedChbtimestamp()
 	{
 		clsCritical locker(m_objpCS);
 
-		pos = m_LastMsgsList->GetHeadPosition();
 		bChecked = chbReadingTimeStamp.GetCheck();
-		while(pos)
-		{
-			msgStsCurrentMessage = (MessageStatus*)m_LastMsgsList->GetNext(pos);
-			msgStsCurrentMessage->ShowingPeriod = bChecked > 0;
-		}
+		m_ShowPeriod = bChecked > 0;
+		for(int i=0; i < m_LastMsgsTable.GetCount(); i++)
+			if (m_LastMsgsTable[i].SetShowingPeriod(bChecked > 0))
+				m_DisplayModel.MarkChanged(i);
 	}
 }
 
@@ -1283,7 +1177,7 @@ void CPCANBasicExampleDlg::OnBnClickedButtonfilterapply()
 	{
 		// Sets the custom filter
 		//
-		stsResult = m_objPCANBasic->FilterMessages(m_PcanHandle, nudFilterFrom.GetPos32(), nudFilterTo.GetPos32(), chbFilterExtended.GetCheck() ? PCAN_MODE_EXTENDED : PCAN_MODE_STANDARD);
+		stsResult = m_objCANSource->FilterMessages(nudFilterFrom.GetPos32(), nudFilterTo.GetPos32(), chbFilterExtended.GetCheck() ? PCAN_MODE_EXTENDED : PCAN_MODE_STANDARD);
 		// If success, an information message is written, if it is not, an error message is shown
 		//
 		if (stsResult == PCAN_ERROR_OK)
@@ -1371,9 +1265,10 @@ void CPCANBasicExampleDlg::OnBnClickedButtonread()
 {
 	TPCANStatus stsResult;
 
-	// We execute the "Read" function of the PCANBasic                
+	// One burst goes through the source and the ring, as with the
+	// other reading modes
 	//
-	stsResult = m_IsFD ? ReadMessageFD() : ReadMessage();
+	stsResult = ReadMessageBatch();
 	if (stsResult != PCAN_ERROR_OK)
 		// If an error occurred, an information message is included
 		//
@@ -1391,10 +1286,9 @@ void CPCANBasicExampleDlg::OnBnClickedButtonreadingclear()
 		//
 		lstMessages.DeleteAllItems();
 		lstMessages_GPS.DeleteAllItems();
-		//This Piece of code cause bugs!!!
-		while(m_LastMsgsList->GetCount())
-			delete m_LastMsgsList->RemoveHead();
-		//This Piece of code cause bugs!!!
+		m_LastMsgsTable.Clear();
+		m_SignalPlan.ResetSlots();
+		m_DisplayModel.Reset();
 		m_Xbow_AddedItem = false;
 		m_Xbow_Added2Item = false;
 	}
@@ -1791,9 +1685,14 @@ void CPCANBasicExampleDlg::OnClose()
 	if(btnRelease.IsWindowEnabled())
 		OnBnClickedBtnrelease();
 
-	// Close the Read-Event
+	// The replay feeds the ring, it goes first
+	//
+	delete m_objReplay;
+	m_objReplay = NULL;
+
+	// Close the Ring-Event
 	//
-	CloseHandle(m_hEvent);
+	CloseHandle(m_hRingEvent);
 
 	// (Protected environment)
 	//
@@ -1801,20 +1700,19 @@ void CPCANBasicExampleDlg::OnClose()
 		clsCritical locker(m_objpCS);
 		//Free Ressources
 		//
+		delete m_objCANSource;
+		m_objCANSource = NULL;
 		delete m_objPCANBasic;		
+		delete m_objRxRing;
 
-		while(m_LastMsgsList->GetCount())
-			delete m_LastMsgsList->RemoveHead();
-		delete m_LastMsgsList;
+		m_LastMsgsTable.Clear();
+		m_SignalPlan.ResetSlots();
 
 		// Delete GPS Record;
 		{
 			m_GPS_Msg_List.resize(0);
 			m_GPS_Msg_List.clear();
 
-			m_GPS_Str_RAW.resize(0);
-			m_GPS_Str_RAW.clear();
-
 			m_GPS_CPU_Time.resize(0);
 			m_GPS_CPU_Time.clear();
 
@@ -1834,15 +1732,19 @@ void CPCANBasicExampleDlg::OnClose()
 	FinalizeProtection();
 
 	{
-		CloseHandle(m_GPS_Net_Event);
-		CloseHandle(m_Xbow_Net_Event);
-		CloseHandle(m_Send_Event);
+		// The sending thread blocks on its events, so it is
+		// woken up and joined before they are closed
+		//
 		if (m_Network_hThread)
 		{
 			InterlockedExchange(&m_Send_Terminated, 1);
+			SetEvent(m_Send_Event);
 			WaitForSingleObject(m_Network_hThread, INFINITE);
 			m_Network_hThread = NULL;
 		}
+		CloseHandle(m_GPS_Net_Event);
+		CloseHandle(m_Xbow_Net_Event);
+		CloseHandle(m_Send_Event);
 	}
 	
 
@@ -1896,6 +1798,48 @@ void CPCANBasicExampleDlg::OnBnClickedButtonstatus()
 	//
 	info.Format("Status: %s (%Xh)", errorName, status);
 	IncludeTextMessage(info);
+
+	// Display the state of the receive ring
+	//
+	info.Format("Receive ring: %u/%u messages, high-water mark %u, overflows %I64u", 
+		m_objRxRing->GetDepth(), m_objRxRing->GetCapacity(), m_objRxRing->GetHighWaterMark(), m_objRxRing->GetOverflows());
+	IncludeTextMessage(info);
+
+	// Display the quality of the adapter to host clock alignment
+	//
+	ClockAlignmentStats clockStats = m_ClockAlign.GetStatistics();
+	info.Format("Clock alignment: %u samples, drift %.2f ppm, residual jitter %.1f us RMS / %.1f us max", 
+		clockStats.Samples, clockStats.DriftPpm, clockStats.ResidualRms / 1000.0, clockStats.ResidualMax / 1000.0);
+	IncludeTextMessage(info);
+
+	// Display what the traffic generator produced so far
+	//
+	if (m_Simulate && m_objCANSource != NULL)
+	{
+		TrafficStats trafficStats = static_cast<GeneratorSource*>(m_objCANSource)->GetStatistics();
+		info.Format("Generated: %I64u VBOX frames, %I64u other frames, %I64u corrupted, %I64u dropped", 
+			trafficStats.GPSFrames, trafficStats.BackgroundFrames, trafficStats.Corrupted, trafficStats.Dropped);
+		IncludeTextMessage(info);
+	}
+
+	// Display the exchanges between the processing and the display
+	//
+	DisplayModelStats displayStats = m_DisplayModel.GetStatistics();
+	info.Format("Display: %I64u snapshots published (%I64u rows, %I64u replaced unread), %I64u rendered, %I64u idle refreshes", 
+		displayStats.Published, displayStats.RowsPublished, displayStats.Overwritten, displayStats.Acquired, displayStats.Idle);
+	IncludeTextMessage(info);
+
+	// Display the timing of the GPS messages, from the last snapshot
+	//
+	std::shared_ptr<const TimingSnapshot> timing = m_TimingStats.GetSnapshot();
+	for (TimingSnapshot::const_iterator i = timing->begin(); i != timing->end(); ++i)
+	{
+		if (i->ID < 0x301 || i->ID > 0x305)
+			continue;
+		info.Format("Timing %03Xh: %I64u messages, %.2f Hz, period %I64u / %.1f / %I64u us (min/mean/max), std dev %.1f us", 
+			i->ID, i->Count, TimingStatistics::GetRate(*i), i->MinPeriod, i->MeanPeriod, i->MaxPeriod, TimingStatistics::GetStdDeviation(*i));
+		IncludeTextMessage(info);
+	}
 }
 
 void CPCANBasicExampleDlg::OnBnClickedButtonreset()
@@ -1977,74 +1921,28 @@ CString CPCANBasicExampleDlg::IntToStr(int iValue)
 
 CString CPCANBasicExampleDlg::IntToHex(int iValue, short iDigits)
 {	
-	CString strTemp, strtest;
+	char chToReceive[40];
 
-	strTemp.Format("%0" + IntToStr(iDigits) + "X",iValue);
-
-	return strTemp;
+	HexEncodeValue((DWORD)iValue, (iDigits < 32) ? iDigits : 32, chToReceive);
+	return chToReceive;
 }
 DWORD CPCANBasicExampleDlg::HexTextToInt(CString ToConvert)
 {
 	DWORD iToReturn = 0;
-	int iExp = 0;
-	char chByte;
 
-	// The string to convert is empty
-	//
-	if(ToConvert == "")
-		return 0;
-	// The string have more than 8 character (the equivalent value
-	// exeeds the DWORD capacyty
-	//
-	if(ToConvert.GetLength() > 8)
-		return 0;
-	// We convert any character to its Upper case
+	// An empty string, or one of more than 8 characters (the equivalent
+	// value exceeds the DWORD capacity) gives 0, a character other than
+	// a hexadecimal digit -1
 	//
-	ToConvert = ToConvert.MakeUpper();
-
-	try
-	{
-		// We calculate the number using the Hex To Decimal formula
-		//
-		for(int i= ToConvert.GetLength()-1; i >= 0; i--){
-			chByte = ToConvert[i];
-			switch(int(chByte)){
-				case 65:
-					iToReturn += (DWORD)(10*pow(16.0f,iExp));
-					break;
-				case 66:
-					iToReturn += (DWORD)(11*pow(16.0f,iExp));
-					break;
-				case 67:
-					iToReturn += (DWORD)(12*pow(16.0f,iExp));
-					break;
-				case 68:
-					iToReturn += (DWORD)(13*pow(16.0f,iExp));
-					break;
-				case 69:
-					iToReturn += (DWORD)(14*pow(16.0f,iExp));
-					break;
-				case 70:
-					iToReturn += (DWORD)(15*pow(16.0f,iExp));
-					break;
-				default:
-					if((int(chByte) <48)||(int(chByte)>57))
-						return -1;
-					iToReturn += (DWORD)(atoi(&chByte)*pow(16.0f,iExp));
-					break;
-
-			}
-			iExp++;
-		}
-	}
-	catch(...)
+	switch (HexDecodeValue(ToConvert, ToConvert.GetLength(), &iToReturn))
 	{
-		// Error, return 0
-		//
+	case HEX_OK:
+		return iToReturn;
+	case HEX_ERROR_DIGIT:
+		return -1;
+	default:
 		return 0;
 	}
-
-	return iToReturn;
 }
 
 void CPCANBasicExampleDlg::CheckHexEditBox(CString* txtData)
@@ -2123,148 +2021,126 @@ void CPCANBasicExampleDlg::SetTimerDisplay(bool bEnable)
 
 void CPCANBasicExampleDlg::DisplayMessages()
 {
-	POSITION pos;
+	std::shared_ptr<const DisplaySnapshot> snapshot;
+	std::vector<MessageStatus>::const_iterator msgStatus;
 	int iCurrentItem, iCurrentItem_GPS;
-	MessageStatus *msgStatus;
-	CString strTempCount;
+	char szType[MSG_TYPE_TEXT_SIZE];
+	char szID[MSG_ID_TEXT_SIZE];
+	char szData[MSG_DATA_TEXT_SIZE];
+	char szTime[MSG_TIME_TEXT_SIZE];
+	VBoxData vbox = {};
+
+	// The rows are rendered from the last snapshot published by the
+	// processing thread, without taking its lock
+	//
+	snapshot = m_DisplayModel.Acquire();
+	if (!snapshot)
+		return;
 
-    // We search if a message (Same ID and Type) is 
-    // already received or if this is a new message
-	// (in a protected environment)
+	// The messages were cleared since the last refresh
 	//
+	if (snapshot->Generation != m_DisplayGeneration)
 	{
-		clsCritical locker(m_objpCS);
+		lstMessages.DeleteAllItems();
+		lstMessages_GPS.DeleteAllItems();
+		m_Xbow_AddedItem = false;
+		m_Xbow_Added2Item = false;
+		m_DisplayXbowPackets = 0;
+		m_DisplayGeneration = snapshot->Generation;
+	}
 
-		pos = m_LastMsgsList->GetHeadPosition();
-		for(int i=0; i < m_LastMsgsList->GetCount(); i++)
-		{
-			msgStatus = (MessageStatus*)m_LastMsgsList->GetNext(pos);
-			if(msgStatus->MarkedAsUpdated)
-			{
-				msgStatus->MarkedAsUpdated = false;
+	for (msgStatus = snapshot->Rows.begin(); msgStatus != snapshot->Rows.end(); ++msgStatus)
+	{
+		iCurrentItem = msgStatus->GetPosition();
+		int ID_NUM = (int)msgStatus->GetID();
+
+		// The texts are only rendered for the rows being refreshed
+		//
+		msgStatus->FormatData(szData, sizeof(szData));
+		msgStatus->FormatTime(szTime, sizeof(szTime));
 
-				iCurrentItem = msgStatus->Position;
+		// A new message gets its ListView Item, with its type and ID
+		//
+		if (iCurrentItem >= lstMessages.GetItemCount())
+		{
+			msgStatus->FormatType(szType, sizeof(szType));
+			msgStatus->FormatID(szID, sizeof(szID));
 
-				strTempCount = lstMessages.GetItemText(iCurrentItem,MSG_COUNT);
-				CString DATA = msgStatus->DataString;
+			iCurrentItem = AddLVItem(szType);
+			lstMessages.SetItemText(iCurrentItem, MSG_ID, szID);
+			if (ID_NUM >= 0x301 && ID_NUM <= 0x305)
+				ADDLVItem_GPS(szType);
+		}
 
-				lstMessages.SetItemText(iCurrentItem,MSG_LENGTH,IntToStr(GetLengthFromDLC(msgStatus->CANMsg.DLC, !(msgStatus->CANMsg.MSGTYPE & PCAN_MESSAGE_FD))));
-				lstMessages.SetItemText(iCurrentItem,MSG_COUNT,IntToStr(msgStatus->Count));
-				lstMessages.SetItemText(iCurrentItem, MSG_TIME, msgStatus->TimeString);
-				lstMessages.SetItemText(iCurrentItem, MSG_DATA, DATA);
+		lstMessages.SetItemText(iCurrentItem,MSG_LENGTH,IntToStr(msgStatus->GetLength()));
+		lstMessages.SetItemText(iCurrentItem,MSG_COUNT,IntToStr(msgStatus->GetCount()));
+		lstMessages.SetItemText(iCurrentItem, MSG_TIME, szTime);
+		lstMessages.SetItemText(iCurrentItem, MSG_DATA, szData);
 
-				CString ID = msgStatus->IdString;
-				ID.Truncate(ID.GetLength() - 1);
-				int ID_NUM = HexTextToUnsigned(ID);
-				if (ID_NUM >= 0x301 && ID_NUM <= 0x305)
-				{
-					iCurrentItem_GPS = min(ID_NUM - 0x301, lstMessages_GPS.GetItemCount() - 1);
-					DisplayGPSInformation(DATA, iCurrentItem_GPS, ID_NUM);
-				}
-			}
+		if (DecodeVBoxFrame(ID_NUM, msgStatus->GetData(), msgStatus->GetLength(), &vbox))
+		{
+			iCurrentItem_GPS = min(ID_NUM - 0x301, lstMessages_GPS.GetItemCount() - 1);
+			DisplayGPSInformation(szData, &vbox, iCurrentItem_GPS, ID_NUM);
 		}
+	}
 
-		CString strTemp = "";
-		// EnterCriticalSection(&m_xBow_CriticalSection);
-		strTemp = m_Xbow_Msg_Latest;
-		// LeaveCriticalSection(&m_xBow_CriticalSection);
+	// Last Xbow packet
+	//
+	if (snapshot->XbowPackets != m_DisplayXbowPackets)
+	{
+		CString strTemp = FormatXbowPacket(snapshot->XbowPacket);
+		XbowSample xbow;
 
-		if (!m_Xbow_AddedItem && strTemp != "")
+		if (!m_Xbow_AddedItem)
 		{
 			ADDLVItem_GPS(strTemp);
 			m_Xbow_AddedItem = true;
 		}
-		else if (strTemp != "")
+		else if (ParseXbowPacket(snapshot->XbowPacket, &xbow))
 		{
 			iCurrentItem_GPS = min(0x306 - 0x301, lstMessages_GPS.GetItemCount() - 1);
-			int ID_NUM = 0x306;
-			DisplayGPSInformation(strTemp, iCurrentItem_GPS, ID_NUM);
+			DisplayXbowInformation(strTemp, xbow, iCurrentItem_GPS);
 		}
+		m_DisplayXbowPackets = snapshot->XbowPackets;
 	}
+
+	m_DisplayModel.Acknowledge(snapshot->Sequence);
 }
 
-void CPCANBasicExampleDlg::InsertMsgEntry(TPCANMsgFD NewMsg, TPCANTimestampFD timeStamp)
+void CPCANBasicExampleDlg::InsertMsgEntry(const CANFrameView &NewMsg, TPCANTimestampFD timeStamp)
 {
-	MessageStatus *msgStsCurrentMsg;
-	int iCurrentItem, iCurrentItem_GPS;
+	int index;
 
 	// (Protected environment)
 	//
 	{
 		clsCritical locker(m_objpCS);
 
-		// We add this status in the last message list
-		//
-		msgStsCurrentMsg = new MessageStatus(NewMsg, timeStamp, lstMessages.GetItemCount());
-		msgStsCurrentMsg->ShowingPeriod = chbReadingTimeStamp.GetCheck() > 0;
-		m_LastMsgsList->AddTail(msgStsCurrentMsg);
-
-		CString ID = msgStsCurrentMsg->IdString;
-		CString Data = msgStsCurrentMsg->DataString;
-
-		// Add the new ListView Item with the Type of the message
+		// We add this status in the last message table. Its ListView
+		// Item is created by the display, from the next snapshot
 		//
-		iCurrentItem = AddLVItem(msgStsCurrentMsg->TypeString);
-		// We set the ID of the message
-        //
-		lstMessages.SetItemText(iCurrentItem, MSG_ID, ID);
-        // We set the length of the Message
-        //		
-		lstMessages.SetItemText(iCurrentItem,MSG_LENGTH,IntToStr(GetLengthFromDLC(NewMsg.DLC, !(NewMsg.MSGTYPE & PCAN_MESSAGE_FD))));
-        // we set the message count message (this is the First, so count is 1)
-        //
-		lstMessages.SetItemText(iCurrentItem,MSG_COUNT,IntToStr(msgStsCurrentMsg->Count));
-        // Add timestamp information
-        //
-		lstMessages.SetItemText(iCurrentItem, MSG_TIME, msgStsCurrentMsg->TimeString);
-		// We set the data of the message. 	
-        //
-		lstMessages.SetItemText(iCurrentItem, MSG_DATA, Data);
-
-		{
-			m_GPS_Msg_List.push_back(GPS_MK_PAIR(ID, Data));
-			boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
-			boost::posix_time::time_duration diff = now - time_t_epoch;
+		MessageStatus msgStsNew(NewMsg, timeStamp, m_LastMsgsTable.GetCount());
+		msgStsNew.SetShowingPeriod(m_ShowPeriod);
+		index = m_LastMsgsTable.Add(NewMsg.ID, NewMsg.MSGTYPE, msgStsNew);
+		m_DisplayModel.MarkChanged(index);
+		m_SignalPlan.Decode(index, NewMsg, timeStamp, &m_SignalBuffer);
 
-			if (m_GPS_Msg_List.size() == 1) InterlockedExchange(&m_GPS_Is_First, 1);
+		m_GPS_Msg_List.push_back(m_LastMsgsTable[index]);
 
-			ID.Truncate(ID.GetLength() - 1);
-			const int ID_NUM = HexTextToUnsigned(ID);
-			if (ID_NUM >= 0x301 && ID_NUM <= 0x305)
-			{
-				iCurrentItem_GPS = ADDLVItem_GPS(msgStsCurrentMsg->TypeString);
-			}
-		}
+		if (m_GPS_Msg_List.size() == 1) InterlockedExchange(&m_GPS_Is_First, 1);
 	}
 }
 
 void CPCANBasicExampleDlg::InitGPSConfig()
 {
 	//Custom GPS Recorder
-	m_GPS_Num_Count = 0;
 	m_GPS_Send_Num_Count = 0;
-	m_GPS_First_Distance = -1;
-	m_GPS_Distance_Offset = 0;
-
-	m_GPS_Recorder = "Time\tX\tY\tSpeed\tHeading\tWGS84\tVerticalV\tTrigDist\tLongAcc\tLatAcc\tStatus\tTrigTime\tTrigV\tDistance\tSats.\tRAW\tID\tCPUTIME\n";
-	m_GPS_Str_Time = "";
-	m_GPS_Str_X = "";
-	m_GPS_Str_Y = "";
-	m_GPS_Str_Sats = "";
-	m_GPS_Str_Velocity = "";
-	m_GPS_Str_Heading = "";
-	m_GPS_Str_WGS84 = "";
-	m_GPS_Str_VerticalV = "";
-	m_GPS_Str_TrigDist = "";
-	m_GPS_Str_LongAcc = "";
-	m_GPS_Str_LatACC = "";
-	m_GPS_Str_Status = "";
-	m_GPS_Str_TrigTime = "";
-	m_GPS_Str_TrigV = "";
-	m_GPS_Str_Distance = "";
-
-	m_GPS_Str_RAW.clear();
-	m_GPS_Str_RAW.resize(GPS_DATA_COUNT,"");
+	m_GPS_Distance.Reset();
+
+	m_GPS_Recorder = "Time\tX\tY\tSpeed\tHeading\tWGS84\tVerticalV\tTrigDist\tLongAcc\tLatAcc\tStatus\tTrigTime\tTrigV\tDistance\tSats.";
+	for (int i = 0; i < GPS_DATA_COUNT; i++)
+		m_GPS_Recorder += "\tRAW\tID";
+	m_GPS_Recorder += "\tCPUTIME\n";
 
 	if (!m_GPS_Msg_List.empty()) m_GPS_Msg_List.clear();
 	if (!m_GPS_CPU_Time.empty()) m_GPS_CPU_Time.clear();
@@ -2390,10 +2266,12 @@ void CPCANBasicExampleDlg::NetworkAccpetorHandler(boost::asio::ip::tcp::socket *
 	//boost::asio::deadline_timer writeTimer(socket->get_io_service());
 	boost::system::error_code ercode;
 	size_t bytetransferred = 0;
+	HANDLE events[2] = { m_GPS_Net_Event, m_Send_Event };
 	while (!m_Send_Terminated)
 	{
-
-		if (WaitForSingleObject(m_GPS_Net_Event, GPS_LATENCY) == WAIT_OBJECT_0)
+		// Sleeps until a GPS message is ready or the sending is stopped
+		//
+		if (WaitForMultipleObjects(2, events, FALSE, INFINITE) == WAIT_OBJECT_0)
 		{
 			{
  				clsCritical locker(m_objpCS);
@@ -2733,166 +2611,128 @@ DWORD WINAPI CPCANBasicExampleDlg::XbowDataReadThreadFunc(LPVOID lpParam)
 		}
 	Sleep(20);
 
-	RxBytes = 45;
-	unsigned num = 0;
-	unsigned char content[450];
-	memset(content, 0, sizeof(content));
-
-	ftStatus = FT_Read(ftHandle, content, RxBytes, &BytesReceived);
-	ftStatus = FT_Read(ftHandle, content, RxBytes, &BytesReceived);
-	ftStatus = FT_Read(ftHandle, content, RxBytes, &BytesReceived);
+	// The packets are cut out of whatever the reads return, so a partial
+	// read or a stalled device only delays them
+	//
+	unsigned char content[XBOW_PACKET_SIZE * 16];
+	unsigned resetflag = 0;
+	XbowFramer framer;
 
-	BytesReceived = 65535;
-	while (BytesReceived != RxBytes || ftStatus != FT_OK)
+	while (!m_XbowTerminated)
 	{
-		IncludeTextMessage("Reading...");
+		// Reads the bytes queued, or waits up to the read timeout for a packet
+		//
+		ftStatus = FT_GetQueueStatus(ftHandle, &RxBytes);
+		if (ftStatus != FT_OK || RxBytes == 0)
+			RxBytes = XBOW_PACKET_SIZE;
+		else if (RxBytes > sizeof(content))
+			RxBytes = sizeof(content);
+
 		ftStatus = FT_Read(ftHandle, content, RxBytes, &BytesReceived);
-	}
+		if (ftStatus != FT_OK)
+		{
+			IncludeTextMessage("Xbow read failed");
+			break;
+		}
 
-	for (int i = 0; i < 45 / 2; i++)
-	{
-		const unsigned char &temp = content[i];
-		const unsigned char &tempend = content[i + 22];
-		if (temp == 0xFF && tempend == 0xFF)
+		InterlockedExchange(&resetflag, m_Xbow_Algin);
+		if (resetflag)
 		{
-			unsigned char c = 0;
-			int j = i;
-			for (j = i + 1; j < i + 21; j++)
-			{
-				c += content[j];
-			}
-			c = c % 255;
-			if (c == content[j])
-			{
-				num = (45 - j - 1);
-				num = (num <= 22) ? 22 - num : num % 22;
-				break;
-			}
+			framer.Resynchronize();
+			InterlockedExchange(&m_Xbow_Algin, 0);
 		}
+		FeedXbowBytes(&framer, content, BytesReceived, m_Clock.GetRecordTime());
 	}
 
-	RxBytes = num;
-	BytesReceived = 65535;
-	while (BytesReceived != RxBytes || ftStatus != FT_OK)
+	ErrorMsg.Format("Xbow: %I64u packets, %I64u bad bytes, %I64u resyncs", framer.GetStats().Packets, framer.GetStats().BadBytes, framer.GetStats().Resyncs);
+	IncludeTextMessage(ErrorMsg);
+
+	ftStatus = FT_Close(ftHandle);
+	if (ftStatus != FT_OK)
 	{
-		IncludeTextMessage("Reading...");
-		ftStatus = FT_Read(ftHandle, content, RxBytes, &BytesReceived);
+		InterlockedExchange(&m_XbowTerminated, 1);
+		return 1;
 	}
 
-	CString tempstr, tempstr2;
-	const unsigned perdata = 1;
-	unsigned resetflag = 0;
-	while (!m_XbowTerminated)
-	{
-		BytesReceived = 65535;
-		RxBytes = 22 * perdata;
-		while (BytesReceived != RxBytes || ftStatus != FT_OK)
-		{
-			ftStatus = FT_Read(ftHandle, content, RxBytes, &BytesReceived);
-		}
+	return 0;
+}
 
-		for (int k = 0; k < perdata; k++)
-		{
-			int i = k * 22 + 1;
-			int ii = i + 20;
-			unsigned char c = 0;
-			tempstr.Format("%02X ", content[i - 1]);
-			tempstr2 += tempstr;
-			for (; i < ii; i++)
-			{
-				c += content[i];
-				tempstr.Format("%02X ", content[i]);
-				tempstr2 += tempstr;
-			}
-			c = c % 255;
-			tempstr.Format("%02X", content[ii]);
-			tempstr2 += tempstr;
-
-			// 			EnterCriticalSection(&m_xBow_CriticalSection);
-			// 			if (c == content[ii] && content[0] == 0xFF)
-			// 			{
-			// 				m_Xbow_Msg_List.push_back(tempstr2);
-			// 				m_Xbow_Msg_Latest = tempstr2;
-			// 				++m_Xbow_Effictive_Count;
-			// 			}
-			// 			++m_Xbow_Count;
-			// 			resetflag = m_Xbow_Algin;
-			// 			LeaveCriticalSection(&m_xBow_CriticalSection);
+CString CPCANBasicExampleDlg::FormatXbowPacket(const unsigned char *Packet)
+{
+	char szPacket[XBOW_PACKET_SIZE * 3];
 
-			{
-				clsCritical locker(m_objpCS);
-				if (c == content[ii] && content[0] == 0xFF)
-				{
-					m_Xbow_Msg_List.push_back(tempstr2);
-					boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
-					boost::posix_time::time_duration diff = now - time_t_epoch;
-					m_Xbow_CPU_Time.push_back(diff.total_milliseconds());
-					m_Xbow_Msg_Latest = tempstr2;
-					GetGPSXbowInformation(m_Xbow_Msg_Latest, 0x306);
-					++m_Xbow_Effictive_Count;
-				}
-				++m_Xbow_Count;
-				resetflag = m_Xbow_Algin;
-			}
+	HexEncodeSpaced(Packet, XBOW_PACKET_SIZE, szPacket);
+	return szPacket;
+}
 
-			tempstr.Empty();
-			tempstr2.Empty();
-		}
+void CPCANBasicExampleDlg::ProcessXbowPacket(const unsigned char *Packet, __int64 RecordTime)
+{
+	XbowSample sample;
 
-		if (resetflag)
-		{			
-			FT_Read(ftHandle, content, 45, &BytesReceived);
-			FT_Read(ftHandle, content, 45, &BytesReceived);
-			
-			RxBytes = 45;
-			BytesReceived = 65535;
-			while (BytesReceived != RxBytes || ftStatus != FT_OK)
-			{
-				ftStatus = FT_Read(ftHandle, content, RxBytes, &BytesReceived);
-			}
-
-			for (int i = 0; i < 45 / 2; i++)
-			{
-				const unsigned char &temp = content[i];
-				const unsigned char &tempend = content[i + 22];
-				if (temp == 0xFF && tempend == 0xFF)
-				{
-					unsigned char c = 0;
-					int j = i;
-					for (j = i + 1; j < i + 21; j++)
-					{
-						c += content[j];
-					}
-					c = c % 255;
-					if (c == content[j])
-					{
-						num = (45 - j - 1);
-						num = (num <= 22) ? 22 - num : num % 22;
-						break;
-					}
-				}
-			}
+	// The packet is checked and read in place, the list keeps the sample
+	//
+	clsCritical locker(m_objpCS);
+	if (ParseXbowPacket(Packet, &sample))
+	{
+		m_DisplayModel.SetXbowPacket(Packet);
+		m_Xbow_Msg_List.push_back(sample);
+		m_Xbow_CPU_Time.push_back(RecordTime);
+		GetGPSXbowInformation();
+		++m_Xbow_Effictive_Count;
+	}
+	++m_Xbow_Count;
+}
 
-			RxBytes = num;
-			BytesReceived = 65535;
+void CPCANBasicExampleDlg::FeedXbowBytes(XbowFramer *Framer, const unsigned char *Data, DWORD Length, __int64 RecordTime)
+{
+	unsigned char packets[XBOW_PACKET_SIZE * 16];
+	UINT64 resyncs = Framer->GetStats().Resyncs;
+	DWORD used = 0, consumed, dwCount;
 
-			while (BytesReceived != RxBytes || ftStatus != FT_OK)
-			{
-				ftStatus = FT_Read(ftHandle, content, num, &BytesReceived);
-			}
+	while (used < Length)
+	{
+		dwCount = Framer->Push(&Data[used], Length - used, packets, 16, &consumed);
+		for (DWORD i = 0; i < dwCount; i++)
+			ProcessXbowPacket(&packets[i * XBOW_PACKET_SIZE], RecordTime);
+		used += consumed;
+	}
 
-// 			EnterCriticalSection(&m_xBow_CriticalSection);
-// 			m_Xbow_Algin = 0;
-// 			LeaveCriticalSection(&m_xBow_CriticalSection);
-			InterlockedExchange(&m_Xbow_Algin, 0);
-		}
+	// Each time the packets are lost counts as one bad packet
+	//
+	if (Framer->GetStats().Resyncs != resyncs)
+	{
+		clsCritical locker(m_objpCS);
+		m_Xbow_Count += (unsigned)(Framer->GetStats().Resyncs - resyncs);
 	}
+}
 
-	ftStatus = FT_Close(ftHandle);
-	if (ftStatus != FT_OK)
+DWORD WINAPI CPCANBasicExampleDlg::CallSimXbowThreadFunc(LPVOID lpParam)
+{
+	CPCANBasicExampleDlg* dialog = (CPCANBasicExampleDlg*)lpParam;
+
+	return dialog->SimXbowThreadFunc(NULL);
+}
+
+DWORD WINAPI CPCANBasicExampleDlg::SimXbowThreadFunc(LPVOID lpParam)
+{
+	// The generator describes the same run as the one of the CAN
+	// source, its streams being functions of time only
+	//
+	// The stream goes through the framer as the serial bytes do, with the
+	// bytes lost that the configuration asks for
+	//
+	TrafficGenerator generator(m_SimConfig);
+	unsigned char stream[XBOW_PACKET_SIZE * 64];
+	UINT64 start = m_Clock.Now();
+	XbowFramer framer;
+	DWORD dwSize;
+
+	while (!m_XbowTerminated)
 	{
-		InterlockedExchange(&m_XbowTerminated, 1);
-		return 1;
+		dwSize = generator.GenerateXbowStream((m_Clock.Now() - start) / 1000, stream, sizeof(stream));
+		FeedXbowBytes(&framer, stream, dwSize, m_Clock.GetRecordTime());
+		if (dwSize + XBOW_PACKET_SIZE <= sizeof(stream))
+			Sleep(1);
 	}
 
 	return 0;
@@ -2967,7 +2807,6 @@ void CPCANBasicExampleDlg::InitCrossXbow()
 	m_Xbow_hThread = NULL;
 	m_Xbow_Count = 0;
 	m_Xbow_Effictive_Count = 0;
-	m_Xbow_Msg_Latest = "";
 	m_Xbow_AddedItem = false;
 	m_Xbow_Added2Item = false;
 	m_Xbow_Algin = 0;
@@ -3040,19 +2879,27 @@ void CPCANBasicExampleDlg::StoreAccMsgList()
 
 	clsCritical locker(m_objpCS);
 
-	std::vector<CString>::const_iterator msgI = m_Xbow_Msg_List.cbegin();
-	std::vector<CString>::const_iterator msgEND = m_Xbow_Msg_List.cend();
-	const unsigned ID_NUM = 0x306;
+	std::vector<XbowSample>::const_iterator msgI = m_Xbow_Msg_List.cbegin();
+	std::vector<XbowSample>::const_iterator msgEND = m_Xbow_Msg_List.cend();
+	char szRatio[33];
+	double ratio(0);
 
 	std::vector<__int64>::const_iterator timeI = m_Xbow_CPU_Time.cbegin();
 	std::vector<__int64>::const_iterator timeEnd = m_Xbow_CPU_Time.cend();
 	CString time;
 	std::string temp;
+
+	// The bad ratio is the one of the whole session
+	//
+	if (m_Xbow_Count != 0)
+		ratio = (double)(m_Xbow_Count - m_Xbow_Effictive_Count) / (double)m_Xbow_Count;
+	_gcvt_s(szRatio, sizeof(szRatio), ratio, 6);
+	m_Xbow_Badratio = szRatio;
+	m_Xbow_Badratio += "\t";
+
 	while (msgI != msgEND)
 	{
-		CString Data;
-		Data = (*msgI);
-		DisplayGPSInformation(Data, 0, ID_NUM, true);
+		RecordXbowInformation(*msgI);
 		if (timeI != timeEnd)
 		{
 			time.Format("\t%I64u", *timeI);
@@ -3074,176 +2921,154 @@ void CPCANBasicExampleDlg::StoreMsgList()
 {
 	clsCritical locker(m_objpCS);
 
-	int iCurrentItem_GPS;
+	VBoxEpochAssembler assembler(GPS_EPOCH_TIMEOUT);
+	VBoxBatch batch;
+	VBoxFix fix;
+	size_t rows[VBOX_FRAME_COUNT] = {};
+	INT64 time;
+	DWORD gpsTime;
+	CString strTemp;
 
-	std::vector<std::pair<CString, CString>>::const_iterator msg_i = m_GPS_Msg_List.cbegin();
-	std::vector<std::pair<CString, CString>>::const_iterator msg_END = m_GPS_Msg_List.cend();
-	std::vector<uint64_t>::const_iterator timeI = m_GPS_CPU_Time.cbegin();
-	std::vector<uint64_t>::const_iterator timeEnd = m_GPS_CPU_Time.cend();
+	// The VBOX frames are decoded per ID in one pass
+	//
+	for (size_t i = 0; i < m_GPS_Msg_List.size(); i++)
+		batch.Add(m_GPS_Msg_List[i].GetID(), m_GPS_Msg_List[i].GetData(), m_GPS_Msg_List[i].GetLength(), i);
+	batch.Decode();
 
-	CString time;
-	std::string temp;
-	while (msg_i != msg_END)
+	// Then the frames of each GPS cycle are gathered, in the order they
+	// were received, into one fix recorded as one row. The CPU times are
+	// kept in parallel with the frames
+	//
+	for (size_t i = 0; i < m_GPS_Msg_List.size(); i++)
 	{
-		CString ID = (*msg_i).first;
-		CString Data;
-		ID.Truncate(ID.GetLength() - 1);
-		int ID_NUM = HexTextToUnsigned(ID);
-		if (ID_NUM >= 0x301 && ID_NUM <= 0x305)
-		{
-			iCurrentItem_GPS = min(ID_NUM - 0x301, lstMessages_GPS.GetItemCount() - 1);
-			Data = (*msg_i).second;
-			DisplayGPSInformation(Data, iCurrentItem_GPS, ID_NUM, true);
-			if (timeI != timeEnd)
-			{
-				time.Format("%I64u", *timeI);
-				temp = CT2CA(time);
-				++timeI;
-			}
-			else
-			{
-				temp = "CPU_TIME_MISSING";
-			}
-			m_GPS_Recorder += temp;
-			m_GPS_Recorder += "\n";
-		}
-
-		++msg_i;
+		DWORD ID_NUM = m_GPS_Msg_List[i].GetID();
+		if (!IsVBoxID(ID_NUM))
+			continue;
+
+		const VBoxBlock &block = batch.GetBlock(ID_NUM);
+		size_t &row = rows[ID_NUM - VBOX_ID_FIRST];
+		if (row >= block.Index.size() || block.Index[row] != i)
+			continue;
+
+		time = (i < m_GPS_CPU_Time.size()) ? (INT64)m_GPS_CPU_Time[i] : -1;
+		gpsTime = (ID_NUM == VBOX_ID_FIRST) ? (DWORD)block.Raw[1][row] : 0;
+		if (assembler.Add(ID_NUM, row, time, gpsTime, &fix))
+			RecordGPSFix(fix, batch);
+		row++;
 	}
+	if (assembler.Flush(&fix))
+		RecordGPSFix(fix, batch);
+
+	const VBoxEpochStats &stats = assembler.GetStats();
+	strTemp.Format("GPS fixes recorded: %I64u, %I64u with frames missing (%I64u timed out), %I64u repeated 0x301 dropped",
+		stats.Complete + stats.Incomplete, stats.Incomplete, stats.TimedOut, stats.Repeated);
+	IncludeTextMessage(strTemp);
 }
 
-void CPCANBasicExampleDlg::GetGPSXbowInformation(CString Data, int ID_NUM)
+void CPCANBasicExampleDlg::RecordGPSFix(const VBoxFix &Fix, const VBoxBatch &Batch)
 {
-	Data.Replace(" ", "");
+	const VBoxBlock &b301 = Batch.GetBlock(0x301), &b302 = Batch.GetBlock(0x302), &b303 = Batch.GetBlock(0x303);
+	const VBoxBlock &b304 = Batch.GetBlock(0x304), &b305 = Batch.GetBlock(0x305);
+	size_t r301 = Fix.Row[0], r302 = Fix.Row[1], r303 = Fix.Row[2], r304 = Fix.Row[3], r305 = Fix.Row[4];
+	bool has301 = HasVBoxFrame(Fix, 0x301), has302 = HasVBoxFrame(Fix, 0x302), has303 = HasVBoxFrame(Fix, 0x303);
+	bool has304 = HasVBoxFrame(Fix, 0x304), has305 = HasVBoxFrame(Fix, 0x305);
+	char szRaw[VBOX_FRAME_LENGTH * 2 + 16];
+	CString status, time;
+	size_t length;
 
-	const unsigned UNIT = 2;
-	unsigned POS = 0;
+	// Fields in the order of the header, from the raw columns of the
+	// batch, empty for the frames missing
+	//
+	m_GPS_Recorder += has301 ? RawFieldToStr(b301.Raw[1][r301]) + RawFieldToStr(b301.Raw[2][r301]) : "\t\t";
+	m_GPS_Recorder += has302 ? RawFieldToStr(b302.Raw[0][r302]) + RawFieldToStr(b302.Raw[1][r302]) + RawFieldToStr(b302.Raw[2][r302]) : "\t\t\t";
+	m_GPS_Recorder += has303 ? RawFieldToStr(b303.Raw[0][r303]) + RawFieldToStr(b303.Raw[1][r303]) : "\t\t";
+	m_GPS_Recorder += has304 ? RawFieldToStr(b304.Raw[0][r304]) + RawFieldToStr(b304.Raw[1][r304]) + RawFieldToStr(b304.Raw[2][r304]) : "\t\t\t";
+	if (has303)
+	{
+		status = UnsignedToBinString(std::bitset<8>((unsigned long)b303.Raw[2][r303]));
+		status.Truncate(status.GetLength() / 2);
+		m_GPS_Recorder += CT2CA(status);
+	}
+	m_GPS_Recorder += "\t";
+	m_GPS_Recorder += has305 ? RawFieldToStr(b305.Raw[1][r305]) + RawFieldToStr(b305.Raw[2][r305]) + RawFieldToStr(b305.Raw[0][r305]) : "\t\t\t";
+	m_GPS_Recorder += has301 ? RawFieldToStr(b301.Raw[0][r301]) : "\t";
 
-	CString Latitude(""), Longitude(""), Speed_Knots(""), Heading(""), Altitude_WGS("");
-	CString Vertical_V("");
-	CString Long_Acc(""), Lat_Acc("");
+	// Raw data of each frame, as in the GPS data column without its
+	// spaces, and ID
+	//
+	for (DWORD id = VBOX_ID_FIRST; id <= VBOX_ID_LAST; id++)
+	{
+		if (!HasVBoxFrame(Fix, id))
+		{
+			m_GPS_Recorder += "\t\t";
+			continue;
+		}
+		const VBoxBlock &block = Batch.GetBlock(id);
+		length = HexEncode((const BYTE*)&block.Payload[Fix.Row[id - VBOX_ID_FIRST]], VBOX_FRAME_LENGTH, szRaw);
+		sprintf_s(szRaw + length, sizeof(szRaw) - length, "\t%X\t", id);
+		m_GPS_Recorder += szRaw;
+	}
 
-	CString RollAngle(""), PitchAngle(""), RollRate(""), PitchRate(""), YawRate("");
-	CString AccX(""), AccY(""), AccZ("");
+	// The GPS time going back before the first one is flagged
+	//
+	if (has301 && Fix.GPSTime != 0)
+	{
+		unsigned isfirst(0);
+		InterlockedExchange(&isfirst, m_GPS_Is_First);
+		if (isfirst)
+		{
+			m_GPS_Begin_Time = Fix.GPSTime;
+			InterlockedExchange(&m_GPS_Is_First, 0);
+		}
+		else
+		{
+			if (m_GPS_Begin_Time > Fix.GPSTime)
+				m_GPS_Recorder += "WARNING";
+		}
+	}
 
-	int temp = -1, subtemp = -1;
-	int upt = -1, lowt = -1;
-	short signed stemp = -1;
-	unsigned utemp = 0, tempT = 0, tempH = 0, tempM = 0, tempM1 = 0, tempS = 0;
-	double lowv(-1);
-	std::bitset<8> bitw(0);
+	// CPU time of the first frame of the epoch
+	//
+	if (Fix.FirstTime >= 0)
+	{
+		time.Format("%I64d", Fix.FirstTime);
+		m_GPS_Recorder += CT2CA(time);
+	}
+	else
+		m_GPS_Recorder += "CPU_TIME_MISSING";
+	m_GPS_Recorder += "\n";
+}
 
-	CString MSG = "PlaceHolder_Xbow";
+std::string CPCANBasicExampleDlg::RawFieldToStr(int Value)
+{
+	char szValue[33];
 
+	_itoa_s(Value, szValue, sizeof(szValue), 10);
+	return std::string(szValue) + "\t";
+}
+
+void CPCANBasicExampleDlg::GetGPSXbowInformation()
+{
+	// Only a placeholder is sent for the Xbow. Once the string holds it,
+	// assigning it again does not allocate
+	//
+	{
+		clsCritical locker(m_objpCS);
+		m_Xbow_Msg_TobeSent = "PlaceHolder_Xbow";
+	}
+	SetEvent(m_Xbow_Net_Event);
+}
+
+void CPCANBasicExampleDlg::GetGPSInformation(const VBoxData &VBox, int ID_NUM)
+{
 	switch (ID_NUM)
 	{
-// 	case 0x301:
-// 		POS += UNIT;
-// 
-// 		POS += 3 * UNIT;
-// 
-// 		Latitude = Data.Mid(POS, 4 * UNIT);
-// 		temp = (int)HexTextToUnsigned(Latitude);
-// 
-// 		m_GPS_Msg_Latest += "LatitudeBEGIN" + Latitude + "LatitudeEND";
-// 		InterlockedIncrement(&m_GPS_Send_Num_Count);
-// 		break;
 	case 0x302:
-// 		Longitude = Data.Mid(0, 4 * UNIT);
-// 		temp = (int)HexTextToUnsigned(Longitude);
-// 		m_GPS_Msg_Latest += "LongitudeBEGIN" + Longitude + "LongitudeEND";
-// 		POS += 4 * UNIT;
-
-		Speed_Knots = Data.Mid(POS, 2 * UNIT);
-		temp = HexTextToUnsigned(Speed_Knots);
-		m_GPS_Msg_Latest.Format("%.3f\n",double(temp)*0.01f*1.852f);
-		POS += 2 * UNIT;
-
-// 		Heading = Data.Mid(POS, 2 * UNIT);
-// 		temp = HexTextToUnsigned(Heading);
-// 		m_GPS_Msg_Latest += "HeadingBEGIN" + Heading + "HeadingEND";
-		
+		// Speed in km/h
+		//
+		m_GPS_Msg_Latest.Format("%.3f\n", double(GetVBoxNetworkSpeed(VBox))*0.01f*1.852f);
 		InterlockedIncrement(&m_GPS_Send_Num_Count);
 		break;
-// 	case 0x303:
-// 		Altitude_WGS = Data.Mid(0, 3 * UNIT);
-// 		temp = HexTextToUnsigned(Altitude_WGS);
-// 		if (Altitude_WGS.GetAt(0) >= '8')
-// 			temp -= (0xFFFFFF + 0x1); //24bit signed
-// 		m_GPS_Msg_Latest += "AltitudeBEGIN" + Altitude_WGS + "AltitudeEND";
-// 		POS += 3 * UNIT;
-// 
-// 		Vertical_V = Data.Mid(POS, 2 * UNIT);
-// 		stemp = (short signed)HexTextToUnsigned(Vertical_V);
-// 		m_GPS_Msg_Latest += "VSpeedBEGIN" + Vertical_V + "VSpeedEND";
-// 		POS += 2 * UNIT;
-// 
-// 		POS += 2 * UNIT;
-// 		
-// 		InterlockedIncrement(&m_GPS_Send_Num_Count);
-// 		break;
-// 	case 0x304:
-// 		POS += 4 * UNIT;
-// 
-// 		Long_Acc = Data.Mid(POS, 2 * UNIT);
-// 		stemp = (short signed)HexTextToUnsigned(Long_Acc);
-// 		POS += 2 * UNIT;
-// 		m_GPS_Msg_Latest += "LongAccBEGIN" + Long_Acc + "LongAccEND";
-// 
-// 		Lat_Acc = Data.Mid(POS, 2 * UNIT);
-// 		stemp = (short signed)HexTextToUnsigned(Lat_Acc);
-// 		m_GPS_Msg_Latest += "LatAccBEGIN" + Lat_Acc + "LatAccEND";
-// 
-// 		InterlockedIncrement(&m_GPS_Send_Num_Count);
-// 		break;
-// 	case 0x305:
-// 		POS += 4 * UNIT;
-// 
-// 		POS += 2 * UNIT;
-// 		break;
-	case 0x306:
-		RollAngle = Data.Mid(1 * UNIT, 2 * UNIT);
-		PitchAngle = Data.Mid(3 * UNIT, 2 * UNIT);
-		RollRate = Data.Mid(5 * UNIT, 2 * UNIT);
-		PitchRate = Data.Mid(7 * UNIT, 2 * UNIT);
-		YawRate = Data.Mid(9 * UNIT, 2 * UNIT);
-		AccX = Data.Mid(11 * UNIT, 2 * UNIT);
-		AccY = Data.Mid(13 * UNIT, 2 * UNIT);
-		AccZ = Data.Mid(15 * UNIT, 2 * UNIT);
-
-		stemp = (short signed)HexTextToUnsigned(RollAngle);
-		lowv = (double)stemp * (180.0f) / pow(2, 15);
-		RollAngle.Format("%s: %.6f  ", "X_Angle", lowv);
-
-		stemp = (short signed)HexTextToUnsigned(PitchAngle);
-		lowv = (double)stemp * (180.0f) / pow(2, 15);
-		PitchAngle.Format("%s: %.6f", "Y_Angle", lowv);
-
-		stemp = (short signed)HexTextToUnsigned(RollRate);
-		lowv = (double)stemp * 200.0f * 1.5f / pow(2, 15);
-		RollRate.Format("%s: %.6f  ", "X_Rate", lowv);
-
-		stemp = (short signed)HexTextToUnsigned(PitchRate);
-		lowv = (double)stemp * 200.0f * 1.5f / pow(2, 15);
-		PitchRate.Format("%s: %.6f", "Y_Rate", lowv);
-
-		stemp = (short signed)HexTextToUnsigned(YawRate);
-		lowv = (double)stemp * 200.0f * 1.5f / pow(2, 15);
-		YawRate.Format("%s: %.6f  ", "Z_Rate", lowv);
-
-		stemp = (short signed)HexTextToUnsigned(AccX);
-		lowv = (double)stemp * 2.0f * 1.5f / pow(2, 15);
-		AccX.Format("%s: %.6f", "AccX", lowv);
-
-		stemp = (short signed)HexTextToUnsigned(AccY);
-		lowv = (double)stemp * 2.0f * 1.5f / pow(2, 15);
-		AccY.Format("%s: %.6f  ", "AccY", lowv);
-
-		stemp = (short signed)HexTextToUnsigned(AccZ);
-		lowv = (double)stemp * 2.0f * 1.5f / pow(2, 15);
-		AccZ.Format("%s: %.6f", "AccZ", lowv);
-
-	break;
 	default:
 		break;
 	}
@@ -3259,37 +3084,24 @@ void CPCANBasicExampleDlg::GetGPSXbowInformation(CString Data, int ID_NUM)
 		m_GPS_Msg_Latest = "";
 		SetEvent(m_GPS_Net_Event);
 	}
-
-	else if (ID_NUM == 0x306)
-	{
-		CT2CA pszConvertedAnsiString(MSG);
-		{
-			clsCritical locker(m_objpCS);
-			m_Xbow_Msg_TobeSent = pszConvertedAnsiString;
-		}
-		SetEvent(m_Xbow_Net_Event);
-	}
 }
 
-void CPCANBasicExampleDlg::DisplayGPSInformation(CString GPS, int iCurrentItem_GPS, int ID_NUM, bool WriteEnable /* = False*/)
+void CPCANBasicExampleDlg::DisplayGPSInformation(CString GPS, const VBoxData *VBox, int iCurrentItem_GPS, int ID_NUM)
 {
 	lstMessages_GPS.SetItemText(iCurrentItem_GPS, GPS_DATA, GPS);
-	GPS.Replace(" ", "");
+
+	// The VBOX fields come decoded from the frame, the text is only shown
+	//
+	if (IsVBoxID(ID_NUM) && VBox == NULL)
+		return;
 
 	const unsigned UNIT = 2;
-	unsigned POS = 0;
 
 	CString Sats(""), Time(""), Latitude(""), Longitude(""), Speed_Knots(""), Heading(""), Altitude_WGS("");
 	CString VQuality(""), D_GPS(""), Vertical_V("");
 	CString Trig_Dist(""), Long_Acc(""), Lat_Acc("");
 	CString Trig_Time(""), Trig_V(""), Distance("");
-	
-	CString RollAngle(""), PitchAngle(""), RollRate(""), PitchRate(""), YawRate("");
-	CString AccX(""), AccY(""), AccZ(""), Tempature("");
-	CString Badratio("");
 
-	unsigned placeholder(0);
-	
 	int temp = -1,subtemp = -1;
 	int upt = -1, lowt = -1;
 	short signed stemp = -1;
@@ -3303,22 +3115,12 @@ void CPCANBasicExampleDlg::DisplayGPSInformation(CString GPS, int iCurrentItem_G
 	switch (ID_NUM) 
 	{
 	case 0x301:
-		Sats = GPS.Mid(0, UNIT);
-		temp = HexTextToUnsigned(Sats);
-		_itoa_s(temp, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_Sats = double2char;
-		m_GPS_Str_Sats += "\t";
+		temp = VBox->Sats;
 		Sats = "Sats.:  " + IntToStr(temp);
 		InterlockedExchange(&utemp, m_GPS_Msg_Sent_Num);
 		Sats += "  Sent:  " + IntToStr(utemp);
-		POS += UNIT;
 
-		Time = GPS.Mid(POS, 3 * UNIT);
-		tempT = HexTextToUnsigned(Time);
-		placeholder = tempT;
-		_itoa_s(tempT, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_Time = double2char;
-		m_GPS_Str_Time += "\t";
+		tempT = VBox->Time;
 
 		utemp = tempT % 100;
 		tempT /= 100;
@@ -3332,13 +3134,8 @@ void CPCANBasicExampleDlg::DisplayGPSInformation(CString GPS, int iCurrentItem_G
 		tempH = tempH % 24;
 
 		Time = "UTC+10: " + FormatTimeString(tempH, tempM1, tempS, utemp);
-		POS += 3 * UNIT;
 
-		Latitude = GPS.Mid(POS, 4 * UNIT);
-		temp = (int) HexTextToUnsigned(Latitude);
-		_itoa_s(temp, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_X = double2char;
-		m_GPS_Str_X += "\t";
+		temp = VBox->Latitude;
 
 		subtemp = temp % 100000;
 		temp /= 100000;
@@ -3356,16 +3153,9 @@ void CPCANBasicExampleDlg::DisplayGPSInformation(CString GPS, int iCurrentItem_G
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, GPS_SATS, Sats);
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, GPS_TIME, Time);
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, GPS_LATITUDE, Latitude);
-
-		m_GPS_Str_RAW.at(0) = GPS + "\t" + "301" + "\t";
-		++m_GPS_Num_Count;
 		break;
 	case 0x302:
-		Longitude = GPS.Mid(0, 4 * UNIT);
-		temp = (int) HexTextToUnsigned(Longitude);
-		_itoa_s(temp, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_Y = double2char;
-		m_GPS_Str_Y += "\t";
+		temp = VBox->Longitude;
 
 		subtemp = temp % 100000;
 		temp /= 100000;
@@ -3380,13 +3170,7 @@ void CPCANBasicExampleDlg::DisplayGPSInformation(CString GPS, int iCurrentItem_G
 		_gcvt_s(double2char, sizeofdouble2str, abs(lowv), 10);
 		Longitude += " (" + sign + double2char + ")";
 
-		POS += 4 * UNIT;
-
-		Speed_Knots = GPS.Mid(POS, 2 * UNIT);
-		temp = HexTextToUnsigned(Speed_Knots);
-		_itoa_s(temp, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_Velocity = double2char;
-		m_GPS_Str_Velocity += "\t";
+		temp = VBox->Speed;
 
 		upt = temp / 100;
 		lowt = temp % 100;
@@ -3396,13 +3180,7 @@ void CPCANBasicExampleDlg::DisplayGPSInformation(CString GPS, int iCurrentItem_G
 		_gcvt_s(double2char, sizeofdouble2str, lowv, 5);
 		Speed_Knots += " (" + (CString)double2char + ")";
 
-		POS += 2 * UNIT;
-
-		Heading = GPS.Mid(POS, 2 * UNIT);
-		temp = HexTextToUnsigned(Heading);
-		_itoa_s(temp, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_Heading = double2char;
-		m_GPS_Str_Heading += "\t";
+		temp = VBox->Heading;
 
 		upt = temp / 100;
 		lowt = temp % 100;
@@ -3411,83 +3189,45 @@ void CPCANBasicExampleDlg::DisplayGPSInformation(CString GPS, int iCurrentItem_G
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, GPS_LONGITUDE, Longitude);
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, GPS_SPEED_KNOTS, Speed_Knots);
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, GPS_HEADING, Heading);
-
-		m_GPS_Str_RAW.at(1) = GPS + "\t" + "302" + "\t";
-		++m_GPS_Num_Count;
 		break;
 	case 0x303:
-		Altitude_WGS = GPS.Mid(0, 3 * UNIT);
-		temp = HexTextToUnsigned(Altitude_WGS);
-		if (Altitude_WGS.GetAt(0) >= '8')
-			temp -= (0xFFFFFF + 0x1); //24bit signed
-		_itoa_s(temp, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_WGS84 = double2char;
-		m_GPS_Str_WGS84 += "\t";
+		temp = VBox->Altitude;
 
 		upt = temp / 100;
 		lowt = temp % 100;
 		temp < 0 ? sign = "- " : sign = "+ ";
 		Altitude_WGS = "WGS.84: " + sign + IntToStr(abs(upt)) + "." + IntToStr(abs(lowt));
-		POS += 3 * UNIT;
 
-		Vertical_V = GPS.Mid(POS, 2 * UNIT);
-		stemp = (short signed) HexTextToUnsigned(Vertical_V);
-		_itoa_s(stemp, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_VerticalV = double2char;
-		m_GPS_Str_VerticalV += "\t";
+		stemp = VBox->VerticalSpeed;
 
 		upt = stemp / 100;
 		lowt = stemp % 100;
 		stemp < 0 ? sign = "- " : sign = "+ ";
 		Vertical_V = "Vertical Speed: " + sign + IntToStr(abs(upt)) + "." + IntToStr(abs(lowt));
-		POS += 2 * UNIT;
 
-		POS += 2 * UNIT;
-		D_GPS = GPS.Mid(POS, UNIT);
-		bitw = HexTextToUnsigned(D_GPS);
+		bitw = VBox->Status;
 		D_GPS = UnsignedToBinString(bitw);
 		D_GPS.Truncate(D_GPS.GetLength() / 2);
-		m_GPS_Str_Status = D_GPS;
-		m_GPS_Str_Status += "\t";
 
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, GPS_ALTITUDE_WGS, Altitude_WGS);
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, GPS_Vertical_V, Vertical_V);
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, GPS_DGPS, D_GPS);
-
-		m_GPS_Str_RAW.at(2) = GPS + "\t" + "303" + "\t";
-		++m_GPS_Num_Count;
 		break;
 	case 0x304:
-		Trig_Dist = GPS.Mid(0, 4 * UNIT);
-		tempT = HexTextToUnsigned(Trig_Dist);
-		_itoa_s(tempT, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_TrigDist = double2char;
-		m_GPS_Str_TrigDist += "\t";
+		tempT = VBox->TrigDistance;
 
 		lowv = (double)tempT * 0.000078125f;
 		_gcvt_s(double2char, sizeofdouble2str, lowv, 9);
 		Trig_Dist = "Trig_Dist: " + (CString)double2char;
 
-		POS += 4 * UNIT;
-
-		Long_Acc = GPS.Mid(POS, 2 * UNIT);
-		stemp = (short signed)HexTextToUnsigned(Long_Acc);
-		_itoa_s(stemp, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_LongAcc = double2char;
-		m_GPS_Str_LongAcc += "\t";
+		stemp = VBox->LongAcc;
 
 		upt = stemp / 100;
 		lowt = stemp % 100;
 		stemp < 0 ? sign = "- " : sign = "+ ";
 		Long_Acc = "Long_Acc: " + sign + IntToStr(abs(upt)) + "." + IntToStr(abs(lowt));
 
-		POS += 2 * UNIT;
-
-		Lat_Acc = GPS.Mid(POS, 2 * UNIT);
-		stemp = (short signed)HexTextToUnsigned(Lat_Acc);
-		_itoa_s(stemp, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_LatACC = double2char;
-		m_GPS_Str_LatACC += "\t";
+		stemp = VBox->LatAcc;
 
 		stemp < 0 ? sign = "- " : sign = "+ ";
 		upt = stemp / 100;
@@ -3497,47 +3237,24 @@ void CPCANBasicExampleDlg::DisplayGPSInformation(CString GPS, int iCurrentItem_G
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, 1, Trig_Dist);
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, 2, Long_Acc);
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, 3, Lat_Acc);
-
-		m_GPS_Str_RAW.at(3) = GPS + "\t" + "304" + "\t";
-		++m_GPS_Num_Count;
 		break;
 	case 0x305:
-		Distance = GPS.Mid(POS, 4 * UNIT);
-		tempT = HexTextToUnsigned(Distance);
-		_itoa_s(tempT, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_Distance = double2char;
-		m_GPS_Str_Distance += "\t";
-
-		lowv = (double)tempT * 0.000078125f;
-		m_GPS_Distance_Offset = (lowv < m_GPS_Distance_Offset ? m_GPS_First_Distance + max(lowv, 0.000078125f) : m_GPS_Distance_Offset);
-		lowv += m_GPS_Distance_Offset;
+		// Distance of the trial, kept in counts across the wraps and the
+		// resets of the VBOX counter
+		//
+		m_GPS_Distance.Update(VBox->Distance);
+		_gcvt_s(double2char, sizeofdouble2str, m_GPS_Distance.GetMeters(), 12);
 
-		m_GPS_First_Distance = (m_GPS_First_Distance < 0 ? lowv : m_GPS_First_Distance);
-		_gcvt_s(double2char, sizeofdouble2str, lowv - m_GPS_First_Distance, 9);
-		
 		Distance = "Distance: " + (CString)double2char;
 		Distance += "\t";
-		m_GPS_First_Distance = lowv;
 
-		POS += 4 * UNIT;
-
-		Trig_Time = GPS.Mid(POS, 2 * UNIT);
-		temp = HexTextToUnsigned(Trig_Time);
-		_itoa_s(temp, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_TrigTime = double2char;
-		m_GPS_Str_TrigTime += "\t";
+		temp = VBox->TrigTime;
 
 		upt = temp / 100;
 		lowt = temp % 100;
 		Trig_Time = "Trig_Time: " + IntToStr(upt) + "." + IntToStr(lowt);
 
-		POS += 2 * UNIT;
-
-		Trig_V = GPS.Mid(POS, 2 * UNIT);
-		temp = HexTextToUnsigned(Trig_V);
-		_itoa_s(temp, double2char, sizeofdouble2str, 10);
-		m_GPS_Str_TrigV = double2char;
-		m_GPS_Str_TrigV += "\t";
+		temp = VBox->TrigSpeed;
 
 		upt = temp / 100;
 		lowt = temp % 100;
@@ -3550,195 +3267,93 @@ void CPCANBasicExampleDlg::DisplayGPSInformation(CString GPS, int iCurrentItem_G
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, 1, Distance);
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, 2, Trig_Time);
 		lstMessages_GPS.SetItemText(iCurrentItem_GPS, 3, Trig_V);
-
-		m_GPS_Str_RAW.at(4) = GPS + "\t" + "305" + "\t";
-		++m_GPS_Num_Count;
 		break;
-	case 0x306:
-		// 		EnterCriticalSection(&m_xBow_CriticalSection);
-		// 		utemp = m_Xbow_Count;
-		// 		tempT = m_Xbow_Effictive_Count;
-		// 		LeaveCriticalSection(&m_xBow_CriticalSection);
+	default:
+		break;
+	}
+}
 
-		{
-			clsCritical locker(m_objpCS);
-			utemp = m_Xbow_Count;
-			tempT = m_Xbow_Effictive_Count;
-		}
+void CPCANBasicExampleDlg::DisplayXbowInformation(CString Packet, const XbowSample &Sample, int iCurrentItem_GPS)
+{
+	CString RollAngle(""), PitchAngle(""), RollRate(""), PitchRate(""), YawRate("");
+	CString AccX(""), AccY(""), AccZ(""), Tempature(""), Time("");
+	CString Badratio("");
+	unsigned count = 0, effective = 0, sent = 0;
+	double ratio(0);
 
-		if (utemp == 0)
-			lowv = 0.0f;
-		else
-			lowv = (double)(utemp - tempT) / (double)utemp;
-		_gcvt_s(double2char, sizeofdouble2str, lowv, 6);
-		m_Xbow_Badratio = double2char;
-		m_Xbow_Badratio += "\t";
-		Badratio.Format("%s: %d (bad: %.3f)", "Xbow: ", utemp,lowv);
-
-		RollAngle = GPS.Mid(1*UNIT, 2*UNIT);
-		PitchAngle = GPS.Mid(3*UNIT, 2*UNIT);
-		RollRate = GPS.Mid(5 * UNIT, 2 * UNIT);
-		PitchRate = GPS.Mid(7 * UNIT, 2 * UNIT);
-		YawRate = GPS.Mid(9 * UNIT, 2 * UNIT);
-		AccX = GPS.Mid(11 * UNIT, 2 * UNIT);
-		AccY = GPS.Mid(13 * UNIT, 2 * UNIT);
-		AccZ = GPS.Mid(15 * UNIT, 2 * UNIT);
-		Tempature = GPS.Mid(17 * UNIT, 2 * UNIT);
-		Time = GPS.Mid(19 * UNIT, 2 * UNIT);
-
-		stemp = (short signed)HexTextToUnsigned(RollAngle);
-		lowv = (double)stemp * (180.0f) / pow(2, 15);
-		_itoa_s(stemp, double2char, sizeofdouble2str, 10);
-		m_Xbow_RollAngle = double2char;
-		m_Xbow_RollAngle += "\t";
-		RollAngle.Format("%s: %.3f  ","X_Angle",lowv);
-		
-		stemp = (short signed)HexTextToUnsigned(PitchAngle);
-		lowv = (double)stemp * (180.0f) / pow(2, 15);
-		_itoa_s(stemp, double2char, sizeofdouble2str, 10);
-		m_Xbow_PitchAngle = double2char;
-		m_Xbow_PitchAngle += "\t";
-		PitchAngle.Format("%s: %.3f", "Y_Angle", lowv);
-
-		RollAngle += PitchAngle;
-
-		stemp = (short signed)HexTextToUnsigned(RollRate);
-		lowv = (double)stemp * 200.0f * 1.5f / pow(2, 15);
-		_itoa_s(stemp, double2char, sizeofdouble2str, 10);
-		m_Xbow_RollRate = double2char;
-		m_Xbow_RollRate += "\t";
-		RollRate.Format("%s: %.3f  ", "X_Rate", lowv);
-
-		stemp = (short signed)HexTextToUnsigned(PitchRate);
-		lowv = (double)stemp * 200.0f * 1.5f / pow(2, 15);
-		_itoa_s(stemp, double2char, sizeofdouble2str, 10);
-		m_Xbow_PitchRate = double2char;
-		m_Xbow_PitchRate += "\t";
-		PitchRate.Format("%s: %.3f", "Y_Rate", lowv);
-
-		RollRate += PitchRate;
-
-		stemp = (short signed)HexTextToUnsigned(YawRate);
-		lowv = (double)stemp * 200.0f * 1.5f / pow(2, 15);
-		_itoa_s(stemp, double2char, sizeofdouble2str, 10);
-		m_Xbow_YawRate = double2char;
-		m_Xbow_YawRate += "\t";
-		YawRate.Format("%s: %.3f  ", "Z_Rate", lowv);
-
-		stemp = (short signed)HexTextToUnsigned(AccX);
-		lowv = (double)stemp * 4.0f * 1.5f / pow(2, 15);
-		_itoa_s(stemp, double2char, sizeofdouble2str, 10);
-		m_Xbow_AccX = double2char;
-		m_Xbow_AccX += "\t";
-		AccX.Format("%s: %.3f", "AccX", lowv);
-
-		YawRate += AccX;
-
-		stemp = (short signed)HexTextToUnsigned(AccY);
-		lowv = (double)stemp * 4.0f * 1.5f / pow(2, 15);
-		_itoa_s(stemp, double2char, sizeofdouble2str, 10);
-		m_Xbow_AccY = double2char;
-		m_Xbow_AccY += "\t";
-		AccY.Format("%s: %.3f  ", "AccY", lowv);
-
-		stemp = (short signed)HexTextToUnsigned(AccZ);
-		lowv = (double)stemp * 4.0f * 1.5f / pow(2, 15);
-		_itoa_s(stemp, double2char, sizeofdouble2str, 10);
-		m_Xbow_AccZ = double2char;
-		m_Xbow_AccZ += "\t";
-		AccZ.Format("%s: %.3f", "AccZ", lowv);
-
-		AccY += AccZ;
-
-		utemp = HexTextToUnsigned(Tempature);
-		lowv = (((double)utemp * 5.0f / 4096.0f) - 1.375f) * 44.44f;
-		_itoa_s(utemp, double2char, sizeofdouble2str, 10);
-		m_Xbow_Tem = double2char;
-		m_Xbow_Tem += "\t";
-		Tempature.Format("%s: %.3f", "Tempature", lowv);
-
-		utemp = HexTextToUnsigned(Time);
-		_itoa_s(utemp, double2char, sizeofdouble2str, 10);
-		m_Xbow_Time = double2char;
-		m_Xbow_Time += "\t";
-		InterlockedExchange(&tempS, m_Xbow_Msg_Sent_Num);
-		Time.Format("%s: %d  Sent: %d", "Time", utemp, tempS);
-
-		if (!m_Xbow_Added2Item)
-		{
-			ADDLVItem_GPS(GPS);
-			m_Xbow_Added2Item = true;
-		}
+	lstMessages_GPS.SetItemText(iCurrentItem_GPS, GPS_DATA, Packet);
+	Packet.Replace(" ", "");
 
-		lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 2, 0, GPS.Mid(0 * UNIT, 11 * UNIT));
-		lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 2, 1, RollAngle);
-		lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 2, 2, YawRate);
-		lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 2, 3, Badratio);
+	InterlockedExchange(&count, m_Xbow_Count);
+	InterlockedExchange(&effective, m_Xbow_Effictive_Count);
+	if (count != 0)
+		ratio = (double)(count - effective) / (double)count;
+	Badratio.Format("%s: %d (bad: %.3f)", "Xbow: ", count, ratio);
 
-		lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 1, 0, GPS.Mid(11 * UNIT + 1, 11 * UNIT));
-		lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 1, 1, RollRate);
-		lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 1, 2, AccY);
-		lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 1, 3, Time);
+	RollAngle.Format("%s: %.3f  ", "X_Angle", GetXbowAngle(Sample.RollAngle));
+	PitchAngle.Format("%s: %.3f", "Y_Angle", GetXbowAngle(Sample.PitchAngle));
+	RollAngle += PitchAngle;
 
-		break;
-	default:
-		break;
-	}
+	RollRate.Format("%s: %.3f  ", "X_Rate", GetXbowRate(Sample.RollRate));
+	PitchRate.Format("%s: %.3f", "Y_Rate", GetXbowRate(Sample.PitchRate));
+	RollRate += PitchRate;
 
-	if (WriteEnable)
-	{
-		if (m_GPS_Num_Count >= GPS_NUM_COUNT)
-		{
-			m_GPS_Num_Count = 0;
+	YawRate.Format("%s: %.3f  ", "Z_Rate", GetXbowRate(Sample.YawRate));
+	AccX.Format("%s: %.3f", "AccX", GetXbowAcc(Sample.AccX));
+	YawRate += AccX;
 
-			m_GPS_Recorder += m_GPS_Str_Time + m_GPS_Str_X + m_GPS_Str_Y + m_GPS_Str_Velocity + m_GPS_Str_Heading;
-			m_GPS_Recorder += m_GPS_Str_WGS84 + m_GPS_Str_Velocity + m_GPS_Str_TrigDist + m_GPS_Str_LongAcc;
-			m_GPS_Recorder += m_GPS_Str_LatACC + m_GPS_Str_Status + m_GPS_Str_TrigTime + m_GPS_Str_TrigV;
-			m_GPS_Recorder += m_GPS_Str_Distance + m_GPS_Str_Sats;
+	AccY.Format("%s: %.3f  ", "AccY", GetXbowAcc(Sample.AccY));
+	AccZ.Format("%s: %.3f", "AccZ", GetXbowAcc(Sample.AccZ));
+	AccY += AccZ;
 
-			std::vector<std::string>::const_iterator i = m_GPS_Str_RAW.cbegin();
-			std::vector<std::string>::const_iterator END = m_GPS_Str_RAW.cend();
-			while (i != END)
-			{
-				m_GPS_Recorder += *i;
-				++i;
-			}
-			m_GPS_Str_RAW.assign(GPS_DATA_COUNT, "");
+	Tempature.Format("%s: %.3f", "Tempature", GetXbowTemperature(Sample.Temperature));
 
-			if (placeholder)
-			{
-				unsigned isfirst(0);
-				InterlockedExchange(&isfirst, m_GPS_Is_First);
-				if (isfirst)
-				{
-					m_GPS_Begin_Time = placeholder;
-					InterlockedExchange(&m_GPS_Is_First, 0);
-				}
-				else
-				{
-					if (m_GPS_Begin_Time > placeholder)
-						m_GPS_Recorder += "WARNING";
-				}
-			}
+	InterlockedExchange(&sent, m_Xbow_Msg_Sent_Num);
+	Time.Format("%s: %d  Sent: %d", "Time", Sample.Time, sent);
 
-// 			m_GPS_Recorder += "\n";
+	if (!m_Xbow_Added2Item)
+	{
+		ADDLVItem_GPS(Packet);
+		m_Xbow_Added2Item = true;
+	}
 
-			return;
-		}
+	lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 2, 0, Packet.Mid(0, 22));
+	lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 2, 1, RollAngle);
+	lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 2, 2, YawRate);
+	lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 2, 3, Badratio);
 
-		if (GPS.GetLength() == 22 * 2)
-		{
-			m_Xbow_Recorder += m_Xbow_RollAngle + m_Xbow_PitchAngle + m_Xbow_RollRate + m_Xbow_PitchRate;
-			m_Xbow_Recorder += m_Xbow_YawRate + m_Xbow_AccX + m_Xbow_AccY + m_Xbow_AccZ;
-			m_Xbow_Recorder += m_Xbow_Tem + m_Xbow_Time;
-			m_Xbow_Recorder += m_Xbow_Badratio;
-			m_Xbow_Recorder += GPS;
+	lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 1, 0, Packet.Mid(23, 22));
+	lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 1, 1, RollRate);
+	lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 1, 2, AccY);
+	lstMessages_GPS.SetItemText(lstMessages_GPS.GetItemCount() - 1, 3, Time);
+}
 
-// 			m_Xbow_Recorder += "\n";
+void CPCANBasicExampleDlg::RecordXbowInformation(const XbowSample &Sample)
+{
+	char szRaw[XBOW_PACKET_SIZE * 2 + 1];
+	BYTE packet[XBOW_PACKET_SIZE];
 
-			return;
-		}
-	}
+	m_Xbow_RollAngle = RawFieldToStr(Sample.RollAngle);
+	m_Xbow_PitchAngle = RawFieldToStr(Sample.PitchAngle);
+	m_Xbow_RollRate = RawFieldToStr(Sample.RollRate);
+	m_Xbow_PitchRate = RawFieldToStr(Sample.PitchRate);
+	m_Xbow_YawRate = RawFieldToStr(Sample.YawRate);
+	m_Xbow_AccX = RawFieldToStr(Sample.AccX);
+	m_Xbow_AccY = RawFieldToStr(Sample.AccY);
+	m_Xbow_AccZ = RawFieldToStr(Sample.AccZ);
+	m_Xbow_Tem = RawFieldToStr(Sample.Temperature);
+	m_Xbow_Time = RawFieldToStr(Sample.Time);
+
+	// Raw packet, rebuilt from the sample as it was received
+	//
+	PackXbowSample(Sample, packet);
+	HexEncode(packet, XBOW_PACKET_SIZE, szRaw);
+
+	m_Xbow_Recorder += m_Xbow_RollAngle + m_Xbow_PitchAngle + m_Xbow_RollRate + m_Xbow_PitchRate;
+	m_Xbow_Recorder += m_Xbow_YawRate + m_Xbow_AccX + m_Xbow_AccY + m_Xbow_AccZ;
+	m_Xbow_Recorder += m_Xbow_Tem + m_Xbow_Time;
+	m_Xbow_Recorder += m_Xbow_Badratio;
+	m_Xbow_Recorder += szRaw;
 }
 
 CString CPCANBasicExampleDlg::FormatTimeString(unsigned hour, unsigned minute, unsigned seconds, unsigned remainder)
@@ -3755,23 +3370,13 @@ CString CPCANBasicExampleDlg::FormatTimeString(unsigned hour, unsigned minute, u
 	return formatted;
 }
 
-unsigned CPCANBasicExampleDlg::HexTextToUnsigned(CString ToConvert)
-{
-	unsigned int x;
-	std::stringstream ss;
-	ss << std::hex << ToConvert;
-	ss >> x;
-
-	return x;
-}
-
 CString CPCANBasicExampleDlg::UnsignedToBinString(const std::bitset<8> &bitw)
 {
 	CString binw("");
 
 	size_t counts = bitw.size();
 	unsigned num = 0;
-	for (size_t i = counts - 1; i >= 0 ; i--)
+	for (size_t i = counts; i-- > 0; )
 	{
 		bitw.test(i) == false ? binw += '0' : binw += '1';
 		++num;
@@ -3875,12 +3480,54 @@ void CPCANBasicExampleDlg::WriteGPSFile()
 		}
 	}
 
-	dir += "GPS.txt";
-
 	std::ofstream myfile;
-	myfile.open(dir, std::ofstream::out);
+	myfile.open(dir + "GPS.txt", std::ofstream::out);
 	myfile << m_GPS_Recorder;
 	myfile.close();
+
+	// The clock mapping of the session is stored next to the data
+	//
+	myfile.open(dir + "Clock.txt", std::ofstream::out);
+	myfile << m_Clock.GetSessionInfo();
+	myfile.close();
+
+	// And the state of the trial distance, from which a replay of the
+	// next part of the session can go on
+	//
+	myfile.open(dir + "Distance.txt", std::ofstream::out);
+	myfile << FormatVBoxDistanceState(m_GPS_Distance.GetState());
+	myfile.close();
+
+	// And the timing statistics of every received message
+	//
+	{
+		clsCritical locker(m_objpCS);
+		m_TimingStats.Publish();
+	}
+	myfile.open(dir + "Timing.txt", std::ofstream::out);
+	myfile << m_TimingStats.GetReport();
+	myfile.close();
+
+	// And the vehicle signals, if a DBC file was loaded
+	//
+	if (m_SignalPlan.GetSignalCount() > 0)
+	{
+		clsCritical locker(m_objpCS);
+
+		myfile.open(dir + "Signals.txt", std::ofstream::out);
+		myfile << m_SignalPlan.GetReport(m_SignalBuffer);
+		myfile.close();
+	}
+}
+
+void CPCANBasicExampleDlg::StartClockSession()
+{
+	// The wall clock is only read here, all recorded times are
+	// derived from the monotonic clock afterwards
+	//
+	boost::posix_time::time_duration diff = boost::posix_time::microsec_clock::local_time() - time_t_epoch;
+
+	m_Clock.StartSession((INT64)diff.total_microseconds() * 1000);
 }
 
 void CPCANBasicExampleDlg::WriteShutterGlass()
@@ -3958,120 +3605,116 @@ void CPCANBasicExampleDlg::WriteShutterGlass()
 // 	btnRefreshCom.EnableWindow(TRUE);
 // }
 
-void CPCANBasicExampleDlg::ProcessMessage(TPCANMsgFD theMsg, TPCANTimestampFD itsTimeStamp)
+void CPCANBasicExampleDlg::ProcessMessages(const TPCANMsgFDEntry *entries, const UINT64 *hostTimes, DWORD count)
+{
+	// The whole burst is handled in one protected environment
+	//
+	clsCritical locker(m_objpCS);
+
+	for (DWORD i = 0; i < count; i++)
+		ProcessMessageLocked(MakeFrameView(entries[i].Msg), entries[i].Timestamp, hostTimes[i]);
+}
+
+void CPCANBasicExampleDlg::ProcessMessageLocked(const CANFrameView &theMsg, TPCANTimestampFD itsTimeStamp, UINT64 hostTime)
 {
-	POSITION pos;
 	MessageStatus *msg;
+	int index;
+
+	m_TimingStats.Update(theMsg.ID, theMsg.MSGTYPE, itsTimeStamp);
 
     // We search if a message (Same ID and Type) is 
     // already received or if this is a new message
-	// (in a protected environment)
 	//
+	index = m_LastMsgsTable.Find(theMsg.ID, theMsg.MSGTYPE);
+	if (index != MSG_TABLE_NONE)
 	{
-		clsCritical locker(m_objpCS);
-
-		pos = m_LastMsgsList->GetHeadPosition();
-		for(int i=0; i < m_LastMsgsList->GetCount(); i++)
-		{
-			msg = (MessageStatus*)m_LastMsgsList->GetNext(pos);
-			if((msg->CANMsg.ID == theMsg.ID) && (msg->CANMsg.MSGTYPE == theMsg.MSGTYPE))
-			{
-				// Modify the message and exit
-				//
-				CString ID = msg->IdString;
-				CString DATA = msg->DataString;
-
-				msg->Update(theMsg, itsTimeStamp);
-				m_GPS_Msg_List.push_back(GPS_MK_PAIR(ID, DATA));
-				boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
-				boost::posix_time::time_duration diff = now - time_t_epoch;
-				m_GPS_CPU_Time.push_back(diff.total_milliseconds());
-
-				ID.Truncate(ID.GetLength() - 1);
-				int ID_NUM = HexTextToUnsigned(ID);
-				if (ID_NUM >= 0x301 && ID_NUM <= 0x305)
-				{
-					GetGPSXbowInformation(DATA, ID_NUM);
-				}
-				
-				return;
-			}
-		}
-		// Message not found. It will created
+		// Modify the message and exit
+		//
+		msg = &m_LastMsgsTable[index];
+		msg->Update(theMsg, itsTimeStamp);
+		m_DisplayModel.MarkChanged(index);
+		m_SignalPlan.Decode(index, theMsg, itsTimeStamp, &m_SignalBuffer);
+		m_GPS_Msg_List.push_back(*msg);
+		m_GPS_CPU_Time.push_back(m_Clock.ToRecordTime(hostTime));
+
+		// The GPS messages are decoded from their data bytes
 		//
-		InsertMsgEntry(theMsg, itsTimeStamp);
+		VBoxData vbox = {};
+		int ID_NUM = (int)msg->GetID();
+		if (DecodeVBoxFrame(ID_NUM, msg->GetData(), msg->GetLength(), &vbox))
+			GetGPSInformation(vbox, ID_NUM);
+		
+		return;
 	}
+	// Message not found. It will created
+	//
+	InsertMsgEntry(theMsg, itsTimeStamp);
+	m_GPS_CPU_Time.push_back(m_Clock.ToRecordTime(hostTime));
 }
 
-void CPCANBasicExampleDlg::ProcessMessage(TPCANMsg theMsg, TPCANTimestamp itsTimeStamp)
-{		
-    TPCANMsgFD newMsg;
-    TPCANTimestampFD newTimestamp;
-
-	newMsg = TPCANMsgFD();
-	newMsg.ID = theMsg.ID;
-	newMsg.DLC = theMsg.LEN;
-    for (int i = 0; i < ((theMsg.LEN > 8) ? 8 : theMsg.LEN); i++)
-        newMsg.DATA[i] = theMsg.DATA[i];
-    newMsg.MSGTYPE = theMsg.MSGTYPE;
-
-	newTimestamp = (itsTimeStamp.micros + 1000 * itsTimeStamp.millis + 0x100000000 * 1000 * itsTimeStamp.millis_overflow);
-	
-	ProcessMessage(newMsg, newTimestamp);
-}
-
-TPCANStatus CPCANBasicExampleDlg::ReadMessageFD()
+TPCANStatus CPCANBasicExampleDlg::ReadMessageBatch()
 {
-    TPCANMsgFD CANMsg;
-    TPCANTimestampFD CANTimeStamp;
-    TPCANStatus stsResult;
-
-    // We execute the "Read" function of the PCANBasic                
-    //
-    stsResult = m_objPCANBasic->ReadFD(m_PcanHandle, &CANMsg, &CANTimeStamp);
-    if (stsResult == PCAN_ERROR_OK)
-        // We process the received message
-        //
-        ProcessMessage(CANMsg, CANTimeStamp);
+	TPCANStatus stsResult;
+	DWORD dwCount;
 
-    return stsResult;
-}
+	// Nothing to read without a source (replay or released)
+	//
+	if (m_objCANSource == NULL)
+		return PCAN_ERROR_ILLOPERATION;
 
-TPCANStatus CPCANBasicExampleDlg::ReadMessage()
-{
-    TPCANMsg CANMsg;
-    TPCANTimestamp CANTimeStamp;
-    TPCANStatus stsResult;
+	// One burst of up to CAN_READ_BATCH messages. The messages are only
+	// copied into the ring, the processing thread takes them from there,
+	// so no lock is taken here
+	//
+	stsResult = m_objCANSource->ReadBatch(&m_ReadBatchFD[0], (DWORD)m_ReadBatchFD.size(), &dwCount);
+	if (dwCount > 0)
+	{
+		// The newest message of the burst is the one received closest
+		// to now; it feeds the clock estimator, which then gives every
+		// message a de-jittered host reception time
+		//
+		m_ClockAlign.AddSample(m_ReadBatchFD[dwCount - 1].Timestamp, m_Clock.Now());
+		for (DWORD i = 0; i < dwCount; i++)
+			m_ReadHostTimes[i] = m_ClockAlign.ToHost(m_ReadBatchFD[i].Timestamp);
 
-    // We execute the "Read" function of the PCANBasic                
-    //
-    stsResult = m_objPCANBasic->Read(m_PcanHandle, &CANMsg, &CANTimeStamp);
-    if (stsResult == PCAN_ERROR_OK)
-        // We process the received message
-        //
-        ProcessMessage(CANMsg, CANTimeStamp);
+		m_objRxRing->Push(&m_ReadBatchFD[0], &m_ReadHostTimes[0], dwCount);
+		SetEvent(m_hRingEvent);
+	}
 
-    return stsResult;
+	return stsResult;
 }
 
 void CPCANBasicExampleDlg::ReadMessages()
 {
 	TPCANStatus stsResult;
 
-	// We read at least one time the queue looking for messages.
-	// If a message is found, we look again trying to find more.
-	// If the queue is empty or an error occurr, we get out from
-	// the dowhile statement.
+	// Nothing to read without a source (replay or released)
+	//
+	if (m_objCANSource == NULL)
+		return;
+
+	// We drain the queue in bursts. If the queue is empty or an error
+	// occurr, we get out from the dowhile statement.
 	//			
 	do
 	{
-		stsResult =  m_IsFD ? ReadMessageFD() : ReadMessage();
+		stsResult = ReadMessageBatch();
         if (stsResult == PCAN_ERROR_ILLOPERATION)
             break;
 	} while (btnRelease.IsWindowEnabled() && (!(stsResult & PCAN_ERROR_QRCVEMPTY)));
 }
 
-DWORD WINAPI CPCANBasicExampleDlg::CallCANReadThreadFunc(LPVOID lpParam) 
+void CPCANBasicExampleDlg::ProcessRing()
+{
+	DWORD dwCount;
+
+	// Each burst taken from the ring is processed under a single lock
+	//
+	while ((dwCount = m_objRxRing->Pop(&m_ProcessBatch[0], &m_ProcessHostTimes[0], (DWORD)m_ProcessBatch.size())) > 0)
+		ProcessMessages(&m_ProcessBatch[0], &m_ProcessHostTimes[0], dwCount);
+}
+
+DWORD WINAPI CPCANBasicExampleDlg::CallProcessThreadFunc(LPVOID lpParam) 
 {
 	// Cast lpParam argument to PCANBasicExampleDlg*
 	//
@@ -4079,51 +3722,362 @@ DWORD WINAPI CPCANBasicExampleDlg::CallCANReadThreadFunc(LPVOID lpParam)
 	
 	// Call PCANBasicExampleDlg Thread member function
 	//
-	return dialog->CANReadThreadFunc(NULL);
+	return dialog->ProcessThreadFunc(NULL);
 }
 
-DWORD WINAPI CPCANBasicExampleDlg::CANReadThreadFunc(LPVOID lpParam) 
+DWORD WINAPI CPCANBasicExampleDlg::ProcessThreadFunc(LPVOID lpParam) 
+{
+	// Sleeps until the reader feeds the ring or the thread is stopped
+	//
+	while (!m_ProcessTerminated)
+	{
+		// Also wakes up at the display rate, so the last changes
+		// get published when the bus goes quiet
+		//
+		WaitForSingleObject(m_hRingEvent, (DWORD)(DISPLAY_PUBLISH_INTERVAL / NS_PER_MS));
+		ProcessRing();
+		PublishDisplay();
+	}
+
+	// Messages stored before the stop request are not lost
+	//
+	ProcessRing();
+	PublishDisplay();
+
+	return 0;
+}
+
+void CPCANBasicExampleDlg::PublishDisplay()
+{
+	clsCritical locker(m_objpCS);
+
+	m_DisplayModel.Publish(m_LastMsgsTable, m_Clock.Now());
+}
+
+void CPCANBasicExampleDlg::StartProcessing()
+{
+	if (m_hProcessThread != NULL)
+		return;
+
+	// Nothing is reading or processing at this point
+	//
+	m_objRxRing->Clear();
+	m_objRxRing->ResetStatistics();
+	m_ClockAlign.Reset();
+	m_TimingStats.Reset();
+	m_SignalBuffer.Clear();
+	ResetEvent(m_hRingEvent);
+
+	InterlockedExchange(&m_ProcessTerminated, 0);
+	m_hProcessThread = CreateThread(NULL, NULL, CPCANBasicExampleDlg::CallProcessThreadFunc, (LPVOID)this, NULL, NULL);
+
+	if (m_hProcessThread == NULL)
+		::MessageBox(NULL, "Create CANProcess-Thread failed", "Error!", MB_ICONERROR);
+}
+
+void CPCANBasicExampleDlg::LoadSignalPlan()
 {
+	std::vector<SignalDescriptor> signals;
+	DbcLoadStats stats;
+	std::string error;
+	CString info;
+
+	// The vehicle signals are optional
+	//
+	if (!boost::filesystem::exists(SIGNAL_DBC_FILE))
+		return;
+
+	if (!LoadDbcFile(SIGNAL_DBC_FILE, &signals, &stats, &error))
+	{
+		info.Format("Vehicle signals not loaded: %s", error.c_str());
+		IncludeTextMessage(info);
+		return;
+	}
+
+	m_SignalPlan.Build(signals);
+	m_SignalBuffer.Reset(m_SignalPlan.GetSignalCount());
+
+	// Their messages are received with the GPS ones
+	//
+	for (size_t i = 0; i < signals.size(); i++)
+	{
+		if (i > 0 && signals[i].ID == signals[i - 1].ID)
+			continue;
+		if (signals[i].ID & DBC_ID_EXTENDED)
+			m_FilterPlanner.Subscribe(signals[i].ID & ~DBC_ID_EXTENDED, signals[i].ID & ~DBC_ID_EXTENDED, PCAN_MODE_EXTENDED);
+		else
+			m_FilterPlanner.Subscribe(signals[i].ID, signals[i].ID, PCAN_MODE_STANDARD);
+	}
+
+	info.Format("Vehicle signals: %d messages, %d signals (%d multiplexed, %d too long skipped)",
+		stats.Messages, stats.Signals, stats.Multiplexed, stats.Unsupported);
+	IncludeTextMessage(info);
+}
+
+void CPCANBasicExampleDlg::ApplyFilterPlan(CANSource *Source)
+{
+	std::vector<CANFilterRange> ranges;
 	TPCANStatus stsResult;
-	DWORD result, dwTemp;
+	CString info;
 
-	m_Terminated = false;
+	// "Open" on the filter page records the whole bus
+	//
+	m_FilterPlanner.SetRecordAll(rdbFilterOpen.GetCheck() != 0);
+
+	stsResult = m_FilterPlanner.Apply(Source, &ranges);
+	if (stsResult != PCAN_ERROR_OK)
+	{
+		IncludeTextMessage(GetFormatedError(stsResult));
+		return;
+	}
 
-	// Sets the handle of the Receive-Event.
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		info.Format("Filter planned: %s IDs 0x%X to 0x%X", (ranges[i].Mode == PCAN_MODE_EXTENDED) ? "extended" : "standard", ranges[i].FromID, ranges[i].ToID);
+		IncludeTextMessage(info);
+	}
+}
+
+void CPCANBasicExampleDlg::StopProcessing()
+{
+	if (m_hProcessThread == NULL)
+		return;
+
+	// The reader must be stopped already, so the thread
+	// empties the ring before it ends
 	//
-	stsResult = m_objPCANBasic->SetValue(m_PcanHandle, PCAN_RECEIVE_EVENT ,&m_hEvent, sizeof(m_hEvent));
+	InterlockedExchange(&m_ProcessTerminated, 1);
+	SetEvent(m_hRingEvent);
+	WaitForSingleObject(m_hProcessThread, INFINITE);
+	CloseHandle(m_hProcessThread);
+	m_hProcessThread = NULL;
+}
 
-	// If it fails, a error message is shown
+void CPCANBasicExampleDlg::ParseCommandLine()
+{
+	CString info;
+	const char *option;
+
+	m_ReplayTraceFile.clear();
+	m_ReplayXbowFile.clear();
+	m_ReplaySpeed = REPLAY_REALTIME;
+	m_Simulate = false;
+	m_SimConfig = TrafficGenerator::GetDefaultConfig();
+
+	// Replay:     /replay <file.trc> /xbow <Acc.txt> /speed <N|max>
+	// Simulation: /simulate /gpsrate <Hz> /xbowrate <Hz> /busload <frames/s> /busids <N>
+	//             /noise <scale> /corrupt <p> /dropout <p> /dropoutlen <N> /seed <N>
 	//
+	for (int i = 1; i < __argc; i++)
+	{
+		option = __argv[i];
+		if (_stricmp(option, "/simulate") == 0)
+		{
+			m_Simulate = true;
+			continue;
+		}
+		if (i + 1 >= __argc)
+			break;
+
+		if (_stricmp(option, "/replay") == 0)
+			m_ReplayTraceFile = __argv[++i];
+		else if (_stricmp(option, "/xbow") == 0)
+			m_ReplayXbowFile = __argv[++i];
+		else if (_stricmp(option, "/speed") == 0)
+		{
+			++i;
+			m_ReplaySpeed = (_stricmp(__argv[i], "max") == 0) ? REPLAY_UNTHROTTLED : atof(__argv[i]);
+			if (m_ReplaySpeed < 0)
+				m_ReplaySpeed = REPLAY_REALTIME;
+		}
+		else if (_stricmp(option, "/gpsrate") == 0)
+			m_SimConfig.GPSRate = atof(__argv[++i]);
+		else if (_stricmp(option, "/xbowrate") == 0)
+			m_SimConfig.XbowRate = atof(__argv[++i]);
+		else if (_stricmp(option, "/busload") == 0)
+			m_SimConfig.BackgroundRate = atof(__argv[++i]);
+		else if (_stricmp(option, "/busids") == 0)
+			m_SimConfig.BackgroundIDs = (DWORD)atoi(__argv[++i]);
+		else if (_stricmp(option, "/noise") == 0)
+			m_SimConfig.Noise = atof(__argv[++i]);
+		else if (_stricmp(option, "/corrupt") == 0)
+			m_SimConfig.CorruptionRate = atof(__argv[++i]);
+		else if (_stricmp(option, "/dropout") == 0)
+			m_SimConfig.DropoutRate = atof(__argv[++i]);
+		else if (_stricmp(option, "/dropoutlen") == 0)
+			m_SimConfig.DropoutLength = (DWORD)atoi(__argv[++i]);
+		else if (_stricmp(option, "/seed") == 0)
+			m_SimConfig.Seed = (DWORD)atoi(__argv[++i]);
+	}
+
+	if (m_Simulate)
+	{
+		if (m_SimConfig.BackgroundRate > 0 && m_SimConfig.BackgroundIDs == 0)
+			m_SimConfig.BackgroundIDs = 100;
+		info.Format("Simulation mode: VBOX %.0f Hz, Xbow %.0f Hz, %.0f other frames/s on %u IDs", 
+			m_SimConfig.GPSRate, m_SimConfig.XbowRate, m_SimConfig.BackgroundRate, m_SimConfig.BackgroundIDs);
+		IncludeTextMessage(info);
+		info.Format("Simulation faults: noise x%.2f, corruption %.4f, dropout %.4f (%u long)", 
+			m_SimConfig.Noise, m_SimConfig.CorruptionRate, m_SimConfig.DropoutRate, m_SimConfig.DropoutLength);
+		IncludeTextMessage(info);
+	}
+
+	if (m_ReplayTraceFile.empty() && m_ReplayXbowFile.empty())
+		return;
+
+	if (m_ReplaySpeed > 0)
+		info.Format("Replay mode: \"%s\" \"%s\" at x%.2f", m_ReplayTraceFile.c_str(), m_ReplayXbowFile.c_str(), m_ReplaySpeed);
+	else
+		info.Format("Replay mode: \"%s\" \"%s\" unthrottled", m_ReplayTraceFile.c_str(), m_ReplayXbowFile.c_str());
+	IncludeTextMessage(info);
+}
+
+void CPCANBasicExampleDlg::StartReplay()
+{
+	boost::posix_time::time_duration epoch = time_t_epoch - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1));
+	TPCANStatus stsResult;
+
+	// The Xbow recording counts its times from time_t_epoch
+	//
+	stsResult = m_objReplay->Open(m_ReplayTraceFile.c_str(), m_ReplayXbowFile.c_str(), (INT64)epoch.total_milliseconds());
 	if (stsResult != PCAN_ERROR_OK)
 	{
-		::MessageBox(NULL, GetFormatedError(stsResult), "Error!",MB_ICONERROR);
-		m_Terminated = true;
-		return 1;
+		::MessageBox(NULL, GetFormatedError(stsResult), "Error!", MB_ICONERROR);
+		return;
 	}
+	if (m_objReplay->GetCANSource() != NULL)
+		ApplyFilterPlan(m_objReplay->GetCANSource());
+
+	// Same preparation as with the hardware
+	//
+	InitGPSConfig();
+	InitCrossXbow();
+	m_Shutter_Time_Rec.clear();
+	StartProcessing();
+
+	stsResult = m_objReplay->Start(this, m_ReplaySpeed);
+	if (stsResult != PCAN_ERROR_OK)
+	{
+		StopProcessing();
+		m_objReplay->Close();
+		::MessageBox(NULL, GetFormatedError(stsResult), "Error!", MB_ICONERROR);
+		return;
+	}
+
+	// The replay is the only producer of the ring, nothing is read by
+	// hand while it runs
+	//
+	SetTimerDisplay(true);
+	btnInit.EnableWindow(FALSE);
+	btnRead.EnableWindow(FALSE);
+	btnRelease.EnableWindow(TRUE);
+	IncludeTextMessage("Replay started");
+}
+
+void CPCANBasicExampleDlg::StopReplay()
+{
+	ReplayStats stats;
+	CString info;
+
+	if (!m_objReplay->IsOpen())
+		return;
+
+	m_objReplay->Stop();
+	m_objReplay->Close();
+
+	stats = m_objReplay->GetStatistics();
+	info.Format("Replay %s: %I64u CAN messages, %I64u Xbow packets, %.1f s of recording in %.1f s (x%.2f)", 
+		stats.Finished ? "finished" : "stopped", stats.CANMessages, stats.XbowPackets, 
+		stats.RecordedTime / 1e9, stats.ElapsedTime / 1e9, stats.AchievedSpeed);
+	IncludeTextMessage(info);
+	info.Format("Replay throughput %.0f msg/s, pacing error %.1f us mean / %.1f us max, %I64u late", 
+		stats.Throughput, stats.PacingErrorMean / 1000.0, stats.PacingErrorMax / 1000.0, stats.LateEvents);
+	IncludeTextMessage(info);
+}
+
+void CPCANBasicExampleDlg::OnReplayCAN(const TPCANMsgFDEntry* Entries, const UINT64* HostTimes, DWORD Count)
+{
+	DWORD dwStored;
+
+	// Unlike the hardware, the replay waits for room in the ring
+	// instead of losing messages, so a fast replay measures the
+	// processing rather than the ring size
+	//
+	while (Count > 0 && m_objReplay->IsRunning())
+	{
+		dwStored = m_objRxRing->GetCapacity() - m_objRxRing->GetDepth();
+		if (dwStored > Count)
+			dwStored = Count;
+		if (dwStored == 0)
+		{
+			Sleep(0);
+			continue;
+		}
+
+		m_objRxRing->Push(Entries, HostTimes, dwStored);
+		SetEvent(m_hRingEvent);
+		Entries += dwStored;
+		HostTimes += dwStored;
+		Count -= dwStored;
+	}
+}
+
+void CPCANBasicExampleDlg::OnReplayXbow(const BYTE* Packet, UINT64 HostTime)
+{
+	ProcessXbowPacket(Packet, m_Clock.ToRecordTime(HostTime));
+}
+
+void CPCANBasicExampleDlg::OnReplayFinished(const ReplayStats & /*Stats*/)
+{
+	// Runs on the replay thread, which must not wait for the UI.
+	// The statistics are shown by StopReplay on release
+	//
+}
+
+DWORD WINAPI CPCANBasicExampleDlg::CallCANReadThreadFunc(LPVOID lpParam) 
+{
+	// Cast lpParam argument to PCANBasicExampleDlg*
+	//
+	CPCANBasicExampleDlg* dialog = (CPCANBasicExampleDlg*)lpParam;
+	
+	// Call PCANBasicExampleDlg Thread member function
+	//
+	return dialog->CANReadThreadFunc(NULL);
+}
+
+DWORD WINAPI CPCANBasicExampleDlg::CANReadThreadFunc(LPVOID lpParam) 
+{
+	TPCANStatus stsResult;
 
 	// While this mode is selected
 	//
 	while(!m_Terminated)
 	{
-		//Wait for CAN Data...
-		result = WaitForSingleObject(m_hEvent, 1);
+		// Sleeps until CAN Data arrives or the thread is stopped
+		// through CancelWait
+		//
+		stsResult = m_objCANSource->WaitForMessages(CAN_WAIT_INFINITE);
 
-		if (result == WAIT_OBJECT_0)
+		if (stsResult == PCAN_ERROR_OK)
 			ReadMessages();
+		else if (stsResult != PCAN_ERROR_QRCVEMPTY)
+		{
+			// If the wait fails, a error message is shown
+			//
+			::MessageBox(NULL, GetFormatedError(stsResult), "Error!",MB_ICONERROR);
+			return 1;
+		}
 	}
 
-	// Resets the Event-handle configuration
-	//
-	dwTemp = 0;
-	m_objPCANBasic->SetValue(m_PcanHandle, PCAN_RECEIVE_EVENT ,&dwTemp, sizeof(dwTemp));
-	
 	return 0;
 }
 
 void CPCANBasicExampleDlg::ReadingModeChanged()
 {
-	if (!btnRelease.IsWindowEnabled())
+	// A replay feeds the ring from its own thread and there is no
+	// source to read then: the reading mode is ignored until release
+	//
+	if (!btnRelease.IsWindowEnabled() || (m_objReplay != NULL && m_objReplay->IsOpen()) || m_objCANSource == NULL)
 		return;
 
 	// If active reading mode is By Timer
@@ -4135,6 +4089,7 @@ void CPCANBasicExampleDlg::ReadingModeChanged()
 		if(m_hThread != NULL)
 		{
 			m_Terminated = true;
+			m_objCANSource->CancelWait();
 			WaitForSingleObject(m_hThread,-1);
 			m_hThread = NULL;
 		}
@@ -4152,6 +4107,7 @@ void CPCANBasicExampleDlg::ReadingModeChanged()
 
 		// Create Reading Thread ....
 		//
+		m_Terminated = false;
 		m_hThread = CreateThread(NULL, NULL, CPCANBasicExampleDlg::CallCANReadThreadFunc, (LPVOID)this, NULL, NULL);
 
 		if(m_hThread == NULL)
@@ -4164,6 +4120,7 @@ void CPCANBasicExampleDlg::ReadingModeChanged()
 		if(m_hThread != NULL)
 		{
 			m_Terminated = true;
+			m_objCANSource->CancelWait();
 			WaitForSingleObject(m_hThread,-1);
 			m_hThread = NULL;
 		}
@@ -4517,9 +4474,8 @@ void CPCANBasicExampleDlg::OnBnClickedButtonglass()
 	lc >> m_LaneChange_Time;
 	m_LaneChange_Time_Constant = m_LaneChange_Time;
 
-	m_Shutter_CPUTIME_BEGIN = boost::posix_time::microsec_clock::local_time();
-	boost::posix_time::time_duration diff = m_Shutter_CPUTIME_BEGIN - time_t_epoch;
-	std::pair<__int64, std::string> temp(diff.total_milliseconds(), "Start");
+	m_Shutter_CPUTIME_BEGIN = m_Clock.Now();
+	std::pair<__int64, std::string> temp(m_Clock.ToRecordTime(m_Shutter_CPUTIME_BEGIN), "Start");
 	m_Shutter_Time_Rec.push_back(temp);
 
 	if (!btnInit.IsWindowEnabled())
@@ -4562,10 +4518,7 @@ void CPCANBasicExampleDlg::OnBnClickedButtonsw()
 
 	SetShutterGlass();
 
-	boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
-	boost::posix_time::time_duration diff = now - time_t_epoch;
-
-	std::pair<__int64, std::string> temp(diff.total_milliseconds(), "OFF");
+	std::pair<__int64, std::string> temp(m_Clock.GetRecordTime(), "OFF");
 
 	m_Shutter_Time_Rec.push_back(temp);
 
@@ -4579,10 +4532,7 @@ void CPCANBasicExampleDlg::OnBnClickedButtonsw2()
 
 	SetShutterGlass(false);
 
-	boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
-	boost::posix_time::time_duration diff = now - time_t_epoch;
-
-	std::pair<__int64, std::string> temp(diff.total_milliseconds(), "ON");
+	std::pair<__int64, std::string> temp(m_Clock.GetRecordTime(), "ON");
 
 	m_Shutter_Time_Rec.push_back(temp);
 
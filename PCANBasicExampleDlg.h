@@ -14,6 +14,25 @@
 #include <boost/bind.hpp>
 
 #include "PCANBasicClass.h"
+#include "PCANSource.h"
+#include "CANRing.h"
+#include "TimestampService.h"
+#include "ClockAlignment.h"
+#include "FilterPlanner.h"
+#include "SessionReplay.h"
+#include "GeneratorSource.h"
+#include "MessageStatus.h"
+#include "MessageTable.h"
+#include "DisplayModel.h"
+#include "TimingStatistics.h"
+#include "VBoxDecoder.h"
+#include "VBoxBatch.h"
+#include "VBoxEpoch.h"
+#include "VBoxDistance.h"
+#include "XbowParser.h"
+#include "HexCodec.h"
+#include "SignalPlan.h"
+#include "DbcLoader.h"
 
 #include <Math.h>
 #include <bitset>
@@ -43,17 +62,25 @@ using namespace std;
 #define GPS_Vertical_V		2
 #define GPS_DGPS			3
 
-#define GPS_NUM_COUNT		1
+// Time after the first VBOX frame of a GPS cycle past which a frame
+// belongs to the next one, in milliseconds
+//
+#define GPS_EPOCH_TIMEOUT	VBOX_EPOCH_TIMEOUT
+
 #define GPS_DATA_COUNT		5
 #define GPS_SEND_NUM_COUNT  1	//4
 
+#define CAN_READ_BATCH		256
+#define CAN_RING_SIZE		8192
+
+// DBC file of the vehicle signals recorded besides the GPS, if present
+//
+#define SIGNAL_DBC_FILE		".\\Vehicle.dbc"
+
 #define GPS_MSG_NUMS		950000
 #define XBOW_MSG_NUMS		300000
 
-#define GPS_MK_PAIR(x,y)	std::pair<CString,CString>(x,y)
-
 #define CONNECTION_ERROR	1
-#define GPS_LATENCY			1
 #define XBOW_LATENCY		1
 
 #define FT232SN				"FTU7GDEE"
@@ -81,54 +108,8 @@ class clsCritical
 };
 #pragma endregion
 
-// Message Status structure used to show CAN Messages
-// in a ListView
-//
-#pragma region Message Status class
-class MessageStatus
-{
-	private:
-		TPCANMsgFD m_Msg;
-		TPCANTimestampFD m_TimeStamp;		
-		TPCANTimestampFD m_oldTimeStamp;		
-		int m_iIndex;
-		int m_Count;
-        bool m_bShowPeriod;
-        bool m_bWasChanged;
-
-	public:
-		MessageStatus(TPCANMsgFD canMsg, TPCANTimestampFD canTimestamp, int listIndex);
-		void Update(TPCANMsgFD canMsg, TPCANTimestampFD canTimestamp);
-
-		TPCANMsgFD GetCANMsg();
-		TPCANTimestampFD GetTimestamp();
-		int GetPosition();
-		CString GetTypeString();
-		CString GetIdString();
-		CString GetDataString();
-		CString GetTimeString();
-		int GetCount();
-		bool GetShowingPeriod();
-		bool GetMarkedAsUpdated();
-
-		void SetShowingPeriod(bool value);
-		void SetMarkedAsUpdated(bool value);
-
-		__declspec(property (get = GetCANMsg)) TPCANMsgFD CANMsg;
-        __declspec(property (get = GetTimestamp)) TPCANTimestampFD Timestamp;
-        __declspec(property (get = GetPosition)) int Position;
-        __declspec(property (get = GetTypeString)) CString TypeString;
-        __declspec(property (get = GetIdString)) CString IdString;
-        __declspec(property (get = GetDataString)) CString DataString;
-		__declspec(property (get = GetTimeString)) CString TimeString;
-        __declspec(property (get = GetCount)) int Count;
-        __declspec(property (get = GetShowingPeriod, put = SetShowingPeriod)) bool ShowingPeriod;
-        __declspec(property (get = GetMarkedAsUpdated, put = SetMarkedAsUpdated)) bool MarkedAsUpdated;		
-};
-#pragma endregion
-
 // PCANBasicExampleDlg dialog
-class CPCANBasicExampleDlg : public CDialog
+class CPCANBasicExampleDlg : public CDialog, public ReplaySink
 {
 // Construction
 public:
@@ -248,6 +229,10 @@ private:
 	bool m_Terminated;
 	PCANBasicClass *m_objPCANBasic;
 
+	// Source the received CAN messages are read from
+	//
+	CANSource *m_objCANSource;
+
     // Saves the desired connection mode
     //
     bool m_IsFD;
@@ -279,13 +264,22 @@ private:
 	//
 	UINT_PTR m_tmrDisplay;
 
-	// CAN messages array. Store the message status for its display
+	// CAN messages table. Store the message status for its display
 	//
-	CPtrList *m_LastMsgsList;
+	MessageTable<MessageStatus> m_LastMsgsTable;
 
-	// Handle to set Received-Event
+	// Snapshots of the changed rows, published by the processing thread
+	// and rendered by the display timer. The generation and the Xbow
+	// packet count last rendered are only used by the display
 	//
-	HANDLE m_hEvent;
+	DisplayModel m_DisplayModel;
+	UINT64 m_DisplayGeneration;
+	UINT64 m_DisplayXbowPackets;
+
+	// Period or timestamp display of new messages, mirrors the checkbox
+	// for the processing thread
+	//
+	bool m_ShowPeriod;
 
 	// Handle to the thread to read using Received-Event method
 	//
@@ -298,6 +292,62 @@ private:
 	//
 	CRITICAL_SECTION *m_objpCS;
 
+	// Preallocated buffer used to drain the receive queue in one call
+	//
+	std::vector<TPCANMsgFDEntry> m_ReadBatchFD;
+	std::vector<UINT64> m_ReadHostTimes;
+
+	// Maps the adapter timestamps onto the host clock. Only used
+	// by the thread reading the CAN source
+	//
+	ClockAlignment m_ClockAlign;
+
+	// Per-ID timing statistics of the received messages, updated by the
+	// processing thread and read from its snapshots
+	//
+	TimingStatistics m_TimingStats;
+
+	// Vehicle signals of the DBC file, decoded by the processing thread
+	// into their columns
+	//
+	SignalPlan m_SignalPlan;
+	SignalBuffer m_SignalBuffer;
+
+	// IDs consumed by the GPS decoder, turned into the reception
+	// filter of the source at connection time
+	//
+	FilterPlanner m_FilterPlanner;
+
+	// Replay of a recorded trial, used instead of the hardware when the
+	// command line gives one: /replay <file.trc> /xbow <Acc.txt> /speed <N|max>
+	//
+	SessionReplay *m_objReplay;
+	std::string m_ReplayTraceFile;
+	std::string m_ReplayXbowFile;
+	double m_ReplaySpeed;
+
+	// Synthetic VBOX and Xbow traffic used instead of the hardware for
+	// load and soak tests (/simulate, see ParseCommandLine for the options)
+	//
+	bool m_Simulate;
+	TrafficConfig m_SimConfig;
+
+	// Ring handing the received messages from the reader to the
+	// processing thread, and the event signaled when it is fed
+	//
+	CANRing *m_objRxRing;
+	HANDLE m_hRingEvent;
+
+	// Handle to the thread processing the messages of the ring
+	//
+	HANDLE m_hProcessThread;
+	unsigned m_ProcessTerminated;
+
+	// Preallocated buffer used to drain the ring in one call
+	//
+	std::vector<TPCANMsgFDEntry> m_ProcessBatch;
+	std::vector<UINT64> m_ProcessHostTimes;
+
 	// ------------------------------------------------------------------------------------------
 	// Help functions
 	// ------------------------------------------------------------------------------------------
@@ -366,24 +416,58 @@ private:
 	void DisplayMessages();
 	// Create new MessageStatus using provided parameters
 	//
-	void InsertMsgEntry(TPCANMsgFD NewMsg, TPCANTimestampFD MyTimeStamp);
-	// Processes a received message, in order to show it in the Message-ListView
+	void InsertMsgEntry(const CANFrameView &NewMsg, TPCANTimestampFD MyTimeStamp);
+	// Processes a burst of received messages under a single lock
+	//
+	void ProcessMessages(const TPCANMsgFDEntry *entries, const UINT64 *hostTimes, DWORD count);
+	// Processes a received message (m_objpCS must be held by the caller).
+	// hostTime is the reception time on the monotonic host clock
 	//
-	void ProcessMessage(TPCANMsgFD theMsg, TPCANTimestampFD itsTimeStamp);
-	void ProcessMessage(TPCANMsg MyMsg, TPCANTimestamp MyTimeStamp);
+	void ProcessMessageLocked(const CANFrameView &theMsg, TPCANTimestampFD itsTimeStamp, UINT64 hostTime);
 	// static Thread function to manage reading by event
 	//
 	static DWORD WINAPI CallCANReadThreadFunc(LPVOID lpParam);
 	// member Thread function to manage reading by event
 	//
 	DWORD WINAPI CANReadThreadFunc(LPVOID lpParam);
+	// static Thread function to process the messages of the ring
+	//
+	static DWORD WINAPI CallProcessThreadFunc(LPVOID lpParam);
+	// member Thread function to process the messages of the ring
+	//
+	DWORD WINAPI ProcessThreadFunc(LPVOID lpParam);
+	// Start/Stop the processing thread
+	//
+	void StartProcessing();
+	void StopProcessing();
+	// Configures the source filter with the IDs the decoder subscribes
+	//
+	void ApplyFilterPlan(CANSource *Source);
+	// Reads the replay and simulation options of the command line
+	//
+	void ParseCommandLine();
+	// Start/Stop the replay of a recorded trial
+	//
+	void StartReplay();
+	void StopReplay();
+	// Receivers of the replayed data (replay thread)
+	//
+	void OnReplayCAN(const TPCANMsgFDEntry* Entries, const UINT64* HostTimes, DWORD Count);
+	void OnReplayXbow(const BYTE* Packet, UINT64 HostTime);
+	void OnReplayFinished(const ReplayStats &Stats);
+	// Processes the messages stored in the ring
+	//
+	void ProcessRing();
+	// Publishes the rows changed since the last display snapshot, if due
+	//
+	void PublishDisplay();
 	// Manage Reading method (Timer, Event or manual)
 	//
 	void ReadingModeChanged();
-	// Functions for reading PCAN-Basic messages
+	// Functions for reading PCAN-Basic messages, through the source and
+	// the ring
 	//
-	TPCANStatus ReadMessageFD();
-	TPCANStatus ReadMessage();
+	TPCANStatus ReadMessageBatch();
 	void ReadMessages();
 
 	// Critical section Ini/deinit functions
@@ -393,16 +477,22 @@ private:
 
 	/*============================================================*/
 	//Custom GPS
-	void DisplayGPSInformation(CString GPS, int iCurrentItem_GPS, int ID_NUM, bool WriteEnable = false);
-	unsigned HexTextToUnsigned(CString ToConvert);
+	void DisplayGPSInformation(CString GPS, const VBoxData *VBox, int iCurrentItem_GPS, int ID_NUM);
 	CString UnsignedToBinString(const std::bitset<8> &bitw);
 	CString FormatTimeString(unsigned hour, unsigned minute, unsigned seconds, unsigned remainder);
-	void GetGPSXbowInformation(CString Data, int ID_NUM);
+	void GetGPSXbowInformation();
+	void GetGPSInformation(const VBoxData &VBox, int ID_NUM);
+	void LoadSignalPlan();
 
 	void StoreMsgList();
+	void RecordGPSFix(const VBoxFix &Fix, const VBoxBatch &Batch);
+	std::string RawFieldToStr(int Value);
 	void WriteGPSFile();
+	void StartClockSession();
 // 	void ComUninitialize();
 	void StoreAccMsgList();
+	void DisplayXbowInformation(CString Packet, const XbowSample &Sample, int iCurrentItem_GPS);
+	void RecordXbowInformation(const XbowSample &Sample);
 	void WriteAccFile();
 
 	void InitGPSConfig();
@@ -412,29 +502,35 @@ private:
 	void ConnectCrossXbow();
 	static DWORD WINAPI CallReadXbowDataThreadFunc(LPVOID lpParam);
 	DWORD WINAPI XbowDataReadThreadFunc(LPVOID lpParam);
+	// Checks and stores a packet of the Xbow, received at RecordTime
+	//
+	void ProcessXbowPacket(const unsigned char *Packet, __int64 RecordTime);
+	// Cuts the packets out of bytes of the Xbow stream and processes them
+	//
+	void FeedXbowBytes(XbowFramer *Framer, const unsigned char *Data, DWORD Length, __int64 RecordTime);
+	// Formats an Xbow packet as text, "FF 01 .. 14"
+	//
+	CString FormatXbowPacket(const unsigned char *Packet);
+	// Thread function feeding the Xbow path with synthetic packets
+	//
+	static DWORD WINAPI CallSimXbowThreadFunc(LPVOID lpParam);
+	DWORD WINAPI SimXbowThreadFunc(LPVOID lpParam);
 
 	std::string m_GPS_Recorder;
-	std::string m_GPS_Str_Time, m_GPS_Str_X, m_GPS_Str_Y, m_GPS_Str_Sats;
-	std::string m_GPS_Str_Velocity, m_GPS_Str_Heading, m_GPS_Str_WGS84, m_GPS_Str_VerticalV;
-	std::string m_GPS_Str_TrigDist,m_GPS_Str_LongAcc,m_GPS_Str_LatACC,m_GPS_Str_Status;
-	std::string m_GPS_Str_TrigTime, m_GPS_Str_TrigV, m_GPS_Str_Distance;
-	std::vector<string> m_GPS_Str_RAW;
-	int m_GPS_Num_Count;
-	double m_GPS_First_Distance;
-	double m_GPS_Distance_Offset;
+	VBoxDistanceAccumulator m_GPS_Distance;
 
 	/*===================================================================================*/
 	//WILL be read & written by different threads, so be extremely careful, have to be
 	//locked each time of using
 	//
-	std::vector<std::pair<CString, CString>> m_GPS_Msg_List;
-	std::vector<CString> m_Xbow_Msg_List;
-	CString m_Xbow_Msg_Latest;
+	std::vector<MessageStatus> m_GPS_Msg_List;
+	std::vector<XbowSample> m_Xbow_Msg_List;
 	std::string m_Xbow_Msg_TobeSent;
 	unsigned m_Xbow_Msg_Sent_Num;
 	unsigned m_GPS_Begin_Time;
 	unsigned m_GPS_Is_First;
 	std::vector<uint64_t> m_GPS_CPU_Time;
+	TimestampService m_Clock;
 	std::vector<__int64> m_Xbow_CPU_Time;
 
 	std::string m_GPS_Msg_TobeSent;
@@ -478,7 +574,7 @@ private:
 
 	double m_Shutter_Time;
 	double m_Shutter_Time_Constant;
-	boost::posix_time::ptime m_Shutter_CPUTIME_BEGIN;
+	UINT64 m_Shutter_CPUTIME_BEGIN;
 	long double m_Shutter_Duration;
 	std::vector<std::pair<__int64,std::string>> m_Shutter_Time_Rec;
 
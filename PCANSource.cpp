@@ -0,0 +1,134 @@
+#include "stdafx.h"
+#include "PCANSource.h"
+
+PCANSource::PCANSource(PCANBasicClass *pcanBasic, TPCANHandle channel, TPCANBaudrate btr0Btr1, TPCANType hwType, DWORD ioPort, WORD interrupt)
+{
+	m_objPCANBasic = pcanBasic;
+	m_PcanHandle = channel;
+	m_IsFD = false;
+	m_Baudrate = btr0Btr1;
+	m_HwType = hwType;
+	m_IOPort = ioPort;
+	m_Interrupt = interrupt;
+	CreateEvents();
+}
+
+PCANSource::PCANSource(PCANBasicClass *pcanBasic, TPCANHandle channel, const char *bitrateFD)
+{
+	m_objPCANBasic = pcanBasic;
+	m_PcanHandle = channel;
+	m_IsFD = true;
+	m_Baudrate = 0;
+	m_HwType = 0;
+	m_IOPort = 0;
+	m_Interrupt = 0;
+	m_BitrateFD = bitrateFD;
+	CreateEvents();
+}
+
+PCANSource::~PCANSource()
+{
+	CloseHandle(m_hReceiveEvent);
+	CloseHandle(m_hWakeEvent);
+}
+
+void PCANSource::CreateEvents()
+{
+	m_hReceiveEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_hWakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+TPCANStatus PCANSource::Initialize()
+{
+	TPCANStatus stsResult;
+
+	if (m_IsFD)
+		stsResult = m_objPCANBasic->InitializeFD(m_PcanHandle, &m_BitrateFD[0]);
+	else
+		stsResult = m_objPCANBasic->Initialize(m_PcanHandle, m_Baudrate, m_HwType, m_IOPort, m_Interrupt);
+
+	// The Receive-Event stays attached for the whole connection, so
+	// WaitForMessages can block on it in any reading mode
+	//
+	if (stsResult == PCAN_ERROR_OK || stsResult == PCAN_ERROR_CAUTION)
+	{
+		ResetEvent(m_hWakeEvent);
+		m_objPCANBasic->SetValue(m_PcanHandle, PCAN_RECEIVE_EVENT, &m_hReceiveEvent, sizeof(m_hReceiveEvent));
+	}
+
+	return stsResult;
+}
+
+TPCANStatus PCANSource::Uninitialize()
+{
+	DWORD dwTemp = 0;
+
+	// Resets the Event-handle configuration
+	//
+	m_objPCANBasic->SetValue(m_PcanHandle, PCAN_RECEIVE_EVENT, &dwTemp, sizeof(dwTemp));
+
+	return m_objPCANBasic->Uninitialize(m_PcanHandle);
+}
+
+TPCANStatus PCANSource::ReadBatch(TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count)
+{
+	TPCANStatus stsResult;
+	DWORD dwCount;
+
+	// FD channels deliver the entries directly
+	//
+	if (m_IsFD)
+		return m_objPCANBasic->ReadBatchFD(m_PcanHandle, EntryBuffer, MaxCount, Count);
+
+	// Standard channels are drained into the staging buffer and widened
+	//
+	if (m_ReadBatch.size() < MaxCount)
+		m_ReadBatch.resize(MaxCount);
+
+	stsResult = m_objPCANBasic->ReadBatch(m_PcanHandle, &m_ReadBatch[0], MaxCount, &dwCount);
+	for (DWORD i = 0; i < dwCount; i++)
+		ConvertToMsgFD(m_ReadBatch[i].Msg, m_ReadBatch[i].Timestamp, &EntryBuffer[i].Msg, &EntryBuffer[i].Timestamp);
+
+	*Count = dwCount;
+	return stsResult;
+}
+
+TPCANStatus PCANSource::FilterMessages(DWORD FromID, DWORD ToID, TPCANMode Mode)
+{
+	return m_objPCANBasic->FilterMessages(m_PcanHandle, FromID, ToID, Mode);
+}
+
+DWORD PCANSource::GetMaxFilterRanges() const
+{
+	// PCAN-Basic expands the filter to cover every range given
+	//
+	return 1;
+}
+
+TPCANStatus PCANSource::WaitForMessages(DWORD Timeout)
+{
+	HANDLE handles[2] = { m_hReceiveEvent, m_hWakeEvent };
+
+	switch (WaitForMultipleObjects(2, handles, FALSE, Timeout))
+	{
+		case WAIT_OBJECT_0:
+			return PCAN_ERROR_OK;
+
+		case WAIT_OBJECT_0 + 1:
+		case WAIT_TIMEOUT:
+			return PCAN_ERROR_QRCVEMPTY;
+
+		default:
+			return PCAN_ERROR_UNKNOWN;
+	}
+}
+
+void PCANSource::CancelWait()
+{
+	SetEvent(m_hWakeEvent);
+}
+
+const char* PCANSource::GetName() const
+{
+	return "PCAN";
+}
@@ -0,0 +1,68 @@
+//  PCANSource.h
+//
+//  ~~~~~~~~~~~~
+//
+//  CAN source reading a PCAN channel through the PCAN-Basic API
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __PCANSOURCEH_
+#define __PCANSOURCEH_
+
+#include "CANSource.h"
+#include "PCANBasicClass.h"
+
+#include <string>
+#include <vector>
+
+// PCAN-Basic backed CAN source
+//
+class PCANSource : public CANSource
+{
+	private:
+		// PCAN-Basic instance, owned by the caller
+		//
+		PCANBasicClass *m_objPCANBasic;
+
+		// Connection parameters
+		//
+		TPCANHandle m_PcanHandle;
+		bool m_IsFD;
+		TPCANBaudrate m_Baudrate;
+		TPCANType m_HwType;
+		DWORD m_IOPort;
+		WORD m_Interrupt;
+		std::string m_BitrateFD;
+
+		// Staging buffer for standard CAN messages before they are widened
+		//
+		std::vector<TPCANMsgEntry> m_ReadBatch;
+
+		// Receive-Event set by PCAN-Basic and event used to cancel a wait
+		//
+		HANDLE m_hReceiveEvent;
+		HANDLE m_hWakeEvent;
+
+		void CreateEvents();
+
+	public:
+		// PCANSource constructor for a standard CAN channel
+		//
+		PCANSource(PCANBasicClass *pcanBasic, TPCANHandle channel, TPCANBaudrate btr0Btr1, TPCANType hwType = 0, DWORD ioPort = 0, WORD interrupt = 0);
+		// PCANSource constructor for a FD capable channel
+		//
+		PCANSource(PCANBasicClass *pcanBasic, TPCANHandle channel, const char *bitrateFD);
+		// PCANSource destructor
+		//
+		~PCANSource();
+
+		TPCANStatus Initialize();
+		TPCANStatus Uninitialize();
+		TPCANStatus ReadBatch(TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count);
+		TPCANStatus FilterMessages(DWORD FromID, DWORD ToID, TPCANMode Mode);
+		DWORD GetMaxFilterRanges() const;
+		TPCANStatus WaitForMessages(DWORD Timeout);
+		void CancelWait();
+		const char* GetName() const;
+};
+#endif
@@ -0,0 +1,285 @@
+﻿#include "ReplaySource.h"
+#include "HexCodec.h"
+
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+ReplaySource::ReplaySource(const char *fileName)
+{
+	m_FileName = fileName;
+	m_FileVersion = 11;
+	m_StartTime = -1;
+	m_FilterCustom = false;
+	m_FilterFrom[0] = m_FilterFrom[1] = 1;
+	m_FilterTo[0] = m_FilterTo[1] = 0;
+	m_LineCount = 0;
+	m_SkippedLines = 0;
+	m_WakePending = false;
+}
+
+TPCANStatus ReplaySource::Initialize()
+{
+	if (m_File.is_open())
+		return PCAN_ERROR_HWINUSE;
+
+	m_File.open(m_FileName.c_str(), std::ifstream::in);
+	if (!m_File.is_open())
+		return PCAN_ERROR_ILLHW;
+
+	m_FileVersion = 11;
+	m_StartTime = -1;
+	m_LineCount = 0;
+	m_SkippedLines = 0;
+
+	return PCAN_ERROR_OK;
+}
+
+TPCANStatus ReplaySource::Uninitialize()
+{
+	if (m_File.is_open())
+		m_File.close();
+
+	return PCAN_ERROR_OK;
+}
+
+TPCANStatus ReplaySource::ReadBatch(TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count)
+{
+	std::string line;
+	DWORD dwRead = 0;
+
+	*Count = 0;
+	if (!m_File.is_open())
+		return PCAN_ERROR_INITIALIZE;
+
+	while (dwRead < MaxCount)
+	{
+		if (!std::getline(m_File, line))
+		{
+			*Count = dwRead;
+			return PCAN_ERROR_QRCVEMPTY;
+		}
+		m_LineCount++;
+
+		if (ParseLine(line, &EntryBuffer[dwRead]) && IsAccepted(EntryBuffer[dwRead].Msg))
+			dwRead++;
+	}
+
+	*Count = dwRead;
+	return PCAN_ERROR_OK;
+}
+
+TPCANStatus ReplaySource::FilterMessages(DWORD FromID, DWORD ToID, TPCANMode Mode)
+{
+	int i = (Mode == PCAN_MODE_EXTENDED) ? 1 : 0;
+
+	if (FromID > ToID)
+		return PCAN_ERROR_ILLPARAMVAL;
+
+	// As with the PCAN hardware, the filter is expanded with every call
+	//
+	if (!m_FilterCustom || m_FilterFrom[i] > m_FilterTo[i])
+	{
+		m_FilterFrom[i] = FromID;
+		m_FilterTo[i] = ToID;
+	}
+	else
+	{
+		m_FilterFrom[i] = FromID < m_FilterFrom[i] ? FromID : m_FilterFrom[i];
+		m_FilterTo[i] = ToID > m_FilterTo[i] ? ToID : m_FilterTo[i];
+	}
+	m_FilterCustom = true;
+
+	return PCAN_ERROR_OK;
+}
+
+DWORD ReplaySource::GetMaxFilterRanges() const
+{
+	// One range per identifier length, the standard and the extended
+	// ones being filtered apart
+	//
+	return 1;
+}
+
+TPCANStatus ReplaySource::WaitForMessages(DWORD Timeout)
+{
+	std::unique_lock<std::mutex> lock(m_WaitMutex);
+
+	// Until its end the trace always has messages pending
+	//
+	if (m_File.is_open() && m_File.good() && !m_WakePending)
+		return PCAN_ERROR_OK;
+
+	if (Timeout == CAN_WAIT_INFINITE)
+		m_WaitCondition.wait(lock, [this] { return m_WakePending; });
+	else
+		m_WaitCondition.wait_for(lock, std::chrono::milliseconds(Timeout), [this] { return m_WakePending; });
+	m_WakePending = false;
+
+	return PCAN_ERROR_QRCVEMPTY;
+}
+
+void ReplaySource::CancelWait()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_WaitMutex);
+		m_WakePending = true;
+	}
+	m_WaitCondition.notify_all();
+}
+
+const char* ReplaySource::GetName() const
+{
+	return m_FileName.c_str();
+}
+
+unsigned long long ReplaySource::GetSkippedLines() const
+{
+	return m_SkippedLines;
+}
+
+INT64 ReplaySource::GetStartTime() const
+{
+	return m_StartTime;
+}
+
+void ReplaySource::ParseStartTime(const std::string &line)
+{
+	std::string::size_type pos;
+	int day, month, year, hour, minute, second, millisecond;
+
+	// 2.x: ";$STARTTIME=42248.5340162037", days since 1899-12-30
+	//
+	pos = line.find("$STARTTIME=");
+	if (pos != std::string::npos)
+	{
+		m_StartTime = (INT64)((atof(line.c_str() + pos + 11) - 25569.0) * 86400000.0 + 0.5);
+		return;
+	}
+
+	// 1.1: ";   Start time: 31.08.2015 12:49:27.500.0"
+	//
+	pos = line.find("Start time:");
+	if (pos == std::string::npos)
+		return;
+	if (sscanf(line.c_str() + pos + 11, "%d.%d.%d %d:%d:%d.%d", &day, &month, &year, &hour, &minute, &second, &millisecond) != 7)
+		return;
+
+	// Days from 1970-01-01 of the civil date
+	//
+	INT64 y = (month <= 2) ? year - 1 : year;
+	INT64 era = (y >= 0 ? y : y - 399) / 400;
+	INT64 yoe = y - era * 400;
+	INT64 doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	INT64 doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	INT64 days = era * 146097 + doe - 719468;
+
+	m_StartTime = ((days * 24 + hour) * 60 + minute) * 60000LL + second * 1000LL + millisecond;
+}
+
+bool ReplaySource::IsAccepted(const TPCANMsgFD &msg) const
+{
+	int i = (msg.MSGTYPE & PCAN_MESSAGE_EXTENDED) ? 1 : 0;
+
+	if (!m_FilterCustom)
+		return true;
+
+	return msg.ID >= m_FilterFrom[i] && msg.ID <= m_FilterTo[i];
+}
+
+bool ReplaySource::ParseLine(const std::string &line, TPCANMsgFDEntry *entry)
+{
+	std::istringstream ss(line);
+	std::string number, type, direction, idText, token;
+	double offset;
+	size_t count;
+	int length;
+
+	// Header lines; the file version and the start time are of interest
+	//
+	if (line.empty() || line[0] == ';')
+	{
+		std::string::size_type pos = line.find("$FILEVERSION=");
+		if (pos != std::string::npos)
+			m_FileVersion = (int)(atof(line.c_str() + pos + 13) * 10 + 0.5);
+		else
+			ParseStartTime(line);
+		return false;
+	}
+
+	// 1.1:    "   12)      1059.9  Rx         0301  8  11 22 33 44 55 66 77 88"
+	// 2.x:    "   12      1059.900 DT     0301 Rx 8  11 22 33 44 55 66 77 88"
+	//
+	if (!(ss >> number >> offset >> type))
+	{
+		m_SkippedLines++;
+		return false;
+	}
+
+	entry->Msg = TPCANMsgFD();
+	entry->Msg.MSGTYPE = PCAN_MESSAGE_STANDARD;
+
+	if (m_FileVersion < 20)
+	{
+		if (type != "Rx" && type != "Tx")
+			return false;
+		if (!(ss >> idText >> length))
+		{
+			m_SkippedLines++;
+			return false;
+		}
+		entry->Msg.DLC = (BYTE)length;
+	}
+	else
+	{
+		if (type != "DT" && type != "FD" && type != "FB" && type != "FE" && type != "BI" && type != "RR")
+			return false;
+		if (!(ss >> idText >> direction >> length))
+		{
+			m_SkippedLines++;
+			return false;
+		}
+		if (type == "RR")
+			entry->Msg.MSGTYPE |= PCAN_MESSAGE_RTR;
+		if (type == "FD" || type == "FB" || type == "FE" || type == "BI")
+			entry->Msg.MSGTYPE |= PCAN_MESSAGE_FD;
+		if (type == "FB" || type == "BI")
+			entry->Msg.MSGTYPE |= PCAN_MESSAGE_BRS;
+		if (type == "FE" || type == "BI")
+			entry->Msg.MSGTYPE |= PCAN_MESSAGE_ESI;
+		entry->Msg.DLC = (BYTE)((entry->Msg.MSGTYPE & PCAN_MESSAGE_FD) ? length : GetDLCFromLength(length));
+	}
+
+	// Extended identifiers are written with 8 digits
+	//
+	if (HexDecodeValue(idText.c_str(), idText.size(), &entry->Msg.ID) != HEX_OK)
+	{
+		m_SkippedLines++;
+		return false;
+	}
+	if (idText.size() > 4)
+		entry->Msg.MSGTYPE |= PCAN_MESSAGE_EXTENDED;
+
+	// Data bytes, or the RTR marker of version 1.1
+	//
+	length = GetLengthFromDLC(entry->Msg.DLC, !(entry->Msg.MSGTYPE & PCAN_MESSAGE_FD));
+	for (int i = 0; (i < length || i == 0) && (ss >> token); i++)
+	{
+		if (token == "RTR")
+		{
+			entry->Msg.MSGTYPE |= PCAN_MESSAGE_RTR;
+			break;
+		}
+		if (i < length && HexDecodeBytes(token.c_str(), token.size(), &entry->Msg.DATA[i], 1, &count) != HEX_OK)
+		{
+			m_SkippedLines++;
+			return false;
+		}
+	}
+
+	// Time offset is given in milliseconds
+	//
+	entry->Timestamp = (TPCANTimestampFD)(offset * 1000.0 + 0.5);
+
+	return true;
+}
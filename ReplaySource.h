@@ -0,0 +1,93 @@
+//  ReplaySource.h
+//
+//  ~~~~~~~~~~~~
+//
+//  CAN source replaying a PCAN-Trace file (*.trc), as written by the
+//  PCAN-Basic trace configured in ConfigureTraceFile or by PCAN-View.
+//  File versions 1.1 and 2.x are understood
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __REPLAYSOURCEH_
+#define __REPLAYSOURCEH_
+
+#include "CANSource.h"
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+// PCAN-Trace file backed CAN source
+//
+class ReplaySource : public CANSource
+{
+	private:
+		// Trace file
+		//
+		std::string m_FileName;
+		std::ifstream m_File;
+		int m_FileVersion;
+
+		// Local wall time of the start of the trace, in milliseconds
+		// since 1970-01-01, or -1 when the header does not give it
+		//
+		INT64 m_StartTime;
+
+		// Reception filter, fully opened until FilterMessages is called
+		//
+		bool m_FilterCustom;
+		DWORD m_FilterFrom[2];
+		DWORD m_FilterTo[2];
+
+		// Statistics of the replay
+		//
+		unsigned long long m_LineCount;
+		unsigned long long m_SkippedLines;
+
+		// Lets WaitForMessages sleep once the trace is exhausted
+		//
+		std::mutex m_WaitMutex;
+		std::condition_variable m_WaitCondition;
+		bool m_WakePending;
+
+		// Parses one line of the trace. Returns false for comments and
+		// for records that are not CAN messages
+		//
+		bool ParseLine(const std::string &line, TPCANMsgFDEntry *entry);
+
+		// Parses the start time header of the trace, if the line is one
+		//
+		void ParseStartTime(const std::string &line);
+
+		// Checks an entry against the reception filter
+		//
+		bool IsAccepted(const TPCANMsgFD &msg) const;
+
+	public:
+		// ReplaySource constructor
+		//
+		explicit ReplaySource(const char *fileName);
+
+		TPCANStatus Initialize();
+		TPCANStatus Uninitialize();
+		TPCANStatus ReadBatch(TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count);
+		TPCANStatus FilterMessages(DWORD FromID, DWORD ToID, TPCANMode Mode);
+		DWORD GetMaxFilterRanges() const;
+		TPCANStatus WaitForMessages(DWORD Timeout);
+		void CancelWait();
+		const char* GetName() const;
+
+		// Gets the number of lines that could not be parsed as a CAN message
+		//
+		unsigned long long GetSkippedLines() const;
+
+		/// <summary>
+		/// Gets the local wall time at which the trace was started, in
+		/// milliseconds since 1970-01-01. The header is read with the first
+		/// messages, so it is known once ReadBatch has been called
+		/// </summary>
+		/// <returns>"The start time, or -1 if the trace does not give it"</returns>
+		INT64 GetStartTime() const;
+};
+#endif
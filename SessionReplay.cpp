@@ -0,0 +1,350 @@
+#include "SessionReplay.h"
+#include "HexCodec.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+SessionReplay::SessionReplay(TimestampService *clock)
+	: m_CANBatch(REPLAY_BATCH), m_CANHostTimes(REPLAY_BATCH), m_Running(false)
+{
+	m_Clock = clock;
+	m_CANIndex = 0;
+	m_CANCount = 0;
+	m_CANEnd = true;
+	m_CANBase = 0;
+	m_XbowEpoch = 0;
+	m_XbowTime = 0;
+	m_XbowEnd = true;
+	m_XbowBase = 0;
+	m_Sink = NULL;
+	m_Speed = REPLAY_REALTIME;
+	m_Stats = ReplayStats();
+	m_PacingErrorSum = 0;
+	m_PacedEvents = 0;
+}
+
+SessionReplay::~SessionReplay()
+{
+	Close();
+}
+
+TPCANStatus SessionReplay::Open(const char *TraceFile, const char *XbowFile, INT64 XbowEpoch)
+{
+	TPCANStatus stsResult;
+
+	Close();
+
+	if (TraceFile != NULL && *TraceFile)
+	{
+		m_CANSource.reset(new ReplaySource(TraceFile));
+		stsResult = m_CANSource->Initialize();
+		if (stsResult != PCAN_ERROR_OK)
+		{
+			m_CANSource.reset();
+			return stsResult;
+		}
+	}
+
+	if (XbowFile != NULL && *XbowFile)
+	{
+		m_XbowFile.open(XbowFile, std::ifstream::in);
+		if (!m_XbowFile.is_open())
+		{
+			Close();
+			return PCAN_ERROR_ILLHW;
+		}
+	}
+
+	if (!m_CANSource && !m_XbowFile.is_open())
+		return PCAN_ERROR_ILLPARAMVAL;
+
+	m_XbowEpoch = XbowEpoch;
+
+	return PCAN_ERROR_OK;
+}
+
+void SessionReplay::Close()
+{
+	Stop();
+
+	if (m_CANSource)
+	{
+		m_CANSource->Uninitialize();
+		m_CANSource.reset();
+	}
+	if (m_XbowFile.is_open())
+		m_XbowFile.close();
+	m_XbowFile.clear();
+}
+
+CANSource* SessionReplay::GetCANSource()
+{
+	return m_CANSource.get();
+}
+
+TPCANStatus SessionReplay::Start(ReplaySink *Sink, double Speed)
+{
+	if (m_Thread.joinable())
+		return PCAN_ERROR_ILLOPERATION;
+	if (Sink == NULL || Speed < 0)
+		return PCAN_ERROR_ILLPARAMVAL;
+	if (!m_CANSource && !m_XbowFile.is_open())
+		return PCAN_ERROR_INITIALIZE;
+
+	m_Sink = Sink;
+	m_Speed = Speed;
+	{
+		std::lock_guard<std::mutex> lock(m_StatsMutex);
+		m_Stats = ReplayStats();
+		m_PacingErrorSum = 0;
+		m_PacedEvents = 0;
+	}
+
+	m_Running.store(true);
+	m_Thread = std::thread(&SessionReplay::ReplayThreadFunc, this);
+
+	return PCAN_ERROR_OK;
+}
+
+void SessionReplay::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_WaitMutex);
+		m_Running.store(false);
+	}
+	m_WaitCondition.notify_all();
+
+	if (m_Thread.joinable())
+		m_Thread.join();
+}
+
+bool SessionReplay::IsOpen() const
+{
+	return m_CANSource || m_XbowFile.is_open();
+}
+
+bool SessionReplay::IsRunning() const
+{
+	return m_Running.load();
+}
+
+ReplayStats SessionReplay::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_StatsMutex);
+
+	return m_Stats;
+}
+
+void SessionReplay::ReadCAN()
+{
+	m_CANIndex = 0;
+	m_CANCount = 0;
+	if (m_CANSource)
+		m_CANSource->ReadBatch(&m_CANBatch[0], REPLAY_BATCH, &m_CANCount);
+
+	// The trace only comes short of messages at its end
+	//
+	m_CANEnd = (m_CANCount == 0);
+}
+
+void SessionReplay::ReadXbow()
+{
+	std::string line, raw;
+	std::string::size_type last, previous;
+	size_t count;
+	char *end;
+
+	m_XbowEnd = true;
+	if (!m_XbowFile.is_open())
+		return;
+
+	// "<decoded fields>\t...\t<raw packet>\t<CPUTIME>", the raw packet
+	// being written in hexadecimal without separators. The header
+	// line and the records without a time are skipped
+	//
+	while (std::getline(m_XbowFile, line))
+	{
+		last = line.find_last_of('\t');
+		if (last == std::string::npos || last == 0)
+			continue;
+		m_XbowTime = (INT64)strtoll(line.c_str() + last + 1, &end, 10);
+		if (end == line.c_str() + last + 1)
+			continue;
+
+		previous = line.find_last_of('\t', last - 1);
+		previous = (previous == std::string::npos) ? 0 : previous + 1;
+		raw.clear();
+		for (std::string::size_type i = previous; i < last; i++)
+			if (line[i] != ' ')
+				raw += line[i];
+		if (raw.size() < XBOW_PACKET_SIZE * 2)
+			continue;
+		raw.erase(0, raw.size() - XBOW_PACKET_SIZE * 2);
+
+		if (HexDecodeBytes(raw.c_str(), raw.size(), m_XbowPacket, XBOW_PACKET_SIZE, &count) != HEX_OK)
+			continue;
+		if (m_XbowPacket[0] != XBOW_HEADER)
+			continue;
+
+		m_XbowEnd = false;
+		return;
+	}
+}
+
+INT64 SessionReplay::GetCANTime() const
+{
+	return m_CANBase + (INT64)m_CANBatch[m_CANIndex].Timestamp * 1000;
+}
+
+INT64 SessionReplay::GetXbowTime() const
+{
+	return m_XbowBase + (m_XbowEpoch + m_XbowTime) * NS_PER_MS;
+}
+
+bool SessionReplay::WaitUntil(UINT64 Due)
+{
+	UINT64 now;
+
+	while (m_Running.load())
+	{
+		now = m_Clock->Now();
+		if (now >= Due)
+			return true;
+
+		// Sleeps while the remaining time allows it, then spins
+		//
+		if (Due - now > REPLAY_SPIN_THRESHOLD)
+		{
+			std::unique_lock<std::mutex> lock(m_WaitMutex);
+			m_WaitCondition.wait_for(lock, std::chrono::nanoseconds(Due - now - REPLAY_SPIN_THRESHOLD), [this] { return !m_Running.load(); });
+		}
+		else
+			std::this_thread::yield();
+	}
+
+	return false;
+}
+
+void SessionReplay::UpdateStatistics(UINT64 Start, INT64 Recorded, UINT64 Lateness, DWORD CANCount, DWORD XbowCount)
+{
+	UINT64 elapsed = m_Clock->Now() - Start;
+	std::lock_guard<std::mutex> lock(m_StatsMutex);
+
+	m_Stats.CANMessages += CANCount;
+	m_Stats.XbowPackets += XbowCount;
+	m_Stats.RecordedTime = (Recorded > 0) ? (UINT64)Recorded : 0;
+	m_Stats.ElapsedTime = elapsed;
+	if (elapsed > 0)
+	{
+		m_Stats.Throughput = (double)(m_Stats.CANMessages + m_Stats.XbowPackets) * NS_PER_SECOND / elapsed;
+		m_Stats.AchievedSpeed = (double)m_Stats.RecordedTime / elapsed;
+	}
+
+	// Pacing only makes sense when the replay waits
+	//
+	if (m_Speed > 0)
+	{
+		m_PacingErrorSum += Lateness;
+		m_PacedEvents++;
+		m_Stats.PacingErrorMean = m_PacingErrorSum / m_PacedEvents;
+		if (Lateness > m_Stats.PacingErrorMax)
+			m_Stats.PacingErrorMax = Lateness;
+		if (Lateness > REPLAY_LATE_THRESHOLD)
+			m_Stats.LateEvents++;
+	}
+}
+
+void SessionReplay::ReplayThreadFunc()
+{
+	bool paced = m_Speed > 0;
+	bool finished = false;
+	UINT64 start, due, now, lateness;
+	INT64 origin, limit, recorded, delivered;
+	DWORD first, count;
+
+	// Primes both streams. Without the start time of the trace the
+	// two are aligned on their first record
+	//
+	m_CANBase = 0;
+	m_XbowBase = 0;
+	ReadCAN();
+	ReadXbow();
+	if (!m_CANEnd && m_CANSource->GetStartTime() >= 0)
+		m_CANBase = m_CANSource->GetStartTime() * NS_PER_MS;
+	else if (!m_CANEnd && !m_XbowEnd)
+		m_XbowBase = GetCANTime() - GetXbowTime();
+
+	if (m_CANEnd)
+		origin = m_XbowEnd ? 0 : GetXbowTime();
+	else
+		origin = (m_XbowEnd || GetCANTime() <= GetXbowTime()) ? GetCANTime() : GetXbowTime();
+
+	start = m_Clock->Now();
+	while (m_Running.load())
+	{
+		if (m_CANEnd && m_XbowEnd)
+		{
+			finished = true;
+			break;
+		}
+
+		// Host time at which the next record is due. Unthrottled, the
+		// records keep their original spacing in the host times given
+		//
+		bool isCAN = !m_CANEnd && (m_XbowEnd || GetCANTime() <= GetXbowTime());
+		recorded = (isCAN ? GetCANTime() : GetXbowTime()) - origin;
+		if (recorded < 0)
+			recorded = 0;
+		due = start + (UINT64)(paced ? recorded / m_Speed : recorded);
+
+		if (paced && !WaitUntil(due))
+			break;
+		now = paced ? m_Clock->Now() : due;
+		lateness = now - due;
+
+		if (isCAN)
+		{
+			// Every message due by now goes in one call, up to the
+			// next Xbow packet
+			//
+			limit = m_XbowEnd ? INT64_MAX : GetXbowTime();
+			first = m_CANIndex;
+			count = 0;
+			delivered = recorded;
+			do
+			{
+				recorded = GetCANTime() - origin;
+				if (recorded < 0)
+					recorded = 0;
+				due = start + (UINT64)(paced ? recorded / m_Speed : recorded);
+				if ((paced && due > now) || (count > 0 && GetCANTime() > limit))
+					break;
+
+				m_CANHostTimes[m_CANIndex] = due;
+				delivered = recorded;
+				m_CANIndex++;
+				count++;
+			} while (m_CANIndex < m_CANCount);
+
+			m_Sink->OnReplayCAN(&m_CANBatch[first], &m_CANHostTimes[first], count);
+			UpdateStatistics(start, delivered, lateness, count, 0);
+
+			if (m_CANIndex >= m_CANCount)
+				ReadCAN();
+		}
+		else
+		{
+			m_Sink->OnReplayXbow(m_XbowPacket, due);
+			UpdateStatistics(start, recorded, lateness, 0, 1);
+
+			ReadXbow();
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_StatsMutex);
+		m_Stats.Finished = finished;
+	}
+	m_Running.store(false);
+	m_Sink->OnReplayFinished(GetStatistics());
+}
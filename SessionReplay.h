@@ -0,0 +1,213 @@
+//  SessionReplay.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Replays a recorded trial: the CAN messages of a PCAN-Trace file and
+//  the Xbow packets of an Acc.txt recording are merged on their original
+//  timeline and handed to a sink, paced in real time, N times faster or
+//  as fast as the sink takes them
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __SESSIONREPLAYH_
+#define __SESSIONREPLAYH_
+
+#include "ReplaySource.h"
+#include "TimestampService.h"
+#include "XbowTypes.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Replay speeds: 1.0 keeps the original gaps, N is N times faster
+// and REPLAY_UNTHROTTLED does not wait at all
+//
+#define REPLAY_REALTIME			1.0
+#define REPLAY_UNTHROTTLED		0.0
+
+// Number of CAN messages read from the trace at once
+//
+#define REPLAY_BATCH			256
+
+// Below this remaining time the replay stops sleeping and spins,
+// since the sleep granularity of the host is coarser (1 ms)
+//
+#define REPLAY_SPIN_THRESHOLD	1000000ULL
+
+// Deliveries later than this count as late (1 ms)
+//
+#define REPLAY_LATE_THRESHOLD	1000000ULL
+
+// Statistics of a replay
+//
+typedef struct tagReplayStats
+{
+	UINT64 CANMessages;      // CAN messages delivered
+	UINT64 XbowPackets;      // Xbow packets delivered
+	UINT64 RecordedTime;     // Span of the recording delivered, in nanoseconds
+	UINT64 ElapsedTime;      // Time taken to deliver it, in nanoseconds
+	double Throughput;       // Messages and packets delivered per second
+	double AchievedSpeed;    // RecordedTime / ElapsedTime
+	UINT64 PacingErrorMean;  // Mean delay of the deliveries after their due time, in nanoseconds
+	UINT64 PacingErrorMax;   // Largest of those delays
+	UINT64 LateEvents;       // Deliveries delayed more than REPLAY_LATE_THRESHOLD
+	bool   Finished;         // The end of the recording was reached
+} ReplayStats;
+
+// Receiver of the replayed data. The calls are made from the replay
+// thread, so they must not call SessionReplay::Stop
+//
+class ReplaySink
+{
+	public:
+		virtual ~ReplaySink() {}
+
+		/// <summary>
+		/// Receives CAN messages due for delivery, in trace order
+		/// </summary>
+		/// <param name="Entries">"The messages, with their original adapter timestamps"</param>
+		/// <param name="HostTimes">"Replayed host reception time of each message, in nanoseconds"</param>
+		/// <param name="Count">"Number of messages"</param>
+		virtual void OnReplayCAN(const TPCANMsgFDEntry* Entries, const UINT64* HostTimes, DWORD Count) = 0;
+
+		/// <summary>
+		/// Receives an Xbow packet as read from the serial port
+		/// </summary>
+		/// <param name="Packet">"XBOW_PACKET_SIZE bytes, starting with the 0xFF header"</param>
+		/// <param name="HostTime">"Replayed host reception time, in nanoseconds"</param>
+		virtual void OnReplayXbow(const BYTE* Packet, UINT64 HostTime) = 0;
+
+		/// <summary>
+		/// Called once the replay thread ends, at the end of the recording or on Stop
+		/// </summary>
+		virtual void OnReplayFinished(const ReplayStats &Stats) = 0;
+};
+
+// Paced replay of a recorded trial
+//
+class SessionReplay
+{
+	private:
+		TimestampService *m_Clock;
+
+		// CAN stream and its read-ahead
+		//
+		std::unique_ptr<ReplaySource> m_CANSource;
+		std::vector<TPCANMsgFDEntry> m_CANBatch;
+		std::vector<UINT64> m_CANHostTimes;
+		DWORD m_CANIndex;
+		DWORD m_CANCount;
+		bool m_CANEnd;
+		INT64 m_CANBase;
+
+		// Xbow stream and its read-ahead. Times in the recording are
+		// milliseconds since m_XbowEpoch
+		//
+		std::ifstream m_XbowFile;
+		INT64 m_XbowEpoch;
+		BYTE m_XbowPacket[XBOW_PACKET_SIZE];
+		INT64 m_XbowTime;
+		bool m_XbowEnd;
+		INT64 m_XbowBase;
+
+		// Replay thread
+		//
+		ReplaySink *m_Sink;
+		double m_Speed;
+		std::thread m_Thread;
+		std::atomic<bool> m_Running;
+		std::mutex m_WaitMutex;
+		std::condition_variable m_WaitCondition;
+
+		// Statistics, updated by the replay thread
+		//
+		mutable std::mutex m_StatsMutex;
+		ReplayStats m_Stats;
+		UINT64 m_PacingErrorSum;
+		UINT64 m_PacedEvents;
+
+		// Reads ahead the next messages of the trace
+		//
+		void ReadCAN();
+
+		// Reads ahead the next valid packet of the Xbow recording
+		//
+		void ReadXbow();
+
+		// Time of the pending CAN message and Xbow packet on the common
+		// timeline of the recording, in nanoseconds
+		//
+		INT64 GetCANTime() const;
+		INT64 GetXbowTime() const;
+
+		// Sleeps until the due time. Returns false if the replay is stopped
+		//
+		bool WaitUntil(UINT64 Due);
+
+		// Accounts the deliveries of one step
+		//
+		void UpdateStatistics(UINT64 Start, INT64 Recorded, UINT64 Lateness, DWORD CANCount, DWORD XbowCount);
+
+		// Replay thread
+		//
+		void ReplayThreadFunc();
+
+		SessionReplay(const SessionReplay&);
+		SessionReplay& operator=(const SessionReplay&);
+
+	public:
+		// SessionReplay constructor. The clock is owned by the caller
+		//
+		explicit SessionReplay(TimestampService *clock);
+		// SessionReplay destructor. Stops the replay
+		//
+		~SessionReplay();
+
+		/// <summary>
+		/// Opens the recordings to be replayed. Either one may be omitted
+		/// </summary>
+		/// <param name="TraceFile">"PCAN-Trace file of the CAN bus, or NULL"</param>
+		/// <param name="XbowFile">"Acc.txt file of the Xbow, or NULL"</param>
+		/// <param name="XbowEpoch">"Origin of the CPUTIME column of the Xbow file, in local
+		/// milliseconds since 1970-01-01. Used to place both streams on one timeline
+		/// when the trace gives its start time"</param>
+		/// <returns>"A TPCANStatus error code"</returns>
+		TPCANStatus Open(const char *TraceFile, const char *XbowFile, INT64 XbowEpoch);
+
+		/// <summary>
+		/// Stops the replay and closes the recordings
+		/// </summary>
+		void Close();
+
+		/// <summary>
+		/// Gets the source of the CAN stream, so its filter can be configured
+		/// before the replay starts. NULL without a trace file
+		/// </summary>
+		CANSource* GetCANSource();
+
+		/// <summary>
+		/// Starts the replay thread
+		/// </summary>
+		/// <param name="Sink">"Receiver of the data, owned by the caller"</param>
+		/// <param name="Speed">"REPLAY_REALTIME, a speed-up factor or REPLAY_UNTHROTTLED"</param>
+		/// <returns>"A TPCANStatus error code"</returns>
+		TPCANStatus Start(ReplaySink *Sink, double Speed = REPLAY_REALTIME);
+
+		/// <summary>
+		/// Stops and joins the replay thread
+		/// </summary>
+		void Stop();
+
+		// Replay information, safe to read from any thread
+		//
+		bool IsOpen() const;
+		bool IsRunning() const;
+		ReplayStats GetStatistics() const;
+};
+#endif
@@ -0,0 +1,59 @@
+#include "SignalDecoder.h"
+
+bool PrepareSignal(SignalDescriptor *Signal)
+{
+	int msbOffset;
+
+	if (Signal->Length < 1 || Signal->Length > SIGNAL_MAX_LENGTH || Signal->StartBit < 0 || Signal->Scale == 0.0)
+		return false;
+
+	Signal->FirstByte = Signal->StartBit / 8;
+	if (Signal->ByteOrder == SIGNAL_BIG_ENDIAN)
+	{
+		msbOffset = 7 - Signal->StartBit % 8;
+		Signal->Bytes = (msbOffset + Signal->Length + 7) / 8;
+		Signal->Shift = Signal->Bytes * 8 - msbOffset - Signal->Length;
+	}
+	else if (Signal->ByteOrder == SIGNAL_LITTLE_ENDIAN)
+	{
+		Signal->Bytes = (Signal->StartBit % 8 + Signal->Length + 7) / 8;
+		Signal->Shift = Signal->StartBit % 8;
+	}
+	else
+		return false;
+
+	return true;
+}
+
+bool ExtractSignal(const SignalDescriptor &Signal, const BYTE *Data, int Length, INT64 *Raw)
+{
+	const BYTE *bytes;
+	UINT64 raw = 0;
+
+	if (Signal.FirstByte + Signal.Bytes > Length)
+		return false;
+
+	bytes = Data + Signal.FirstByte;
+	if (Signal.ByteOrder == SIGNAL_BIG_ENDIAN)
+		for (int i = 0; i < Signal.Bytes; i++)
+			raw = (raw << 8) | bytes[i];
+	else
+		for (int i = 0; i < Signal.Bytes; i++)
+			raw |= (UINT64)bytes[i] << (8 * i);
+
+	raw = (raw >> Signal.Shift) & (((UINT64)1 << Signal.Length) - 1);
+	*Raw = Signal.Signed ? SignExtendSignal(raw, Signal.Length) : (INT64)raw;
+
+	return true;
+}
+
+bool DecodeSignal(const SignalDescriptor &Signal, const BYTE *Data, int Length, double *Value)
+{
+	INT64 raw;
+
+	if (!ExtractSignal(Signal, Data, Length, &raw))
+		return false;
+
+	*Value = (double)raw * Signal.Scale + Signal.Offset;
+	return true;
+}
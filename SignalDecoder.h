@@ -0,0 +1,188 @@
+//  SignalDecoder.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Extraction of the signals packed in the data of a CAN frame, described
+//  by their ID, start bit, length, byte order, signedness, scale, offset
+//  and unit, with the bit numbering of the DBC files.
+//
+//  A signal known when compiling is a Signal<> type: its position is
+//  resolved by the compiler and its extraction reads exactly the bytes it
+//  covers. A signal known at run time (loaded from a file) is a
+//  SignalDescriptor, prepared once and then extracted with the same
+//  results
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __SIGNALDECODERH_
+#define __SIGNALDECODERH_
+
+#include "CANTypes.h"
+
+#include <string>
+
+// Byte orders, with the values of the DBC files
+//
+#define SIGNAL_BIG_ENDIAN		0	// Motorola, start bit is the most significant one
+#define SIGNAL_LITTLE_ENDIAN	1	// Intel, start bit is the least significant one
+
+// Longest signal supported, in bits
+//
+#define SIGNAL_MAX_LENGTH		32
+
+// Description of a signal known at run time
+//
+typedef struct tagSignalDescriptor
+{
+	std::string Name;
+	std::string Unit;
+	DWORD ID;             // ID of the frame carrying the signal
+	int StartBit;         // DBC numbering: bit (StartBit % 8) of byte (StartBit / 8)
+	int Length;           // In bits, 1 to SIGNAL_MAX_LENGTH
+	int ByteOrder;        // SIGNAL_BIG_ENDIAN or SIGNAL_LITTLE_ENDIAN
+	bool Signed;          // Two's complement raw value
+	double Scale;         // Physical value = raw * Scale + Offset
+	double Offset;
+
+	// Set by PrepareSignal
+	//
+	int FirstByte;        // First byte covered
+	int Bytes;            // Number of bytes covered
+	int Shift;            // Right shift of the bytes read
+} SignalDescriptor;
+
+// Reads Count bytes as one integer
+//
+template <int Count>
+struct SignalBytes
+{
+	static UINT64 BigEndian(const BYTE *Data)
+	{
+		return (SignalBytes<Count - 1>::BigEndian(Data) << 8) | Data[Count - 1];
+	}
+
+	static UINT64 LittleEndian(const BYTE *Data)
+	{
+		return SignalBytes<Count - 1>::LittleEndian(Data) | ((UINT64)Data[Count - 1] << (8 * (Count - 1)));
+	}
+};
+
+template <>
+struct SignalBytes<0>
+{
+	static UINT64 BigEndian(const BYTE *) { return 0; }
+	static UINT64 LittleEndian(const BYTE *) { return 0; }
+};
+
+// Sign-extends the Length low bits of a raw value
+//
+inline INT64 SignExtendSignal(UINT64 Raw, int Length)
+{
+	UINT64 sign = (UINT64)1 << (Length - 1);
+
+	return (INT64)((Raw ^ sign) - sign);
+}
+
+// Signal known at compile time. The scale is the ratio ScaleNum / ScaleDen
+//
+template <DWORD TID, int TStartBit, int TLength, int TByteOrder, bool TSigned,
+	INT64 TScaleNum = 1, INT64 TScaleDen = 1, INT64 TOffset = 0>
+class Signal
+{
+	static_assert(TLength >= 1 && TLength <= SIGNAL_MAX_LENGTH, "Signal length out of range");
+	static_assert(TByteOrder == SIGNAL_BIG_ENDIAN || TByteOrder == SIGNAL_LITTLE_ENDIAN, "Unknown byte order");
+	static_assert(TScaleDen != 0, "Null scale denominator");
+
+	private:
+		// Position of the start bit counted from the most significant bit
+		// of the first byte, for the big-endian signals
+		//
+		static const int MsbOffset = 7 - TStartBit % 8;
+
+	public:
+		static const DWORD ID = TID;
+		static const int FirstByte = TStartBit / 8;
+		static const int Bytes = (TByteOrder == SIGNAL_BIG_ENDIAN)
+			? (MsbOffset + TLength + 7) / 8
+			: (TStartBit % 8 + TLength + 7) / 8;
+		static const int Shift = (TByteOrder == SIGNAL_BIG_ENDIAN)
+			? Bytes * 8 - MsbOffset - TLength
+			: TStartBit % 8;
+
+		// Minimum data length of a frame carrying the signal
+		//
+		static const int MinLength = FirstByte + Bytes;
+
+		/// <summary>
+		/// Extracts the raw value of the signal. The data holds at least
+		/// MinLength bytes
+		/// </summary>
+		static INT64 Extract(const BYTE *Data)
+		{
+			UINT64 raw = (TByteOrder == SIGNAL_BIG_ENDIAN)
+				? SignalBytes<Bytes>::BigEndian(Data + FirstByte)
+				: SignalBytes<Bytes>::LittleEndian(Data + FirstByte);
+
+			raw = (raw >> Shift) & (((UINT64)1 << TLength) - 1);
+			return TSigned ? SignExtendSignal(raw, TLength) : (INT64)raw;
+		}
+
+		/// <summary>
+		/// Extracts the physical value of the signal
+		/// </summary>
+		static double Decode(const BYTE *Data)
+		{
+			return (double)Extract(Data) * ((double)TScaleNum / (double)TScaleDen) + (double)TOffset;
+		}
+
+		/// <summary>
+		/// Gives the run-time description of the signal
+		/// </summary>
+		static SignalDescriptor Describe(const char *Name, const char *Unit)
+		{
+			SignalDescriptor signal;
+
+			signal.Name = Name;
+			signal.Unit = Unit;
+			signal.ID = TID;
+			signal.StartBit = TStartBit;
+			signal.Length = TLength;
+			signal.ByteOrder = TByteOrder;
+			signal.Signed = TSigned;
+			signal.Scale = (double)TScaleNum / (double)TScaleDen;
+			signal.Offset = (double)TOffset;
+			signal.FirstByte = FirstByte;
+			signal.Bytes = Bytes;
+			signal.Shift = Shift;
+
+			return signal;
+		}
+};
+
+/// <summary>
+/// Checks a signal known at run time and computes its position
+/// </summary>
+/// <param name="Signal">"Signal to prepare"</param>
+/// <returns>"false if the length, byte order or scale is invalid"</returns>
+bool PrepareSignal(SignalDescriptor *Signal);
+
+/// <summary>
+/// Extracts the raw value of a prepared signal
+/// </summary>
+/// <param name="Signal">"Prepared signal"</param>
+/// <param name="Data">"Data bytes of the frame"</param>
+/// <param name="Length">"Number of data bytes"</param>
+/// <param name="Raw">"Raw value of the signal"</param>
+/// <returns>"false if the frame is too short for the signal"</returns>
+bool ExtractSignal(const SignalDescriptor &Signal, const BYTE *Data, int Length, INT64 *Raw);
+
+/// <summary>
+/// Extracts the physical value of a prepared signal
+/// </summary>
+/// <param name="Signal">"Prepared signal"</param>
+/// <param name="Data">"Data bytes of the frame"</param>
+/// <param name="Length">"Number of data bytes"</param>
+/// <param name="Value">"Physical value of the signal"</param>
+/// <returns>"false if the frame is too short for the signal"</returns>
+bool DecodeSignal(const SignalDescriptor &Signal, const BYTE *Data, int Length, double *Value);
+#endif
@@ -0,0 +1,173 @@
+#include "SignalPlan.h"
+#include "DbcLoader.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include <string.h>
+
+void SignalBuffer::Reset(int Columns)
+{
+	m_Columns.assign(Columns, std::vector<SignalSample>());
+}
+
+void SignalBuffer::Clear()
+{
+	for (size_t i = 0; i < m_Columns.size(); i++)
+		m_Columns[i].clear();
+}
+
+// Orders the columns by message, keeping the DBC order within one
+//
+class SignalOrder
+{
+	private:
+		const std::vector<SignalDescriptor> &m_Signals;
+
+	public:
+		SignalOrder(const std::vector<SignalDescriptor> &Signals) : m_Signals(Signals) {}
+
+		bool operator()(int Left, int Right) const
+		{
+			return m_Signals[Left].ID < m_Signals[Right].ID;
+		}
+};
+
+void SignalPlan::Build(const std::vector<SignalDescriptor> &Signals)
+{
+	std::vector<int> columns;
+	SignalOperation operation;
+	PlanMessage message;
+	DWORD id;
+
+	m_Signals = Signals;
+	m_Operations.clear();
+	m_Operations.reserve(Signals.size());
+	m_Messages.Clear();
+	m_Slots.clear();
+
+	for (int i = 0; i < (int)Signals.size(); i++)
+		columns.push_back(i);
+	std::stable_sort(columns.begin(), columns.end(), SignalOrder(m_Signals));
+
+	for (size_t i = 0; i < columns.size(); i++)
+	{
+		const SignalDescriptor &signal = m_Signals[columns[i]];
+
+		// The signals of one message follow each other
+		//
+		if (i == 0 || signal.ID != m_Signals[columns[i - 1]].ID)
+		{
+			id = signal.ID & ~DBC_ID_EXTENDED;
+			message.First = (int)m_Operations.size();
+			message.Count = 0;
+			m_Messages.Add(id, (signal.ID & DBC_ID_EXTENDED) ? PCAN_MESSAGE_EXTENDED : PCAN_MESSAGE_STANDARD, message);
+		}
+		m_Messages[m_Messages.GetCount() - 1].Count++;
+
+		operation.Column = columns[i];
+		operation.FirstByte = signal.FirstByte;
+		operation.Bytes = signal.Bytes;
+		operation.Shift = signal.Shift;
+		operation.MinLength = signal.FirstByte + signal.Bytes;
+		operation.Wide = operation.MinLength > 8;
+		operation.BigEndian = (signal.ByteOrder == SIGNAL_BIG_ENDIAN);
+		operation.WindowShift = operation.BigEndian ? (8 - operation.MinLength) * 8 + signal.Shift : signal.FirstByte * 8 + signal.Shift;
+		operation.Mask = ((UINT64)1 << signal.Length) - 1;
+		operation.Sign = signal.Signed ? (UINT64)1 << (signal.Length - 1) : 0;
+		operation.Scale = signal.Scale;
+		operation.Offset = signal.Offset;
+		m_Operations.push_back(operation);
+	}
+}
+
+void SignalPlan::ResetSlots()
+{
+	m_Slots.clear();
+}
+
+int SignalPlan::FindMessage(const CANFrameView &Frame) const
+{
+	return m_Messages.Find(Frame.ID, Frame.MSGTYPE & PCAN_MESSAGE_EXTENDED);
+}
+
+int SignalPlan::Decode(int Slot, const CANFrameView &Frame, UINT64 Timestamp, SignalBuffer *Buffer)
+{
+	const SignalOperation *operation, *end;
+	const BYTE *head, *bytes;
+	BYTE padded[8];
+	UINT64 bigEndian, littleEndian, raw;
+	int message, decoded = 0;
+
+	if (m_Operations.empty() || (Frame.MSGTYPE & (PCAN_MESSAGE_RTR | PCAN_MESSAGE_STATUS)) != 0)
+		return 0;
+
+	// The plan message of a slot is looked up once
+	//
+	if (Slot >= (int)m_Slots.size())
+		m_Slots.resize(Slot + 1, SIGNAL_PLAN_UNKNOWN);
+	if (m_Slots[Slot] == SIGNAL_PLAN_UNKNOWN)
+		m_Slots[Slot] = FindMessage(Frame);
+	message = m_Slots[Slot];
+	if (message == MSG_TABLE_NONE)
+		return 0;
+
+	// The first 8 bytes are read once, in both byte orders
+	//
+	head = Frame.DATA;
+	if (Frame.LEN < 8)
+	{
+		memset(padded, 0, sizeof(padded));
+		memcpy(padded, Frame.DATA, Frame.LEN);
+		head = padded;
+	}
+	bigEndian = SignalBytes<8>::BigEndian(head);
+	littleEndian = SignalBytes<8>::LittleEndian(head);
+
+	operation = &m_Operations[m_Messages[message].First];
+	end = operation + m_Messages[message].Count;
+	for (; operation != end; ++operation)
+	{
+		if (operation->MinLength > Frame.LEN)
+			continue;
+
+		if (!operation->Wide)
+			raw = (operation->BigEndian ? bigEndian : littleEndian) >> operation->WindowShift;
+		else
+		{
+			bytes = Frame.DATA + operation->FirstByte;
+			raw = 0;
+			if (operation->BigEndian)
+				for (int i = 0; i < operation->Bytes; i++)
+					raw = (raw << 8) | bytes[i];
+			else
+				for (int i = 0; i < operation->Bytes; i++)
+					raw |= (UINT64)bytes[i] << (8 * i);
+			raw >>= operation->Shift;
+		}
+		raw &= operation->Mask;
+		raw = (raw ^ operation->Sign) - operation->Sign;
+
+		Buffer->Append(operation->Column, Timestamp, (double)(INT64)raw * operation->Scale + operation->Offset);
+		decoded++;
+	}
+
+	return decoded;
+}
+
+std::string SignalPlan::GetReport(const SignalBuffer &Buffer) const
+{
+	std::ostringstream report;
+
+	report.precision(10);
+	report << "Signal\tUnit\tTime\tValue\n";
+	for (int i = 0; i < Buffer.GetColumnCount() && i < GetSignalCount(); i++)
+	{
+		const std::vector<SignalSample> &samples = Buffer.GetSamples(i);
+
+		for (size_t j = 0; j < samples.size(); j++)
+			report << m_Signals[i].Name << '\t' << m_Signals[i].Unit << '\t' << samples[j].Timestamp << '\t' << samples[j].Value << '\n';
+	}
+
+	return report.str();
+}
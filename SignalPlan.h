@@ -0,0 +1,135 @@
+//  SignalPlan.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Extraction plan of the signals subscribed from a DBC file. The signals
+//  are turned into a flat array of shift/mask/scale operations, grouped
+//  by message. A frame finds its operations through the slot it has in
+//  the message table, so decoding it costs the same whatever the number
+//  of messages the DBC defines. The values go to a columnar buffer, one
+//  column per signal
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __SIGNALPLANH_
+#define __SIGNALPLANH_
+
+#include "SignalDecoder.h"
+#include "MessageTable.h"
+
+#include <string>
+#include <vector>
+
+// Slot of the message table not looked up in the plan yet
+//
+#define SIGNAL_PLAN_UNKNOWN		(-2)
+
+// Decoded value of a signal
+//
+typedef struct tagSignalSample
+{
+	UINT64 Timestamp;
+	double Value;
+} SignalSample;
+
+// Values of the decoded signals, one column per signal of the plan
+//
+class SignalBuffer
+{
+	private:
+		std::vector<std::vector<SignalSample> > m_Columns;
+
+	public:
+		// Sets the number of columns, removing every value
+		//
+		void Reset(int Columns);
+
+		// Removes every value, keeping the columns
+		//
+		void Clear();
+
+		void Append(int Column, UINT64 Timestamp, double Value)
+		{
+			SignalSample sample = { Timestamp, Value };
+
+			m_Columns[Column].push_back(sample);
+		}
+
+		int GetColumnCount() const { return (int)m_Columns.size(); }
+		const std::vector<SignalSample>& GetSamples(int Column) const { return m_Columns[Column]; }
+};
+
+// Extraction plan
+//
+class SignalPlan
+{
+	private:
+		// Extraction of one signal. The signals held in the first 8 bytes
+		// are shifted out of one 64-bit read of the frame
+		//
+		typedef struct tagSignalOperation
+		{
+			int Column;
+			int FirstByte;
+			int Bytes;
+			int Shift;            // In the bytes covered
+			int WindowShift;      // In the first 8 bytes
+			int MinLength;        // Data length holding the signal
+			bool Wide;            // Goes past the first 8 bytes
+			bool BigEndian;
+			UINT64 Mask;
+			UINT64 Sign;          // Sign bit, 0 for unsigned signals
+			double Scale;
+			double Offset;
+		} SignalOperation;
+
+		// Operations of one message
+		//
+		typedef struct tagPlanMessage
+		{
+			int First;
+			int Count;
+		} PlanMessage;
+
+		std::vector<SignalDescriptor> m_Signals;
+		std::vector<SignalOperation> m_Operations;
+		MessageTable<PlanMessage> m_Messages;
+
+		// Plan message of each slot of the message table
+		//
+		std::vector<int> m_Slots;
+
+		int FindMessage(const CANFrameView &Frame) const;
+
+	public:
+		/// <summary>
+		/// Builds the plan of a set of signals, as read by the DBC loader
+		/// </summary>
+		/// <param name="Signals">"Prepared signals, the columns of the plan in this order"</param>
+		void Build(const std::vector<SignalDescriptor> &Signals);
+
+		/// <summary>
+		/// Forgets the slots of the message table, when it is cleared
+		/// </summary>
+		void ResetSlots();
+
+		/// <summary>
+		/// Decodes the signals of a frame into the buffer
+		/// </summary>
+		/// <param name="Slot">"Slot of the frame in the message table"</param>
+		/// <param name="Frame">"Frame to decode"</param>
+		/// <param name="Timestamp">"Time of the frame"</param>
+		/// <param name="Buffer">"Buffer of the values, reset for this plan"</param>
+		/// <returns>"The number of signals decoded"</returns>
+		int Decode(int Slot, const CANFrameView &Frame, UINT64 Timestamp, SignalBuffer *Buffer);
+
+		int GetSignalCount() const { return (int)m_Signals.size(); }
+		int GetMessageCount() const { return m_Messages.GetCount(); }
+		const SignalDescriptor& GetSignal(int Column) const { return m_Signals[Column]; }
+
+		/// <summary>
+		/// Gives the values of a buffer as tab-separated text, one line per value
+		/// </summary>
+		std::string GetReport(const SignalBuffer &Buffer) const;
+};
+#endif
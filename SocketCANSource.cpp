@@ -0,0 +1,328 @@
+﻿#include "SocketCANSource.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can/raw.h>
+
+// Number of frames fetched from the kernel per recvmmsg call
+//
+#define SOCKETCAN_MMSG_COUNT	64
+
+// Ranges per identifier length kept exact in the CAN_RAW_FILTER list.
+// A range costs up to 2 x 29 - 2 id/mask pairs (2 x 11 - 2 for the
+// standard IDs), checked one by one by the kernel for every frame. The
+// ranges of both lengths must fit the 512 pairs the kernel takes at most
+// (CAN_RAW_FILTER_MAX): 6 x (56 + 20) = 456 pairs
+//
+#define SOCKETCAN_MAX_RANGES	6
+
+SocketCANSource::SocketCANSource(const char *interfaceName, bool isFD)
+{
+	m_Interface = interfaceName;
+	m_IsFD = isFD;
+	m_Socket = -1;
+
+	m_WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	m_Epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (m_Epoll >= 0 && m_WakeFd >= 0)
+	{
+		struct epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.fd = m_WakeFd;
+		epoll_ctl(m_Epoll, EPOLL_CTL_ADD, m_WakeFd, &event);
+	}
+}
+
+SocketCANSource::~SocketCANSource()
+{
+	Uninitialize();
+	if (m_Epoll >= 0)
+		close(m_Epoll);
+	if (m_WakeFd >= 0)
+		close(m_WakeFd);
+}
+
+TPCANStatus SocketCANSource::Initialize()
+{
+	struct ifreq ifr;
+	struct sockaddr_can addr;
+	int enable = 1;
+
+	if (m_Socket >= 0)
+		return PCAN_ERROR_HWINUSE;
+
+	m_Socket = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+	if (m_Socket < 0)
+		return PCAN_ERROR_NODRIVER;
+
+	// Resolves the interface index
+	//
+	memset(&ifr, 0, sizeof(ifr));
+	strncpy(ifr.ifr_name, m_Interface.c_str(), IFNAMSIZ - 1);
+	if (ioctl(m_Socket, SIOCGIFINDEX, &ifr) < 0)
+	{
+		Uninitialize();
+		return PCAN_ERROR_ILLHW;
+	}
+
+	// FD frames must be enabled explicitly, and the kernel reception
+	// time is delivered with each frame
+	//
+	if (m_IsFD && setsockopt(m_Socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) < 0)
+	{
+		Uninitialize();
+		return PCAN_ERROR_ILLOPERATION;
+	}
+	setsockopt(m_Socket, SOL_SOCKET, SO_TIMESTAMP, &enable, sizeof(enable));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.can_family = AF_CAN;
+	addr.can_ifindex = ifr.ifr_ifindex;
+	if (bind(m_Socket, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+	{
+		Uninitialize();
+		return PCAN_ERROR_ILLHW;
+	}
+
+	// The socket is watched together with the wake-up eventfd.
+	// Closing the socket removes it from the epoll set again
+	//
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = m_Socket;
+	if (m_Epoll < 0 || epoll_ctl(m_Epoll, EPOLL_CTL_ADD, m_Socket, &event) < 0)
+	{
+		Uninitialize();
+		return PCAN_ERROR_RESOURCE;
+	}
+
+	return ApplyFilters();
+}
+
+TPCANStatus SocketCANSource::Uninitialize()
+{
+	if (m_Socket >= 0)
+		close(m_Socket);
+	m_Socket = -1;
+
+	return PCAN_ERROR_OK;
+}
+
+TPCANStatus SocketCANSource::ReadBatch(TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count)
+{
+	struct canfd_frame frames[SOCKETCAN_MMSG_COUNT];
+	struct iovec iovs[SOCKETCAN_MMSG_COUNT];
+	struct mmsghdr msgs[SOCKETCAN_MMSG_COUNT];
+	char controls[SOCKETCAN_MMSG_COUNT][CMSG_SPACE(sizeof(struct timeval))];
+	DWORD dwRead = 0;
+
+	*Count = 0;
+	if (m_Socket < 0)
+		return PCAN_ERROR_INITIALIZE;
+
+	while (dwRead < MaxCount)
+	{
+		unsigned int want = MaxCount - dwRead;
+		if (want > SOCKETCAN_MMSG_COUNT)
+			want = SOCKETCAN_MMSG_COUNT;
+
+		for (unsigned int i = 0; i < want; i++)
+		{
+			iovs[i].iov_base = &frames[i];
+			iovs[i].iov_len = sizeof(frames[i]);
+			memset(&msgs[i], 0, sizeof(msgs[i]));
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_control = controls[i];
+			msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+		}
+
+		int received = recvmmsg(m_Socket, msgs, want, MSG_DONTWAIT, NULL);
+		if (received <= 0)
+		{
+			*Count = dwRead;
+			if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+				return PCAN_ERROR_UNKNOWN;
+			return PCAN_ERROR_QRCVEMPTY;
+		}
+
+		for (int i = 0; i < received; i++)
+		{
+			const struct canfd_frame &frame = frames[i];
+			TPCANMsgFDEntry &entry = EntryBuffer[dwRead];
+			struct cmsghdr *cmsg;
+
+			// Error frames carry no bus data
+			//
+			if (frame.can_id & CAN_ERR_FLAG)
+				continue;
+
+			FrameToMessage(frame, msgs[i].msg_len == CANFD_MTU, entry.Msg);
+
+			// Kernel reception time, in microseconds
+			//
+			entry.Timestamp = 0;
+			for (cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg))
+				if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMP)
+				{
+					struct timeval tv;
+					memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+					entry.Timestamp = (TPCANTimestampFD)tv.tv_sec * 1000000 + tv.tv_usec;
+				}
+
+			dwRead++;
+		}
+
+		if ((unsigned int)received < want)
+		{
+			*Count = dwRead;
+			return PCAN_ERROR_QRCVEMPTY;
+		}
+	}
+
+	*Count = dwRead;
+	return PCAN_ERROR_OK;
+}
+
+TPCANStatus SocketCANSource::FilterMessages(DWORD FromID, DWORD ToID, TPCANMode Mode)
+{
+	if (FromID > ToID)
+		return PCAN_ERROR_ILLPARAMVAL;
+
+	RangeToFilters(FromID, ToID, Mode == PCAN_MODE_EXTENDED, m_Filters);
+
+	if (m_Socket < 0)
+		return PCAN_ERROR_OK;
+	return ApplyFilters();
+}
+
+DWORD SocketCANSource::GetMaxFilterRanges() const
+{
+	return SOCKETCAN_MAX_RANGES;
+}
+
+TPCANStatus SocketCANSource::WaitForMessages(DWORD Timeout)
+{
+	struct epoll_event events[2];
+	bool pending = false;
+	int ready;
+
+	if (m_Epoll < 0)
+		return PCAN_ERROR_RESOURCE;
+
+	ready = epoll_wait(m_Epoll, events, 2, Timeout == CAN_WAIT_INFINITE ? -1 : (int)Timeout);
+	if (ready < 0)
+		return errno == EINTR ? PCAN_ERROR_QRCVEMPTY : PCAN_ERROR_UNKNOWN;
+
+	for (int i = 0; i < ready; i++)
+		if (events[i].data.fd == m_WakeFd)
+		{
+			// Consumes the wake-up so the next wait blocks again
+			//
+			uint64_t value;
+			if (read(m_WakeFd, &value, sizeof(value)) < 0)
+				continue;
+		}
+		else
+			pending = true;
+
+	return pending ? PCAN_ERROR_OK : PCAN_ERROR_QRCVEMPTY;
+}
+
+void SocketCANSource::CancelWait()
+{
+	uint64_t value = 1;
+
+	if (m_WakeFd >= 0 && write(m_WakeFd, &value, sizeof(value)) < 0)
+		return;
+}
+
+const char* SocketCANSource::GetName() const
+{
+	return m_Interface.c_str();
+}
+
+int SocketCANSource::GetDescriptor() const
+{
+	return m_Socket;
+}
+
+TPCANStatus SocketCANSource::ApplyFilters()
+{
+	// Without registered filters the socket keeps its default, fully opened filter
+	//
+	if (m_Filters.empty())
+		return PCAN_ERROR_OK;
+
+	if (setsockopt(m_Socket, SOL_CAN_RAW, CAN_RAW_FILTER, &m_Filters[0], m_Filters.size() * sizeof(struct can_filter)) < 0)
+		return PCAN_ERROR_ILLPARAMVAL;
+
+	return PCAN_ERROR_OK;
+}
+
+void SocketCANSource::FrameToMessage(const struct canfd_frame &Frame, bool IsFD, TPCANMsgFD &Msg)
+{
+	Msg.MSGTYPE = PCAN_MESSAGE_STANDARD;
+	if (Frame.can_id & CAN_EFF_FLAG)
+	{
+		Msg.ID = Frame.can_id & CAN_EFF_MASK;
+		Msg.MSGTYPE |= PCAN_MESSAGE_EXTENDED;
+	}
+	else
+		Msg.ID = Frame.can_id & CAN_SFF_MASK;
+	if (IsFD)
+	{
+		Msg.MSGTYPE |= PCAN_MESSAGE_FD;
+		if (Frame.flags & CANFD_BRS)
+			Msg.MSGTYPE |= PCAN_MESSAGE_BRS;
+		if (Frame.flags & CANFD_ESI)
+			Msg.MSGTYPE |= PCAN_MESSAGE_ESI;
+	}
+	Msg.DLC = (BYTE)GetDLCFromLength(Frame.len);
+
+	// A remote request only gives the length asked for, whatever is left
+	// in the data bytes of the frame
+	//
+	if (Frame.can_id & CAN_RTR_FLAG)
+	{
+		Msg.MSGTYPE |= PCAN_MESSAGE_RTR;
+		memset(Msg.DATA, 0, sizeof(Msg.DATA));
+	}
+	else
+		memcpy(Msg.DATA, Frame.data, Frame.len);
+}
+
+void SocketCANSource::RangeToFilters(DWORD FromID, DWORD ToID, bool Extended, std::vector<struct can_filter> &Filters)
+{
+	const DWORD idMask = Extended ? CAN_EFF_MASK : CAN_SFF_MASK;
+	unsigned long long id = FromID & idMask;
+	const unsigned long long last = ToID & idMask;
+
+	// Covers the range with the largest aligned power-of-two blocks,
+	// each of them being exactly one id/mask pair
+	//
+	while (id <= last)
+	{
+		unsigned long long size = 1;
+		while ((id & ((size << 1) - 1)) == 0 && id + (size << 1) - 1 <= last)
+			size <<= 1;
+
+		struct can_filter filter;
+		filter.can_id = (canid_t)id | (Extended ? CAN_EFF_FLAG : 0);
+		filter.can_mask = (canid_t)(idMask & ~(size - 1)) | CAN_EFF_FLAG;
+		Filters.push_back(filter);
+
+		id += size;
+	}
+}
+#endif
@@ -0,0 +1,88 @@
+//  SocketCANSource.h
+//
+//  ~~~~~~~~~~~~
+//
+//  CAN source reading a Linux SocketCAN interface (can0, vcan0, ...)
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __SOCKETCANSOURCEH_
+#define __SOCKETCANSOURCEH_
+
+#include "CANSource.h"
+
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/can.h>
+
+// SocketCAN backed CAN source
+//
+class SocketCANSource : public CANSource
+{
+	private:
+		// Interface name and connection mode
+		//
+		std::string m_Interface;
+		bool m_IsFD;
+
+		// Raw CAN socket, -1 while not initialized
+		//
+		int m_Socket;
+
+		// epoll instance watching the socket and the eventfd used
+		// to cancel a wait. Both live as long as the object
+		//
+		int m_Epoll;
+		int m_WakeFd;
+
+		// Reception filters registered through FilterMessages
+		//
+		std::vector<struct can_filter> m_Filters;
+
+		// Applies m_Filters to the socket
+		//
+		TPCANStatus ApplyFilters();
+
+	public:
+		// SocketCANSource constructor
+		//
+		SocketCANSource(const char *interfaceName, bool isFD = false);
+		// SocketCANSource destructor
+		//
+		~SocketCANSource();
+
+		TPCANStatus Initialize();
+		TPCANStatus Uninitialize();
+		TPCANStatus ReadBatch(TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count);
+		TPCANStatus FilterMessages(DWORD FromID, DWORD ToID, TPCANMode Mode);
+		DWORD GetMaxFilterRanges() const;
+		TPCANStatus WaitForMessages(DWORD Timeout);
+		void CancelWait();
+		const char* GetName() const;
+
+		// Gets the file descriptor of the socket, to be waited on
+		//
+		int GetDescriptor() const;
+
+		/// <summary>
+		/// Splits an ID range into the minimal list of SocketCAN id/mask filters
+		/// </summary>
+		/// <param name="FromID">"The lowest CAN ID of the range"</param>
+		/// <param name="ToID">"The highest CAN ID of the range"</param>
+		/// <param name="Extended">"True for 29-bit identifiers"</param>
+		/// <param name="Filters">"The filters are appended to this list"</param>
+		static void RangeToFilters(DWORD FromID, DWORD ToID, bool Extended, std::vector<struct can_filter> &Filters);
+
+		/// <summary>
+		/// Converts a received frame into a PCAN-Basic message. Remote
+		/// requests carry their length only, their data being zeroed
+		/// </summary>
+		/// <param name="Frame">"The frame read from the socket"</param>
+		/// <param name="IsFD">"True if the frame was read as a CAN FD one"</param>
+		/// <param name="Msg">"The message to fill"</param>
+		static void FrameToMessage(const struct canfd_frame &Frame, bool IsFD, TPCANMsgFD &Msg);
+};
+#endif
+#endif
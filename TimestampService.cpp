@@ -0,0 +1,160 @@
+﻿#include "TimestampService.h"
+
+#include <chrono>
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+// Reads the system wall clock
+//
+static INT64 ReadSystemClock()
+{
+	std::chrono::system_clock::duration utc = std::chrono::system_clock::now().time_since_epoch();
+
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(utc).count();
+}
+
+TimestampService::TimestampService(WallClockReader WallClock)
+	: m_Sequence(0)
+{
+	m_WallClock = (WallClock != NULL) ? WallClock : ReadSystemClock;
+
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+
+	QueryPerformanceFrequency(&frequency);
+	m_Frequency = (UINT64)frequency.QuadPart;
+#else
+	m_Frequency = NS_PER_SECOND;
+#endif
+
+	m_Session.Monotonic = Now();
+	m_Session.Utc = m_WallClock();
+	m_Session.Record = m_Session.Utc;
+	m_Session.Started = false;
+	PublishMapping();
+}
+
+UINT64 TimestampService::ReadCounter() const
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+
+	QueryPerformanceCounter(&counter);
+	return (UINT64)counter.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (UINT64)ts.tv_sec * NS_PER_SECOND + ts.tv_nsec;
+#endif
+}
+
+UINT64 TimestampService::Now() const
+{
+	UINT64 ticks = ReadCounter();
+
+	if (m_Frequency == NS_PER_SECOND)
+		return ticks;
+
+	// Whole seconds and remainder are scaled apart, so the
+	// multiplication cannot overflow
+	//
+	return (ticks / m_Frequency) * NS_PER_SECOND + (ticks % m_Frequency) * NS_PER_SECOND / m_Frequency;
+}
+
+void TimestampService::PublishMapping()
+{
+	UINT64 sequence = m_Sequence.load(std::memory_order_relaxed);
+
+	// Odd while the fields change, the fence keeping their stores after
+	// the one of the odd sequence
+	//
+	m_Sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_PublishedMonotonic.store(m_Session.Monotonic, std::memory_order_relaxed);
+	m_PublishedUtc.store(m_Session.Utc, std::memory_order_relaxed);
+	m_PublishedRecord.store(m_Session.Record, std::memory_order_relaxed);
+	m_PublishedStarted.store(m_Session.Started, std::memory_order_relaxed);
+	m_Sequence.store(sequence + 2, std::memory_order_release);
+}
+
+TimestampMapping TimestampService::GetMapping() const
+{
+	TimestampMapping session;
+	UINT64 before, after;
+
+	// A session being started while the fields are read leaves the
+	// sequence odd or changed, they are then read again
+	//
+	do
+	{
+		before = m_Sequence.load(std::memory_order_acquire);
+		session.Monotonic = m_PublishedMonotonic.load(std::memory_order_relaxed);
+		session.Utc = m_PublishedUtc.load(std::memory_order_relaxed);
+		session.Record = m_PublishedRecord.load(std::memory_order_relaxed);
+		session.Started = m_PublishedStarted.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after = m_Sequence.load(std::memory_order_relaxed);
+	} while ((before & 1) != 0 || before != after);
+
+	return session;
+}
+
+void TimestampService::StartSession(INT64 RecordNow)
+{
+	TimestampMapping session;
+	INT64 previous;
+
+	session.Utc = m_WallClock();
+
+	std::lock_guard<std::mutex> lock(m_SessionLock);
+
+	// The wall clock stepping back between two sessions would make the
+	// recorded times go back. The times of the previous session then go
+	// on, the constructor's being in another scale
+	//
+	session.Monotonic = Now();
+	session.Record = RecordNow;
+	session.Started = true;
+	if (m_Session.Started)
+	{
+		previous = m_Session.Record + (INT64)(session.Monotonic - m_Session.Monotonic);
+		if (session.Record < previous)
+			session.Record = previous;
+	}
+	m_Session = session;
+	PublishMapping();
+}
+
+INT64 TimestampService::ToUtc(UINT64 Monotonic) const
+{
+	TimestampMapping session = GetMapping();
+
+	return session.Utc + (INT64)(Monotonic - session.Monotonic);
+}
+
+INT64 TimestampService::ToRecordTime(UINT64 Monotonic) const
+{
+	TimestampMapping session = GetMapping();
+
+	return (session.Record + (INT64)(Monotonic - session.Monotonic)) / NS_PER_MS;
+}
+
+INT64 TimestampService::GetRecordTime() const
+{
+	return ToRecordTime(Now());
+}
+
+std::string TimestampService::GetSessionInfo() const
+{
+	TimestampMapping session = GetMapping();
+	char info[256];
+
+	snprintf(info, sizeof(info), "Monotonic\tUTC\tRecord\tFrequency\n%llu\t%lld\t%lld\t%llu\n",
+		(unsigned long long)session.Monotonic, (long long)session.Utc, (long long)(session.Record / NS_PER_MS), (unsigned long long)m_Frequency);
+
+	return info;
+}
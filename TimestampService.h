@@ -0,0 +1,127 @@
+//  TimestampService.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Central time source of the recorder. Samples are stamped from a
+//  calibrated monotonic counter in 64-bit nanoseconds; the wall clock is
+//  read only once per session to map those stamps onto UTC and onto the
+//  millisecond times written in the recordings. The mapping is replaced
+//  under a lock and published through a sequence counter, so the threads
+//  stamping samples read it without any lock and never see half of a
+//  session, and a new session never maps the current time before the
+//  previous one did: the recorded times stay monotonic when the wall
+//  clock steps
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __TIMESTAMPSERVICEH_
+#define __TIMESTAMPSERVICEH_
+
+#include "CANTypes.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#define NS_PER_MS			1000000LL
+#define NS_PER_SECOND		1000000000LL
+
+// Reader of the wall clock, in nanoseconds since the Unix epoch (UTC)
+//
+typedef INT64 (*WallClockReader)();
+
+// Mapping of a session from the monotonic time
+//
+typedef struct tagTimestampMapping
+{
+	UINT64 Monotonic;     // Monotonic time at the start of the session
+	INT64 Utc;            // UTC at that time, in nanoseconds
+	INT64 Record;         // Recording time at that time, in nanoseconds
+	bool Started;         // Set by StartSession, not by the constructor
+} TimestampMapping;
+
+// Monotonic nanosecond clock with a per-session wall-clock mapping
+//
+class TimestampService
+{
+	private:
+		// Counter frequency in ticks per second (1e9 when the
+		// counter already counts nanoseconds)
+		//
+		UINT64 m_Frequency;
+
+		WallClockReader m_WallClock;
+
+		// Mapping of the session, taken at StartSession, guarded by
+		// m_SessionLock which serializes the sessions
+		//
+		TimestampMapping m_Session;
+		std::mutex m_SessionLock;
+
+		// Copy of the mapping read by the threads stamping samples. The
+		// sequence is odd while a session replaces it, and a reader
+		// seeing it odd or changed reads again
+		//
+		std::atomic<UINT64> m_Sequence;
+		std::atomic<UINT64> m_PublishedMonotonic;
+		std::atomic<INT64> m_PublishedUtc;
+		std::atomic<INT64> m_PublishedRecord;
+		std::atomic<bool> m_PublishedStarted;
+
+		// Reads the raw counter
+		//
+		UINT64 ReadCounter() const;
+
+		// Publishes m_Session to the readers. Called under m_SessionLock
+		//
+		void PublishMapping();
+
+		// Gets a copy of the mapping, without locking
+		//
+		TimestampMapping GetMapping() const;
+
+	public:
+		// TimestampService constructor. Calibrates the counter and
+		// starts a session with the record epoch at the UTC epoch. The
+		// wall clock is the system one unless another reader is given
+		//
+		TimestampService(WallClockReader WallClock = NULL);
+
+		/// <summary>
+		/// Gets the current monotonic time in nanoseconds. The origin is
+		/// arbitrary but fixed for the life of the process
+		/// </summary>
+		UINT64 Now() const;
+
+		/// <summary>
+		/// Starts a recording session: pairs the current monotonic time with
+		/// the UTC wall clock and with the time scale of the recordings. A
+		/// recording time before the one of the previous session is not
+		/// taken, the previous scale going on
+		/// </summary>
+		/// <param name="RecordNow">"Current time in the scale used by the recordings,
+		/// in nanoseconds since their epoch"</param>
+		void StartSession(INT64 RecordNow);
+
+		/// <summary>
+		/// Converts a monotonic time into nanoseconds since the Unix epoch (UTC)
+		/// </summary>
+		INT64 ToUtc(UINT64 Monotonic) const;
+
+		/// <summary>
+		/// Converts a monotonic time into milliseconds of the recording time scale
+		/// </summary>
+		INT64 ToRecordTime(UINT64 Monotonic) const;
+
+		/// <summary>
+		/// Gets the current time in milliseconds of the recording time scale
+		/// </summary>
+		INT64 GetRecordTime() const;
+
+		/// <summary>
+		/// Gets the mapping of the current session as text, to be stored
+		/// next to the recordings
+		/// </summary>
+		std::string GetSessionInfo() const;
+};
+#endif
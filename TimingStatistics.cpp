@@ -0,0 +1,149 @@
+#include "TimingStatistics.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+TimingStatistics::TimingStatistics()
+	: m_Snapshot(std::make_shared<TimingSnapshot>())
+{
+	m_NextPublish = 0;
+}
+
+void TimingStatistics::Update(DWORD ID, TPCANMessageType MsgType, TPCANTimestampFD Timestamp)
+{
+	int index = m_Table.Find(ID, MsgType);
+	UINT64 period, deviation;
+	double delta;
+	int bucket;
+
+	if (index == MSG_TABLE_NONE)
+	{
+		PeriodStats stats;
+
+		memset(&stats, 0, sizeof(stats));
+		stats.ID = ID;
+		stats.MsgType = MsgType;
+		stats.Count = 1;
+		stats.FirstTime = Timestamp;
+		stats.LastTime = Timestamp;
+		m_Table.Add(ID, MsgType, stats);
+	}
+	else
+	{
+		PeriodStats &stats = m_Table[index];
+
+		// A timestamp going backwards (adapter reset) counts as no gap
+		//
+		period = (Timestamp > stats.LastTime) ? Timestamp - stats.LastTime : 0;
+		stats.LastTime = Timestamp;
+		stats.Count++;
+
+		// Welford's update of the mean and of the squared deviations,
+		// over the Count - 1 periods seen so far
+		//
+		delta = (double)period - stats.MeanPeriod;
+		if (stats.Count == 2)
+		{
+			stats.MinPeriod = period;
+			stats.MaxPeriod = period;
+			delta = 0;
+		}
+		else
+		{
+			if (period < stats.MinPeriod)
+				stats.MinPeriod = period;
+			if (period > stats.MaxPeriod)
+				stats.MaxPeriod = period;
+		}
+		stats.MeanPeriod += ((double)period - stats.MeanPeriod) / (double)(stats.Count - 1);
+		stats.M2 += delta * ((double)period - stats.MeanPeriod);
+
+		// Log2 bucket of the deviation from the mean before this period
+		//
+		deviation = (UINT64)fabs(delta);
+		for (bucket = 0; deviation > 0 && bucket < TIMING_JITTER_BUCKETS - 1; bucket++)
+			deviation >>= 1;
+		stats.Jitter[bucket]++;
+	}
+
+	if (Timestamp >= m_NextPublish)
+	{
+		Publish();
+		m_NextPublish = Timestamp + TIMING_PUBLISH_INTERVAL;
+	}
+}
+
+void TimingStatistics::Publish()
+{
+	std::shared_ptr<TimingSnapshot> snapshot = std::make_shared<TimingSnapshot>();
+
+	snapshot->reserve(m_Table.GetCount());
+	for (int i = 0; i < m_Table.GetCount(); i++)
+		snapshot->push_back(m_Table[i]);
+
+	std::atomic_store(&m_Snapshot, std::shared_ptr<const TimingSnapshot>(snapshot));
+}
+
+void TimingStatistics::Reset()
+{
+	m_Table.Clear();
+	m_NextPublish = 0;
+	std::atomic_store(&m_Snapshot, std::shared_ptr<const TimingSnapshot>(std::make_shared<TimingSnapshot>()));
+}
+
+std::shared_ptr<const TimingSnapshot> TimingStatistics::GetSnapshot() const
+{
+	return std::atomic_load(&m_Snapshot);
+}
+
+double TimingStatistics::GetRate(const PeriodStats &Stats)
+{
+	if (Stats.Count < 2 || Stats.LastTime <= Stats.FirstTime)
+		return 0;
+
+	return (double)(Stats.Count - 1) * 1000000.0 / (double)(Stats.LastTime - Stats.FirstTime);
+}
+
+double TimingStatistics::GetStdDeviation(const PeriodStats &Stats)
+{
+	if (Stats.Count < 3)
+		return 0;
+
+	return sqrt(Stats.M2 / (double)(Stats.Count - 2));
+}
+
+std::string TimingStatistics::GetReport() const
+{
+	std::shared_ptr<const TimingSnapshot> snapshot = GetSnapshot();
+	std::string report;
+	char line[128];
+
+	report = "ID\tType\tCount\tRate\tMinPeriod\tMeanPeriod\tMaxPeriod\tStdDev";
+	for (int i = 0; i < TIMING_JITTER_BUCKETS - 1; i++)
+	{
+		snprintf(line, sizeof(line), "\tJitter<%uus", 1u << i);
+		report += line;
+	}
+	snprintf(line, sizeof(line), "\tJitter>=%uus\n", 1u << (TIMING_JITTER_BUCKETS - 2));
+	report += line;
+
+	for (TimingSnapshot::const_iterator i = snapshot->begin(); i != snapshot->end(); ++i)
+	{
+		snprintf(line, sizeof(line), ((i->MsgType & PCAN_MESSAGE_EXTENDED) != 0) ? "%08Xh\t%02Xh" : "%03Xh\t%02Xh",
+			(unsigned)i->ID, (unsigned)i->MsgType);
+		report += line;
+		snprintf(line, sizeof(line), "\t%llu\t%.3f\t%llu\t%.1f\t%llu\t%.1f",
+			(unsigned long long)i->Count, GetRate(*i), (unsigned long long)i->MinPeriod, i->MeanPeriod,
+			(unsigned long long)i->MaxPeriod, GetStdDeviation(*i));
+		report += line;
+		for (int j = 0; j < TIMING_JITTER_BUCKETS; j++)
+		{
+			snprintf(line, sizeof(line), "\t%u", (unsigned)i->Jitter[j]);
+			report += line;
+		}
+		report += "\n";
+	}
+
+	return report;
+}
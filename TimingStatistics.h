@@ -0,0 +1,113 @@
+//  TimingStatistics.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Per-ID timing statistics of the received messages: count, rate,
+//  minimum, mean and maximum period, its variance and a histogram of the
+//  jitter. Each frame costs a table lookup and a few arithmetic
+//  operations. The statistics are published as immutable snapshots, so
+//  they can be read from any thread while frames keep coming
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __TIMINGSTATISTICSH_
+#define __TIMINGSTATISTICSH_
+
+#include "CANTypes.h"
+#include "MessageTable.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Number of buckets of the jitter histogram. Bucket 0 counts deviations
+// under 1 us, bucket k those in [2^(k-1), 2^k) us and the last one all
+// the larger ones
+//
+#define TIMING_JITTER_BUCKETS		16
+
+// Frame time between two automatic snapshots, in microseconds
+//
+#define TIMING_PUBLISH_INTERVAL		100000
+
+// Timing statistics of one message (ID and type). Periods are in
+// microseconds of adapter time
+//
+typedef struct tagPeriodStats
+{
+	DWORD ID;
+	TPCANMessageType MsgType;
+	UINT64 Count;                          // Frames received
+	TPCANTimestampFD FirstTime;            // Timestamp of the first one
+	TPCANTimestampFD LastTime;             // Timestamp of the last one
+	UINT64 MinPeriod;
+	UINT64 MaxPeriod;
+	double MeanPeriod;
+	double M2;                             // Sum of the squared deviations from the mean
+	DWORD Jitter[TIMING_JITTER_BUCKETS];   // Deviations of the periods from the running mean
+} PeriodStats;
+
+// Snapshot of the statistics of every message, in reception order
+//
+typedef std::vector<PeriodStats> TimingSnapshot;
+
+// Incremental per-ID timing statistics
+//
+class TimingStatistics
+{
+	private:
+		// Statistics being updated, only touched by the ingest thread
+		//
+		MessageTable<PeriodStats> m_Table;
+		TPCANTimestampFD m_NextPublish;
+
+		// Last published snapshot, swapped atomically
+		//
+		std::shared_ptr<const TimingSnapshot> m_Snapshot;
+
+		TimingStatistics(const TimingStatistics&);
+		TimingStatistics& operator=(const TimingStatistics&);
+
+	public:
+		// TimingStatistics constructor
+		//
+		TimingStatistics();
+
+		/// <summary>
+		/// Accounts a received frame. Publishes a snapshot every
+		/// TIMING_PUBLISH_INTERVAL of frame time. Not thread-safe: the
+		/// frames of a session must be given by one thread at a time
+		/// </summary>
+		/// <param name="ID">"CAN ID of the frame"</param>
+		/// <param name="MsgType">"Type of the frame"</param>
+		/// <param name="Timestamp">"Reception time, in microseconds"</param>
+		void Update(DWORD ID, TPCANMessageType MsgType, TPCANTimestampFD Timestamp);
+
+		/// <summary>
+		/// Publishes a snapshot of the current statistics. Same thread as Update
+		/// </summary>
+		void Publish();
+
+		/// <summary>
+		/// Removes every statistic and publishes an empty snapshot. Same
+		/// thread as Update
+		/// </summary>
+		void Reset();
+
+		/// <summary>
+		/// Gets the last published snapshot. Safe from any thread
+		/// </summary>
+		std::shared_ptr<const TimingSnapshot> GetSnapshot() const;
+
+		/// <summary>
+		/// Formats the last published snapshot as a tab separated table,
+		/// with a header line and one line per message
+		/// </summary>
+		std::string GetReport() const;
+
+		// Values derived from the statistics of a message
+		//
+		static double GetRate(const PeriodStats &Stats);
+		static double GetStdDeviation(const PeriodStats &Stats);
+};
+#endif
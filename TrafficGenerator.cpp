@@ -0,0 +1,341 @@
+#include "TrafficGenerator.h"
+
+#include <math.h>
+
+// Starting point of the run and physical constants
+//
+#define TRAFFIC_LATITUDE		-37.8136
+#define TRAFFIC_LONGITUDE		144.9631
+#define TRAFFIC_ALTITUDE		30.0
+#define METERS_PER_DEGREE		111320.0
+#define KNOTS_PER_MS			1.943844
+#define STANDARD_GRAVITY		9.80665
+#define TRAFFIC_PI				3.14159265358979323846
+
+// Time used for the schedules that are disabled
+//
+#define TRAFFIC_NEVER			1e300
+
+// Stores the Count low bytes of Value in big-endian order
+//
+static void PutBigEndian(BYTE *Data, INT64 Value, int Count)
+{
+	for (int i = Count - 1; i >= 0; i--)
+	{
+		Data[i] = (BYTE)(Value & 0xFF);
+		Value >>= 8;
+	}
+}
+
+// Rounds a value to a 16-bit signed field
+//
+static INT64 ToInt16(double Value)
+{
+	Value = floor(Value + 0.5);
+	if (Value > 32767)
+		return 32767;
+	if (Value < -32768)
+		return -32768;
+	return (INT64)Value;
+}
+
+TrafficGenerator::TrafficGenerator(const TrafficConfig &Config)
+	: m_Config(Config), m_Normal(0.0, 1.0), m_Uniform(0.0, 1.0)
+{
+	Reset();
+}
+
+TrafficConfig TrafficGenerator::GetDefaultConfig()
+{
+	TrafficConfig config;
+
+	config.GPSRate = 20;
+	config.XbowRate = 100;
+	config.BackgroundRate = 0;
+	config.BackgroundIDs = 0;
+	config.Noise = 0;
+	config.CorruptionRate = 0;
+	config.DropoutRate = 0;
+	config.DropoutLength = 1;
+	config.SlipRate = 0;
+	config.Speed = 20;
+	config.Radius = 100;
+	config.StartTime = 0;
+	config.Seed = 1;
+
+	return config;
+}
+
+void TrafficGenerator::Reset()
+{
+	m_Random.seed(m_Config.Seed);
+	m_Normal.reset();
+	m_Stats = TrafficStats();
+
+	m_NextGPS = (m_Config.GPSRate > 0) ? 0 : TRAFFIC_NEVER;
+	m_GPSFrame = 0;
+	m_GPSDropout = 0;
+	m_NextBackground = (m_Config.BackgroundRate > 0 && m_Config.BackgroundIDs > 0) ? 0 : TRAFFIC_NEVER;
+	m_NextXbow = (m_Config.XbowRate > 0) ? 0 : TRAFFIC_NEVER;
+	m_XbowDropout = 0;
+}
+
+double TrafficGenerator::Noise(double sigma)
+{
+	if (m_Config.Noise <= 0)
+		return 0;
+
+	return m_Normal(m_Random) * sigma * m_Config.Noise;
+}
+
+void TrafficGenerator::Corrupt(BYTE *Data, DWORD Length)
+{
+	if (Length == 0 || m_Config.CorruptionRate <= 0 || m_Uniform(m_Random) >= m_Config.CorruptionRate)
+		return;
+
+	Data[m_Random() % Length] ^= (BYTE)(1 + m_Random() % 255);
+	m_Stats.Corrupted++;
+}
+
+void TrafficGenerator::BuildGPSFrame(DWORD Index, double Time, TPCANMsgFD &Msg)
+{
+	double t = Time / 1e6;
+	double angle = m_Config.Speed * t / m_Config.Radius;
+	double north = m_Config.Radius * sin(angle) + Noise(0.02);
+	double east = m_Config.Radius * (1 - cos(angle)) + Noise(0.02);
+	double latitude = TRAFFIC_LATITUDE + north / METERS_PER_DEGREE;
+	double longitude = TRAFFIC_LONGITUDE + east / (METERS_PER_DEGREE * cos(TRAFFIC_LATITUDE * TRAFFIC_PI / 180));
+	double lateral = m_Config.Speed * m_Config.Speed / m_Config.Radius / STANDARD_GRAVITY;
+	INT64 centiseconds;
+
+	Msg = TPCANMsgFD();
+	Msg.ID = 0x301 + Index;
+	Msg.MSGTYPE = PCAN_MESSAGE_STANDARD;
+	Msg.DLC = 8;
+
+	switch (Index)
+	{
+		// Sats (1), UTC time of day in 10 ms (3), latitude in 1e-5 minutes (4)
+		//
+		case 0:
+			centiseconds = ((INT64)m_Config.StartTime * 100 + (INT64)(t * 100)) % 8640000;
+			PutBigEndian(&Msg.DATA[0], 10 + (INT64)floor(Noise(1) + 0.5), 1);
+			PutBigEndian(&Msg.DATA[1], centiseconds, 3);
+			PutBigEndian(&Msg.DATA[4], (INT64)floor(latitude * 60 * 100000 + 0.5), 4);
+			break;
+
+		// Longitude in 1e-5 minutes (4), speed in 0.01 knots (2), heading in 0.01 degrees (2)
+		//
+		case 1:
+			PutBigEndian(&Msg.DATA[0], (INT64)floor(longitude * 60 * 100000 + 0.5), 4);
+			PutBigEndian(&Msg.DATA[4], (INT64)floor((m_Config.Speed + Noise(0.05)) * KNOTS_PER_MS * 100 + 0.5), 2);
+			PutBigEndian(&Msg.DATA[6], ((INT64)floor((angle * 180 / TRAFFIC_PI + Noise(0.2)) * 100 + 0.5) % 36000 + 36000) % 36000, 2);
+			break;
+
+		// WGS84 altitude in cm (3, signed), vertical speed in cm/s (2, signed), unused (2), status (1)
+		//
+		case 2:
+			PutBigEndian(&Msg.DATA[0], (INT64)floor((TRAFFIC_ALTITUDE + Noise(0.1)) * 100 + 0.5), 3);
+			PutBigEndian(&Msg.DATA[3], ToInt16(Noise(0.02) * 100), 2);
+			Msg.DATA[7] = 0x03;
+			break;
+
+		// Trigger distance (4), longitudinal and lateral acceleration in 0.01 g (2 + 2, signed)
+		//
+		case 3:
+			PutBigEndian(&Msg.DATA[4], ToInt16(Noise(0.01) * 100), 2);
+			PutBigEndian(&Msg.DATA[6], ToInt16((lateral + Noise(0.01)) * 100), 2);
+			break;
+
+		// Distance in 1/12800 m (4), trigger time (2) and speed (2)
+		//
+		default:
+			PutBigEndian(&Msg.DATA[0], (INT64)(m_Config.Speed * t * 12800), 4);
+			break;
+	}
+}
+
+void TrafficGenerator::BuildBackgroundFrame(TPCANMsgFD &Msg)
+{
+	DWORD index = m_Random() % m_Config.BackgroundIDs;
+
+	// The IDs skip the ones of the VBOX and continue with
+	// extended IDs once the 11-bit range is exhausted
+	//
+	Msg = TPCANMsgFD();
+	Msg.ID = (index < 0x301) ? index : index + 5;
+	Msg.MSGTYPE = (Msg.ID > 0x7FF) ? PCAN_MESSAGE_EXTENDED : PCAN_MESSAGE_STANDARD;
+	Msg.DLC = 8;
+	for (int i = 0; i < 8; i++)
+		Msg.DATA[i] = (BYTE)m_Random();
+}
+
+void TrafficGenerator::BuildXbowPacket(double Time, BYTE *Packet)
+{
+	double t = Time / 1e6;
+	double lateral = m_Config.Speed * m_Config.Speed / m_Config.Radius / STANDARD_GRAVITY;
+	double yawRate = m_Config.Speed / m_Config.Radius * 180 / TRAFFIC_PI;
+
+	// Angles scaled by 180 / 2^15 degrees, rates by 300 / 2^15 degrees
+	// per second and accelerations by 6 / 2^15 g
+	//
+	Packet[0] = XBOW_HEADER;
+	PutBigEndian(&Packet[XBOW_ROLL_ANGLE], ToInt16((2 * lateral + Noise(0.1)) * 32768 / 180), 2);
+	PutBigEndian(&Packet[XBOW_PITCH_ANGLE], ToInt16(Noise(0.1) * 32768 / 180), 2);
+	PutBigEndian(&Packet[XBOW_ROLL_RATE], ToInt16(Noise(0.2) * 32768 / 300), 2);
+	PutBigEndian(&Packet[XBOW_PITCH_RATE], ToInt16(Noise(0.2) * 32768 / 300), 2);
+	PutBigEndian(&Packet[XBOW_YAW_RATE], ToInt16((yawRate + Noise(0.2)) * 32768 / 300), 2);
+	PutBigEndian(&Packet[XBOW_ACC_X], ToInt16(Noise(0.005) * 32768 / 6), 2);
+	PutBigEndian(&Packet[XBOW_ACC_Y], ToInt16((lateral + Noise(0.005)) * 32768 / 6), 2);
+	PutBigEndian(&Packet[XBOW_ACC_Z], ToInt16((1 + Noise(0.005)) * 32768 / 6), 2);
+
+	// 25 degrees C through the (V * 5 / 4096 - 1.375) * 44.44 sensor law,
+	// and a free running millisecond timer
+	//
+	PutBigEndian(&Packet[XBOW_TEMPERATURE], 1587, 2);
+	PutBigEndian(&Packet[XBOW_TIME], (INT64)(t * 1000) & 0xFFFF, 2);
+	Packet[XBOW_CHECKSUM] = GetXbowChecksum(Packet);
+}
+
+DWORD TrafficGenerator::GenerateCAN(UINT64 Until, TPCANMsgFDEntry *Entries, DWORD MaxCount)
+{
+	double period = (m_Config.GPSRate > 0) ? 1e6 / m_Config.GPSRate : 0;
+	double gap = (period / 5 < VBOX_FRAME_GAP) ? period / 5 : VBOX_FRAME_GAP;
+	double nextGPS, time;
+	DWORD dwCount = 0;
+
+	while (dwCount < MaxCount)
+	{
+		nextGPS = m_NextGPS + m_GPSFrame * gap;
+		time = (nextGPS <= m_NextBackground) ? nextGPS : m_NextBackground;
+		if (time >= (double)Until)
+			break;
+
+		if (nextGPS <= m_NextBackground)
+		{
+			// Dropouts swallow whole epochs
+			//
+			if (m_GPSFrame == 0)
+			{
+				if (m_GPSDropout == 0 && m_Config.DropoutRate > 0 && m_Uniform(m_Random) < m_Config.DropoutRate)
+					m_GPSDropout = m_Config.DropoutLength;
+				if (m_GPSDropout > 0)
+				{
+					m_GPSDropout--;
+					m_Stats.Dropped += 5;
+					m_NextGPS += period;
+					continue;
+				}
+			}
+
+			BuildGPSFrame(m_GPSFrame, m_NextGPS, Entries[dwCount].Msg);
+			m_Stats.GPSFrames++;
+			if (++m_GPSFrame == 5)
+			{
+				m_GPSFrame = 0;
+				m_NextGPS += period;
+			}
+		}
+		else
+		{
+			BuildBackgroundFrame(Entries[dwCount].Msg);
+			m_Stats.BackgroundFrames++;
+			m_NextBackground += 1e6 / m_Config.BackgroundRate;
+		}
+
+		Corrupt(Entries[dwCount].Msg.DATA, 8);
+		Entries[dwCount].Timestamp = (TPCANTimestampFD)time;
+		dwCount++;
+	}
+
+	return dwCount;
+}
+
+bool TrafficGenerator::NextXbowPacket(UINT64 Until, BYTE *Packet)
+{
+	double time;
+
+	while (m_NextXbow < (double)Until)
+	{
+		time = m_NextXbow;
+		m_NextXbow += 1e6 / m_Config.XbowRate;
+
+		if (m_XbowDropout == 0 && m_Config.DropoutRate > 0 && m_Uniform(m_Random) < m_Config.DropoutRate)
+			m_XbowDropout = m_Config.DropoutLength;
+		if (m_XbowDropout > 0)
+		{
+			m_XbowDropout--;
+			m_Stats.Dropped++;
+			continue;
+		}
+
+		BuildXbowPacket(time, Packet);
+		Corrupt(Packet, XBOW_PACKET_SIZE);
+		m_Stats.XbowPackets++;
+		return true;
+	}
+
+	return false;
+}
+
+DWORD TrafficGenerator::GenerateXbow(UINT64 Until, BYTE *Packets, DWORD MaxCount)
+{
+	DWORD dwCount = 0;
+
+	while (dwCount < MaxCount && NextXbowPacket(Until, &Packets[dwCount * XBOW_PACKET_SIZE]))
+		dwCount++;
+
+	return dwCount;
+}
+
+DWORD TrafficGenerator::GenerateXbowStream(UINT64 Until, BYTE *Buffer, DWORD Size)
+{
+	BYTE packet[XBOW_PACKET_SIZE];
+	DWORD written = 0, lost, first;
+
+	while (written + XBOW_PACKET_SIZE <= Size && NextXbowPacket(Until, packet))
+	{
+		// A serial overrun loses a run of bytes inside the packet
+		//
+		lost = 0;
+		first = XBOW_PACKET_SIZE;
+		if (m_Config.SlipRate > 0 && m_Uniform(m_Random) < m_Config.SlipRate)
+		{
+			lost = 1 + m_Random() % (XBOW_PACKET_SIZE - 1);
+			first = m_Random() % (XBOW_PACKET_SIZE - lost + 1);
+			m_Stats.SlippedBytes += lost;
+		}
+
+		memcpy(&Buffer[written], packet, first);
+		written += first;
+		if (first < XBOW_PACKET_SIZE)
+		{
+			memcpy(&Buffer[written], &packet[first + lost], XBOW_PACKET_SIZE - first - lost);
+			written += XBOW_PACKET_SIZE - first - lost;
+		}
+	}
+
+	return written;
+}
+
+UINT64 TrafficGenerator::GetNextCANTime() const
+{
+	double period = (m_Config.GPSRate > 0) ? 1e6 / m_Config.GPSRate : 0;
+	double gap = (period / 5 < VBOX_FRAME_GAP) ? period / 5 : VBOX_FRAME_GAP;
+	double next = m_NextGPS + m_GPSFrame * gap;
+
+	if (m_NextBackground < next)
+		next = m_NextBackground;
+
+	return (next >= TRAFFIC_NEVER) ? (UINT64)-1 : (UINT64)next;
+}
+
+UINT64 TrafficGenerator::GetNextXbowTime() const
+{
+	return (m_NextXbow >= TRAFFIC_NEVER) ? (UINT64)-1 : (UINT64)m_NextXbow;
+}
+
+TrafficStats TrafficGenerator::GetStatistics() const
+{
+	return m_Stats;
+}
@@ -0,0 +1,155 @@
+//  TrafficGenerator.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Synthetic VBOX and Crossbow traffic for load and soak tests. The
+//  vehicle drives a circle at constant speed, so every stream is a pure
+//  function of time and several generators built with the same
+//  configuration describe the same run. Noise, corruption, dropouts and
+//  unrelated bus traffic are drawn from a seeded random generator
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __TRAFFICGENERATORH_
+#define __TRAFFICGENERATORH_
+
+#include "CANTypes.h"
+#include "XbowTypes.h"
+
+#include <random>
+
+// Gap between the 5 frames of a VBOX epoch (about 1 frame time at 1 Mbit/s)
+//
+#define VBOX_FRAME_GAP			150
+
+// Configuration of the generated traffic
+//
+typedef struct tagTrafficConfig
+{
+	double GPSRate;          // VBOX epochs (0x301 to 0x305) per second, 0 for none
+	double XbowRate;         // Xbow packets per second, 0 for none
+	double BackgroundRate;   // Frames per second with IDs the collector does not decode
+	DWORD  BackgroundIDs;    // Number of distinct IDs of those frames
+	double Noise;            // Scale of the measurement noise, 1 for typical sensors
+	double CorruptionRate;   // Probability that a frame or a packet gets a random byte
+	double DropoutRate;      // Probability that a dropout starts at an epoch or a packet
+	DWORD  DropoutLength;    // Epochs or packets lost in a dropout
+	double SlipRate;         // Probability that bytes are lost before a packet of the Xbow stream
+	double Speed;            // Speed of the vehicle in m/s
+	double Radius;           // Radius of its circle in m
+	DWORD  StartTime;        // UTC time of day at the start, in seconds
+	DWORD  Seed;             // Seed of the random generator
+} TrafficConfig;
+
+// Counters of the generated traffic
+//
+typedef struct tagTrafficStats
+{
+	UINT64 GPSFrames;        // VBOX frames generated
+	UINT64 BackgroundFrames; // Unrelated frames generated
+	UINT64 XbowPackets;      // Xbow packets generated
+	UINT64 Corrupted;        // Frames and packets with a corrupted byte
+	UINT64 Dropped;          // VBOX frames and Xbow packets lost in dropouts
+	UINT64 SlippedBytes;     // Bytes lost from the Xbow stream
+} TrafficStats;
+
+// Synthetic traffic generator
+//
+class TrafficGenerator
+{
+	private:
+		TrafficConfig m_Config;
+		TrafficStats m_Stats;
+		std::mt19937 m_Random;
+		std::normal_distribution<double> m_Normal;
+		std::uniform_real_distribution<double> m_Uniform;
+
+		// Schedules, in microseconds since the start
+		//
+		double m_NextGPS;
+		DWORD m_GPSFrame;
+		DWORD m_GPSDropout;
+		double m_NextBackground;
+		double m_NextXbow;
+		DWORD m_XbowDropout;
+
+		// Draws the noise of a measurement
+		//
+		double Noise(double sigma);
+
+		// Builds the VBOX frame Index (0 for 0x301) of the epoch at Time
+		//
+		void BuildGPSFrame(DWORD Index, double Time, TPCANMsgFD &Msg);
+
+		// Builds an unrelated frame
+		//
+		void BuildBackgroundFrame(TPCANMsgFD &Msg);
+
+		// Builds the Xbow packet sampled at Time
+		//
+		void BuildXbowPacket(double Time, BYTE *Packet);
+
+		// Changes a random byte of a buffer, if chosen to
+		//
+		void Corrupt(BYTE *Data, DWORD Length);
+
+		// Gets the next Xbow packet due before Until. Returns false if none
+		//
+		bool NextXbowPacket(UINT64 Until, BYTE *Packet);
+
+	public:
+		// TrafficGenerator constructor
+		//
+		explicit TrafficGenerator(const TrafficConfig &Config);
+
+		/// <summary>
+		/// Gets a configuration with a clean 20 Hz VBOX and 100 Hz Xbow
+		/// </summary>
+		static TrafficConfig GetDefaultConfig();
+
+		/// <summary>
+		/// Restarts the traffic from time 0
+		/// </summary>
+		void Reset();
+
+		/// <summary>
+		/// Generates the CAN frames due before a time, in time order
+		/// </summary>
+		/// <param name="Until">"Time in microseconds since the start"</param>
+		/// <param name="Entries">"Buffer for the frames, stamped in microseconds since the start"</param>
+		/// <param name="MaxCount">"Capacity of Entries"</param>
+		/// <returns>"The number of frames stored in Entries"</returns>
+		DWORD GenerateCAN(UINT64 Until, TPCANMsgFDEntry *Entries, DWORD MaxCount);
+
+		/// <summary>
+		/// Generates the Xbow packets due before a time
+		/// </summary>
+		/// <param name="Until">"Time in microseconds since the start"</param>
+		/// <param name="Packets">"Buffer for MaxCount packets of XBOW_PACKET_SIZE bytes"</param>
+		/// <param name="MaxCount">"Capacity of Packets"</param>
+		/// <returns>"The number of packets stored"</returns>
+		DWORD GenerateXbow(UINT64 Until, BYTE *Packets, DWORD MaxCount);
+
+		/// <summary>
+		/// Generates the Xbow traffic due before a time as the byte stream
+		/// of the serial port, where slips make packets lose bytes
+		/// </summary>
+		/// <param name="Until">"Time in microseconds since the start"</param>
+		/// <param name="Buffer">"Buffer for the bytes"</param>
+		/// <param name="Size">"Capacity of Buffer, at least XBOW_PACKET_SIZE"</param>
+		/// <returns>"The number of bytes stored"</returns>
+		DWORD GenerateXbowStream(UINT64 Until, BYTE *Buffer, DWORD Size);
+
+		/// <summary>
+		/// Gets the time of the next CAN frame, in microseconds since the start
+		/// </summary>
+		UINT64 GetNextCANTime() const;
+
+		/// <summary>
+		/// Gets the time of the next Xbow packet, in microseconds since the start
+		/// </summary>
+		UINT64 GetNextXbowTime() const;
+
+		TrafficStats GetStatistics() const;
+};
+#endif
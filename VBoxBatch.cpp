@@ -0,0 +1,238 @@
+﻿#include "VBoxBatch.h"
+
+#include <string.h>
+
+#ifdef CPU_X86
+#include <immintrin.h>
+#endif
+
+// A field is moved to the top bytes of a 32-bit lane, most significant
+// byte first, then shifted down: arithmetically if signed, which extends
+// its sign
+//
+typedef struct tagVBoxField
+{
+	int FirstByte;
+	int Bytes;
+	int Shift;
+	bool Signed;
+	bool Unsigned32;      // Unsigned on 32 bits, above the range of INT32
+	double Scale;
+	double Offset;
+	BYTE Low[16];         // Two frames to the lanes 0 and 1
+	BYTE High[16];        // Two frames to the lanes 2 and 3
+} VBoxField;
+
+static void PrepareField(const SignalDescriptor &Signal, VBoxField *Field)
+{
+	Field->FirstByte = Signal.FirstByte;
+	Field->Bytes = Signal.Bytes;
+	Field->Shift = 8 * (4 - Signal.Bytes);
+	Field->Signed = Signal.Signed;
+	Field->Unsigned32 = !Signal.Signed && Signal.Bytes == 4;
+	Field->Scale = Signal.Scale;
+	Field->Offset = Signal.Offset;
+
+	// The VBOX fields are whole bytes, 4 at most, one 32-bit lane
+	//
+	memset(Field->Low, 0x80, sizeof(Field->Low));
+	memset(Field->High, 0x80, sizeof(Field->High));
+	for (int frame = 0; frame < 2; frame++)
+	{
+		for (int j = 0; j < Signal.Bytes && j < 4; j++)
+		{
+			Field->Low[4 * frame + 3 - j] = (BYTE)(8 * frame + Signal.FirstByte + j);
+			Field->High[4 * (frame + 2) + 3 - j] = (BYTE)(8 * frame + Signal.FirstByte + j);
+		}
+	}
+}
+
+static void ExtractScalar(const VBoxField &Field, const UINT64 *Payload, size_t First, size_t Count, INT32 *Raw)
+{
+	const BYTE *data;
+	DWORD value;
+
+	for (size_t i = First; i < Count; i++)
+	{
+		data = (const BYTE*)&Payload[i] + Field.FirstByte;
+		value = 0;
+		for (int j = 0; j < Field.Bytes; j++)
+			value = (value << 8) | data[j];
+		value <<= Field.Shift;
+		Raw[i] = Field.Signed ? ((INT32)value >> Field.Shift) : (INT32)(value >> Field.Shift);
+	}
+}
+
+static void ScaleScalar(const VBoxField &Field, const INT32 *Raw, size_t First, size_t Count, double *Value)
+{
+	for (size_t i = First; i < Count; i++)
+	{
+		if (Field.Unsigned32)
+			Value[i] = (double)(DWORD)Raw[i] * Field.Scale + Field.Offset;
+		else
+			Value[i] = (double)Raw[i] * Field.Scale + Field.Offset;
+	}
+}
+
+#ifdef CPU_X86
+CPU_TARGET_SSSE3
+static void ExtractSSSE3(const VBoxField &Field, const UINT64 *Payload, size_t Count, INT32 *Raw)
+{
+	__m128i low = _mm_loadu_si128((const __m128i*)Field.Low);
+	__m128i high = _mm_loadu_si128((const __m128i*)Field.High);
+	__m128i shift = _mm_cvtsi32_si128(Field.Shift);
+	__m128i value;
+	size_t i;
+
+	// 4 frames at a time
+	//
+	for (i = 0; i + 4 <= Count; i += 4)
+	{
+		value = _mm_or_si128(
+			_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&Payload[i]), low),
+			_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&Payload[i + 2]), high));
+		value = Field.Signed ? _mm_sra_epi32(value, shift) : _mm_srl_epi32(value, shift);
+		_mm_storeu_si128((__m128i*)&Raw[i], value);
+	}
+	ExtractScalar(Field, Payload, i, Count, Raw);
+}
+
+CPU_TARGET_SSSE3
+static void ScaleSSE2(const VBoxField &Field, const INT32 *Raw, size_t Count, double *Value)
+{
+	__m128d scale = _mm_set1_pd(Field.Scale);
+	__m128d offset = _mm_set1_pd(Field.Offset);
+	__m128d wrap = _mm_set1_pd(Field.Unsigned32 ? 4294967296.0 : 0.0);
+	__m128d value;
+	size_t i;
+
+	// 2 values at a time. An unsigned 32-bit field read as negative gets
+	// 2^32 back
+	//
+	for (i = 0; i + 2 <= Count; i += 2)
+	{
+		value = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i*)&Raw[i]));
+		value = _mm_add_pd(value, _mm_and_pd(_mm_cmplt_pd(value, _mm_setzero_pd()), wrap));
+		_mm_storeu_pd(&Value[i], _mm_add_pd(_mm_mul_pd(value, scale), offset));
+	}
+	ScaleScalar(Field, Raw, i, Count, Value);
+}
+
+CPU_TARGET_AVX2
+static void ExtractAVX2(const VBoxField &Field, const UINT64 *Payload, size_t Count, INT32 *Raw)
+{
+	__m128i low128 = _mm_loadu_si128((const __m128i*)Field.Low);
+	__m128i high128 = _mm_loadu_si128((const __m128i*)Field.High);
+	__m256i low = _mm256_inserti128_si256(_mm256_castsi128_si256(low128), low128, 1);
+	__m256i high = _mm256_inserti128_si256(_mm256_castsi128_si256(high128), high128, 1);
+	__m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+	__m128i shift = _mm_cvtsi32_si128(Field.Shift);
+	__m256i value;
+	size_t i;
+
+	// 8 frames at a time. The shuffles stay within the 128-bit halves,
+	// so the lanes come as frames 0 1 4 5 2 3 6 7 and are put back in order
+	//
+	for (i = 0; i + 8 <= Count; i += 8)
+	{
+		value = _mm256_or_si256(
+			_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)&Payload[i]), low),
+			_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)&Payload[i + 4]), high));
+		value = _mm256_permutevar8x32_epi32(value, order);
+		value = Field.Signed ? _mm256_sra_epi32(value, shift) : _mm256_srl_epi32(value, shift);
+		_mm256_storeu_si256((__m256i*)&Raw[i], value);
+	}
+	ExtractScalar(Field, Payload, i, Count, Raw);
+}
+
+CPU_TARGET_AVX2
+static void ScaleAVX(const VBoxField &Field, const INT32 *Raw, size_t Count, double *Value)
+{
+	__m256d scale = _mm256_set1_pd(Field.Scale);
+	__m256d offset = _mm256_set1_pd(Field.Offset);
+	__m256d wrap = _mm256_set1_pd(Field.Unsigned32 ? 4294967296.0 : 0.0);
+	__m256d value;
+	size_t i;
+
+	for (i = 0; i + 4 <= Count; i += 4)
+	{
+		value = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)&Raw[i]));
+		value = _mm256_add_pd(value, _mm256_and_pd(_mm256_cmp_pd(value, _mm256_setzero_pd(), _CMP_LT_OQ), wrap));
+		_mm256_storeu_pd(&Value[i], _mm256_add_pd(_mm256_mul_pd(value, scale), offset));
+	}
+	ScaleScalar(Field, Raw, i, Count, Value);
+}
+#endif
+
+VBoxBatch::VBoxBatch()
+{
+	m_Path = GetSupportedPath();
+}
+
+int VBoxBatch::GetSupportedPath()
+{
+	return GetCPUVectorPath();
+}
+
+void VBoxBatch::SetPath(int Path)
+{
+	m_Path = (Path < GetSupportedPath()) ? Path : GetSupportedPath();
+	if (m_Path < VBOX_BATCH_SCALAR)
+		m_Path = VBOX_BATCH_SCALAR;
+}
+
+void VBoxBatch::Clear()
+{
+	for (int i = 0; i < VBOX_FRAME_COUNT; i++)
+	{
+		m_Blocks[i].Payload.clear();
+		m_Blocks[i].Index.clear();
+		for (int j = 0; j < VBOX_BLOCK_FIELDS; j++)
+		{
+			m_Blocks[i].Raw[j].clear();
+			m_Blocks[i].Value[j].clear();
+		}
+	}
+}
+
+void VBoxBatch::Decode()
+{
+	const std::vector<SignalDescriptor> &signals = GetVBoxSignals();
+	VBoxField field;
+	size_t count;
+
+	// The signals come 3 per frame, in the order of the IDs
+	//
+	for (int i = 0; i < VBOX_FRAME_COUNT; i++)
+	{
+		VBoxBlock &block = m_Blocks[i];
+
+		count = block.Payload.size();
+		for (int j = 0; j < VBOX_BLOCK_FIELDS; j++)
+		{
+			block.Raw[j].resize(count);
+			block.Value[j].resize(count);
+			if (count == 0)
+				continue;
+
+			PrepareField(signals[i * VBOX_BLOCK_FIELDS + j], &field);
+			switch (m_Path)
+			{
+#ifdef CPU_X86
+			case VBOX_BATCH_AVX2:
+				ExtractAVX2(field, &block.Payload[0], count, &block.Raw[j][0]);
+				ScaleAVX(field, &block.Raw[j][0], count, &block.Value[j][0]);
+				break;
+			case VBOX_BATCH_SSSE3:
+				ExtractSSSE3(field, &block.Payload[0], count, &block.Raw[j][0]);
+				ScaleSSE2(field, &block.Raw[j][0], count, &block.Value[j][0]);
+				break;
+#endif
+			default:
+				ExtractScalar(field, &block.Payload[0], 0, count, &block.Raw[j][0]);
+				ScaleScalar(field, &block.Raw[j][0], 0, count, &block.Value[j][0]);
+				break;
+			}
+		}
+	}
+}
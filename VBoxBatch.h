@@ -0,0 +1,102 @@
+//  VBoxBatch.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Batch decoder of recorded VBOX frames. The frames are collected per ID
+//  into blocks of 8-byte payloads, then the three fields of each ID are
+//  extracted for the whole block into columns (structure of arrays): raw
+//  integers in the units sent, and the values scaled as the VBox* signals.
+//  The extraction uses SSSE3 or AVX2 byte shuffles when the processor has
+//  them, chosen at run time, and a scalar path otherwise
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __VBOXBATCHH_
+#define __VBOXBATCHH_
+
+#include "VBoxDecoder.h"
+#include "CPUFeatures.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+// Extraction paths
+//
+#define VBOX_BATCH_SCALAR		CPU_VECTOR_SCALAR
+#define VBOX_BATCH_SSSE3		CPU_VECTOR_SSSE3
+#define VBOX_BATCH_AVX2			CPU_VECTOR_AVX2
+
+// Fields carried by each VBOX frame
+//
+#define VBOX_BLOCK_FIELDS		3
+
+// Frames of one VBOX ID, in the order they were added
+//
+typedef struct tagVBoxBlock
+{
+	std::vector<UINT64> Payload;                  // Data bytes, as received
+	std::vector<size_t> Index;                    // Position given to Add
+	std::vector<INT32> Raw[VBOX_BLOCK_FIELDS];    // Fields in the units sent
+	std::vector<double> Value[VBOX_BLOCK_FIELDS]; // Fields scaled
+} VBoxBlock;
+
+// Batch decoder
+//
+class VBoxBatch
+{
+	private:
+		VBoxBlock m_Blocks[VBOX_FRAME_COUNT];
+		int m_Path;
+
+	public:
+		// The fastest path supported is used by default
+		//
+		VBoxBatch();
+
+		/// <summary>
+		/// Gets the fastest extraction path of the processor
+		/// </summary>
+		static int GetSupportedPath();
+
+		/// <summary>
+		/// Chooses the extraction path, limited to the supported one
+		/// </summary>
+		void SetPath(int Path);
+		int GetPath() const { return m_Path; }
+
+		/// <summary>
+		/// Removes every frame, keeping the memory
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Adds a frame to the block of its ID
+		/// </summary>
+		/// <param name="ID">"ID of the frame"</param>
+		/// <param name="Data">"Data bytes of the frame"</param>
+		/// <param name="Length">"Number of data bytes"</param>
+		/// <param name="Index">"Position of the frame, kept with it"</param>
+		/// <returns>"false if the frame is not a complete VBOX frame"</returns>
+		bool Add(DWORD ID, const BYTE *Data, int Length, size_t Index)
+		{
+			UINT64 payload;
+
+			if (!IsVBoxID(ID) || Length < VBOX_FRAME_LENGTH)
+				return false;
+
+			VBoxBlock &block = m_Blocks[ID - VBOX_ID_FIRST];
+			memcpy(&payload, Data, sizeof(payload));
+			block.Payload.push_back(payload);
+			block.Index.push_back(Index);
+			return true;
+		}
+
+		/// <summary>
+		/// Extracts the fields of every frame added
+		/// </summary>
+		void Decode();
+
+		const VBoxBlock& GetBlock(DWORD ID) const { return m_Blocks[ID - VBOX_ID_FIRST]; }
+};
+#endif
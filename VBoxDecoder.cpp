@@ -0,0 +1,73 @@
+#include "VBoxDecoder.h"
+
+bool DecodeVBoxFrame(DWORD ID, const BYTE *Data, int Length, VBoxData *Result)
+{
+	if (!IsVBoxID(ID) || Length < VBOX_FRAME_LENGTH)
+		return false;
+
+	switch (ID)
+	{
+	case 0x301:
+		Result->Sats = (BYTE)VBoxSats::Extract(Data);
+		Result->Time = (DWORD)VBoxTime::Extract(Data);
+		Result->Latitude = (INT32)VBoxLatitude::Extract(Data);
+		break;
+	case 0x302:
+		Result->Longitude = (INT32)VBoxLongitude::Extract(Data);
+		Result->Speed = (WORD)VBoxSpeed::Extract(Data);
+		Result->Heading = (WORD)VBoxHeading::Extract(Data);
+		break;
+	case 0x303:
+		// Bytes 5 and 6 are not used
+		//
+		Result->Altitude = (INT32)VBoxAltitude::Extract(Data);
+		Result->VerticalSpeed = (INT16)VBoxVerticalSpeed::Extract(Data);
+		Result->Status = (BYTE)VBoxStatus::Extract(Data);
+		break;
+	case 0x304:
+		Result->TrigDistance = (DWORD)VBoxTrigDistance::Extract(Data);
+		Result->LongAcc = (INT16)VBoxLongAcc::Extract(Data);
+		Result->LatAcc = (INT16)VBoxLatAcc::Extract(Data);
+		break;
+	case 0x305:
+		Result->Distance = (DWORD)VBoxDistance::Extract(Data);
+		Result->TrigTime = (WORD)VBoxTrigTime::Extract(Data);
+		Result->TrigSpeed = (WORD)VBoxTrigSpeed::Extract(Data);
+		break;
+	}
+	Result->Received |= 1 << (ID - VBOX_ID_FIRST);
+
+	return true;
+}
+
+// Builds the description of the VBOX signals
+//
+static std::vector<SignalDescriptor> DescribeVBoxSignals()
+{
+	std::vector<SignalDescriptor> signals;
+
+	signals.push_back(VBoxSats::Describe("Sats", ""));
+	signals.push_back(VBoxTime::Describe("Time", "s"));
+	signals.push_back(VBoxLatitude::Describe("Latitude", "min"));
+	signals.push_back(VBoxLongitude::Describe("Longitude", "min"));
+	signals.push_back(VBoxSpeed::Describe("Speed", "knots"));
+	signals.push_back(VBoxHeading::Describe("Heading", "deg"));
+	signals.push_back(VBoxAltitude::Describe("Altitude", "m"));
+	signals.push_back(VBoxVerticalSpeed::Describe("VerticalSpeed", "m/s"));
+	signals.push_back(VBoxStatus::Describe("Status", ""));
+	signals.push_back(VBoxTrigDistance::Describe("TrigDistance", "m"));
+	signals.push_back(VBoxLongAcc::Describe("LongAcc", "g"));
+	signals.push_back(VBoxLatAcc::Describe("LatAcc", "g"));
+	signals.push_back(VBoxDistance::Describe("Distance", "m"));
+	signals.push_back(VBoxTrigTime::Describe("TrigTime", "s"));
+	signals.push_back(VBoxTrigSpeed::Describe("TrigSpeed", "knots"));
+
+	return signals;
+}
+
+const std::vector<SignalDescriptor>& GetVBoxSignals()
+{
+	static const std::vector<SignalDescriptor> signals = DescribeVBoxSignals();
+
+	return signals;
+}
@@ -0,0 +1,118 @@
+//  VBoxDecoder.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Decoder of the GPS frames sent by the VBOX on the CAN bus (IDs 0x301
+//  to 0x305). The big-endian fields are read straight from the data
+//  bytes into integers, in the units of the VBOX, without going through
+//  a text representation. Each field is described as a signal
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __VBOXDECODERH_
+#define __VBOXDECODERH_
+
+#include "CANTypes.h"
+#include "SignalDecoder.h"
+
+#include <vector>
+
+// IDs of the VBOX frames
+//
+#define VBOX_ID_FIRST			0x301
+#define VBOX_ID_LAST			0x305
+#define VBOX_FRAME_COUNT		(VBOX_ID_LAST - VBOX_ID_FIRST + 1)
+
+// Data bytes of a VBOX frame
+//
+#define VBOX_FRAME_LENGTH		8
+
+// Scale of the distances, in meters per unit
+//
+#define VBOX_DISTANCE_UNIT		0.000078125f
+
+// Signals of the VBOX frames, big-endian, scaled to the units given
+// by GetVBoxSignals
+//
+typedef Signal<0x301,  7,  8, SIGNAL_BIG_ENDIAN, false>              VBoxSats;
+typedef Signal<0x301, 15, 24, SIGNAL_BIG_ENDIAN, false, 1, 100>      VBoxTime;
+typedef Signal<0x301, 39, 32, SIGNAL_BIG_ENDIAN, true,  1, 100000>   VBoxLatitude;
+typedef Signal<0x302,  7, 32, SIGNAL_BIG_ENDIAN, true,  1, 100000>   VBoxLongitude;
+typedef Signal<0x302, 39, 16, SIGNAL_BIG_ENDIAN, false, 1, 100>      VBoxSpeed;
+typedef Signal<0x302, 55, 16, SIGNAL_BIG_ENDIAN, false, 1, 100>      VBoxHeading;
+typedef Signal<0x303,  7, 24, SIGNAL_BIG_ENDIAN, true,  1, 100>      VBoxAltitude;
+typedef Signal<0x303, 31, 16, SIGNAL_BIG_ENDIAN, true,  1, 100>      VBoxVerticalSpeed;
+typedef Signal<0x303, 63,  8, SIGNAL_BIG_ENDIAN, false>              VBoxStatus;
+typedef Signal<0x304,  7, 32, SIGNAL_BIG_ENDIAN, false, 1, 12800>    VBoxTrigDistance;
+typedef Signal<0x304, 39, 16, SIGNAL_BIG_ENDIAN, true,  1, 100>      VBoxLongAcc;
+typedef Signal<0x304, 55, 16, SIGNAL_BIG_ENDIAN, true,  1, 100>      VBoxLatAcc;
+typedef Signal<0x305,  7, 32, SIGNAL_BIG_ENDIAN, false, 1, 12800>    VBoxDistance;
+typedef Signal<0x305, 39, 16, SIGNAL_BIG_ENDIAN, false, 1, 100>      VBoxTrigTime;
+typedef Signal<0x305, 55, 16, SIGNAL_BIG_ENDIAN, false, 1, 100>      VBoxTrigSpeed;
+
+// Fields of the VBOX frames, in the units sent
+//
+typedef struct tagVBoxData
+{
+	// 0x301
+	BYTE   Sats;              // Satellites in use
+	DWORD  Time;              // UTC time of day, in 1/100 s (24 bits)
+	INT32  Latitude;          // In 1/100000 minutes, positive north
+
+	// 0x302
+	INT32  Longitude;         // In 1/100000 minutes, positive west
+	WORD   Speed;             // In 1/100 knots
+	WORD   Heading;           // In 1/100 degrees
+
+	// 0x303
+	INT32  Altitude;          // WGS84 altitude in 1/100 m (24 bits, signed)
+	INT16  VerticalSpeed;     // In 1/100 m/s
+	BYTE   Status;            // DGPS and fix status bits
+
+	// 0x304
+	DWORD  TrigDistance;      // Distance since the trigger, in VBOX_DISTANCE_UNIT
+	INT16  LongAcc;           // Longitudinal acceleration, in 1/100 g
+	INT16  LatAcc;            // Lateral acceleration, in 1/100 g
+
+	// 0x305
+	DWORD  Distance;          // Distance travelled, in VBOX_DISTANCE_UNIT
+	WORD   TrigTime;          // Time of the trigger, in 1/100 s
+	WORD   TrigSpeed;         // Speed at the trigger, in 1/100 knots
+
+	DWORD  Received;          // Frames decoded, bit (ID - VBOX_ID_FIRST)
+} VBoxData;
+
+/// <summary>
+/// Tells if an ID is the one of a VBOX frame
+/// </summary>
+inline bool IsVBoxID(DWORD ID)
+{
+	return ID >= VBOX_ID_FIRST && ID <= VBOX_ID_LAST;
+}
+
+/// <summary>
+/// Decodes a VBOX frame into the fields it carries, the others being
+/// left unchanged
+/// </summary>
+/// <param name="ID">"ID of the frame"</param>
+/// <param name="Data">"Data bytes of the frame"</param>
+/// <param name="Length">"Number of data bytes"</param>
+/// <param name="Result">"Fields to update"</param>
+/// <returns>"false if the frame is not a complete VBOX frame"</returns>
+bool DecodeVBoxFrame(DWORD ID, const BYTE *Data, int Length, VBoxData *Result);
+
+/// <summary>
+/// Gets the speed sent over the network, in 1/100 knots: the Speed field
+/// of the 0x302 frame (bytes 4-5), the one displayed
+/// </summary>
+inline WORD GetVBoxNetworkSpeed(const VBoxData &Data)
+{
+	return Data.Speed;
+}
+
+/// <summary>
+/// Gives the run-time description of the VBOX signals, the same as the
+/// VBox* signal types
+/// </summary>
+const std::vector<SignalDescriptor>& GetVBoxSignals();
+#endif
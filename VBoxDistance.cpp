@@ -0,0 +1,51 @@
+#include "VBoxDistance.h"
+
+#include <stdio.h>
+#include <string.h>
+
+VBoxDistanceAccumulator::VBoxDistanceAccumulator(DWORD MaxStep)
+{
+	memset(&m_State, 0, sizeof(m_State));
+	m_State.MaxStep = MaxStep;
+}
+
+void VBoxDistanceAccumulator::Reset()
+{
+	DWORD maxStep = m_State.MaxStep;
+
+	memset(&m_State, 0, sizeof(m_State));
+	m_State.MaxStep = maxStep;
+}
+
+#define VBOX_DISTANCE_STATE_NAMES	"Counts\tReadings\tWraps\tResets\tLast\tMaxStep\n"
+
+std::string FormatVBoxDistanceState(const VBoxDistanceState &State)
+{
+	char text[256];
+
+	snprintf(text, sizeof(text), VBOX_DISTANCE_STATE_NAMES "%llu\t%llu\t%llu\t%llu\t%lu\t%lu\n",
+		(unsigned long long)State.Counts, (unsigned long long)State.Readings, (unsigned long long)State.Wraps,
+		(unsigned long long)State.Resets, (unsigned long)State.Last, (unsigned long)State.MaxStep);
+
+	return text;
+}
+
+bool ParseVBoxDistanceState(const char *Text, VBoxDistanceState *State)
+{
+	unsigned long long counts, readings, wraps, resets;
+	unsigned long last, maxStep;
+	size_t names = strlen(VBOX_DISTANCE_STATE_NAMES);
+
+	if (strncmp(Text, VBOX_DISTANCE_STATE_NAMES, names) != 0)
+		return false;
+	if (sscanf(Text + names, "%llu\t%llu\t%llu\t%llu\t%lu\t%lu", &counts, &readings, &wraps, &resets, &last, &maxStep) != 6)
+		return false;
+
+	State->Counts = counts;
+	State->Readings = readings;
+	State->Wraps = wraps;
+	State->Resets = resets;
+	State->Last = (DWORD)last;
+	State->MaxStep = (DWORD)maxStep;
+	return true;
+}
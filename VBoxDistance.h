@@ -0,0 +1,125 @@
+//  VBoxDistance.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Accumulator of the distance sent by the VBOX in its 0x305 frame. The
+//  32-bit counter, in VBOX_DISTANCE_UNIT, wraps after about 335 km and
+//  goes back to zero when the VBOX is reset. Both are told apart from the
+//  step between two readings and the distance of the trial is kept in
+//  64-bit counts, so it stays exact however long the trial. The state is
+//  a plain structure, which can be stored and given back to resume a
+//  session
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __VBOXDISTANCEH_
+#define __VBOXDISTANCEH_
+
+#include "CANTypes.h"
+
+#include <string>
+
+// Counts of the distance counter per meter (VBOX_DISTANCE_UNIT)
+//
+#define VBOX_DISTANCE_COUNTS_PER_METER	12800
+
+// Longest step forward of the counter between two readings, in counts
+// (10 km). A counter going back is taken as wrapped if it went forward
+// by less than that through the wrap, and as reset otherwise
+//
+#define VBOX_DISTANCE_MAX_STEP			(10000 * VBOX_DISTANCE_COUNTS_PER_METER)
+
+// State of an accumulator. It only holds integers and can be copied as
+// bytes
+//
+typedef struct tagVBoxDistanceState
+{
+	UINT64 Counts;        // Distance of the trial, in VBOX_DISTANCE_UNIT
+	UINT64 Readings;      // Counters given, 0 before the first one
+	UINT64 Wraps;         // Times the counter wrapped
+	UINT64 Resets;        // Times the counter was reset
+	DWORD Last;           // Last counter given
+	DWORD MaxStep;        // Longest step taken as a move forward
+} VBoxDistanceState;
+
+// Distance accumulator. The trial starts at the first counter given
+//
+class VBoxDistanceAccumulator
+{
+	private:
+		VBoxDistanceState m_State;
+
+	public:
+		VBoxDistanceAccumulator(DWORD MaxStep = VBOX_DISTANCE_MAX_STEP);
+
+		/// <summary>
+		/// Starts a new trial, keeping the longest step
+		/// </summary>
+		void Reset();
+
+		/// <summary>
+		/// Accounts a reading of the counter
+		/// </summary>
+		/// <param name="Counter">"Distance of the 0x305 frame, in VBOX_DISTANCE_UNIT"</param>
+		void Update(DWORD Counter)
+		{
+			DWORD step = Counter - m_State.Last;
+
+			// The unsigned difference goes over a wrap. Going back by more
+			// than a plausible step forward is a reset, the counter
+			// starting again from zero
+			//
+			if (m_State.Readings != 0)
+			{
+				if (Counter >= m_State.Last)
+					m_State.Counts += step;
+				else if (step <= m_State.MaxStep)
+				{
+					m_State.Counts += step;
+					m_State.Wraps++;
+				}
+				else
+				{
+					m_State.Counts += Counter;
+					m_State.Resets++;
+				}
+			}
+			m_State.Last = Counter;
+			m_State.Readings++;
+		}
+
+		/// <summary>
+		/// Gets the distance of the trial, in VBOX_DISTANCE_UNIT
+		/// </summary>
+		UINT64 GetCounts() const { return m_State.Counts; }
+
+		/// <summary>
+		/// Gets the distance of the trial in meters, exact up to 2^53 counts
+		/// </summary>
+		double GetMeters() const { return (double)m_State.Counts / VBOX_DISTANCE_COUNTS_PER_METER; }
+
+		/// <summary>
+		/// Gets the state, to resume the trial later
+		/// </summary>
+		const VBoxDistanceState& GetState() const { return m_State; }
+
+		/// <summary>
+		/// Resumes a trial from a state got before
+		/// </summary>
+		void SetState(const VBoxDistanceState &State) { m_State = State; }
+};
+
+/// <summary>
+/// Formats a state as text, a line of names and a line of values, to be
+/// stored next to the recordings
+/// </summary>
+std::string FormatVBoxDistanceState(const VBoxDistanceState &State);
+
+/// <summary>
+/// Reads a state formatted by FormatVBoxDistanceState
+/// </summary>
+/// <param name="Text">"Text of the state"</param>
+/// <param name="State">"State read, left unchanged on error"</param>
+/// <returns>"false if the text is not a state"</returns>
+bool ParseVBoxDistanceState(const char *Text, VBoxDistanceState *State);
+#endif
@@ -0,0 +1,104 @@
+#include "VBoxEpoch.h"
+
+#include <string.h>
+
+VBoxEpochAssembler::VBoxEpochAssembler(INT64 Timeout)
+{
+	m_Timeout = Timeout;
+	Reset();
+}
+
+void VBoxEpochAssembler::Reset()
+{
+	memset(&m_Fix, 0, sizeof(m_Fix));
+	m_LastID = 0;
+	m_HasGPSTime = false;
+	m_LastGPSTime = 0;
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+void VBoxEpochAssembler::Close(VBoxFix *Fix)
+{
+	if (m_Fix.Received == VBOX_EPOCH_COMPLETE)
+		m_Stats.Complete++;
+	else
+		m_Stats.Incomplete++;
+
+	if (HasVBoxFrame(m_Fix, VBOX_ID_FIRST))
+	{
+		m_HasGPSTime = true;
+		m_LastGPSTime = m_Fix.GPSTime;
+	}
+
+	*Fix = m_Fix;
+	memset(&m_Fix, 0, sizeof(m_Fix));
+	m_LastID = 0;
+}
+
+bool VBoxEpochAssembler::Add(DWORD ID, size_t Row, INT64 Time, DWORD GPSTime, VBoxFix *Fix)
+{
+	bool ended = false;
+
+	if (!IsVBoxID(ID))
+		return false;
+
+	m_Stats.Frames++;
+
+	// A 0x301 with the GPS time of the fix it would join or follow is
+	// the same fix sent again
+	//
+	if (ID == VBOX_ID_FIRST)
+	{
+		if (HasVBoxFrame(m_Fix, VBOX_ID_FIRST) ? GPSTime == m_Fix.GPSTime : (m_Fix.Received == 0 && m_HasGPSTime && GPSTime == m_LastGPSTime))
+		{
+			m_Stats.Repeated++;
+			return false;
+		}
+	}
+
+	// The frames of a cycle come in ID order, a 0x301 first: a frame
+	// not following the last one, a 0x301 among them, starts the next
+	// cycle. So does a frame coming too late after the first one
+	//
+	if (m_Fix.Received != 0)
+	{
+		if (ID <= m_LastID)
+			ended = true;
+		else if (Time - m_Fix.FirstTime > m_Timeout)
+		{
+			m_Stats.TimedOut++;
+			ended = true;
+		}
+		if (ended)
+			Close(Fix);
+	}
+
+	if (m_Fix.Received == 0)
+		m_Fix.FirstTime = Time;
+	m_Fix.LastTime = Time;
+	m_Fix.Received |= 1 << (ID - VBOX_ID_FIRST);
+	m_Fix.Row[ID - VBOX_ID_FIRST] = Row;
+	if (ID == VBOX_ID_FIRST)
+		m_Fix.GPSTime = GPSTime;
+	m_LastID = ID;
+
+	// A complete epoch is given at once. It can not be the one started
+	// by this frame
+	//
+	if (m_Fix.Received == VBOX_EPOCH_COMPLETE)
+	{
+		Close(Fix);
+		ended = true;
+	}
+
+	return ended;
+}
+
+bool VBoxEpochAssembler::Flush(VBoxFix *Fix)
+{
+	if (m_Fix.Received == 0)
+		return false;
+
+	Close(Fix);
+	return true;
+}
@@ -0,0 +1,114 @@
+//  VBoxEpoch.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Assembler of the VBOX epochs. The VBOX sends its fix as 5 frames
+//  (IDs 0x301 to 0x305, in that order) within about a millisecond, once
+//  per GPS cycle, the 0x301 carrying the GPS time of the fix. The frames
+//  are grouped back into one fix: an epoch ends when it has all of them,
+//  when a frame does not follow the last one in ID order (the next
+//  cycle), when a 0x301 brings another GPS time, or when a frame comes
+//  later than a timeout after the first one. Epochs with frames missing
+//  are given as well, and counted. The fields are not read here: a fix
+//  gives the row of each of its frames in the VBoxBatch blocks
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __VBOXEPOCHH_
+#define __VBOXEPOCHH_
+
+#include "VBoxDecoder.h"
+
+#include <stddef.h>
+
+// Frames of a complete epoch, bit (ID - VBOX_ID_FIRST)
+//
+#define VBOX_EPOCH_COMPLETE		((1 << VBOX_FRAME_COUNT) - 1)
+
+// Default timeout of an epoch, in milliseconds after its first frame.
+// Half the period of the fastest VBOX (100 Hz)
+//
+#define VBOX_EPOCH_TIMEOUT		5
+
+// One GPS fix, from the frames of an epoch
+//
+typedef struct tagVBoxFix
+{
+	DWORD Received;                 // Frames present, bit (ID - VBOX_ID_FIRST)
+	size_t Row[VBOX_FRAME_COUNT];   // Row given with each frame present
+	DWORD GPSTime;                  // Time of the 0x301, if present, in 1/100 s
+	INT64 FirstTime;                // Time of the first frame of the epoch
+	INT64 LastTime;                 // Time of the last one
+} VBoxFix;
+
+// Counts of an assembler
+//
+typedef struct tagVBoxEpochStats
+{
+	UINT64 Frames;        // VBOX frames added
+	UINT64 Complete;      // Epochs given with their 5 frames
+	UINT64 Incomplete;    // Epochs given with frames missing
+	UINT64 TimedOut;      // Incomplete epochs ended by the timeout
+	UINT64 Repeated;      // 0x301 frames repeating the GPS time of the fix, dropped
+} VBoxEpochStats;
+
+// Assembler of the epochs. The frames are added in the order they were
+// received, with their times in milliseconds
+//
+class VBoxEpochAssembler
+{
+	private:
+		VBoxFix m_Fix;
+		DWORD m_LastID;           // ID of the last frame of the epoch
+		bool m_HasGPSTime;        // A fix was given with a 0x301
+		DWORD m_LastGPSTime;      // Its GPS time
+		INT64 m_Timeout;
+		VBoxEpochStats m_Stats;
+
+		void Close(VBoxFix *Fix);
+
+	public:
+		VBoxEpochAssembler(INT64 Timeout = VBOX_EPOCH_TIMEOUT);
+
+		/// <summary>
+		/// Forgets the epoch started and clears the counts
+		/// </summary>
+		void Reset();
+
+		/// <summary>
+		/// Sets the time after the first frame of an epoch past which a
+		/// frame starts the next one
+		/// </summary>
+		/// <param name="Timeout">"Timeout in milliseconds"</param>
+		void SetTimeout(INT64 Timeout) { m_Timeout = Timeout; }
+		INT64 GetTimeout() const { return m_Timeout; }
+
+		/// <summary>
+		/// Adds a frame to the current epoch, ending it when needed
+		/// </summary>
+		/// <param name="ID">"ID of the frame, frames of other IDs are ignored"</param>
+		/// <param name="Row">"Position of the frame, given back in the fix"</param>
+		/// <param name="Time">"Time the frame was received, in milliseconds"</param>
+		/// <param name="GPSTime">"GPS time decoded from a 0x301 frame, unused for the others"</param>
+		/// <param name="Fix">"Fix of the epoch ended, if any"</param>
+		/// <returns>"true if an epoch ended and was written to Fix"</returns>
+		bool Add(DWORD ID, size_t Row, INT64 Time, DWORD GPSTime, VBoxFix *Fix);
+
+		/// <summary>
+		/// Ends the current epoch, at the end of the frames
+		/// </summary>
+		/// <param name="Fix">"Fix of the epoch, if any"</param>
+		/// <returns>"true if an epoch was started and was written to Fix"</returns>
+		bool Flush(VBoxFix *Fix);
+
+		const VBoxEpochStats& GetStats() const { return m_Stats; }
+};
+
+/// <summary>
+/// Tells if a fix has the frame of an ID
+/// </summary>
+inline bool HasVBoxFrame(const VBoxFix &Fix, DWORD ID)
+{
+	return (Fix.Received & (1 << (ID - VBOX_ID_FIRST))) != 0;
+}
+#endif
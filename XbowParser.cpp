@@ -0,0 +1,162 @@
+#include "XbowParser.h"
+
+#include <string.h>
+
+static inline WORD GetXbowWord(const BYTE *Packet, int Offset)
+{
+	return (WORD)((Packet[Offset] << 8) | Packet[Offset + 1]);
+}
+
+static inline void PutXbowWord(BYTE *Packet, int Offset, WORD Value)
+{
+	Packet[Offset] = (BYTE)(Value >> 8);
+	Packet[Offset + 1] = (BYTE)Value;
+}
+
+bool ParseXbowPacket(const BYTE *Packet, XbowSample *Sample)
+{
+	if (!IsXbowPacketValid(Packet))
+		return false;
+
+	Sample->RollAngle = (INT16)GetXbowWord(Packet, XBOW_ROLL_ANGLE);
+	Sample->PitchAngle = (INT16)GetXbowWord(Packet, XBOW_PITCH_ANGLE);
+	Sample->RollRate = (INT16)GetXbowWord(Packet, XBOW_ROLL_RATE);
+	Sample->PitchRate = (INT16)GetXbowWord(Packet, XBOW_PITCH_RATE);
+	Sample->YawRate = (INT16)GetXbowWord(Packet, XBOW_YAW_RATE);
+	Sample->AccX = (INT16)GetXbowWord(Packet, XBOW_ACC_X);
+	Sample->AccY = (INT16)GetXbowWord(Packet, XBOW_ACC_Y);
+	Sample->AccZ = (INT16)GetXbowWord(Packet, XBOW_ACC_Z);
+	Sample->Temperature = GetXbowWord(Packet, XBOW_TEMPERATURE);
+	Sample->Time = GetXbowWord(Packet, XBOW_TIME);
+
+	return true;
+}
+
+void PackXbowSample(const XbowSample &Sample, BYTE *Packet)
+{
+	Packet[0] = XBOW_HEADER;
+	PutXbowWord(Packet, XBOW_ROLL_ANGLE, (WORD)Sample.RollAngle);
+	PutXbowWord(Packet, XBOW_PITCH_ANGLE, (WORD)Sample.PitchAngle);
+	PutXbowWord(Packet, XBOW_ROLL_RATE, (WORD)Sample.RollRate);
+	PutXbowWord(Packet, XBOW_PITCH_RATE, (WORD)Sample.PitchRate);
+	PutXbowWord(Packet, XBOW_YAW_RATE, (WORD)Sample.YawRate);
+	PutXbowWord(Packet, XBOW_ACC_X, (WORD)Sample.AccX);
+	PutXbowWord(Packet, XBOW_ACC_Y, (WORD)Sample.AccY);
+	PutXbowWord(Packet, XBOW_ACC_Z, (WORD)Sample.AccZ);
+	PutXbowWord(Packet, XBOW_TEMPERATURE, Sample.Temperature);
+	PutXbowWord(Packet, XBOW_TIME, Sample.Time);
+	Packet[XBOW_CHECKSUM] = GetXbowChecksum(Packet);
+}
+
+XbowFramer::XbowFramer()
+{
+	Reset();
+}
+
+void XbowFramer::Reset()
+{
+	m_Count = 0;
+	m_Synchronized = false;
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+void XbowFramer::Resynchronize()
+{
+	Drop(m_Count);
+	m_Count = 0;
+}
+
+void XbowFramer::Drop(UINT64 Bytes)
+{
+	if (Bytes == 0)
+		return;
+
+	m_Stats.BadBytes += Bytes;
+	if (m_Synchronized)
+	{
+		m_Stats.Resyncs++;
+		m_Synchronized = false;
+	}
+}
+
+// Drops the header of the bytes kept, which are not a packet, and moves
+// the next header found among them to the start
+//
+void XbowFramer::Advance()
+{
+	const BYTE *header = (const BYTE*)memchr(&m_Buffer[1], XBOW_HEADER, m_Count - 1);
+	int skipped = header ? (int)(header - m_Buffer) : m_Count;
+
+	Drop(skipped);
+	m_Count -= skipped;
+	memmove(m_Buffer, &m_Buffer[skipped], m_Count);
+}
+
+DWORD XbowFramer::Push(const BYTE *Data, DWORD Length, BYTE *Packets, DWORD MaxCount, DWORD *Consumed)
+{
+	const BYTE *header;
+	DWORD used = 0, dwCount = 0, size;
+
+	while (used < Length && dwCount < MaxCount)
+	{
+		if (m_Count == 0)
+		{
+			// Bytes up to the next header are not part of a packet
+			//
+			if (Data[used] != XBOW_HEADER)
+			{
+				header = (const BYTE*)memchr(&Data[used], XBOW_HEADER, Length - used);
+				size = header ? (DWORD)(header - &Data[used]) : Length - used;
+				Drop(size);
+				used += size;
+				continue;
+			}
+
+			// A whole packet in the chunk is checked where it is
+			//
+			if (Length - used >= XBOW_PACKET_SIZE)
+			{
+				if (IsXbowPacketValid(&Data[used]))
+				{
+					memcpy(&Packets[dwCount * XBOW_PACKET_SIZE], &Data[used], XBOW_PACKET_SIZE);
+					used += XBOW_PACKET_SIZE;
+					dwCount++;
+					m_Stats.Packets++;
+					m_Synchronized = true;
+				}
+				else
+				{
+					Drop(1);
+					used++;
+				}
+				continue;
+			}
+		}
+
+		// The packet continues in the next chunk, or started in the last one
+		//
+		size = XBOW_PACKET_SIZE - m_Count;
+		if (size > Length - used)
+			size = Length - used;
+		memcpy(&m_Buffer[m_Count], &Data[used], size);
+		m_Count += size;
+		used += size;
+
+		if (m_Count == XBOW_PACKET_SIZE)
+		{
+			if (IsXbowPacketValid(m_Buffer))
+			{
+				memcpy(&Packets[dwCount * XBOW_PACKET_SIZE], m_Buffer, XBOW_PACKET_SIZE);
+				m_Count = 0;
+				dwCount++;
+				m_Stats.Packets++;
+				m_Synchronized = true;
+			}
+			else
+				Advance();
+		}
+	}
+
+	*Consumed = used;
+	return dwCount;
+}
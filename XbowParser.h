@@ -0,0 +1,121 @@
+//  XbowParser.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Parser of the packets sent by the Crossbow IMU. The header and the
+//  checksum are checked on the bytes received, then the big-endian fields
+//  are read into a packed sample of integers, in the units of the IMU,
+//  without going through a text representation or allocating. A framer
+//  cuts the packets out of the serial stream, whatever the size of the
+//  reads, and finds them back after lost or corrupted bytes
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __XBOWPARSERH_
+#define __XBOWPARSERH_
+
+#include "XbowTypes.h"
+
+// Scales of the fields, per unit sent: angles in degrees, rates in
+// degrees per second and accelerations in g
+//
+#define XBOW_ANGLE_SCALE		(180.0 / 32768.0)
+#define XBOW_RATE_SCALE			(300.0 / 32768.0)
+#define XBOW_ACC_SCALE			(6.0 / 32768.0)
+
+// Temperature sensor law, (V * 5 / 4096 - 1.375) * 44.44 degrees C
+//
+#define XBOW_TEMPERATURE_SCALE	(5.0 / 4096.0 * 44.44)
+#define XBOW_TEMPERATURE_OFFSET	(-1.375 * 44.44)
+
+// Fields of an Xbow packet, in the units sent. The 16-bit fields pack
+// into 20 bytes without padding
+//
+typedef struct tagXbowSample
+{
+	INT16  RollAngle;         // In XBOW_ANGLE_SCALE
+	INT16  PitchAngle;
+	INT16  RollRate;          // In XBOW_RATE_SCALE
+	INT16  PitchRate;
+	INT16  YawRate;
+	INT16  AccX;              // In XBOW_ACC_SCALE
+	INT16  AccY;
+	INT16  AccZ;
+	WORD   Temperature;       // Sensor reading, in 5/4096 V
+	WORD   Time;              // Free running device timer
+} XbowSample;
+
+/// <summary>
+/// Reads the fields of an Xbow packet
+/// </summary>
+/// <param name="Packet">"XBOW_PACKET_SIZE bytes of the packet"</param>
+/// <param name="Sample">"Fields read, left unchanged if the packet is not valid"</param>
+/// <returns>"false if the header or the checksum is wrong"</returns>
+bool ParseXbowPacket(const BYTE *Packet, XbowSample *Sample);
+
+/// <summary>
+/// Builds the packet of a sample, with its header and checksum
+/// </summary>
+/// <param name="Sample">"Fields of the packet"</param>
+/// <param name="Packet">"XBOW_PACKET_SIZE bytes written"</param>
+void PackXbowSample(const XbowSample &Sample, BYTE *Packet);
+
+// Counts of a framer
+//
+typedef struct tagXbowFramerStats
+{
+	UINT64 Packets;       // Valid packets cut out of the stream
+	UINT64 BadBytes;      // Bytes dropped while looking for a packet
+	UINT64 Resyncs;       // Times the packets were lost and searched again
+} XbowFramerStats;
+
+// Framer of the Xbow stream. A packet starts at a header byte and is
+// kept if its checksum is right; otherwise the search starts again one
+// byte further, at the next header byte
+//
+class XbowFramer
+{
+	private:
+		BYTE m_Buffer[XBOW_PACKET_SIZE];   // Start of a packet cut by a read
+		int m_Count;
+		bool m_Synchronized;
+		XbowFramerStats m_Stats;
+
+		void Drop(UINT64 Bytes);
+		void Advance();
+
+	public:
+		XbowFramer();
+
+		/// <summary>
+		/// Forgets the bytes kept and clears the counts
+		/// </summary>
+		void Reset();
+
+		/// <summary>
+		/// Drops the start of packet kept, to search the next one
+		/// </summary>
+		void Resynchronize();
+
+		/// <summary>
+		/// Cuts the valid packets out of a chunk of the stream
+		/// </summary>
+		/// <param name="Data">"Bytes read, of any number"</param>
+		/// <param name="Length">"Number of bytes read"</param>
+		/// <param name="Packets">"Buffer of MaxCount packets of XBOW_PACKET_SIZE bytes"</param>
+		/// <param name="MaxCount">"Number of packets the buffer holds"</param>
+		/// <param name="Consumed">"Bytes used, less than Length if the buffer is full"</param>
+		/// <returns>"The number of packets written"</returns>
+		DWORD Push(const BYTE *Data, DWORD Length, BYTE *Packets, DWORD MaxCount, DWORD *Consumed);
+
+		bool IsSynchronized() const { return m_Synchronized; }
+		const XbowFramerStats& GetStats() const { return m_Stats; }
+};
+
+// Scaled values of the fields
+//
+inline double GetXbowAngle(INT16 Value) { return Value * XBOW_ANGLE_SCALE; }
+inline double GetXbowRate(INT16 Value) { return Value * XBOW_RATE_SCALE; }
+inline double GetXbowAcc(INT16 Value) { return Value * XBOW_ACC_SCALE; }
+inline double GetXbowTemperature(WORD Value) { return Value * XBOW_TEMPERATURE_SCALE + XBOW_TEMPERATURE_OFFSET; }
+#endif
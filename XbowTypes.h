@@ -0,0 +1,56 @@
+//  XbowTypes.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Layout of the packets sent by the Crossbow IMU in its scaled sensor
+//  mode ('C' command), as read from the FT232R serial port
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __XBOWTYPESH_
+#define __XBOWTYPESH_
+
+#include "CANTypes.h"
+
+// Size of a packet: 0xFF header, 20 data bytes and the checksum
+//
+#define XBOW_PACKET_SIZE		22
+
+// Header byte starting every packet
+//
+#define XBOW_HEADER				0xFF
+
+// Big-endian 16-bit fields of the packet, as byte offsets
+//
+#define XBOW_ROLL_ANGLE			1
+#define XBOW_PITCH_ANGLE		3
+#define XBOW_ROLL_RATE			5
+#define XBOW_PITCH_RATE			7
+#define XBOW_YAW_RATE			9
+#define XBOW_ACC_X				11
+#define XBOW_ACC_Y				13
+#define XBOW_ACC_Z				15
+#define XBOW_TEMPERATURE		17
+#define XBOW_TIME				19
+#define XBOW_CHECKSUM			21
+
+// Computes the checksum of a packet: the 8-bit sum of the 20 data
+// bytes, modulo 255
+//
+inline BYTE GetXbowChecksum(const BYTE *packet)
+{
+	BYTE sum = 0;
+
+	for (int i = 1; i < XBOW_CHECKSUM; i++)
+		sum += packet[i];
+
+	return (BYTE)(sum % 255);
+}
+
+// Checks the header and the checksum of a packet
+//
+inline bool IsXbowPacketValid(const BYTE *packet)
+{
+	return packet[0] == XBOW_HEADER && packet[XBOW_CHECKSUM] == GetXbowChecksum(packet);
+}
+#endif
@@ -0,0 +1,166 @@
+//  BatchDrainBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of the draining of a receive queue: one read and one lock
+//  per frame, as ReadMessages did, against bursts read in one call and
+//  processed under one lock, as ReadBatch and ProcessMessages do. The
+//  source is a stub backend holding a second of traffic in memory, its
+//  queue guarded by a lock as a driver's is
+//
+//  ~~~~~~~~~~~~
+//
+#include "CANSource.h"
+#include "MessageStatus.h"
+#include "MessageTable.h"
+
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#define BENCH_FRAMES		1000000
+#define BENCH_BURST			256
+#define BENCH_RUNS			5
+
+// Stub backend giving the frames of a buffer
+//
+class StubSource : public CANSource
+{
+	private:
+		const std::vector<TPCANMsgFDEntry> &m_Frames;
+		size_t m_Next;
+		std::mutex m_QueueLock;
+
+	public:
+		StubSource(const std::vector<TPCANMsgFDEntry> &Frames) : m_Frames(Frames), m_Next(0) {}
+
+		TPCANStatus Initialize() { m_Next = 0; return PCAN_ERROR_OK; }
+		TPCANStatus Uninitialize() { return PCAN_ERROR_OK; }
+		TPCANStatus ReadBatch(TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count)
+		{
+			std::lock_guard<std::mutex> lock(m_QueueLock);
+
+			*Count = 0;
+			while (*Count < MaxCount && m_Next < m_Frames.size())
+				EntryBuffer[(*Count)++] = m_Frames[m_Next++];
+
+			return (m_Next < m_Frames.size()) ? PCAN_ERROR_OK : PCAN_ERROR_QRCVEMPTY;
+		}
+		TPCANStatus FilterMessages(DWORD, DWORD, TPCANMode) { return PCAN_ERROR_OK; }
+		DWORD GetMaxFilterRanges() const { return 1; }
+		TPCANStatus WaitForMessages(DWORD) { return PCAN_ERROR_OK; }
+		void CancelWait() {}
+		const char* GetName() const { return "Stub"; }
+};
+
+// Consumer updating the table of the last messages, as the dialog does
+// under m_objpCS
+//
+class Consumer
+{
+	public:
+		std::mutex Lock;
+		MessageTable<MessageStatus> Table;
+		UINT64 Locks;
+
+		Consumer() : Locks(0) {}
+
+		void ProcessLocked(const TPCANMsgFDEntry &Entry)
+		{
+			CANFrameView view = MakeFrameView(Entry.Msg);
+			int index = Table.Find(view.ID, view.MSGTYPE);
+
+			if (index != MSG_TABLE_NONE)
+				Table[index].Update(view, Entry.Timestamp);
+			else
+				Table.Add(view.ID, view.MSGTYPE, MessageStatus(view, Entry.Timestamp, Table.GetCount()));
+		}
+};
+
+// A second of traffic: the VBOX at 100 Hz among frames of 60 other IDs
+//
+static void MakeTraffic(std::vector<TPCANMsgFDEntry> &Frames)
+{
+	std::mt19937 random(5);
+	TPCANMsgFDEntry entry = {};
+
+	for (int i = 0; i < BENCH_FRAMES; i++)
+	{
+		entry.Msg.ID = (i % 2000 < 5) ? 0x301 + i % 2000 : 0x100 + random() % 60;
+		entry.Msg.MSGTYPE = PCAN_MESSAGE_STANDARD;
+		entry.Msg.DLC = 8;
+		for (int j = 0; j < 8; j++)
+			entry.Msg.DATA[j] = (BYTE)random();
+		entry.Timestamp = i;
+		Frames.push_back(entry);
+	}
+}
+
+static double DrainPerFrame(const std::vector<TPCANMsgFDEntry> &Frames, Consumer &Target)
+{
+	StubSource source(Frames);
+	TPCANMsgFDEntry entry;
+	DWORD count;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	do
+	{
+		source.ReadBatch(&entry, 1, &count);
+		if (count == 0)
+			break;
+		std::lock_guard<std::mutex> lock(Target.Lock);
+		Target.Locks++;
+		Target.ProcessLocked(entry);
+	} while (true);
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double DrainBursts(const std::vector<TPCANMsgFDEntry> &Frames, Consumer &Target)
+{
+	StubSource source(Frames);
+	std::vector<TPCANMsgFDEntry> entries(BENCH_BURST);
+	DWORD count;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	do
+	{
+		source.ReadBatch(&entries[0], BENCH_BURST, &count);
+		if (count == 0)
+			break;
+		std::lock_guard<std::mutex> lock(Target.Lock);
+		Target.Locks++;
+		for (DWORD i = 0; i < count; i++)
+			Target.ProcessLocked(entries[i]);
+	} while (true);
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+	std::vector<TPCANMsgFDEntry> frames;
+	double perFrame = 0, bursts = 0;
+	int counts[2] = { 0, 0 };
+
+	MakeTraffic(frames);
+	for (int run = 0; run < BENCH_RUNS; run++)
+	{
+		Consumer single, burst;
+
+		perFrame += DrainPerFrame(frames, single);
+		bursts += DrainBursts(frames, burst);
+		counts[0] = single.Table[single.Table.Find(0x301, PCAN_MESSAGE_STANDARD)].GetCount();
+		counts[1] = burst.Table[burst.Table.Find(0x301, PCAN_MESSAGE_STANDARD)].GetCount();
+		if (run == 0)
+			printf("%u frames, %llu locks per frame, %llu locks in bursts of %d\n", (unsigned)frames.size(),
+				(unsigned long long)single.Locks, (unsigned long long)burst.Locks, BENCH_BURST);
+	}
+
+	printf("per frame: %.1f Mframes/s, %.1f ns/frame\n", BENCH_RUNS * frames.size() / perFrame / 1e6, perFrame * 1e9 / BENCH_RUNS / frames.size());
+	printf("bursts:    %.1f Mframes/s, %.1f ns/frame\n", BENCH_RUNS * frames.size() / bursts / 1e6, bursts * 1e9 / BENCH_RUNS / frames.size());
+	printf("0x301 frames: %d and %d\n", counts[0], counts[1]);
+
+	return counts[0] == counts[1] ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+﻿//  CANCaptureBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of the multi-channel capture: frames per second read by the
+//  channel threads and merged by the consumer, for 1 to 8 channels. The
+//  channels are unpaced traffic generators, then, where the vcan0..vcan7
+//  interfaces exist, SocketCAN sources fed by writer threads as fast as
+//  the kernel takes the frames
+//
+//      ip link add dev vcan0 type vcan && ip link set up vcan0
+//
+//  ~~~~~~~~~~~~
+//
+#include "CANCapture.h"
+#include "GeneratorSource.h"
+#include "SocketCANSource.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#define BENCH_MAX_CHANNELS	8
+#define BENCH_SECONDS		1
+
+// Runs the capture of the channels for BENCH_SECONDS and prints its rates
+//
+static void RunCapture(TimestampService *Clock, const char *Name, std::vector<CANSource*> &Sources)
+{
+	CANCapture capture(Clock);
+	std::vector<CANCaptureEntry> entries(CAN_CAPTURE_BATCH);
+	std::chrono::steady_clock::time_point start, end;
+	UINT64 merged = 0, frames = 0, overflows = 0, late = 0;
+	double seconds;
+
+	for (size_t i = 0; i < Sources.size(); i++)
+		capture.AddChannel(Sources[i]);
+
+	capture.Start();
+	start = std::chrono::steady_clock::now();
+	end = start + std::chrono::seconds(BENCH_SECONDS);
+	while (std::chrono::steady_clock::now() < end)
+	{
+		capture.WaitForMessages(10);
+		merged += capture.ReadMerged(&entries[0], (DWORD)entries.size());
+	}
+	capture.Stop();
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	while (DWORD count = capture.ReadMerged(&entries[0], (DWORD)entries.size()))
+		merged += count;
+
+	for (DWORD i = 0; i < capture.GetChannelCount(); i++)
+	{
+		CANChannelStats stats = capture.GetChannelStatistics(i);
+
+		frames += stats.Frames;
+		overflows += stats.Overflows;
+		late += stats.LateFrames;
+	}
+	printf("%s, %zu channels: read %6.2f Mframes/s, merged %6.2f Mframes/s, %llu overflows, %llu late\n",
+		Name, Sources.size(), frames / seconds / 1e6, merged / seconds / 1e6,
+		(unsigned long long)overflows, (unsigned long long)late);
+}
+
+static void BenchGenerators(TimestampService *Clock)
+{
+	TrafficConfig config = TrafficGenerator::GetDefaultConfig();
+
+	config.GPSRate = 0;
+	config.XbowRate = 0;
+	config.BackgroundRate = 1000000;
+	config.BackgroundIDs = 100;
+
+	for (int count = 1; count <= BENCH_MAX_CHANNELS; count *= 2)
+	{
+		std::vector<std::unique_ptr<GeneratorSource> > generators;
+		std::vector<CANSource*> sources;
+
+		for (int i = 0; i < count; i++)
+		{
+			config.Seed = i + 1;
+			generators.push_back(std::unique_ptr<GeneratorSource>(new GeneratorSource(Clock, config, false)));
+			generators.back()->Initialize();
+			sources.push_back(generators.back().get());
+		}
+		RunCapture(Clock, "Generators", sources);
+	}
+}
+
+#ifdef __linux__
+// Writes standard frames to a vcan interface until stopped
+//
+static void WriteFrames(const char *Interface, const std::atomic<bool> *Running)
+{
+	struct ifreq ifr;
+	struct sockaddr_can addr;
+	struct can_frame frame;
+	int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+
+	memset(&ifr, 0, sizeof(ifr));
+	strncpy(ifr.ifr_name, Interface, IFNAMSIZ - 1);
+	memset(&addr, 0, sizeof(addr));
+	addr.can_family = AF_CAN;
+	if (fd < 0 || ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+		return;
+	addr.can_ifindex = ifr.ifr_ifindex;
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+	{
+		close(fd);
+		return;
+	}
+
+	memset(&frame, 0, sizeof(frame));
+	frame.can_dlc = 8;
+	for (DWORD i = 0; Running->load(std::memory_order_relaxed); i++)
+	{
+		frame.can_id = 0x100 + i % 100;
+		memcpy(frame.data, &i, sizeof(i));
+		if (write(fd, &frame, sizeof(frame)) < 0)
+			std::this_thread::yield();
+	}
+	close(fd);
+}
+
+static void BenchVcan(TimestampService *Clock)
+{
+	char names[BENCH_MAX_CHANNELS][16];
+
+	for (int count = 1; count <= BENCH_MAX_CHANNELS; count *= 2)
+	{
+		std::vector<std::unique_ptr<SocketCANSource> > channels;
+		std::vector<CANSource*> sources;
+		std::vector<std::thread> writers;
+		std::atomic<bool> running(true);
+
+		for (int i = 0; i < count; i++)
+		{
+			snprintf(names[i], sizeof(names[i]), "vcan%d", i);
+			channels.push_back(std::unique_ptr<SocketCANSource>(new SocketCANSource(names[i])));
+			if (channels.back()->Initialize() != PCAN_ERROR_OK)
+			{
+				if (count == 1)
+					printf("%s not available, vcan runs skipped\n", names[i]);
+				else
+					printf("%s not available, vcan runs stop at %d channels\n", names[i], count / 2);
+				return;
+			}
+			sources.push_back(channels.back().get());
+		}
+
+		for (int i = 0; i < count; i++)
+			writers.push_back(std::thread(WriteFrames, names[i], &running));
+		RunCapture(Clock, "vcan", sources);
+		running.store(false);
+		for (size_t i = 0; i < writers.size(); i++)
+			writers[i].join();
+		for (size_t i = 0; i < channels.size(); i++)
+			channels[i]->Uninitialize();
+	}
+}
+#endif
+
+int main()
+{
+	TimestampService clock;
+
+	BenchGenerators(&clock);
+#ifdef __linux__
+	BenchVcan(&clock);
+#endif
+
+	return 0;
+}
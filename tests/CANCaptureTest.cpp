@@ -0,0 +1,256 @@
+﻿//  CANCaptureTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the multi-channel capture on stub channels stamping their
+//  frames with the host clock, as an adapter would: the merge order of
+//  frames sent in turn on three channels, the reorder window held for a
+//  silent channel, the frames merged late and the ring overflows
+//
+//  ~~~~~~~~~~~~
+//
+#include "CANCapture.h"
+#include "TestCheck.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Channel whose frames are given by the test, stamped when they are
+// sent, the wait and its cancellation working as with a driver event
+//
+class StubChannel : public CANSource
+{
+	private:
+		TimestampService *m_Clock;
+		std::deque<TPCANMsgFDEntry> m_Queue;
+		std::mutex m_Lock;
+		std::condition_variable m_Condition;
+		bool m_Cancelled;
+
+	public:
+		StubChannel(TimestampService *Clock) : m_Clock(Clock), m_Cancelled(false) {}
+
+		// Sends frames at once, their adapter times given relative to now
+		// in microseconds
+		//
+		void Send(DWORD ID, const INT64 *Offsets, int Count)
+		{
+			TPCANMsgFDEntry entry = {};
+			TPCANTimestampFD now = m_Clock->Now() / 1000;
+
+			{
+				std::lock_guard<std::mutex> lock(m_Lock);
+
+				for (int i = 0; i < Count; i++)
+				{
+					entry.Msg.ID = ID;
+					entry.Msg.MSGTYPE = PCAN_MESSAGE_STANDARD;
+					entry.Msg.DLC = 1;
+					entry.Msg.DATA[0] = (BYTE)i;
+					entry.Timestamp = now + Offsets[i];
+					m_Queue.push_back(entry);
+				}
+			}
+			m_Condition.notify_all();
+		}
+
+		void Send(DWORD ID)
+		{
+			INT64 offset = 0;
+
+			Send(ID, &offset, 1);
+		}
+
+		TPCANStatus Initialize() { return PCAN_ERROR_OK; }
+		TPCANStatus Uninitialize() { return PCAN_ERROR_OK; }
+		TPCANStatus ReadBatch(TPCANMsgFDEntry* EntryBuffer, DWORD MaxCount, DWORD* Count)
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+
+			*Count = 0;
+			while (*Count < MaxCount && !m_Queue.empty())
+			{
+				EntryBuffer[(*Count)++] = m_Queue.front();
+				m_Queue.pop_front();
+			}
+
+			return m_Queue.empty() ? PCAN_ERROR_QRCVEMPTY : PCAN_ERROR_OK;
+		}
+		TPCANStatus FilterMessages(DWORD, DWORD, TPCANMode) { return PCAN_ERROR_OK; }
+		DWORD GetMaxFilterRanges() const { return 1; }
+		TPCANStatus WaitForMessages(DWORD)
+		{
+			std::unique_lock<std::mutex> lock(m_Lock);
+
+			m_Condition.wait(lock, [this] { return m_Cancelled || !m_Queue.empty(); });
+			if (m_Cancelled)
+			{
+				m_Cancelled = false;
+				return PCAN_ERROR_QRCVEMPTY;
+			}
+			return PCAN_ERROR_OK;
+		}
+		void CancelWait()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_Lock);
+				m_Cancelled = true;
+			}
+			m_Condition.notify_all();
+		}
+		const char* GetName() const { return "Stub"; }
+};
+
+static void Sleep(int Milliseconds)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(Milliseconds));
+}
+
+// Waits for the reader of a channel to have read a number of frames
+//
+static bool WaitForFrames(const CANCapture &Capture, DWORD Channel, UINT64 Frames)
+{
+	for (int i = 0; i < 2000 && Capture.GetChannelStatistics(Channel).Frames < Frames; i++)
+		Sleep(1);
+
+	return Capture.GetChannelStatistics(Channel).Frames >= Frames;
+}
+
+// Three channels sent to in turn, 3 ms apart, far more than the
+// latency of the readers: the merge gives them back in that order
+//
+static void TestMergeOrder()
+{
+	TimestampService clock;
+	StubChannel first(&clock), second(&clock), third(&clock);
+	StubChannel *channels[3] = { &first, &second, &third };
+	CANCapture capture(&clock);
+	std::vector<CANCaptureEntry> merged;
+	CANCaptureEntry entries[64];
+	bool ordered = true;
+	DWORD count;
+
+	for (int i = 0; i < 3; i++)
+		CHECK_EQUAL((DWORD)i, capture.AddChannel(channels[i]));
+	CHECK_EQUAL(PCAN_ERROR_OK, capture.Start());
+	CHECK_EQUAL(PCAN_ERROR_ILLOPERATION, capture.Start());
+
+	std::thread consumer([&]()
+	{
+		for (int i = 0; i < 1000 && merged.size() < 60; i++)
+		{
+			capture.WaitForMessages(10);
+			count = capture.ReadMerged(entries, 64);
+			merged.insert(merged.end(), entries, entries + count);
+		}
+	});
+	for (int i = 0; i < 60; i++)
+	{
+		channels[i % 3]->Send(0x100 + i % 3);
+		Sleep(3);
+	}
+	consumer.join();
+
+	capture.Stop();
+	count = capture.ReadMerged(entries, 64);
+	merged.insert(merged.end(), entries, entries + count);
+
+	CHECK_EQUAL((size_t)60, merged.size());
+	for (size_t i = 0; i < merged.size(); i++)
+	{
+		if (merged[i].Channel != i % 3 || merged[i].Entry.Msg.ID != 0x100 + i % 3
+			|| (i > 0 && merged[i].HostTime < merged[i - 1].HostTime))
+			ordered = false;
+	}
+	CHECK(ordered);
+	for (DWORD i = 0; i < 3; i++)
+	{
+		CANChannelStats stats = capture.GetChannelStatistics(i);
+
+		CHECK_EQUAL(20u, stats.Frames);
+		CHECK_EQUAL(0u, stats.LateFrames);
+		CHECK_EQUAL(0u, stats.Overflows);
+		CHECK_EQUAL(PCAN_ERROR_OK, stats.LastError);
+		CHECK_EQUAL((size_t)1, capture.GetIdTable(i).size());
+		CHECK_EQUAL(20u, capture.GetIdTable(i).at(CAN_ID_KEY(merged[i].Entry.Msg)).Count);
+	}
+}
+
+// A frame is held while another channel is silent, for the reorder
+// window only. A frame coming later but older than the ones merged is
+// counted late
+//
+static void TestReorderWindow()
+{
+	TimestampService clock;
+	StubChannel first(&clock), second(&clock);
+	CANCapture capture(&clock, 50 * NS_PER_MS);
+	CANCaptureEntry entries[8];
+	INT64 offsets[2] = { -1000000, 0 };
+
+	capture.AddChannel(&first);
+	capture.AddChannel(&second);
+	capture.Start();
+
+	first.Send(0x200);
+	CHECK(WaitForFrames(capture, 0, 1));
+	CHECK_EQUAL(0u, capture.ReadMerged(entries, 8));
+	Sleep(80);
+	CHECK_EQUAL(1u, capture.ReadMerged(entries, 8));
+	CHECK_EQUAL(0u, entries[0].Channel);
+
+	// Read in one burst, the first frame is placed one second back
+	//
+	second.Send(0x300, offsets, 2);
+	CHECK(WaitForFrames(capture, 1, 2));
+	Sleep(80);
+	CHECK_EQUAL(2u, capture.ReadMerged(entries, 8));
+	CHECK(entries[0].HostTime < entries[1].HostTime);
+	CHECK_EQUAL(1u, capture.GetChannelStatistics(1).LateFrames);
+	CHECK_EQUAL(0u, capture.GetChannelStatistics(0).LateFrames);
+	capture.Stop();
+}
+
+// Frames the consumer does not take fill the ring of their channel, the
+// others are dropped and counted. Once stopped, the ring is flushed
+//
+static void TestOverflow()
+{
+	TimestampService clock;
+	StubChannel channel(&clock);
+	CANCapture capture(&clock, CAN_CAPTURE_REORDER_WINDOW, 16);
+	CANCaptureEntry entries[128];
+	INT64 offsets[100];
+
+	for (int i = 0; i < 100; i++)
+		offsets[i] = i - 100;
+	capture.AddChannel(&channel);
+	capture.Start();
+
+	channel.Send(0x400, offsets, 100);
+	CHECK(WaitForFrames(capture, 0, 100));
+	capture.Stop();
+
+	CANChannelStats stats = capture.GetChannelStatistics(0);
+	CHECK_EQUAL(100u, stats.Frames);
+	CHECK_EQUAL(1u, stats.Bursts);
+	CHECK_EQUAL(84u, stats.Overflows);
+	CHECK_EQUAL(16u, stats.RingHighWater);
+	CHECK_EQUAL(16u, capture.ReadMerged(entries, 128));
+	for (int i = 0; i < 16; i++)
+		CHECK_EQUAL((BYTE)i, entries[i].Entry.Msg.DATA[0]);
+	CHECK_EQUAL(0u, capture.ReadMerged(entries, 128));
+}
+
+int main()
+{
+	TestMergeOrder();
+	TestReorderWindow();
+	TestOverflow();
+
+	return TestResult("CANCaptureTest");
+}
@@ -0,0 +1,235 @@
+//  CANRingTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the SPSC ring of received messages: the capacity rounded to
+//  a power of two, the copies wrapping around the end of the storage,
+//  the overflow count and the high-water mark, and a producer and a
+//  consumer thread passing 2M numbered messages without loss nor reorder
+//
+//  ~~~~~~~~~~~~
+//
+#include "CANRing.h"
+#include "TestCheck.h"
+
+#include <thread>
+#include <vector>
+
+#define STRESS_MESSAGES		2000000
+#define STRESS_CAPACITY		1024
+#define STRESS_BATCH		64
+
+// Numbers messages from First, in their timestamp, ID and host time
+//
+static void Number(TPCANMsgFDEntry *Entries, UINT64 *HostTimes, DWORD Count, UINT64 First)
+{
+	for (DWORD i = 0; i < Count; i++)
+	{
+		Entries[i] = TPCANMsgFDEntry();
+		Entries[i].Timestamp = First + i;
+		Entries[i].Msg.ID = (DWORD)((First + i) & 0x7FF);
+		HostTimes[i] = (First + i) * 3;
+	}
+}
+
+// Checks that messages are numbered from First
+//
+static bool IsNumbered(const TPCANMsgFDEntry *Entries, const UINT64 *HostTimes, DWORD Count, UINT64 First)
+{
+	for (DWORD i = 0; i < Count; i++)
+		if (Entries[i].Timestamp != First + i || Entries[i].Msg.ID != ((First + i) & 0x7FF) || HostTimes[i] != (First + i) * 3)
+			return false;
+
+	return true;
+}
+
+static void TestCapacity()
+{
+	CHECK_EQUAL(1u, CANRing(0).GetCapacity());
+	CHECK_EQUAL(1u, CANRing(1).GetCapacity());
+	CHECK_EQUAL(8u, CANRing(5).GetCapacity());
+	CHECK_EQUAL(1024u, CANRing(1000).GetCapacity());
+	CHECK_EQUAL(1024u, CANRing(1024).GetCapacity());
+	CHECK_EQUAL(2048u, CANRing(1025).GetCapacity());
+}
+
+static void TestWraparound()
+{
+	CANRing ring(8);
+	TPCANMsgFDEntry entries[8];
+	UINT64 hostTimes[8];
+	UINT64 pushed = 0, popped = 0;
+	DWORD count;
+
+	// Every split of the copies across the end of the storage, by
+	// pushes and pops of 1 to 8 messages from every starting index
+	//
+	for (DWORD start = 0; start < 8; start++)
+	{
+		for (DWORD size = 1; size <= 8; size++)
+		{
+			Number(entries, hostTimes, 8, pushed);
+			CHECK_EQUAL(size, ring.Push(entries, hostTimes, size));
+			pushed += size;
+			CHECK_EQUAL(size, ring.GetDepth());
+
+			count = ring.Pop(entries, hostTimes, 8);
+			CHECK_EQUAL(size, count);
+			CHECK(IsNumbered(entries, hostTimes, count, popped));
+			popped += count;
+			CHECK_EQUAL(0u, ring.GetDepth());
+		}
+
+		// The next round starts one message further
+		//
+		Number(entries, hostTimes, 1, pushed++);
+		ring.Push(entries, hostTimes, 1);
+		ring.Pop(entries, hostTimes, 1);
+		popped++;
+	}
+
+	// Pops shorter than the pushes, the rest staying in order
+	//
+	Number(entries, hostTimes, 6, pushed);
+	CHECK_EQUAL(6u, ring.Push(entries, hostTimes, 6));
+	pushed += 6;
+	count = ring.Pop(entries, hostTimes, 4);
+	CHECK(count == 4 && IsNumbered(entries, hostTimes, count, popped));
+	popped += count;
+	Number(entries, hostTimes, 6, pushed);
+	CHECK_EQUAL(6u, ring.Push(entries, hostTimes, 6));
+	pushed += 6;
+	count = ring.Pop(entries, hostTimes, 8);
+	CHECK(count == 8 && IsNumbered(entries, hostTimes, count, popped));
+	popped += count;
+	CHECK_EQUAL(pushed, popped);
+	CHECK_EQUAL(0ULL, ring.GetOverflows());
+}
+
+static void TestOverflow()
+{
+	CANRing ring(16);
+	TPCANMsgFDEntry entries[32];
+	UINT64 hostTimes[32];
+
+	// The messages that do not fit are dropped, the stored ones kept
+	//
+	Number(entries, hostTimes, 20, 0);
+	CHECK_EQUAL(16u, ring.Push(entries, hostTimes, 20));
+	CHECK_EQUAL(4ULL, ring.GetOverflows());
+	CHECK_EQUAL(16u, ring.GetDepth());
+	CHECK_EQUAL(16u, ring.GetHighWaterMark());
+	CHECK_EQUAL(0u, ring.Push(entries, hostTimes, 1));
+	CHECK_EQUAL(5ULL, ring.GetOverflows());
+
+	CHECK_EQUAL(10u, ring.Pop(entries, hostTimes, 10));
+	CHECK(IsNumbered(entries, hostTimes, 10, 0));
+	Number(entries, hostTimes, 12, 16);
+	CHECK_EQUAL(10u, ring.Push(entries, hostTimes, 12));
+	CHECK_EQUAL(7ULL, ring.GetOverflows());
+
+	CHECK_EQUAL(16u, ring.Pop(entries, hostTimes, 32));
+	CHECK(IsNumbered(entries, hostTimes, 16, 10));
+	CHECK_EQUAL(0u, ring.Pop(entries, hostTimes, 32));
+
+	// The counters are reset apart from the messages
+	//
+	ring.Push(entries, hostTimes, 3);
+	ring.ResetStatistics();
+	CHECK_EQUAL(0ULL, ring.GetOverflows());
+	CHECK_EQUAL(0u, ring.GetHighWaterMark());
+	CHECK_EQUAL(3u, ring.GetDepth());
+	ring.Clear();
+	CHECK_EQUAL(0u, ring.GetDepth());
+	CHECK_EQUAL(0u, ring.Pop(entries, hostTimes, 32));
+}
+
+static void TestHighWaterMark()
+{
+	CANRing ring(64);
+	TPCANMsgFDEntry entries[64];
+	UINT64 hostTimes[64];
+
+	Number(entries, hostTimes, 64, 0);
+	ring.Push(entries, hostTimes, 3);
+	ring.Pop(entries, hostTimes, 3);
+	CHECK_EQUAL(3u, ring.GetHighWaterMark());
+
+	// The deepest the ring has been, not its depth
+	//
+	ring.Push(entries, hostTimes, 5);
+	ring.Pop(entries, hostTimes, 2);
+	ring.Push(entries, hostTimes, 1);
+	CHECK_EQUAL(4u, ring.GetDepth());
+	CHECK_EQUAL(5u, ring.GetHighWaterMark());
+	ring.Push(entries, hostTimes, 40);
+	CHECK_EQUAL(44u, ring.GetHighWaterMark());
+	ring.Clear();
+	CHECK_EQUAL(44u, ring.GetHighWaterMark());
+}
+
+// The producer pushes batches of 1 to 64 messages, pushing again what
+// did not fit, while the consumer pops 1 to 100 at a time
+//
+static void TestThreads()
+{
+	CANRing ring(STRESS_CAPACITY);
+	UINT64 rejected = 0, popped = 0, disorders = 0;
+
+	std::thread producer([&]()
+	{
+		TPCANMsgFDEntry entries[STRESS_BATCH];
+		UINT64 hostTimes[STRESS_BATCH];
+		UINT64 pushed = 0;
+		DWORD size, stored;
+
+		while (pushed < STRESS_MESSAGES)
+		{
+			size = 1 + (DWORD)(pushed % STRESS_BATCH);
+			if (size > STRESS_MESSAGES - pushed)
+				size = (DWORD)(STRESS_MESSAGES - pushed);
+			Number(entries, hostTimes, size, pushed);
+			stored = ring.Push(entries, hostTimes, size);
+			rejected += size - stored;
+			pushed += stored;
+			if (stored < size)
+				std::this_thread::yield();
+		}
+	});
+
+	{
+		TPCANMsgFDEntry entries[100];
+		UINT64 hostTimes[100];
+		DWORD count;
+
+		while (popped < STRESS_MESSAGES)
+		{
+			count = ring.Pop(entries, hostTimes, 1 + (DWORD)(popped % 100));
+			if (count == 0)
+				std::this_thread::yield();
+			else if (!IsNumbered(entries, hostTimes, count, popped))
+				disorders++;
+			popped += count;
+		}
+	}
+	producer.join();
+
+	printf("%llu messages through a ring of %u, %llu rejected by a full ring, high-water mark %u\n",
+		(unsigned long long)popped, STRESS_CAPACITY, (unsigned long long)rejected, ring.GetHighWaterMark());
+	CHECK_EQUAL((UINT64)STRESS_MESSAGES, popped);
+	CHECK_EQUAL(0ULL, disorders);
+	CHECK_EQUAL(rejected, ring.GetOverflows());
+	CHECK(ring.GetHighWaterMark() > 0 && ring.GetHighWaterMark() <= STRESS_CAPACITY);
+	CHECK_EQUAL(0u, ring.GetDepth());
+}
+
+int main()
+{
+	TestCapacity();
+	TestWraparound();
+	TestOverflow();
+	TestHighWaterMark();
+	TestThreads();
+
+	return TestResult("CANRingTest");
+}
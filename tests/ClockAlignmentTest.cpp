@@ -0,0 +1,187 @@
+//  ClockAlignmentTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the adapter to host clock estimator on simulated adapters:
+//  a known offset and drift, the host stamping each frame after a fixed
+//  latency plus an exponential one (200 us mean) for the USB transfer and
+//  the scheduling. The drift is recovered, the mapped times follow the
+//  lower envelope of the latency, and the fit starts again when the
+//  adapter clock steps back
+//
+//  ~~~~~~~~~~~~
+//
+#include "ClockAlignment.h"
+#include "TestCheck.h"
+
+#include <math.h>
+#include <random>
+
+#define FRAME_PERIOD_NS		1000000ULL
+#define SECOND_NS			1000000000ULL
+#define BASE_LATENCY_NS		50000.0
+#define MEAN_JITTER_NS		200000.0
+
+// Adapter whose clock started at the given host time and runs fast by
+// the given ppm, the host stamps of its frames being delayed at random
+//
+class SimulatedAdapter
+{
+	private:
+		UINT64 m_Origin;
+		double m_DriftPpm;
+		std::mt19937 m_Random;
+		std::exponential_distribution<double> m_Jitter;
+
+	public:
+		SimulatedAdapter(UINT64 Origin, double DriftPpm, unsigned Seed)
+			: m_Origin(Origin), m_DriftPpm(DriftPpm), m_Random(Seed), m_Jitter(1.0 / MEAN_JITTER_NS)
+		{
+		}
+
+		TPCANTimestampFD GetAdapterTime(UINT64 Reception)
+		{
+			return (TPCANTimestampFD)((Reception - m_Origin) / 1000.0 * (1.0 + m_DriftPpm * 1e-6));
+		}
+
+		UINT64 GetHostTime(UINT64 Reception, bool Jitter)
+		{
+			return Reception + (UINT64)(BASE_LATENCY_NS + (Jitter ? m_Jitter(m_Random) : 0));
+		}
+};
+
+// Feeds the frames of a span of host time. Returns the RMS of the error
+// of the mapped times to the reception times plus the fixed latency,
+// over the last second
+//
+static double Feed(ClockAlignment &Align, SimulatedAdapter &Adapter, UINT64 Start, UINT64 Span, bool Jitter, double *MaxError)
+{
+	double error, sumSquares = 0;
+	int count = 0;
+
+	*MaxError = 0;
+	for (UINT64 reception = Start; reception < Start + Span; reception += FRAME_PERIOD_NS)
+	{
+		TPCANTimestampFD adapter = Adapter.GetAdapterTime(reception);
+
+		Align.AddSample(adapter, Adapter.GetHostTime(reception, Jitter));
+		if (reception + SECOND_NS >= Start + Span)
+		{
+			error = (double)(INT64)(Align.ToHost(adapter) - reception) - BASE_LATENCY_NS;
+			sumSquares += error * error;
+			if (fabs(error) > *MaxError)
+				*MaxError = fabs(error);
+			count++;
+		}
+	}
+
+	return sqrt(sumSquares / count);
+}
+
+// Without jitter, only the microsecond resolution of the adapter remains
+//
+static void TestExact()
+{
+	ClockAlignment align;
+	SimulatedAdapter adapter(5 * SECOND_NS, 80.0, 1);
+	ClockAlignmentStats stats;
+	double rms, maxError;
+
+	rms = Feed(align, adapter, 7 * SECOND_NS, 10 * SECOND_NS, false, &maxError);
+	stats = align.GetStatistics();
+	printf("Exact: drift %.3f ppm, residual RMS %.0f ns, mapping error RMS %.0f ns, max %.0f ns\n",
+		stats.DriftPpm, stats.ResidualRms, rms, maxError);
+
+	CHECK_EQUAL((DWORD)CLOCK_ALIGN_WINDOW, stats.Samples);
+	CHECK_EQUAL(0u, stats.Resets);
+	CHECK(fabs(stats.DriftPpm - 80.0) < 0.5);
+	CHECK(stats.ResidualRms < 1000);
+	CHECK(stats.ResidualMax < 1000);
+	CHECK(maxError < 1000);
+}
+
+// With jitter, the fit follows the least delayed stamps of each interval
+//
+static void TestJitter()
+{
+	const double drifts[] = { -120.0, 0.0, 35.0, 250.0 };
+
+	for (int i = 0; i < 4; i++)
+	{
+		ClockAlignment align;
+		SimulatedAdapter adapter(1 * SECOND_NS, drifts[i], 100 + i);
+		ClockAlignmentStats stats;
+		double rms, maxError;
+		UINT64 frames = 20 * SECOND_NS / FRAME_PERIOD_NS;
+		UINT64 perInterval = (UINT64)ceil(CLOCK_ALIGN_INTERVAL / (1000.0 * (1.0 + drifts[i] * 1e-6)));
+
+		rms = Feed(align, adapter, 3 * SECOND_NS, frames * FRAME_PERIOD_NS, true, &maxError);
+		stats = align.GetStatistics();
+		printf("Drift %+.0f ppm: recovered %+.2f ppm, residual RMS %.1f us, max %.1f us, mapping error RMS %.1f us, max %.1f us\n",
+			drifts[i], stats.DriftPpm, stats.ResidualRms / 1e3, stats.ResidualMax / 1e3, rms / 1e3, maxError / 1e3);
+
+		// The first frame, then one per interval of 10 frames, or 11 when
+		// the adapter is slow, the last 256 in the window
+		//
+		CHECK_EQUAL((DWORD)CLOCK_ALIGN_WINDOW, stats.Samples);
+		CHECK_EQUAL(1 + (frames - 1) / perInterval, stats.TotalSamples);
+		CHECK(fabs(stats.DriftPpm - drifts[i]) < 10.0);
+
+		// The least of 10 exponential delays has a tenth of their mean,
+		// which the residuals and the mapping error are bound to
+		//
+		CHECK(stats.ResidualRms > 1000 && stats.ResidualRms < MEAN_JITTER_NS / 5);
+		CHECK(stats.ResidualMax >= stats.ResidualRms && stats.ResidualMax < MEAN_JITTER_NS);
+		CHECK(rms < MEAN_JITTER_NS / 4);
+		CHECK(maxError < MEAN_JITTER_NS / 2);
+	}
+}
+
+// An adapter clock stepping back, as when the channel is reset, starts
+// the fit again
+//
+static void TestReset()
+{
+	ClockAlignment align;
+	SimulatedAdapter first(0, 40.0, 7), second(12 * SECOND_NS, -60.0, 8);
+	ClockAlignmentStats stats;
+	double rms, maxError;
+
+	Feed(align, first, 1 * SECOND_NS, 10 * SECOND_NS, true, &maxError);
+	CHECK_EQUAL(0u, align.GetStatistics().Resets);
+
+	// The first frame of the new clock resets the window
+	//
+	align.AddSample(second.GetAdapterTime(12 * SECOND_NS + FRAME_PERIOD_NS), second.GetHostTime(12 * SECOND_NS + FRAME_PERIOD_NS, false));
+	stats = align.GetStatistics();
+	CHECK_EQUAL(1u, stats.Resets);
+	CHECK_EQUAL(1u, stats.Samples);
+	CHECK_EQUAL(1ULL, stats.TotalSamples);
+	CHECK_EQUAL(0.0, stats.DriftPpm);
+	CHECK_EQUAL(0.0, stats.ResidualRms);
+
+	// The new drift is then recovered
+	//
+	rms = Feed(align, second, 12 * SECOND_NS + 2 * FRAME_PERIOD_NS, 10 * SECOND_NS, true, &maxError);
+	stats = align.GetStatistics();
+	CHECK_EQUAL(1u, stats.Resets);
+	CHECK_EQUAL((DWORD)CLOCK_ALIGN_WINDOW, stats.Samples);
+	CHECK(fabs(stats.DriftPpm + 60.0) < 10.0);
+	CHECK(rms < MEAN_JITTER_NS / 4);
+
+	// An explicit reset keeps the count of the discontinuities
+	//
+	align.Reset();
+	stats = align.GetStatistics();
+	CHECK_EQUAL(1u, stats.Resets);
+	CHECK_EQUAL(0u, stats.Samples);
+}
+
+int main()
+{
+	TestExact();
+	TestJitter();
+	TestReset();
+
+	return TestResult("ClockAlignmentTest");
+}
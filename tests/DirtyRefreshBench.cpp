@@ -0,0 +1,95 @@
+﻿//  DirtyRefreshBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of a display refresh with 1000 known IDs of which 6 are
+//  active: every entry visited for its updated flag, as DisplayMessages
+//  did, against the rows of the dirty set published by the display
+//  model
+//
+//  ~~~~~~~~~~~~
+//
+#include "DisplayModel.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+#define BENCH_KNOWN			1000
+#define BENCH_ACTIVE		6
+#define BENCH_REFRESHES		100000
+
+// Entry of the old list, with the flag set by ProcessMessage
+//
+typedef struct tagFlaggedStatus
+{
+	MessageStatus Status;
+	bool MarkedAsUpdated;
+} FlaggedStatus;
+
+int main()
+{
+	std::vector<FlaggedStatus> list;
+	std::vector<MessageStatus> rendered;
+	MessageTable<MessageStatus> table;
+	DisplayModel model;
+	std::shared_ptr<const DisplaySnapshot> snapshot;
+	std::chrono::steady_clock::time_point start;
+	TPCANMsg frame = {};
+	UINT64 now = 0, rows = 0;
+	double scan, dirty;
+
+	frame.LEN = 8;
+	for (int i = 0; i < BENCH_KNOWN; i++)
+	{
+		frame.ID = i;
+		FlaggedStatus entry = { MessageStatus(MakeFrameView(frame), 0, i), false };
+		list.push_back(entry);
+		table.Add(i, PCAN_MESSAGE_STANDARD, entry.Status);
+	}
+
+	start = std::chrono::steady_clock::now();
+	for (int refresh = 0; refresh < BENCH_REFRESHES; refresh++)
+	{
+		for (int i = 0; i < BENCH_ACTIVE; i++)
+		{
+			list[0x301 + i].Status.Update(MakeFrameView(frame), refresh);
+			list[0x301 + i].MarkedAsUpdated = true;
+		}
+
+		rendered.clear();
+		for (size_t i = 0; i < list.size(); i++)
+			if (list[i].MarkedAsUpdated)
+			{
+				rendered.push_back(list[i].Status);
+				list[i].MarkedAsUpdated = false;
+			}
+		rows += rendered.size();
+	}
+	scan = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_REFRESHES;
+
+	start = std::chrono::steady_clock::now();
+	for (int refresh = 0; refresh < BENCH_REFRESHES; refresh++)
+	{
+		for (int i = 0; i < BENCH_ACTIVE; i++)
+		{
+			table[0x301 + i].Update(MakeFrameView(frame), refresh);
+			model.MarkChanged(0x301 + i);
+		}
+
+		now += DISPLAY_PUBLISH_INTERVAL;
+		model.Publish(table, now);
+		snapshot = model.Acquire();
+		if (snapshot != NULL)
+		{
+			rows += snapshot->Rows.size();
+			model.Acknowledge(snapshot->Sequence);
+		}
+	}
+	dirty = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_REFRESHES;
+
+	printf("%d known IDs, %d active: flag scan %.0f ns/refresh, dirty set %.0f ns/refresh, %llu rows\n",
+		BENCH_KNOWN, BENCH_ACTIVE, scan, dirty, (unsigned long long)rows);
+
+	return 0;
+}
@@ -0,0 +1,94 @@
+//  DirtySetTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the dirty set, and of the snapshots of the display model
+//  built from it: only the rows marked since the last acknowledged
+//  snapshot are published
+//
+//  ~~~~~~~~~~~~
+//
+#include "DirtySet.h"
+#include "DisplayModel.h"
+#include "TestCheck.h"
+
+static void TestDirtySet()
+{
+	DirtySet set;
+
+	CHECK_EQUAL(0, set.GetCount());
+	CHECK(!set.IsMarked(5000));
+
+	set.Mark(70);
+	set.Mark(3);
+	set.Mark(70);
+	set.Mark(5000);
+	set.Mark(64);
+	CHECK_EQUAL(4, set.GetCount());
+	CHECK_EQUAL(70, set.GetIndexes()[0]);
+	CHECK_EQUAL(3, set.GetIndexes()[1]);
+	CHECK_EQUAL(5000, set.GetIndexes()[2]);
+	CHECK_EQUAL(64, set.GetIndexes()[3]);
+	CHECK(set.IsMarked(64) && set.IsMarked(70) && !set.IsMarked(65) && !set.IsMarked(71));
+
+	set.Clear();
+	CHECK_EQUAL(0, set.GetCount());
+	CHECK(!set.IsMarked(70) && !set.IsMarked(3) && !set.IsMarked(5000) && !set.IsMarked(64));
+	set.Mark(3);
+	CHECK_EQUAL(1, set.GetCount());
+}
+
+static void TestSnapshots()
+{
+	MessageTable<MessageStatus> table;
+	DisplayModel model;
+	std::shared_ptr<const DisplaySnapshot> snapshot;
+	TPCANMsg frame = {};
+	UINT64 now = 0;
+
+	// 1000 known IDs, all new in the first snapshot
+	//
+	frame.LEN = 8;
+	for (int i = 0; i < 1000; i++)
+	{
+		frame.ID = i;
+		model.MarkChanged(table.Add(i, PCAN_MESSAGE_STANDARD, MessageStatus(MakeFrameView(frame), 0, i)));
+	}
+	now += DISPLAY_PUBLISH_INTERVAL;
+	CHECK(model.Publish(table, now));
+	snapshot = model.Acquire();
+	CHECK(snapshot != NULL);
+	CHECK_EQUAL(1000, snapshot->RowCount);
+	CHECK_EQUAL((size_t)1000, snapshot->Rows.size());
+	model.Acknowledge(snapshot->Sequence);
+
+	// Then only the 6 active ones
+	//
+	for (int i = 0; i < 6; i++)
+	{
+		frame.ID = 0x301 + i;
+		table[0x301 + i].Update(MakeFrameView(frame), 1);
+		model.MarkChanged(0x301 + i);
+	}
+	CHECK(!model.Publish(table, now + 1));
+	now += DISPLAY_PUBLISH_INTERVAL;
+	CHECK(model.Publish(table, now));
+	snapshot = model.Acquire();
+	CHECK_EQUAL((size_t)6, snapshot->Rows.size());
+	CHECK_EQUAL(0x301u, snapshot->Rows[0].GetID());
+	model.Acknowledge(snapshot->Sequence);
+
+	// Nothing changed, nothing published
+	//
+	now += DISPLAY_PUBLISH_INTERVAL;
+	CHECK(!model.Publish(table, now));
+	CHECK(model.Acquire() == NULL);
+}
+
+int main()
+{
+	TestDirtySet();
+	TestSnapshots();
+
+	return TestResult("DirtySetTest");
+}
@@ -0,0 +1,272 @@
+﻿//  DisplayModelTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the display model: its exchange counters, the rows carried
+//  by a snapshot replacing one the display did not take, the folding of
+//  the pending snapshots past DISPLAY_MAX_PENDING, the generation of a
+//  reset, and a pipeline thread publishing 2M updates of 2000 IDs while
+//  a display thread renders them, every row ending at its final count
+//
+//  ~~~~~~~~~~~~
+//
+#include "DisplayModel.h"
+#include "TestCheck.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define STRESS_IDS			2000
+#define STRESS_UPDATES		2000000
+#define STRESS_PER_PUBLISH	1000
+
+// Adds the row of an ID to the table, marking it changed
+//
+static void AddRow(MessageTable<MessageStatus> &Table, DisplayModel &Model, DWORD ID)
+{
+	TPCANMsg frame = {};
+
+	frame.ID = ID;
+	frame.LEN = 8;
+	Model.MarkChanged(Table.Add(ID, PCAN_MESSAGE_STANDARD, MessageStatus(MakeFrameView(frame), 0, Table.GetCount())));
+}
+
+// Updates a row of the table, marking it changed
+//
+static void UpdateRow(MessageTable<MessageStatus> &Table, DisplayModel &Model, int Row)
+{
+	TPCANMsg frame = {};
+
+	frame.ID = Table[Row].GetID();
+	frame.LEN = 8;
+	Table[Row].Update(MakeFrameView(frame), 1);
+	Model.MarkChanged(Row);
+}
+
+static void TestCounters()
+{
+	MessageTable<MessageStatus> table;
+	DisplayModel model;
+	std::shared_ptr<const DisplaySnapshot> snapshot;
+	DisplayModelStats stats;
+	UINT64 now = 0;
+
+	// Nothing published yet
+	//
+	CHECK(model.Acquire() == NULL);
+	stats = model.GetStatistics();
+	CHECK_EQUAL(0ULL, stats.Published);
+	CHECK_EQUAL(1ULL, stats.Idle);
+
+	// Rows 0 and 1 in a snapshot the display does not take, replaced by
+	// one adding row 2, which carries the three of them
+	//
+	AddRow(table, model, 0x100);
+	AddRow(table, model, 0x101);
+	CHECK(model.Publish(table, now += DISPLAY_PUBLISH_INTERVAL));
+	AddRow(table, model, 0x102);
+	CHECK(model.Publish(table, now += DISPLAY_PUBLISH_INTERVAL));
+	stats = model.GetStatistics();
+	CHECK_EQUAL(2ULL, stats.Published);
+	CHECK_EQUAL(1ULL, stats.Overwritten);
+	CHECK_EQUAL(5ULL, stats.RowsPublished);
+
+	snapshot = model.Acquire();
+	CHECK(snapshot != NULL);
+	CHECK_EQUAL(2ULL, snapshot->Sequence);
+	CHECK_EQUAL(3, snapshot->RowCount);
+	CHECK_EQUAL((size_t)3, snapshot->Rows.size());
+	for (size_t i = 0; i < snapshot->Rows.size(); i++)
+		CHECK_EQUAL((int)i, snapshot->Rows[i].GetPosition());
+	model.Acknowledge(snapshot->Sequence);
+
+	// Acknowledged, so a refresh finds nothing new, and the next snapshot
+	// only carries the row changed since
+	//
+	CHECK(model.Acquire() == NULL);
+	UpdateRow(table, model, 1);
+	CHECK(model.Publish(table, now += DISPLAY_PUBLISH_INTERVAL));
+	snapshot = model.Acquire();
+	CHECK(snapshot != NULL);
+	CHECK_EQUAL((size_t)1, snapshot->Rows.size());
+	CHECK_EQUAL(1, snapshot->Rows[0].GetPosition());
+	CHECK_EQUAL(2, snapshot->Rows[0].GetCount());
+
+	// Taken but not acknowledged yet, it is handed again
+	//
+	CHECK(model.Acquire() == snapshot);
+	model.Acknowledge(snapshot->Sequence);
+	CHECK(model.Acquire() == NULL);
+
+	stats = model.GetStatistics();
+	CHECK_EQUAL(3ULL, stats.Published);
+	CHECK_EQUAL(1ULL, stats.Overwritten);
+	CHECK_EQUAL(6ULL, stats.RowsPublished);
+	CHECK_EQUAL(3ULL, stats.Acquired);
+	CHECK_EQUAL(3ULL, stats.Idle);
+}
+
+static void TestFolding()
+{
+	MessageTable<MessageStatus> table;
+	DisplayModel model;
+	std::shared_ptr<const DisplaySnapshot> snapshot;
+	const int snapshots = DISPLAY_MAX_PENDING * 3;
+	UINT64 now = 0;
+
+	// One new row per snapshot, row 0 changing again in the last one, and
+	// the display taking none of them
+	//
+	for (int i = 0; i < snapshots; i++)
+	{
+		AddRow(table, model, 0x100 + i);
+		CHECK(model.Publish(table, now += DISPLAY_PUBLISH_INTERVAL));
+	}
+	UpdateRow(table, model, 0);
+	CHECK(model.Publish(table, now += DISPLAY_PUBLISH_INTERVAL));
+	CHECK_EQUAL((UINT64)snapshots, model.GetStatistics().Overwritten);
+
+	// Every row once, in order, row 0 at its last count
+	//
+	snapshot = model.Acquire();
+	CHECK(snapshot != NULL);
+	CHECK_EQUAL((UINT64)snapshots + 1, snapshot->Sequence);
+	CHECK_EQUAL((size_t)snapshots, snapshot->Rows.size());
+	for (size_t i = 0; i < snapshot->Rows.size(); i++)
+		CHECK_EQUAL((int)i, snapshot->Rows[i].GetPosition());
+	CHECK_EQUAL(2, snapshot->Rows[0].GetCount());
+	model.Acknowledge(snapshot->Sequence);
+
+	// Once acknowledged, the folded rows are forgotten
+	//
+	UpdateRow(table, model, 5);
+	CHECK(model.Publish(table, now += DISPLAY_PUBLISH_INTERVAL));
+	snapshot = model.Acquire();
+	CHECK(snapshot != NULL);
+	CHECK_EQUAL((size_t)1, snapshot->Rows.size());
+	CHECK_EQUAL(5, snapshot->Rows[0].GetPosition());
+}
+
+static void TestReset()
+{
+	MessageTable<MessageStatus> table;
+	DisplayModel model;
+	std::shared_ptr<const DisplaySnapshot> snapshot;
+	UINT64 now = 0;
+
+	AddRow(table, model, 0x100);
+	AddRow(table, model, 0x101);
+	CHECK(model.Publish(table, now += DISPLAY_PUBLISH_INTERVAL));
+	snapshot = model.Acquire();
+	CHECK_EQUAL(0ULL, snapshot->Generation);
+	model.Acknowledge(snapshot->Sequence);
+
+	// The empty snapshot of the new generation is published at once,
+	// and the rows marked before the reset are forgotten
+	//
+	UpdateRow(table, model, 1);
+	table.Clear();
+	model.Reset();
+	snapshot = model.Acquire();
+	CHECK(snapshot != NULL);
+	CHECK_EQUAL(1ULL, snapshot->Generation);
+	CHECK_EQUAL(0, snapshot->RowCount);
+	CHECK(snapshot->Rows.empty());
+	model.Acknowledge(snapshot->Sequence);
+
+	// Without waiting for the publish interval, the new rows follow
+	//
+	AddRow(table, model, 0x200);
+	CHECK(model.Publish(table, now));
+	snapshot = model.Acquire();
+	CHECK(snapshot != NULL);
+	if (snapshot != NULL)
+	{
+		CHECK_EQUAL(1ULL, snapshot->Generation);
+		CHECK_EQUAL((size_t)1, snapshot->Rows.size());
+		CHECK_EQUAL(0x200u, snapshot->Rows[0].GetID());
+	}
+
+	model.Reset();
+	snapshot = model.Acquire();
+	CHECK(snapshot != NULL && snapshot->Generation == 2);
+}
+
+static void TestStress()
+{
+	MessageTable<MessageStatus> table;
+	DisplayModel model;
+	std::atomic<bool> writing(true);
+	std::vector<int> rendered(STRESS_IDS, 0);
+	int regressions = 0, complete = 0;
+	UINT64 sequence = 0, snapshots = 0;
+
+	// The pipeline: every ID once, then updates in turn, publishing at
+	// a simulated rate of a snapshot per STRESS_PER_PUBLISH updates
+	//
+	std::thread pipeline([&]()
+	{
+		UINT64 now = 0;
+
+		for (int i = 0; i < STRESS_IDS; i++)
+			AddRow(table, model, i);
+		for (int i = 0; i < STRESS_UPDATES; i++)
+		{
+			UpdateRow(table, model, i % STRESS_IDS);
+			if (i % STRESS_PER_PUBLISH == 0)
+				model.Publish(table, now += DISPLAY_PUBLISH_INTERVAL);
+		}
+		model.Publish(table, now += DISPLAY_PUBLISH_INTERVAL);
+		writing.store(false);
+	});
+
+	// The display: renders the rows of each snapshot it takes, until the
+	// pipeline is done and every row reached its final count
+	//
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+	while (std::chrono::steady_clock::now() < deadline)
+	{
+		bool done = !writing.load();
+		std::shared_ptr<const DisplaySnapshot> snapshot = model.Acquire();
+
+		if (snapshot != NULL)
+		{
+			if (snapshot->Sequence <= sequence)
+				regressions++;
+			sequence = snapshot->Sequence;
+			snapshots++;
+			for (std::vector<MessageStatus>::const_iterator i = snapshot->Rows.begin(); i != snapshot->Rows.end(); ++i)
+			{
+				if (i->GetCount() < rendered[i->GetPosition()])
+					regressions++;
+				rendered[i->GetPosition()] = i->GetCount();
+			}
+			model.Acknowledge(snapshot->Sequence);
+		}
+		else if (done)
+			break;
+		else
+			std::this_thread::yield();
+	}
+	pipeline.join();
+
+	for (int i = 0; i < STRESS_IDS; i++)
+		if (rendered[i] == 1 + STRESS_UPDATES / STRESS_IDS && table[i].GetCount() == rendered[i])
+			complete++;
+	CHECK_EQUAL(STRESS_IDS, complete);
+	CHECK_EQUAL(0, regressions);
+	CHECK(snapshots > 0);
+	CHECK_EQUAL(snapshots, model.GetStatistics().Acquired);
+}
+
+int main()
+{
+	TestCounters();
+	TestFolding();
+	TestReset();
+	TestStress();
+
+	return TestResult("DisplayModelTest");
+}
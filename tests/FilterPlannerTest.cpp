@@ -0,0 +1,216 @@
+﻿//  FilterPlannerTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the filter planner: the plans hold at most the ranges a
+//  source can take for each identifier length and cover every ID
+//  subscribed, the SocketCAN limit fits the kernel filter list, and a
+//  synthetic load through a GeneratorSource keeps every subscribed frame
+//  while the rest of the traffic is dropped by the filter
+//
+//  ~~~~~~~~~~~~
+//
+#include "FilterPlanner.h"
+#include "GeneratorSource.h"
+#include "SocketCANSource.h"
+#include "TestCheck.h"
+
+#include <chrono>
+#include <random>
+
+// Source counting the ranges given, per identifier length
+//
+class CountingSource : public CANSource
+{
+	public:
+		DWORD MaxRanges;
+		DWORD Calls[2];
+
+		CountingSource(DWORD Max) : MaxRanges(Max) { Calls[0] = Calls[1] = 0; }
+
+		TPCANStatus Initialize() { return PCAN_ERROR_OK; }
+		TPCANStatus Uninitialize() { return PCAN_ERROR_OK; }
+		TPCANStatus ReadBatch(TPCANMsgFDEntry*, DWORD, DWORD* Count) { *Count = 0; return PCAN_ERROR_QRCVEMPTY; }
+		TPCANStatus FilterMessages(DWORD, DWORD, TPCANMode Mode) { Calls[Mode == PCAN_MODE_EXTENDED ? 1 : 0]++; return PCAN_ERROR_OK; }
+		DWORD GetMaxFilterRanges() const { return MaxRanges; }
+		TPCANStatus WaitForMessages(DWORD) { return PCAN_ERROR_QRCVEMPTY; }
+		void CancelWait() {}
+		const char* GetName() const { return "Counting"; }
+};
+
+static bool IsPlanned(const std::vector<CANFilterRange> &Plan, DWORD ID, TPCANMode Mode)
+{
+	for (size_t i = 0; i < Plan.size(); i++)
+		if (Plan[i].Mode == Mode && ID >= Plan[i].FromID && ID <= Plan[i].ToID)
+			return true;
+
+	return false;
+}
+
+// Random subscriptions of both lengths: each plan keeps within the limit
+// per length, covers the IDs subscribed, and is exact when the limit is
+// not reached
+//
+static void TestLimits()
+{
+	std::mt19937 random(9);
+	std::vector<CANFilterRange> plan;
+	std::vector<std::pair<DWORD, DWORD> > subscribed[2];
+	const TPCANMode modes[2] = { PCAN_MODE_STANDARD, PCAN_MODE_EXTENDED };
+	const DWORD spaces[2] = { 0x800, 0x20000000 };
+	DWORD counts[2], from, maxRanges;
+	bool covered = true, exact = true;
+
+	for (int round = 0; round < 500; round++)
+	{
+		FilterPlanner planner;
+
+		for (int m = 0; m < 2; m++)
+		{
+			subscribed[m].clear();
+			for (DWORD i = random() % 12; i > 0; i--)
+			{
+				from = random() % spaces[m];
+				subscribed[m].push_back(std::make_pair(from, std::min(spaces[m] - 1, from + (DWORD)(random() % 16))));
+				planner.Subscribe(subscribed[m].back().first, subscribed[m].back().second, modes[m]);
+			}
+		}
+
+		maxRanges = 1 + random() % 16;
+		CountingSource source(maxRanges);
+		CHECK_EQUAL((TPCANStatus)PCAN_ERROR_OK, planner.Apply(&source, &plan));
+
+		counts[0] = counts[1] = 0;
+		for (size_t i = 0; i < plan.size(); i++)
+			counts[plan[i].Mode == PCAN_MODE_EXTENDED ? 1 : 0]++;
+		for (int m = 0; m < 2; m++)
+		{
+			CHECK(counts[m] <= maxRanges);
+			CHECK_EQUAL(counts[m], source.Calls[m]);
+			for (size_t i = 0; i < subscribed[m].size(); i++)
+				covered = covered && IsPlanned(plan, subscribed[m][i].first, modes[m]) && IsPlanned(plan, subscribed[m][i].second, modes[m]);
+		}
+
+		// With room for every range, no ID outside the subscriptions
+		// is planned
+		//
+		if (planner.Plan(32).size() == plan.size())
+			for (size_t i = 0; i < plan.size(); i++)
+			{
+				int m = plan[i].Mode == PCAN_MODE_EXTENDED ? 1 : 0;
+				bool inside = false;
+				for (size_t j = 0; j < subscribed[m].size(); j++)
+					inside = inside || (plan[i].FromID >= subscribed[m][j].first && plan[i].FromID <= subscribed[m][j].second);
+				exact = exact && inside;
+			}
+	}
+	CHECK(covered);
+	CHECK(exact);
+}
+
+// The worst ranges of both lengths, as many as SocketCAN takes, fit the
+// 512 id/mask pairs of the kernel
+//
+static void TestSocketCANBudget()
+{
+	SocketCANSource source("vcan0", false);
+	std::vector<struct can_filter> filters;
+	DWORD ranges = source.GetMaxFilterRanges();
+	DWORD standard = 0x800 / ranges, extended = 0x20000000 / ranges;
+
+	// Ranges from the second ID of a block to its last but one cost the
+	// most pairs
+	//
+	for (DWORD i = 0; i < ranges; i++)
+	{
+		SocketCANSource::RangeToFilters(i * standard + 1, (i + 1) * standard - 2, false, filters);
+		SocketCANSource::RangeToFilters(i * extended + 1, (i + 1) * extended - 2, true, filters);
+	}
+	CHECK(filters.size() <= 512);
+	printf("SocketCAN: %u ranges per length, %u pairs\n", (unsigned)ranges, (unsigned)filters.size());
+}
+
+// Frames of a stream before a time of the traffic
+//
+static void ReadUntil(CANSource &Source, UINT64 Until, std::vector<TPCANMsgFDEntry> &Frames)
+{
+	TPCANMsgFDEntry entries[1024];
+	DWORD count;
+
+	do
+	{
+		Source.ReadBatch(entries, 1024, &count);
+		for (DWORD i = 0; i < count; i++)
+			if (entries[i].Timestamp < Until)
+				Frames.push_back(entries[i]);
+	} while (count == 1024 && entries[count - 1].Timestamp < Until);
+}
+
+// Ten seconds of 50000 frames/s on 3000 IDs of both lengths, with the
+// VBOX at 100 Hz, read with and without the filter planned for the
+// VBOX and a few other IDs
+//
+static void TestSyntheticLoad()
+{
+	TimestampService clock;
+	TrafficConfig config = TrafficGenerator::GetDefaultConfig();
+	std::vector<TPCANMsgFDEntry> all, filtered, expected;
+	std::vector<CANFilterRange> plan;
+	FilterPlanner planner;
+	size_t vbox = 0;
+
+	config.GPSRate = 100;
+	config.XbowRate = 0;
+	config.BackgroundRate = 50000;
+	config.BackgroundIDs = 3000;
+	config.Seed = 3;
+
+	planner.Subscribe(0x301, 0x305, PCAN_MODE_STANDARD);
+	planner.Subscribe(0x100, 0x10F, PCAN_MODE_STANDARD);
+	planner.Subscribe(0x900, 0x90F, PCAN_MODE_EXTENDED);
+	planner.Subscribe(0xA00, 0xA0F, PCAN_MODE_EXTENDED);
+
+	GeneratorSource open(&clock, config, false), source(&clock, config, false);
+	open.Initialize();
+	source.Initialize();
+	CHECK_EQUAL((TPCANStatus)PCAN_ERROR_OK, planner.Apply(&source, &plan));
+	CHECK_EQUAL(2u, plan.size());
+
+	ReadUntil(open, 10000000, all);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	ReadUntil(source, 10000000, filtered);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// The filtered stream is the open one through the plan, and it has
+	// every subscribed frame
+	//
+	for (size_t i = 0; i < all.size(); i++)
+	{
+		TPCANMode mode = (all[i].Msg.MSGTYPE & PCAN_MESSAGE_EXTENDED) ? PCAN_MODE_EXTENDED : PCAN_MODE_STANDARD;
+		if (IsPlanned(plan, all[i].Msg.ID, mode))
+			expected.push_back(all[i]);
+		if (all[i].Msg.ID >= 0x301 && all[i].Msg.ID <= 0x305 && mode == PCAN_MODE_STANDARD)
+			vbox++;
+	}
+	CHECK_EQUAL(expected.size(), filtered.size());
+	bool same = expected.size() == filtered.size();
+	for (size_t i = 0; same && i < expected.size(); i++)
+		same = expected[i].Msg.ID == filtered[i].Msg.ID && expected[i].Timestamp == filtered[i].Timestamp;
+	CHECK(same);
+	CHECK_EQUAL((size_t)5000, vbox);
+	CHECK(filtered.size() < all.size() / 3);
+
+	printf("synthetic load: %u frames, %u passed the filter (%u VBOX), %.1f ns per frame generated\n",
+		(unsigned)all.size(), (unsigned)filtered.size(), (unsigned)vbox, seconds * 1e9 / all.size());
+	source.Uninitialize();
+	open.Uninitialize();
+}
+
+int main()
+{
+	TestLimits();
+	TestSocketCANBudget();
+	TestSyntheticLoad();
+
+	return TestResult("FilterPlannerTest");
+}
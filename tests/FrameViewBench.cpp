@@ -0,0 +1,131 @@
+﻿//  FrameViewBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of the processing of 8-byte standard frames into the status
+//  of their message: widened into a TPCANMsgFD, passed and stored by
+//  value as before, against a CANFrameView and a MessageStatus keeping
+//  the data bytes only. It reports the bytes moved and the time per frame
+//
+//  ~~~~~~~~~~~~
+//
+#include "MessageStatus.h"
+
+#include <chrono>
+#include <random>
+#include <string.h>
+#include <vector>
+
+#define BENCH_FRAMES		1000000
+#define BENCH_RUNS			20
+
+#if defined(__GNUC__)
+#define BENCH_NOINLINE		__attribute__((noinline))
+#else
+#define BENCH_NOINLINE		__declspec(noinline)
+#endif
+
+// The status as it was: the whole message kept, and given back by
+// value by the getter used to compare the IDs. Its members were defined
+// in the dialog translation unit, out of reach of the inliner
+//
+class WidenedStatus
+{
+	private:
+		TPCANMsgFD m_Msg;
+		TPCANTimestampFD m_TimeStamp;
+		TPCANTimestampFD m_oldTimeStamp;
+		int m_Count;
+
+	public:
+		WidenedStatus(TPCANMsgFD canMsg) : m_Msg(canMsg), m_TimeStamp(0), m_oldTimeStamp(0), m_Count(1) {}
+
+		BENCH_NOINLINE TPCANMsgFD GetCANMsg() { return m_Msg; }
+
+		BENCH_NOINLINE void Update(TPCANMsgFD canMsg, TPCANTimestampFD canTimestamp)
+		{
+			m_Msg = canMsg;
+			m_oldTimeStamp = m_TimeStamp;
+			m_TimeStamp = canTimestamp;
+			m_Count += 1;
+		}
+
+		int GetCount() const { return m_Count; }
+		const BYTE* GetData() const { return m_Msg.DATA; }
+};
+
+// ConvertToMsgFD and ProcessMessage as they were
+//
+static BENCH_NOINLINE void ConvertWidened(const TPCANMsg &msg, TPCANMsgFD *msgFD)
+{
+	memset(msgFD, 0, sizeof(*msgFD));
+	msgFD->ID = msg.ID;
+	msgFD->MSGTYPE = msg.MSGTYPE;
+	msgFD->DLC = msg.LEN;
+	memcpy(msgFD->DATA, msg.DATA, 8);
+}
+
+static BENCH_NOINLINE void ProcessWidened(TPCANMsgFD theMsg, TPCANTimestampFD itsTimeStamp, WidenedStatus &Status)
+{
+	if (Status.GetCANMsg().ID == theMsg.ID && Status.GetCANMsg().MSGTYPE == theMsg.MSGTYPE)
+		Status.Update(theMsg, itsTimeStamp);
+}
+
+static BENCH_NOINLINE void ProcessView(const CANFrameView &theMsg, TPCANTimestampFD itsTimeStamp, MessageStatus &Status)
+{
+	if (Status.GetID() == theMsg.ID && Status.GetMsgType() == theMsg.MSGTYPE)
+		Status.Update(theMsg, itsTimeStamp);
+}
+
+int main()
+{
+	std::mt19937 random(8);
+	std::vector<TPCANMsg> frames(BENCH_FRAMES);
+	TPCANMsgFD widened = {};
+	std::chrono::steady_clock::time_point start;
+	double before, after;
+
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		frames[i].ID = 0x301;
+		frames[i].MSGTYPE = PCAN_MESSAGE_STANDARD;
+		frames[i].LEN = 8;
+		for (int j = 0; j < 8; j++)
+			frames[i].DATA[j] = (BYTE)random();
+	}
+
+	widened.ID = 0x301;
+	WidenedStatus old(widened);
+	MessageStatus status(MakeFrameView(frames[0]), 0, 0);
+
+	start = std::chrono::steady_clock::now();
+	for (int run = 0; run < BENCH_RUNS; run++)
+		for (size_t i = 0; i < frames.size(); i++)
+		{
+			ConvertWidened(frames[i], &widened);
+			ProcessWidened(widened, i, old);
+		}
+	before = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_RUNS / BENCH_FRAMES;
+
+	start = std::chrono::steady_clock::now();
+	for (int run = 0; run < BENCH_RUNS; run++)
+		for (size_t i = 0; i < frames.size(); i++)
+			ProcessView(MakeFrameView(frames[i]), i, status);
+	after = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_RUNS / BENCH_FRAMES;
+
+	// Bytes written or copied per frame. Before: the zeroed message and
+	// its copies into the ProcessMessage and Update parameters, the
+	// two getter results, the stored message. After: the view, and the 8
+	// data bytes with the length stored
+	//
+	size_t bytesBefore = sizeof(TPCANMsgFD) * 6;
+	size_t bytesAfter = sizeof(CANFrameView) + 8 + 1;
+
+	printf("widened:    %5.2f ns/frame, %u bytes moved per frame\n", before, (unsigned)bytesBefore);
+	printf("frame view: %5.2f ns/frame, %u bytes moved per frame\n", after, (unsigned)bytesAfter);
+
+	bool same = old.GetCount() == status.GetCount() && memcmp(old.GetData(), status.GetData(), 8) == 0;
+	printf("final status %s\n", same ? "identical" : "DIFFERENT");
+
+	return same ? 0 : 1;
+}
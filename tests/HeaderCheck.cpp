@@ -0,0 +1,39 @@
+//  HeaderCheck.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Includes the portable headers the way PCANBasicExampleDlg.h does, in
+//  its order and followed by its using directive, so names clashing
+//  between them are found without building the dialog
+//
+//  ~~~~~~~~~~~~
+//
+#include "CANRing.h"
+#include "TimestampService.h"
+#include "ClockAlignment.h"
+#include "FilterPlanner.h"
+#include "SessionReplay.h"
+#include "GeneratorSource.h"
+#include "MessageStatus.h"
+#include "MessageTable.h"
+#include "DisplayModel.h"
+#include "TimingStatistics.h"
+#include "VBoxDecoder.h"
+#include "VBoxBatch.h"
+#include "VBoxEpoch.h"
+#include "VBoxDistance.h"
+#include "XbowParser.h"
+#include "HexCodec.h"
+#include "SignalPlan.h"
+#include "DbcLoader.h"
+
+#include <bitset>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+int main()
+{
+	return 0;
+}
@@ -0,0 +1,197 @@
+﻿//  HexCodecTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the hexadecimal text: the spaced encoding of every path the
+//  processor has against printf for every length from 0 to 199 and
+//  every alignment of the data, the other encodings against printf, and
+//  the strict decoding of values and bytes, with the errors it reports
+//
+//  ~~~~~~~~~~~~
+//
+#include "HexCodec.h"
+#include "CPUFeatures.h"
+#include "TestCheck.h"
+
+#include <random>
+#include <stdio.h>
+#include <string>
+
+#define TEST_MAX_LENGTH		200
+#define TEST_CANARY			'#'
+
+static std::string FormatSpaced(const BYTE *Data, size_t Count)
+{
+	std::string text;
+	char byte[4];
+
+	for (size_t i = 0; i < Count; i++)
+	{
+		snprintf(byte, sizeof(byte), (i + 1 < Count) ? "%02X " : "%02X", Data[i]);
+		text += byte;
+	}
+
+	return text;
+}
+
+static void TestEncodeSpaced()
+{
+	static const char *names[] = { "scalar", "SSSE3", "AVX2" };
+	std::mt19937 random(23);
+	BYTE data[TEST_MAX_LENGTH + 4];
+	char text[3 * (TEST_MAX_LENGTH + 4) + 16];
+	int mismatches;
+
+	for (int path = CPU_VECTOR_SCALAR; path <= CPU_VECTOR_AVX2; path++)
+	{
+		SetHexEncodePath(path);
+		if (GetHexEncodePath() != path)
+		{
+			printf("No %s path on this processor\n", names[path]);
+			continue;
+		}
+
+		mismatches = 0;
+		for (int pass = 0; pass < 4; pass++)
+			for (size_t count = 0; count < TEST_MAX_LENGTH; count++)
+				for (size_t offset = 0; offset < 4; offset++)
+				{
+					// A pattern first, then random data
+					//
+					for (size_t i = 0; i < sizeof(data); i++)
+						data[i] = (pass == 0) ? (BYTE)(i * 97 + count) : (BYTE)random();
+
+					memset(text, TEST_CANARY, sizeof(text));
+					size_t length = HexEncodeSpaced(&data[offset], count, text);
+					std::string expected = FormatSpaced(&data[offset], count);
+
+					if (length != expected.size() || expected != text || text[(count == 0) ? 1 : 3 * count] != TEST_CANARY)
+						mismatches++;
+				}
+		printf("%s path: %d mismatches\n", names[path], mismatches);
+		CHECK_EQUAL(0, mismatches);
+	}
+	SetHexEncodePath(CPU_VECTOR_AVX2);
+	CHECK_EQUAL(GetCPUVectorPath(), GetHexEncodePath());
+	SetHexEncodePath(-1);
+	CHECK_EQUAL(CPU_VECTOR_SCALAR, GetHexEncodePath());
+	SetHexEncodePath(CPU_VECTOR_AVX2);
+}
+
+static void TestEncode()
+{
+	static const DWORD values[] = { 0, 1, 0xF, 0x10, 0x7FF, 0x800, 0x1FFFFFFF, 0x12345678, 0xFFFFFFFF };
+	BYTE data[256];
+	char text[2 * 256 + 1], expected[32];
+
+	for (int i = 0; i < 256; i++)
+		data[i] = (BYTE)(255 - i);
+	CHECK_EQUAL((size_t)512, HexEncode(data, 256, text));
+	for (int i = 0; i < 256; i++)
+	{
+		snprintf(expected, sizeof(expected), "%02X", 255 - i);
+		CHECK(text[2 * i] == expected[0] && text[2 * i + 1] == expected[1]);
+	}
+	CHECK(text[512] == '\0');
+	CHECK_EQUAL((size_t)0, HexEncode(data, 0, text));
+	CHECK(text[0] == '\0');
+
+	for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+		for (int digits = 0; digits <= 10; digits++)
+		{
+			char value[16];
+
+			snprintf(expected, sizeof(expected), "%0*X", digits, values[i]);
+			CHECK_EQUAL(strlen(expected), HexEncodeValue(values[i], digits, value));
+			CHECK(strcmp(expected, value) == 0);
+		}
+}
+
+static void TestDecodeValue()
+{
+	DWORD value = 0xCAFE;
+
+	CHECK_EQUAL(HEX_OK, HexDecodeValue("1fffFFFF", 8, &value));
+	CHECK_EQUAL(0x1FFFFFFFu, value);
+	CHECK_EQUAL(HEX_OK, HexDecodeValue("0", 1, &value));
+	CHECK_EQUAL(0u, value);
+	CHECK_EQUAL(HEX_OK, HexDecodeValue("7FF123", 3, &value));
+	CHECK_EQUAL(0x7FFu, value);
+
+	// Errors leave the value as it was
+	//
+	value = 0xCAFE;
+	CHECK_EQUAL(HEX_ERROR_EMPTY, HexDecodeValue("", 0, &value));
+	CHECK_EQUAL(HEX_ERROR_RANGE, HexDecodeValue("100000000", 9, &value));
+	CHECK_EQUAL(HEX_ERROR_DIGIT, HexDecodeValue("12G", 3, &value));
+	CHECK_EQUAL(HEX_ERROR_DIGIT, HexDecodeValue("0x12", 4, &value));
+	CHECK_EQUAL(HEX_ERROR_DIGIT, HexDecodeValue(" 12", 3, &value));
+	CHECK_EQUAL(HEX_ERROR_DIGIT, HexDecodeValue("12 ", 3, &value));
+	CHECK_EQUAL(HEX_ERROR_DIGIT, HexDecodeValue("-1", 2, &value));
+	CHECK_EQUAL(HEX_ERROR_DIGIT, HexDecodeValue("1\0" "2", 3, &value));
+	CHECK_EQUAL(0xCAFEu, value);
+
+	// Only the 22 digits are digits
+	//
+	for (int c = 0; c < 256; c++)
+	{
+		char text = (char)c;
+		bool digit = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+
+		CHECK_EQUAL(digit ? HEX_OK : HEX_ERROR_DIGIT, HexDecodeValue(&text, 1, &value));
+	}
+}
+
+static void TestDecodeBytes()
+{
+	std::mt19937 random(32);
+	BYTE data[TEST_MAX_LENGTH], decoded[TEST_MAX_LENGTH];
+	char text[3 * TEST_MAX_LENGTH];
+	size_t count;
+
+	CHECK_EQUAL(HEX_OK, HexDecodeBytes("01 a2 FF", 8, decoded, 8, &count));
+	CHECK_EQUAL((size_t)3, count);
+	CHECK(decoded[0] == 0x01 && decoded[1] == 0xA2 && decoded[2] == 0xFF);
+	CHECK_EQUAL(HEX_OK, HexDecodeBytes("  0102  03 ", 11, decoded, 8, &count));
+	CHECK_EQUAL((size_t)3, count);
+	CHECK(decoded[0] == 0x01 && decoded[1] == 0x02 && decoded[2] == 0x03);
+
+	CHECK_EQUAL(HEX_ERROR_EMPTY, HexDecodeBytes("", 0, decoded, 8, &count));
+	CHECK_EQUAL(HEX_ERROR_EMPTY, HexDecodeBytes("   ", 3, decoded, 8, &count));
+	CHECK_EQUAL((size_t)0, count);
+	CHECK_EQUAL(HEX_ERROR_PAIR, HexDecodeBytes("01 2 03", 7, decoded, 8, &count));
+	CHECK_EQUAL((size_t)1, count);
+	CHECK_EQUAL(HEX_ERROR_PAIR, HexDecodeBytes("01020", 5, decoded, 8, &count));
+	CHECK_EQUAL((size_t)2, count);
+	CHECK_EQUAL(HEX_ERROR_DIGIT, HexDecodeBytes("01 0G", 5, decoded, 8, &count));
+	CHECK_EQUAL((size_t)1, count);
+	CHECK_EQUAL(HEX_ERROR_DIGIT, HexDecodeBytes("01,02", 5, decoded, 8, &count));
+	CHECK_EQUAL(HEX_ERROR_DIGIT, HexDecodeBytes("01\t02", 5, decoded, 8, &count));
+	CHECK_EQUAL(HEX_ERROR_DIGIT, HexDecodeBytes("G1", 2, decoded, 8, &count));
+	CHECK_EQUAL((size_t)0, count);
+	CHECK_EQUAL(HEX_ERROR_RANGE, HexDecodeBytes("01 02 03", 8, decoded, 2, &count));
+	CHECK_EQUAL((size_t)2, count);
+
+	// Whatever was encoded reads back
+	//
+	for (size_t length = 1; length < TEST_MAX_LENGTH; length++)
+	{
+		for (size_t i = 0; i < length; i++)
+			data[i] = (BYTE)random();
+		CHECK_EQUAL(HEX_OK, HexDecodeBytes(text, HexEncodeSpaced(data, length, text), decoded, length, &count));
+		CHECK_EQUAL(length, count);
+		CHECK(memcmp(data, decoded, length) == 0);
+		CHECK_EQUAL(HEX_OK, HexDecodeBytes(text, HexEncode(data, length, text), decoded, length, &count));
+		CHECK(count == length && memcmp(data, decoded, length) == 0);
+	}
+}
+
+int main()
+{
+	TestEncodeSpaced();
+	TestEncode();
+	TestDecodeValue();
+	TestDecodeBytes();
+
+	return TestResult("HexCodecTest");
+}
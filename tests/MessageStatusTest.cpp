@@ -0,0 +1,283 @@
+//  MessageStatusTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the message status record: every formatter against the text
+//  the dialog built with CString before, for every message type, DLC and
+//  64-byte CAN FD payloads, and into buffers of every size up to the
+//  full text. A counting operator new checks that recording frames and
+//  rendering them allocates nothing
+//
+//  ~~~~~~~~~~~~
+//
+#include "MessageStatus.h"
+#include "MessageTable.h"
+#include "TestCheck.h"
+
+#include <new>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<MessageStatus>::value, "MessageStatus must stay trivially copyable");
+
+// Allocations made through operator new since the start. The operators
+// stay out of line, so GCC does not pair their malloc and free with new
+// and delete
+//
+static unsigned long long g_Allocations = 0;
+
+__attribute__((noinline)) void* operator new(size_t Size)
+{
+	void *memory = malloc(Size > 0 ? Size : 1);
+
+	if (memory == NULL)
+		throw std::bad_alloc();
+	g_Allocations++;
+	return memory;
+}
+
+__attribute__((noinline)) void operator delete(void *Memory) noexcept
+{
+	free(Memory);
+}
+
+__attribute__((noinline)) void operator delete(void *Memory, size_t) noexcept
+{
+	free(Memory);
+}
+
+// The texts of the dialog's MessageStatus, CString::Format being snprintf
+//
+static std::string Format(const char *Format, ...) __attribute__((format(printf, 1, 2)));
+
+static std::string Format(const char *Format, ...)
+{
+	char text[256];
+	va_list args;
+
+	va_start(args, Format);
+	vsnprintf(text, sizeof(text), Format, args);
+	va_end(args);
+
+	return text;
+}
+
+static std::string OldTypeString(const TPCANMsgFD &Msg)
+{
+	std::string strTemp;
+
+	if ((Msg.MSGTYPE & PCAN_MESSAGE_STATUS) != 0)
+		return "STATUS";
+
+	if ((Msg.MSGTYPE & PCAN_MESSAGE_EXTENDED) != 0)
+		strTemp = "EXT";
+	else
+		strTemp = "STD";
+
+	if ((Msg.MSGTYPE & PCAN_MESSAGE_RTR) == PCAN_MESSAGE_RTR)
+		strTemp = (strTemp + "/RTR");
+	else if (Msg.MSGTYPE > PCAN_MESSAGE_EXTENDED)
+	{
+		strTemp.append(" [ ");
+		if (Msg.MSGTYPE & PCAN_MESSAGE_FD)
+			strTemp.append(" FD");
+		if (Msg.MSGTYPE & PCAN_MESSAGE_BRS)
+			strTemp.append(" BRS");
+		if (Msg.MSGTYPE & PCAN_MESSAGE_ESI)
+			strTemp.append(" ESI");
+		strTemp.append(" ]");
+	}
+
+	return strTemp;
+}
+
+static std::string OldIdString(const TPCANMsgFD &Msg)
+{
+	if ((Msg.MSGTYPE & PCAN_MESSAGE_EXTENDED) != 0)
+		return Format("%08Xh", (unsigned)Msg.ID);
+	return Format("%03Xh", (unsigned)Msg.ID);
+}
+
+static std::string OldDataString(const TPCANMsgFD &Msg)
+{
+	std::string strTemp;
+
+	if ((Msg.MSGTYPE & PCAN_MESSAGE_RTR) == PCAN_MESSAGE_RTR)
+		return "Remote Request";
+	for (int i = 0; i < GetLengthFromDLC(Msg.DLC, !(Msg.MSGTYPE & PCAN_MESSAGE_FD)); i++)
+		strTemp += Format(" %02X", Msg.DATA[i]);
+
+	return strTemp;
+}
+
+static std::string OldTimeString(TPCANTimestampFD TimeStamp, TPCANTimestampFD OldTimeStamp, bool ShowPeriod)
+{
+	double fTime = (TimeStamp / 1000.0);
+
+	if (ShowPeriod)
+		fTime -= (OldTimeStamp / 1000.0);
+	return Format("%.1f", fTime);
+}
+
+typedef size_t (MessageStatus::*Formatter)(char *Buffer, size_t Size) const;
+
+// Checks a formatter against the expected text, into buffers of every
+// size: the text is cut, whole bytes of data at a time, and nothing is
+// written past the buffer
+//
+static void CheckFormat(const MessageStatus &Status, Formatter Format, const std::string &Expected, size_t Unit, const char *Name)
+{
+	char buffer[MSG_DATA_TEXT_SIZE + 16];
+	size_t length, kept;
+	int failures = g_CheckFailures;
+
+	for (size_t size = 0; size <= Expected.size() + 1; size++)
+	{
+		memset(buffer, 'Z', sizeof(buffer));
+		length = (Status.*Format)(buffer, size);
+		kept = (size == 0) ? 0 : ((Expected.size() < size) ? Expected.size() : (size - 1) / Unit * Unit);
+
+		CHECK_EQUAL(kept, length);
+		if (size > 0)
+		{
+			CHECK(strlen(buffer) == length);
+			CHECK(Expected.compare(0, length, buffer, length) == 0);
+		}
+		CHECK(buffer[size] == 'Z');
+	}
+	if (g_CheckFailures != failures)
+		printf("%s: \"%s\" expected\n", Name, Expected.c_str());
+}
+
+static void CheckMessage(const TPCANMsgFD &Msg)
+{
+	MessageStatus status(MakeFrameView(Msg), 1000, 0);
+
+	CheckFormat(status, &MessageStatus::FormatType, OldTypeString(Msg), 1, "FormatType");
+	CheckFormat(status, &MessageStatus::FormatID, OldIdString(Msg), 1, "FormatID");
+	CheckFormat(status, &MessageStatus::FormatData, OldDataString(Msg), ((Msg.MSGTYPE & PCAN_MESSAGE_RTR) != 0) ? 1 : 3, "FormatData");
+}
+
+static void TestTypesAndData()
+{
+	const TPCANMessageType types[] = {
+		PCAN_MESSAGE_STANDARD, PCAN_MESSAGE_EXTENDED, PCAN_MESSAGE_RTR, PCAN_MESSAGE_EXTENDED | PCAN_MESSAGE_RTR,
+		PCAN_MESSAGE_FD, PCAN_MESSAGE_FD | PCAN_MESSAGE_BRS, PCAN_MESSAGE_FD | PCAN_MESSAGE_BRS | PCAN_MESSAGE_ESI,
+		PCAN_MESSAGE_EXTENDED | PCAN_MESSAGE_FD | PCAN_MESSAGE_BRS, PCAN_MESSAGE_FD | PCAN_MESSAGE_ESI, PCAN_MESSAGE_STATUS };
+	const DWORD ids[] = { 0, 0x301, 0x7FF, 0x18F00502, 0x1FFFFFFF };
+	TPCANMsgFD msg;
+
+	for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++)
+	{
+		for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); i++)
+		{
+			bool fd = (types[t] & PCAN_MESSAGE_FD) != 0;
+
+			if (ids[i] > 0x7FF && !(types[t] & PCAN_MESSAGE_EXTENDED))
+				continue;
+
+			// Every DLC, 15 being 64 bytes on CAN FD
+			//
+			for (BYTE dlc = 0; dlc <= (fd ? 15 : 8); dlc++)
+			{
+				msg = TPCANMsgFD();
+				msg.ID = ids[i];
+				msg.MSGTYPE = types[t];
+				msg.DLC = dlc;
+				for (int j = 0; j < 64; j++)
+					msg.DATA[j] = (BYTE)(0xF0 - j * 7);
+				CheckMessage(msg);
+			}
+		}
+	}
+
+	// The full text of a 64-byte payload fits MSG_DATA_TEXT_SIZE
+	//
+	char buffer[MSG_DATA_TEXT_SIZE];
+
+	msg = TPCANMsgFD();
+	msg.MSGTYPE = PCAN_MESSAGE_FD;
+	msg.DLC = 15;
+	memset(msg.DATA, 0xAB, sizeof(msg.DATA));
+	CHECK_EQUAL((size_t)64 * 3, MessageStatus(MakeFrameView(msg), 0, 0).FormatData(buffer, sizeof(buffer)));
+	CHECK(strncmp(buffer + 64 * 3 - 6, " AB AB", 7) == 0);
+}
+
+static void TestTime()
+{
+	const TPCANTimestampFD times[] = { 0, 1, 49, 50, 51, 999, 1000, 123456, 4294967295ULL, 1000000000000ULL };
+	TPCANMsgFD msg = TPCANMsgFD();
+
+	msg.DLC = 8;
+	for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); i++)
+	{
+		for (size_t j = i; j < sizeof(times) / sizeof(times[0]); j++)
+		{
+			MessageStatus status(MakeFrameView(msg), times[i], 0);
+
+			// The period between the two last frames, or the timestamp
+			//
+			status.Update(MakeFrameView(msg), times[j]);
+			CheckFormat(status, &MessageStatus::FormatTime, OldTimeString(times[j], times[i], true), 1, "FormatTime");
+			CHECK(status.SetShowingPeriod(false));
+			CHECK(!status.SetShowingPeriod(false));
+			CheckFormat(status, &MessageStatus::FormatTime, OldTimeString(times[j], times[i], false), 1, "FormatTime");
+		}
+	}
+}
+
+// Recording and rendering the frames of a bus with 100 IDs, once the
+// table holds them
+//
+static void TestNoAllocation()
+{
+	MessageTable<MessageStatus> table;
+	TPCANMsgFD msg = TPCANMsgFD();
+	char type[MSG_TYPE_TEXT_SIZE], id[MSG_ID_TEXT_SIZE], data[MSG_DATA_TEXT_SIZE], time[MSG_TIME_TEXT_SIZE];
+	unsigned long long before;
+	size_t length = 0;
+	int index;
+
+	msg.MSGTYPE = PCAN_MESSAGE_FD;
+	msg.DLC = 15;
+	table.Reserve(100);
+	for (DWORD i = 0; i < 100; i++)
+		table.Add(0x100 + i, msg.MSGTYPE, MessageStatus(MakeFrameView(msg), 0, i));
+
+	before = g_Allocations;
+	for (int i = 0; i < 100000; i++)
+	{
+		msg.ID = 0x100 + i % 100;
+		msg.DATA[i % 64] = (BYTE)i;
+		index = table.Find(msg.ID, msg.MSGTYPE);
+		if (index == MSG_TABLE_NONE)
+			continue;
+		table[index].Update(MakeFrameView(msg), i * 100ULL);
+
+		MessageStatus copy = table[index];
+		length += copy.FormatType(type, sizeof(type));
+		length += copy.FormatID(id, sizeof(id));
+		length += copy.FormatData(data, sizeof(data));
+		length += copy.FormatTime(time, sizeof(time));
+	}
+	CHECK_EQUAL(0ULL, g_Allocations - before);
+	CHECK(length > 0);
+
+	// The counter sees the allocations
+	//
+	std::string *text = new std::string(100, 'x');
+	CHECK(g_Allocations - before >= 2);
+	delete text;
+}
+
+int main()
+{
+	TestTypesAndData();
+	TestTime();
+	TestNoAllocation();
+
+	return TestResult("MessageStatusTest");
+}
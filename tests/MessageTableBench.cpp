@@ -0,0 +1,86 @@
+//  MessageTableBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of the lookup of the last status of a message, with 5 to
+//  2000 distinct IDs on the bus: the linear scan of a list of statuses
+//  allocated one by one, as m_LastMsgsList was, against the message
+//  table. Half of the IDs are standard and half extended
+//
+//  ~~~~~~~~~~~~
+//
+#include "MessageStatus.h"
+#include "MessageTable.h"
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <random>
+#include <vector>
+
+#define BENCH_FRAMES		2000000
+
+int main()
+{
+	static const int counts[] = { 5, 20, 100, 500, 1000, 2000 };
+	std::mt19937 random(4);
+	TPCANMsg frame = {};
+	std::chrono::steady_clock::time_point start;
+
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		std::vector<TPCANMsg> frames(BENCH_FRAMES);
+		std::list<MessageStatus*> list;
+		MessageTable<MessageStatus> table;
+		double scan, lookup;
+		int found = 0;
+
+		for (size_t i = 0; i < frames.size(); i++)
+		{
+			int id = random() % counts[c];
+			frame.ID = (id % 2 == 0) ? (DWORD)id : 0x100000 + id;
+			frame.MSGTYPE = (id % 2 == 0) ? PCAN_MESSAGE_STANDARD : PCAN_MESSAGE_EXTENDED;
+			frame.LEN = 8;
+			frames[i] = frame;
+		}
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < frames.size(); i++)
+		{
+			CANFrameView view = MakeFrameView(frames[i]);
+			std::list<MessageStatus*>::iterator it;
+
+			for (it = list.begin(); it != list.end(); ++it)
+				if ((*it)->GetID() == view.ID && (*it)->GetMsgType() == view.MSGTYPE)
+					break;
+			if (it != list.end())
+				(*it)->Update(view, i);
+			else
+				list.push_back(new MessageStatus(view, i, (int)list.size()));
+		}
+		scan = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_FRAMES;
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < frames.size(); i++)
+		{
+			CANFrameView view = MakeFrameView(frames[i]);
+			int index = table.Find(view.ID, view.MSGTYPE);
+
+			if (index != MSG_TABLE_NONE)
+				table[index].Update(view, i);
+			else
+				table.Add(view.ID, view.MSGTYPE, MessageStatus(view, i, table.GetCount()));
+		}
+		lookup = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_FRAMES;
+
+		for (std::list<MessageStatus*>::iterator it = list.begin(); it != list.end(); ++it)
+		{
+			found += (*it)->GetCount() == table[table.Find((*it)->GetID(), (*it)->GetMsgType())].GetCount();
+			delete *it;
+		}
+
+		printf("%4d IDs: list scan %7.1f ns/frame, table %5.1f ns/frame, %d counts equal\n", counts[c], scan, lookup, found);
+	}
+
+	return 0;
+}
@@ -0,0 +1,94 @@
+﻿//  MessageTableTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the message table against a linear list of the same keys:
+//  standard IDs sharing their slot with RTR and FD messages, extended
+//  and status messages through the growing hash, and a clear
+//
+//  ~~~~~~~~~~~~
+//
+#include "MessageTable.h"
+#include "TestCheck.h"
+
+#include <random>
+#include <utility>
+#include <vector>
+
+typedef std::pair<DWORD, TPCANMessageType> Key;
+
+static const TPCANMessageType Types[] =
+{
+	PCAN_MESSAGE_STANDARD,
+	PCAN_MESSAGE_RTR,
+	PCAN_MESSAGE_FD,
+	PCAN_MESSAGE_FD | PCAN_MESSAGE_BRS,
+	PCAN_MESSAGE_EXTENDED,
+	PCAN_MESSAGE_EXTENDED | PCAN_MESSAGE_RTR,
+	PCAN_MESSAGE_STATUS,
+};
+
+// Position of a key in the list, as the CPtrList scan found it
+//
+static int FindLinear(const std::vector<Key> &Keys, DWORD ID, TPCANMessageType MsgType)
+{
+	for (size_t i = 0; i < Keys.size(); i++)
+		if (Keys[i].first == ID && Keys[i].second == MsgType)
+			return (int)i;
+
+	return MSG_TABLE_NONE;
+}
+
+static void TestAgainstList(std::mt19937 &Random)
+{
+	MessageTable<int> table;
+	std::vector<Key> keys;
+	DWORD ID;
+	TPCANMessageType type;
+	int index, expected, mismatches = 0;
+
+	// Frames of random keys, the standard IDs going past 0x7FF and the
+	// extended ones sharing their low bits, so the chains, the hash
+	// collisions and its growth are exercised
+	//
+	for (int i = 0; i < 200000; i++)
+	{
+		type = Types[Random() % (sizeof(Types) / sizeof(Types[0]))];
+		ID = (type & PCAN_MESSAGE_EXTENDED) ? Random() % 1500 * 0x10000 : Random() % 0x900;
+		index = table.Find(ID, type);
+		expected = FindLinear(keys, ID, type);
+		if (index != expected)
+			mismatches++;
+		if (index == MSG_TABLE_NONE)
+		{
+			CHECK_EQUAL((int)keys.size(), table.Add(ID, type, (int)keys.size()));
+			keys.push_back(Key(ID, type));
+		}
+		else
+			table[index]++;
+	}
+	CHECK_EQUAL(0, mismatches);
+	CHECK_EQUAL((int)keys.size(), table.GetCount());
+	printf("%u keys checked\n", (unsigned)keys.size());
+
+	// Entries stay in reception order
+	//
+	for (int i = 0; i < table.GetCount(); i++)
+		CHECK_EQUAL(i, table.Find(keys[i].first, keys[i].second));
+
+	table.Clear();
+	CHECK_EQUAL(0, table.GetCount());
+	for (size_t i = 0; i < keys.size(); i++)
+		CHECK_EQUAL(MSG_TABLE_NONE, table.Find(keys[i].first, keys[i].second));
+	CHECK_EQUAL(0, table.Add(0x301, PCAN_MESSAGE_STANDARD, 7));
+	CHECK_EQUAL(7, table[table.Find(0x301, PCAN_MESSAGE_STANDARD)]);
+}
+
+int main()
+{
+	std::mt19937 random(12);
+
+	TestAgainstList(random);
+
+	return TestResult("MessageTableTest");
+}
@@ -0,0 +1,117 @@
+//  ReplayBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of the replay of a recorded trial: a generated 2.x trace of
+//  1M CAN messages every 100 us merged with an Acc.txt file of a packet
+//  every 10 ms, replayed unthrottled into a counting sink, then one
+//  second of it replayed in real time for the pacing error
+//
+//  ~~~~~~~~~~~~
+//
+#include "SessionReplay.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+
+#define BENCH_TRACE_FILE	"ReplayBench.trc"
+#define BENCH_XBOW_FILE		"ReplayBench_Acc.txt"
+#define BENCH_MESSAGES		1000000
+#define BENCH_MESSAGE_US	100
+#define BENCH_PACKET_MS		10
+
+// Receiver counting what it gets
+//
+class CountingSink : public ReplaySink
+{
+	public:
+		UINT64 Messages;
+
+		CountingSink() : Messages(0) {}
+
+		void OnReplayCAN(const TPCANMsgFDEntry*, const UINT64*, DWORD Count) { Messages += Count; }
+		void OnReplayXbow(const BYTE*, UINT64) { Messages++; }
+		void OnReplayFinished(const ReplayStats&) {}
+};
+
+// Writes a trace and an Xbow recording of the given length, the Xbow
+// epoch being the start time of the trace
+//
+static void WriteRecordings(int Messages)
+{
+	FILE *trace = fopen(BENCH_TRACE_FILE, "w");
+	FILE *xbow = fopen(BENCH_XBOW_FILE, "w");
+
+	fprintf(trace, ";$FILEVERSION=2.0\n;$STARTTIME=42247.5\n");
+	for (int i = 0; i < Messages; i++)
+		fprintf(trace, "%7d %13.3f DT     %04X Rx 8  %02X 00 00 00 00 00 00 %02X\n",
+			i + 1, i * BENCH_MESSAGE_US / 1000.0, 0x301 + i % 5, i & 0xFF, (i >> 8) & 0xFF);
+
+	fprintf(xbow, "Roll_Angle\tPitch_Angle\tRoll_Rate\tPitch_Rate\tYaw_Rate\tAcc_X\tACC_Y\tACC_Z\tTempature\tTime\tBadRatio\tRaw\tCPUTIME\n");
+	for (long long time = 0; time < (long long)Messages * BENCH_MESSAGE_US / 1000; time += BENCH_PACKET_MS)
+	{
+		fprintf(xbow, "0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\tFF");
+		for (int i = 1; i < XBOW_PACKET_SIZE; i++)
+			fprintf(xbow, " %02X", i);
+		fprintf(xbow, "\t%lld\n", time);
+	}
+
+	fclose(trace);
+	fclose(xbow);
+}
+
+static ReplayStats Replay(TimestampService *Clock, double Speed, UINT64 *Delivered)
+{
+	SessionReplay replay(Clock);
+	CountingSink sink;
+	ReplayStats stats;
+
+	if (replay.Open(BENCH_TRACE_FILE, BENCH_XBOW_FILE, 1441022400000LL) != PCAN_ERROR_OK ||
+		replay.Start(&sink, Speed) != PCAN_ERROR_OK)
+	{
+		printf("The recordings could not be replayed\n");
+		return ReplayStats();
+	}
+	while (replay.IsRunning())
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	replay.Stop();
+	stats = replay.GetStatistics();
+	*Delivered = sink.Messages;
+
+	return stats;
+}
+
+int main()
+{
+	TimestampService clock;
+	ReplayStats stats;
+	UINT64 delivered;
+	int result = 0;
+
+	WriteRecordings(BENCH_MESSAGES);
+	stats = Replay(&clock, REPLAY_UNTHROTTLED, &delivered);
+	printf("Unthrottled: %llu CAN messages and %llu Xbow packets, %.1f s of recording in %.3f s\n",
+		(unsigned long long)stats.CANMessages, (unsigned long long)stats.XbowPackets,
+		stats.RecordedTime / 1e9, stats.ElapsedTime / 1e9);
+	printf("             %.2f M/s, %.0fx real time, pacing error mean %llu ns, max %llu ns\n",
+		stats.Throughput / 1e6, stats.AchievedSpeed,
+		(unsigned long long)stats.PacingErrorMean, (unsigned long long)stats.PacingErrorMax);
+	if (!stats.Finished || delivered != stats.CANMessages + stats.XbowPackets)
+		result = 1;
+
+	WriteRecordings(1000000 / BENCH_MESSAGE_US);
+	stats = Replay(&clock, REPLAY_REALTIME, &delivered);
+	printf("Real time:   %llu CAN messages and %llu Xbow packets, %.3f s of recording in %.3f s\n",
+		(unsigned long long)stats.CANMessages, (unsigned long long)stats.XbowPackets,
+		stats.RecordedTime / 1e9, stats.ElapsedTime / 1e9);
+	printf("             pacing error mean %.1f us, max %.1f us, %llu late by more than 1 ms\n",
+		stats.PacingErrorMean / 1e3, stats.PacingErrorMax / 1e3, (unsigned long long)stats.LateEvents);
+	if (!stats.Finished || delivered != stats.CANMessages + stats.XbowPackets)
+		result = 1;
+
+	remove(BENCH_TRACE_FILE);
+	remove(BENCH_XBOW_FILE);
+
+	return result;
+}
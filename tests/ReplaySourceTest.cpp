@@ -0,0 +1,326 @@
+//  ReplaySourceTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the replay of a recorded trial on small inline recordings:
+//  the parsing of PCAN-Trace files of versions 1.1 and 2.x and of their
+//  start time, and the merge of the CAN messages with the Xbow packets
+//  of an Acc.txt file on one timeline, replayed unthrottled so that the
+//  host times given keep the original spacing
+//
+//  ~~~~~~~~~~~~
+//
+#include "SessionReplay.h"
+#include "TestCheck.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#define TRACE_FILE		"ReplaySourceTest.trc"
+#define XBOW_FILE		"ReplaySourceTest_Acc.txt"
+
+// 2015-08-31 12:49:27.500, the start time of the 1.1 trace, and
+// 2015-08-31 12:00:00, the one of the 2.x trace
+//
+#define START_TIME_11	1441025367500LL
+#define START_TIME_20	1441022400000LL
+
+static const char *Trace11 =
+	";$FILEVERSION=1.1\n"
+	";   Start time: 31.08.2015 12:49:27.500.0\n"
+	";   Message Number\n"
+	";   |         Time Offset (ms)\n"
+	";   |         |        Type\n"
+	";   |         |        |        ID (hex)\n"
+	";   |         |        |        |     Data Length\n"
+	";   |         |        |        |     |   Data Bytes (hex) ...\n"
+	";---+--   ----+----  --+--  ----+---  +  -+ -- -- -- -- -- -- --\n"
+	"     1)       100.5  Rx         0301  8  11 22 33 44 55 66 77 88\n"
+	"     2)       110.0  Rx     18F00502  3  01 02 03\n"
+	"     3)       120.0  Rx         0123  1  RTR\n"
+	"     4)       130.0  Warng  FFFFFFFF  4  00 00 00 08  BUSHEAVY\n"
+	"     5)       140.0  Rx         03G1  8  11 22 33 44 55 66 77 88\n"
+	"     6)       150.2  Tx         07FF  0\n";
+
+static const char *Trace20 =
+	";$FILEVERSION=2.0\n"
+	";$STARTTIME=42247.5\n"
+	";   Message Number\n"
+	";   |         Time Offset (ms)\n"
+	";   |         |       Type\n"
+	";   |         |       |        ID (hex)\n"
+	";   |         |       |        |     Rx/Tx\n"
+	";   |         |       |        |     |  Data Length Code\n"
+	";   |         |       |        |     |  |   Data Bytes (hex) ...\n"
+	";---+-- ------+------ +- --+----- +- +- +- -- -- -- -- -- -- --\n"
+	"      1      1059.900 DT     0301 Rx 8  11 22 33 44 55 66 77 88\n"
+	"      2      1060.000 FD     0302 Rx 9  00 01 02 03 04 05 06 07 08 09 0A 0B\n"
+	"      3      1060.100 BI 18F00503 Rx 2  AA BB\n"
+	"      4      1060.200 RR     0123 Rx 2\n"
+	"      5      1060.300 ER          Rx 04 00 02 00 00\n";
+
+// Replay receiver recording what it gets, in order
+//
+class RecordingSink : public ReplaySink
+{
+	public:
+		typedef struct tagEvent
+		{
+			bool CAN;
+			DWORD ID;           // CAN ID, or the second byte of the Xbow packet
+			UINT64 HostTime;
+		} Event;
+
+		std::vector<Event> Events;
+		ReplayStats Stats;
+		bool Finished;
+
+		RecordingSink() : Stats(), Finished(false) {}
+
+		void OnReplayCAN(const TPCANMsgFDEntry* Entries, const UINT64* HostTimes, DWORD Count)
+		{
+			for (DWORD i = 0; i < Count; i++)
+			{
+				Event event = { true, Entries[i].Msg.ID, HostTimes[i] };
+				Events.push_back(event);
+			}
+		}
+
+		void OnReplayXbow(const BYTE* Packet, UINT64 HostTime)
+		{
+			Event event = { false, Packet[1], HostTime };
+			Events.push_back(event);
+		}
+
+		void OnReplayFinished(const ReplayStats &ReplayStats)
+		{
+			Stats = ReplayStats;
+			Finished = true;
+		}
+};
+
+static void WriteFile(const char *FileName, const std::string &Text)
+{
+	FILE *file = fopen(FileName, "w");
+
+	CHECK(file != NULL);
+	if (file == NULL)
+		return;
+	fputs(Text.c_str(), file);
+	fclose(file);
+}
+
+// Acc.txt record of a packet numbered by its second byte, as written by
+// the dialog: decoded fields, the raw packet, then CPUTIME
+//
+static std::string XbowLine(BYTE Number, INT64 CPUTime)
+{
+	std::string line = "0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t";
+	char byte[4], time[32];
+
+	for (int i = 0; i < XBOW_PACKET_SIZE; i++)
+	{
+		snprintf(byte, sizeof(byte), i == 0 ? "%02X" : " %02X", i == 0 ? XBOW_HEADER : (i == 1 ? Number : i));
+		line += byte;
+	}
+	snprintf(time, sizeof(time), "\t%lld\n", (long long)CPUTime);
+
+	return line + time;
+}
+
+// Reads every message of a trace
+//
+static std::vector<TPCANMsgFDEntry> ReadTrace(ReplaySource &Source)
+{
+	std::vector<TPCANMsgFDEntry> entries;
+	TPCANMsgFDEntry batch[2];
+	DWORD count;
+	TPCANStatus status;
+
+	CHECK_EQUAL(PCAN_ERROR_OK, Source.Initialize());
+	CHECK_EQUAL(PCAN_ERROR_OK, Source.WaitForMessages(0));
+	do
+	{
+		status = Source.ReadBatch(batch, 2, &count);
+		entries.insert(entries.end(), batch, batch + count);
+	} while (status == PCAN_ERROR_OK);
+	CHECK_EQUAL(PCAN_ERROR_QRCVEMPTY, status);
+	CHECK_EQUAL(PCAN_ERROR_QRCVEMPTY, Source.WaitForMessages(0));
+
+	return entries;
+}
+
+static void TestTrace11()
+{
+	ReplaySource source(TRACE_FILE);
+	std::vector<TPCANMsgFDEntry> entries;
+	const BYTE data[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88 };
+
+	WriteFile(TRACE_FILE, Trace11);
+	CHECK_EQUAL(-1LL, source.GetStartTime());
+	entries = ReadTrace(source);
+
+	// The warning is not a CAN message, the bad ID is skipped
+	//
+	CHECK_EQUAL((size_t)4, entries.size());
+	CHECK_EQUAL(1ULL, source.GetSkippedLines());
+	CHECK_EQUAL(START_TIME_11, source.GetStartTime());
+	if (entries.size() != 4)
+		return;
+
+	CHECK_EQUAL(0x301u, entries[0].Msg.ID);
+	CHECK_EQUAL(PCAN_MESSAGE_STANDARD, entries[0].Msg.MSGTYPE);
+	CHECK_EQUAL(8, entries[0].Msg.DLC);
+	CHECK(memcmp(entries[0].Msg.DATA, data, sizeof(data)) == 0);
+	CHECK_EQUAL(100500ULL, entries[0].Timestamp);
+
+	CHECK_EQUAL(0x18F00502u, entries[1].Msg.ID);
+	CHECK_EQUAL(PCAN_MESSAGE_EXTENDED, entries[1].Msg.MSGTYPE);
+	CHECK_EQUAL(3, entries[1].Msg.DLC);
+	CHECK(entries[1].Msg.DATA[2] == 0x03 && entries[1].Msg.DATA[3] == 0);
+
+	CHECK_EQUAL(0x123u, entries[2].Msg.ID);
+	CHECK_EQUAL(PCAN_MESSAGE_RTR, entries[2].Msg.MSGTYPE);
+
+	CHECK_EQUAL(0x7FFu, entries[3].Msg.ID);
+	CHECK_EQUAL(0, entries[3].Msg.DLC);
+	CHECK_EQUAL(150200ULL, entries[3].Timestamp);
+	source.Uninitialize();
+
+	// The filter keeps the standard IDs from 0x300
+	//
+	CHECK_EQUAL(PCAN_ERROR_OK, source.FilterMessages(0x300, 0x3FF, PCAN_MODE_STANDARD));
+	entries = ReadTrace(source);
+	CHECK_EQUAL((size_t)1, entries.size());
+	CHECK(entries.size() == 1 && entries[0].Msg.ID == 0x301);
+	source.Uninitialize();
+}
+
+static void TestTrace20()
+{
+	ReplaySource source(TRACE_FILE);
+	std::vector<TPCANMsgFDEntry> entries;
+
+	WriteFile(TRACE_FILE, Trace20);
+	entries = ReadTrace(source);
+
+	// The error frame is not a CAN message
+	//
+	CHECK_EQUAL((size_t)4, entries.size());
+	CHECK_EQUAL(0ULL, source.GetSkippedLines());
+	CHECK_EQUAL(START_TIME_20, source.GetStartTime());
+	if (entries.size() != 4)
+		return;
+
+	CHECK_EQUAL(0x301u, entries[0].Msg.ID);
+	CHECK_EQUAL(PCAN_MESSAGE_STANDARD, entries[0].Msg.MSGTYPE);
+	CHECK_EQUAL(1059900ULL, entries[0].Timestamp);
+
+	// The DLC of a CAN FD message is kept, 9 being 12 bytes
+	//
+	CHECK_EQUAL(0x302u, entries[1].Msg.ID);
+	CHECK_EQUAL(PCAN_MESSAGE_FD, entries[1].Msg.MSGTYPE);
+	CHECK_EQUAL(9, entries[1].Msg.DLC);
+	CHECK(entries[1].Msg.DATA[11] == 0x0B && entries[1].Msg.DATA[12] == 0);
+
+	CHECK_EQUAL(0x18F00503u, entries[2].Msg.ID);
+	CHECK_EQUAL(PCAN_MESSAGE_EXTENDED | PCAN_MESSAGE_FD | PCAN_MESSAGE_BRS | PCAN_MESSAGE_ESI, entries[2].Msg.MSGTYPE);
+	CHECK(entries[2].Msg.DATA[0] == 0xAA && entries[2].Msg.DATA[1] == 0xBB);
+
+	CHECK_EQUAL(0x123u, entries[3].Msg.ID);
+	CHECK_EQUAL(PCAN_MESSAGE_RTR, entries[3].Msg.MSGTYPE);
+	CHECK_EQUAL(2, entries[3].Msg.DLC);
+	source.Uninitialize();
+}
+
+// Replays the recordings unthrottled and checks the order of the
+// deliveries and their host times from the first one, in milliseconds
+//
+static void CheckReplay(const std::string &Trace, const std::string &Xbow, INT64 XbowEpoch, const char *Order, const double *Times)
+{
+	TimestampService clock;
+	SessionReplay replay(&clock);
+	RecordingSink sink;
+	size_t count = strlen(Order);
+
+	WriteFile(TRACE_FILE, Trace);
+	WriteFile(XBOW_FILE, Xbow);
+	CHECK_EQUAL(PCAN_ERROR_OK, replay.Open(TRACE_FILE, XBOW_FILE, XbowEpoch));
+	CHECK_EQUAL(PCAN_ERROR_OK, replay.Start(&sink, REPLAY_UNTHROTTLED));
+	for (int i = 0; i < 5000 && replay.IsRunning(); i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	replay.Stop();
+
+	CHECK(sink.Finished);
+	CHECK(sink.Stats.Finished);
+	CHECK_EQUAL(count, sink.Events.size());
+	CHECK_EQUAL(count, (size_t)(sink.Stats.CANMessages + sink.Stats.XbowPackets));
+	CHECK_EQUAL(0ULL, sink.Stats.PacingErrorMax);
+	if (sink.Events.size() != count)
+		return;
+
+	// 'C' for a CAN message, 'X' for an Xbow packet
+	//
+	for (size_t i = 0; i < count; i++)
+	{
+		CHECK_EQUAL(Order[i] == 'C', sink.Events[i].CAN);
+		CHECK_EQUAL((INT64)(Times[i] * NS_PER_MS + 0.5), (INT64)(sink.Events[i].HostTime - sink.Events[0].HostTime));
+	}
+	CHECK_EQUAL((UINT64)(Times[count - 1] * NS_PER_MS + 0.5), sink.Stats.RecordedTime);
+}
+
+static void TestMerge()
+{
+	// 2.x trace placed by its $STARTTIME, the Xbow file by its epoch. A
+	// CAN message goes before an Xbow packet of the same time
+	//
+	{
+		std::string xbow = "Roll_Angle\tPitch_Angle\tRoll_Rate\tPitch_Rate\tYaw_Rate\tAcc_X\tACC_Y\tACC_Z\tTempature\tTime\tBadRatio\tRaw\tCPUTIME\n";
+		std::string trace = ";$FILEVERSION=2.0\n;$STARTTIME=42247.5\n"
+			"      1        10.000 DT     0301 Rx 8  00 00 00 00 00 00 00 00\n"
+			"      2        20.000 DT     0302 Rx 8  00 00 00 00 00 00 00 00\n"
+			"      3        20.000 DT     0303 Rx 8  00 00 00 00 00 00 00 00\n"
+			"      4        35.500 DT     0304 Rx 8  00 00 00 00 00 00 00 00\n";
+		const double times[] = { 0, 5, 15, 15, 15, 25, 30.5, 45 };
+
+		xbow += XbowLine(1, 5) + XbowLine(2, 20) + XbowLine(3, 30) + XbowLine(4, 50);
+		CheckReplay(trace, xbow, START_TIME_20, "XCCCXXCX", times);
+	}
+
+	// 1.1 trace placed by its start time, 50 ms after the Xbow epoch
+	//
+	{
+		std::string trace = ";$FILEVERSION=1.1\n;   Start time: 31.08.2015 12:49:27.500.0\n"
+			"     1)         0.0  Rx         0301  8  00 00 00 00 00 00 00 00\n"
+			"     2)       100.0  Rx         0302  8  00 00 00 00 00 00 00 00\n";
+		const double times[] = { 0, 50, 100 };
+
+		CheckReplay(trace, XbowLine(1, 100), START_TIME_11 - 50, "CXC", times);
+	}
+
+	// Without a start time, both streams are aligned on their first record
+	//
+	{
+		std::string trace = ";$FILEVERSION=1.1\n"
+			"     1)       100.0  Rx         0301  8  00 00 00 00 00 00 00 00\n"
+			"     2)       110.0  Rx         0302  8  00 00 00 00 00 00 00 00\n";
+		const double times[] = { 0, 0, 5, 10, 15 };
+
+		CheckReplay(trace, XbowLine(1, 7000) + XbowLine(2, 7005) + XbowLine(3, 7015), 0, "CXXCX", times);
+	}
+}
+
+int main()
+{
+	TestTrace11();
+	TestTrace20();
+	TestMerge();
+
+	remove(TRACE_FILE);
+	remove(XBOW_FILE);
+
+	return TestResult("ReplaySourceTest");
+}
@@ -0,0 +1,93 @@
+﻿//  SignalDecoderBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of the 15 VBOX signals decoded from their frames, as
+//  compile-time signals and as run-time descriptors of the same signals
+//
+//  ~~~~~~~~~~~~
+//
+#include "SignalDecoder.h"
+#include "VBoxDecoder.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <vector>
+
+#define BENCH_FRAMES		4096
+#define BENCH_PASSES		500
+
+int main()
+{
+	std::mt19937 random(5);
+	std::vector<BYTE> data(BENCH_FRAMES * 8);
+	std::vector<SignalDescriptor> signals;
+	std::chrono::steady_clock::time_point start;
+	double compiled = 0, described = 0, value;
+	double compiledTime, describedTime;
+
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (BYTE)random();
+
+	signals.push_back(VBoxSats::Describe("Sats", ""));
+	signals.push_back(VBoxTime::Describe("Time", "s"));
+	signals.push_back(VBoxLatitude::Describe("Latitude", "min"));
+	signals.push_back(VBoxLongitude::Describe("Longitude", "min"));
+	signals.push_back(VBoxSpeed::Describe("Speed", "km/h"));
+	signals.push_back(VBoxHeading::Describe("Heading", "deg"));
+	signals.push_back(VBoxAltitude::Describe("Altitude", "m"));
+	signals.push_back(VBoxVerticalSpeed::Describe("VerticalSpeed", "m/s"));
+	signals.push_back(VBoxStatus::Describe("Status", ""));
+	signals.push_back(VBoxTrigDistance::Describe("TrigDistance", "m"));
+	signals.push_back(VBoxLongAcc::Describe("LongAcc", "g"));
+	signals.push_back(VBoxLatAcc::Describe("LatAcc", "g"));
+	signals.push_back(VBoxDistance::Describe("Distance", "m"));
+	signals.push_back(VBoxTrigTime::Describe("TrigTime", "s"));
+	signals.push_back(VBoxTrigSpeed::Describe("TrigSpeed", "km/h"));
+
+	start = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < BENCH_PASSES; pass++)
+		for (int f = 0; f < BENCH_FRAMES; f++)
+		{
+			const BYTE *frame = &data[f * 8];
+
+			compiled += VBoxSats::Decode(frame);
+			compiled += VBoxTime::Decode(frame);
+			compiled += VBoxLatitude::Decode(frame);
+			compiled += VBoxLongitude::Decode(frame);
+			compiled += VBoxSpeed::Decode(frame);
+			compiled += VBoxHeading::Decode(frame);
+			compiled += VBoxAltitude::Decode(frame);
+			compiled += VBoxVerticalSpeed::Decode(frame);
+			compiled += VBoxStatus::Decode(frame);
+			compiled += VBoxTrigDistance::Decode(frame);
+			compiled += VBoxLongAcc::Decode(frame);
+			compiled += VBoxLatAcc::Decode(frame);
+			compiled += VBoxDistance::Decode(frame);
+			compiled += VBoxTrigTime::Decode(frame);
+			compiled += VBoxTrigSpeed::Decode(frame);
+		}
+	compiledTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < BENCH_PASSES; pass++)
+		for (int f = 0; f < BENCH_FRAMES; f++)
+			for (size_t s = 0; s < signals.size(); s++)
+				if (DecodeSignal(signals[s], &data[f * 8], 8, &value))
+					described += value;
+	describedTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%d signals: compiled %.2f ns/signal, descriptors %.2f ns/signal\n", (int)signals.size(),
+		compiledTime / BENCH_PASSES / BENCH_FRAMES / signals.size(),
+		describedTime / BENCH_PASSES / BENCH_FRAMES / signals.size());
+
+	// The sums are taken in the same order and must match exactly
+	//
+	if (compiled != described)
+	{
+		printf("Values differ: %f against %f\n", compiled, described);
+		return 1;
+	}
+	return 0;
+}
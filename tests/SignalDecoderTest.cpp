@@ -0,0 +1,169 @@
+//  SignalDecoderTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the signal extraction against a reference walking the bits
+//  one by one with the DBC numbering: every start bit of an 8-byte frame,
+//  every length, both byte orders and signedness, on random data, with
+//  the run-time descriptors, and the compile-time signals of the VBOX and
+//  a few others against both
+//
+//  ~~~~~~~~~~~~
+//
+#include "SignalDecoder.h"
+#include "VBoxDecoder.h"
+#include "TestCheck.h"
+
+#include <random>
+
+#define TEST_FRAMES		64
+
+// Reference extraction. Big-endian signals go from their most significant
+// bit down through the byte, then on to the most significant bit of the
+// next byte. Gives false if a bit is past the data
+//
+static bool ReferenceExtract(int StartBit, int Length, int ByteOrder, bool Signed, const BYTE *Data, int DataLength, INT64 *Raw)
+{
+	UINT64 raw = 0;
+	int bit = StartBit;
+
+	for (int i = 0; i < Length; i++)
+	{
+		if (bit / 8 >= DataLength)
+			return false;
+		if (ByteOrder == SIGNAL_BIG_ENDIAN)
+		{
+			raw = (raw << 1) | ((Data[bit / 8] >> (bit % 8)) & 1);
+			bit = (bit % 8 == 0) ? bit + 15 : bit - 1;
+		}
+		else
+		{
+			raw |= (UINT64)((Data[bit / 8] >> (bit % 8)) & 1) << i;
+			bit++;
+		}
+	}
+
+	*Raw = Signed ? SignExtendSignal(raw, Length) : (INT64)raw;
+	return true;
+}
+
+static void TestDescriptors(const std::vector<std::vector<BYTE> > &Frames)
+{
+	SignalDescriptor signal;
+	INT64 raw, expected;
+	double value;
+	int mismatches = 0;
+
+	signal.ID = 0x100;
+	signal.Scale = 0.5;
+	signal.Offset = -10;
+	for (int order = SIGNAL_BIG_ENDIAN; order <= SIGNAL_LITTLE_ENDIAN; order++)
+		for (int sign = 0; sign < 2; sign++)
+			for (int start = 0; start < 64; start++)
+				for (int length = 1; length <= SIGNAL_MAX_LENGTH; length++)
+				{
+					signal.StartBit = start;
+					signal.Length = length;
+					signal.ByteOrder = order;
+					signal.Signed = sign != 0;
+					CHECK(PrepareSignal(&signal));
+
+					for (size_t f = 0; f < Frames.size(); f++)
+					{
+						bool fits = ReferenceExtract(start, length, order, sign != 0, Frames[f].data(), 8, &expected);
+
+						if (ExtractSignal(signal, Frames[f].data(), 8, &raw) != fits || (fits && raw != expected))
+							mismatches++;
+						if (fits && (!DecodeSignal(signal, Frames[f].data(), 8, &value) || value != (double)expected * 0.5 - 10))
+							mismatches++;
+					}
+				}
+	CHECK_EQUAL(0, mismatches);
+
+	signal.StartBit = 0;
+	signal.Length = 0;
+	CHECK(!PrepareSignal(&signal));
+	signal.Length = SIGNAL_MAX_LENGTH + 1;
+	CHECK(!PrepareSignal(&signal));
+	signal.Length = 8;
+	signal.ByteOrder = 2;
+	CHECK(!PrepareSignal(&signal));
+	signal.ByteOrder = SIGNAL_LITTLE_ENDIAN;
+	signal.Scale = 0;
+	CHECK(!PrepareSignal(&signal));
+	signal.Scale = 1;
+	signal.StartBit = -1;
+	CHECK(!PrepareSignal(&signal));
+}
+
+// Checks a compile-time signal against the reference and against its own
+// description
+//
+template <class TSignal>
+static void CheckSignal(const std::vector<std::vector<BYTE> > &Frames)
+{
+	SignalDescriptor signal = TSignal::Describe("Signal", "");
+	SignalDescriptor prepared = signal;
+	INT64 raw, expected;
+	double value;
+
+	CHECK(PrepareSignal(&prepared));
+	CHECK_EQUAL(prepared.FirstByte, signal.FirstByte);
+	CHECK_EQUAL(prepared.Bytes, signal.Bytes);
+	CHECK_EQUAL(prepared.Shift, signal.Shift);
+
+	for (size_t f = 0; f < Frames.size(); f++)
+	{
+		CHECK(ReferenceExtract(signal.StartBit, signal.Length, signal.ByteOrder, signal.Signed, Frames[f].data(), TSignal::MinLength, &expected));
+		CHECK_EQUAL(expected, TSignal::Extract(Frames[f].data()));
+		CHECK(ExtractSignal(signal, Frames[f].data(), TSignal::MinLength, &raw));
+		CHECK_EQUAL(expected, raw);
+		CHECK(!ExtractSignal(signal, Frames[f].data(), TSignal::MinLength - 1, &raw));
+		CHECK(DecodeSignal(signal, Frames[f].data(), TSignal::MinLength, &value));
+		CHECK_EQUAL(TSignal::Decode(Frames[f].data()), value);
+	}
+}
+
+static void TestCompiledSignals(const std::vector<std::vector<BYTE> > &Frames)
+{
+	CheckSignal<VBoxSats>(Frames);
+	CheckSignal<VBoxTime>(Frames);
+	CheckSignal<VBoxLatitude>(Frames);
+	CheckSignal<VBoxLongitude>(Frames);
+	CheckSignal<VBoxSpeed>(Frames);
+	CheckSignal<VBoxHeading>(Frames);
+	CheckSignal<VBoxAltitude>(Frames);
+	CheckSignal<VBoxVerticalSpeed>(Frames);
+	CheckSignal<VBoxStatus>(Frames);
+	CheckSignal<VBoxTrigDistance>(Frames);
+	CheckSignal<VBoxLongAcc>(Frames);
+	CheckSignal<VBoxLatAcc>(Frames);
+	CheckSignal<VBoxDistance>(Frames);
+	CheckSignal<VBoxTrigTime>(Frames);
+	CheckSignal<VBoxTrigSpeed>(Frames);
+
+	CheckSignal<Signal<0x100,  0,  1, SIGNAL_LITTLE_ENDIAN, false> >(Frames);
+	CheckSignal<Signal<0x100,  3, 12, SIGNAL_LITTLE_ENDIAN, true, 1, 10, -40> >(Frames);
+	CheckSignal<Signal<0x100, 37, 27, SIGNAL_LITTLE_ENDIAN, true> >(Frames);
+	CheckSignal<Signal<0x100, 32, 32, SIGNAL_LITTLE_ENDIAN, false> >(Frames);
+	CheckSignal<Signal<0x100,  2, 11, SIGNAL_BIG_ENDIAN, true, 3, 4, 7> >(Frames);
+	CheckSignal<Signal<0x100, 60, 29, SIGNAL_BIG_ENDIAN, true> >(Frames);
+	CheckSignal<Signal<0x100, 56,  1, SIGNAL_BIG_ENDIAN, true> >(Frames);
+}
+
+int main()
+{
+	std::mt19937 random(12);
+	std::vector<std::vector<BYTE> > frames(TEST_FRAMES, std::vector<BYTE>(8));
+
+	// Edge patterns first, then random data
+	//
+	for (size_t f = 0; f < frames.size(); f++)
+		for (int i = 0; i < 8; i++)
+			frames[f][i] = (f == 0) ? 0x00 : (f == 1) ? 0xFF : (f == 2) ? (BYTE)(0x80 >> i) : (BYTE)random();
+
+	TestDescriptors(frames);
+	TestCompiledSignals(frames);
+
+	return TestResult("SignalDecoderTest");
+}
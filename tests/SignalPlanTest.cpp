@@ -0,0 +1,161 @@
+﻿//  SignalPlanTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the DBC loader and of the extraction plan: the messages and
+//  signals read from a DBC text, the signals skipped and the errors, then
+//  the values of the plan against DecodeSignal for every signal of a
+//  synthetic DBC of 2000 messages, on frames of every length
+//
+//  ~~~~~~~~~~~~
+//
+#include "DbcLoader.h"
+#include "SignalPlan.h"
+#include "SyntheticDbc.h"
+#include "TestCheck.h"
+
+#include <random>
+
+static const char *TEST_DBC =
+	"VERSION \"\"\n"
+	"\n"
+	"NS_ :\n"
+	"\tCM_\n"
+	"\n"
+	"BU_: VBox Logger\n"
+	"\n"
+	"BO_ 769 VBox_301: 8 VBox\n"
+	" SG_ Sats : 7|8@0+ (1,0) [0|255] \"\" Logger\n"
+	" SG_ Time : 15|24@0+ (0.01,0) [0|86400] \"s\" Logger\n"
+	" SG_ Latitude : 39|32@0- (1E-005,0) [-5400|5400] \"min\" Logger\n"
+	"\r\n"
+	"BO_ 2565866754 Engine: 8 Logger\n"
+	"\tSG_ Mode M : 0|4@1+ (1,0) [0|15] \"\" VBox\n"
+	"\tSG_ Torque m0 : 8|16@1- (0.1,0) [-1000|1000] \"Nm\" VBox\n"
+	"\tSG_ Rpm : 24|16@1+ (0.25,-100) [0|16000] \"rpm\" VBox\n"
+	"\tSG_ Counter : 0|64@1+ (1,0) [0|0] \"\" VBox\n"
+	"\n"
+	"BO_ 3221225472 VECTOR__INDEPENDENT_SIG_MSG: 0 Vector__XXX\n"
+	" SG_ Orphan : 0|8@1+ (1,0) [0|255] \"\" Vector__XXX\n"
+	"\n"
+	"CM_ SG_ 769 Sats \"Satellites in use\";\n"
+	" SG_ NotASignal : 0|8@1+ (1,0) [0|255] \"\" Vector__XXX\n"
+	"BA_DEF_ BO_ \"GenMsgCycleTime\" INT 0 65535;\n";
+
+static void TestLoader()
+{
+	std::vector<SignalDescriptor> signals;
+	DbcLoadStats stats;
+	std::string error;
+
+	CHECK(ParseDbcText(TEST_DBC, &signals, &stats, &error));
+	CHECK_EQUAL(2, stats.Messages);
+	CHECK_EQUAL(5, stats.Signals);
+	CHECK_EQUAL(1, stats.Multiplexed);
+	CHECK_EQUAL(1, stats.Unsupported);
+	CHECK_EQUAL((size_t)5, signals.size());
+
+	CHECK(signals[1].Name == "Time" && signals[1].Unit == "s");
+	CHECK_EQUAL(0x301u, signals[1].ID);
+	CHECK_EQUAL(15, signals[1].StartBit);
+	CHECK_EQUAL(24, signals[1].Length);
+	CHECK_EQUAL(SIGNAL_BIG_ENDIAN, signals[1].ByteOrder);
+	CHECK(!signals[1].Signed && signals[1].Scale == 0.01 && signals[1].Offset == 0);
+	CHECK(signals[2].Signed && signals[2].Scale == 1E-005);
+
+	CHECK(signals[3].Name == "Mode");
+	CHECK_EQUAL(0x18F00502u | DBC_ID_EXTENDED, signals[3].ID);
+	CHECK(signals[4].Name == "Rpm" && signals[4].Unit == "rpm");
+	CHECK_EQUAL(SIGNAL_LITTLE_ENDIAN, signals[4].ByteOrder);
+	CHECK(signals[4].Scale == 0.25 && signals[4].Offset == -100);
+	CHECK_EQUAL(3, signals[4].FirstByte);
+	CHECK_EQUAL(2, signals[4].Bytes);
+
+	CHECK(!ParseDbcText("BO_ 100 Message: 8 Node\n SG_ Bad : 0|8@2+ (1,0) [0|1] \"\" Node\n", &signals, &stats, &error));
+	CHECK(error == "Line 2: malformed signal");
+	CHECK(!ParseDbcText("\n\nBO_ Message: 8 Node\n", &signals, &stats, &error));
+	CHECK(error == "Line 3: malformed message");
+	CHECK(!ParseDbcText("BO_ 100 Message: 8 Node\n SG_ Cut : 0|8@1+ (1,0) [0|1] \"unit\n", &signals, &stats, &error));
+	CHECK(!LoadDbcFile("missing.dbc", &signals, &stats, &error));
+}
+
+// Decodes frames of random data and lengths with the plan, and each of
+// their signals with DecodeSignal, the values being expected equal in
+// the order of the frames
+//
+static void TestPlan()
+{
+	std::vector<SignalDescriptor> signals;
+	std::vector<std::vector<double> > expected;
+	std::vector<int> counts;
+	std::mt19937 random(19);
+	DbcLoadStats stats;
+	std::string error;
+	SignalPlan plan;
+	SignalBuffer buffer;
+	BYTE data[64];
+	CANFrameView frame;
+	double value;
+	int mismatches = 0, decoded = 0, count;
+
+	CHECK(ParseDbcText(MakeSyntheticDbc(2000, 8), &signals, &stats, &error));
+	CHECK_EQUAL(2000, stats.Messages);
+	CHECK_EQUAL(16000, stats.Signals);
+	plan.Build(signals);
+	CHECK_EQUAL(2000, plan.GetMessageCount());
+	CHECK_EQUAL(16000, plan.GetSignalCount());
+	buffer.Reset(plan.GetSignalCount());
+	expected.resize(signals.size());
+
+	// The frames of one message share a slot of the message table, the
+	// signals of message n being the columns 8n to 8n + 7. Some IDs are not
+	// in the DBC
+	//
+	frame.DATA = data;
+	for (int i = 0; i < 20000; i++)
+	{
+		int slot = random() % 2100;
+
+		frame.ID = GetSyntheticDbcID(slot);
+		frame.MSGTYPE = (frame.ID > 0x7FF) ? PCAN_MESSAGE_EXTENDED : PCAN_MESSAGE_STANDARD;
+		frame.LEN = (BYTE)(random() % 65);
+		for (int j = 0; j < 64; j++)
+			data[j] = (BYTE)random();
+
+		count = 0;
+		for (int s = slot * 8; s < slot * 8 + 8 && s < (int)signals.size(); s++)
+			if (DecodeSignal(signals[s], data, frame.LEN, &value))
+			{
+				expected[s].push_back(value);
+				count++;
+			}
+		if (plan.Decode(slot, frame, i, &buffer) != count)
+			mismatches++;
+		decoded += count;
+	}
+
+	for (size_t s = 0; s < signals.size(); s++)
+		if (buffer.GetSamples((int)s).size() != expected[s].size())
+			mismatches++;
+		else
+			for (size_t i = 0; i < expected[s].size(); i++)
+				if (buffer.GetSamples((int)s)[i].Value != expected[s][i])
+					mismatches++;
+	CHECK_EQUAL(0, mismatches);
+	CHECK(decoded > 20000);
+
+	// Remote frames carry no signal
+	//
+	frame.ID = GetSyntheticDbcID(0);
+	frame.MSGTYPE = PCAN_MESSAGE_STANDARD | PCAN_MESSAGE_RTR;
+	frame.LEN = 8;
+	CHECK_EQUAL(0, plan.Decode(0, frame, 0, &buffer));
+}
+
+int main()
+{
+	TestLoader();
+	TestPlan();
+
+	return TestResult("SignalPlanTest");
+}
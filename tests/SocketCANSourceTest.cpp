@@ -0,0 +1,84 @@
+//  SocketCANSourceTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the conversion of the SocketCAN frames into PCAN-Basic
+//  messages: data and remote frames, standard and extended IDs, CAN FD
+//
+//  ~~~~~~~~~~~~
+//
+#include "SocketCANSource.h"
+#include "TestCheck.h"
+
+#include <string.h>
+
+// A frame with every data byte set, as the kernel may leave them
+//
+static struct canfd_frame MakeFrame(canid_t ID, BYTE Length)
+{
+	struct canfd_frame frame;
+
+	memset(&frame, 0, sizeof(frame));
+	frame.can_id = ID;
+	frame.len = Length;
+	for (int i = 0; i < CANFD_MAX_DLEN; i++)
+		frame.data[i] = (BYTE)(0xA0 + i);
+
+	return frame;
+}
+
+static bool IsZero(const BYTE *Data, size_t Length)
+{
+	for (size_t i = 0; i < Length; i++)
+		if (Data[i] != 0)
+			return false;
+
+	return true;
+}
+
+int main()
+{
+	struct canfd_frame frame;
+	TPCANMsgFD msg;
+
+	// Data frame
+	//
+	frame = MakeFrame(0x301, 8);
+	memset(&msg, 0, sizeof(msg));
+	SocketCANSource::FrameToMessage(frame, false, msg);
+	CHECK_EQUAL(0x301u, msg.ID);
+	CHECK_EQUAL((TPCANMessageType)PCAN_MESSAGE_STANDARD, msg.MSGTYPE);
+	CHECK_EQUAL(8, msg.DLC);
+	CHECK(memcmp(msg.DATA, frame.data, 8) == 0);
+
+	// Remote requests keep their length only, over a message holding the
+	// data of a previous frame
+	//
+	frame = MakeFrame(0x305 | CAN_RTR_FLAG, 8);
+	memset(msg.DATA, 0x55, sizeof(msg.DATA));
+	SocketCANSource::FrameToMessage(frame, false, msg);
+	CHECK_EQUAL(0x305u, msg.ID);
+	CHECK_EQUAL((TPCANMessageType)(PCAN_MESSAGE_STANDARD | PCAN_MESSAGE_RTR), msg.MSGTYPE);
+	CHECK_EQUAL(8, msg.DLC);
+	CHECK(IsZero(msg.DATA, sizeof(msg.DATA)));
+
+	frame = MakeFrame(0x12345678 | CAN_EFF_FLAG | CAN_RTR_FLAG, 3);
+	memset(msg.DATA, 0x55, sizeof(msg.DATA));
+	SocketCANSource::FrameToMessage(frame, false, msg);
+	CHECK_EQUAL(0x12345678u, msg.ID);
+	CHECK_EQUAL((TPCANMessageType)(PCAN_MESSAGE_EXTENDED | PCAN_MESSAGE_RTR), msg.MSGTYPE);
+	CHECK_EQUAL(3, msg.DLC);
+	CHECK(IsZero(msg.DATA, sizeof(msg.DATA)));
+
+	// CAN FD frame
+	//
+	frame = MakeFrame(0x1ABCDEF | CAN_EFF_FLAG, 64);
+	frame.flags = CANFD_BRS;
+	SocketCANSource::FrameToMessage(frame, true, msg);
+	CHECK_EQUAL(0x1ABCDEFu, msg.ID);
+	CHECK_EQUAL((TPCANMessageType)(PCAN_MESSAGE_EXTENDED | PCAN_MESSAGE_FD | PCAN_MESSAGE_BRS), msg.MSGTYPE);
+	CHECK_EQUAL(15, msg.DLC);
+	CHECK(memcmp(msg.DATA, frame.data, 64) == 0);
+
+	return TestResult("SocketCANSourceTest");
+}
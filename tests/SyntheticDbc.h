@@ -0,0 +1,65 @@
+//  SyntheticDbc.h
+//
+//  ~~~~~~~~~~~~
+//
+//  DBC text of any number of messages, for the tests and benchmarks of
+//  the loader and of the extraction plan. The first 1024 messages have
+//  standard IDs, the next ones extended IDs. Half the signals of a
+//  message are in its first 8 bytes, the others anywhere in 64 bytes,
+//  with both byte orders, signed or not, of every length
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __SYNTHETICDBCH_
+#define __SYNTHETICDBCH_
+
+#include "CANTypes.h"
+
+#include <stdio.h>
+#include <string>
+
+// Messages with a standard ID
+//
+#define SYNTHETIC_DBC_STANDARD	1024
+
+/// <summary>
+/// Gets the ID of a message of the synthetic DBC, without the extended
+/// flag. Indexes past the messages of the DBC give IDs it does not have
+/// </summary>
+inline DWORD GetSyntheticDbcID(int Index)
+{
+	return (Index < SYNTHETIC_DBC_STANDARD) ? 0x400 + Index : 0x10000 + Index;
+}
+
+/// <summary>
+/// Makes the text of a synthetic DBC
+/// </summary>
+/// <param name="Messages">"Number of messages"</param>
+/// <param name="Signals">"Number of signals per message"</param>
+inline std::string MakeSyntheticDbc(int Messages, int Signals)
+{
+	std::string text = "VERSION \"\"\n\nNS_ :\n\tCM_\n\tBA_DEF_\n\nBS_:\n\nBU_: Node\n\n";
+	char line[160];
+
+	for (int i = 0; i < Messages; i++)
+	{
+		DWORD id = GetSyntheticDbcID(i);
+
+		snprintf(line, sizeof(line), "BO_ %lu Message_%d: 64 Node\n",
+			(unsigned long)((i < SYNTHETIC_DBC_STANDARD) ? id : id | 0x80000000UL), i);
+		text += line;
+		for (int j = 0; j < Signals; j++)
+		{
+			int start = (j < Signals / 2) ? (i * 3 + j * 13) % 64 : (i * 5 + j * 37) % 512;
+
+			snprintf(line, sizeof(line), " SG_ Signal_%d_%d : %d|%d@%d%c (%s,%d) [0|0] \"unit\" Node\n",
+				i, j, start, 1 + (i * 7 + j * 5) % 32, (i + j) % 2, (j % 3 == 0) ? '-' : '+', (j % 2 == 0) ? "0.5" : "1", j);
+			text += line;
+		}
+		text += "\n";
+	}
+	text += "CM_ BO_ 1024 \"First message\";\nBA_DEF_ BO_ \"GenMsgCycleTime\" INT 0 65535;\n";
+
+	return text;
+}
+#endif
@@ -0,0 +1,48 @@
+//  TestCheck.h
+//
+//  ~~~~~~~~~~~~
+//
+//  Checks of the tests of the portable modules. A failed check is
+//  printed with its place and counted; a test returns the count from
+//  main, so ctest sees it failing
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __TESTCHECKH_
+#define __TESTCHECKH_
+
+#include <stdio.h>
+
+static int g_CheckFailures = 0;
+
+#define CHECK(Condition) \
+	do \
+	{ \
+		if (!(Condition)) \
+		{ \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #Condition); \
+			g_CheckFailures++; \
+		} \
+	} while (0)
+
+#define CHECK_EQUAL(Expected, Actual) \
+	do \
+	{ \
+		if (!((Expected) == (Actual))) \
+		{ \
+			printf("%s:%d: check failed: %s == %s\n", __FILE__, __LINE__, #Expected, #Actual); \
+			g_CheckFailures++; \
+		} \
+	} while (0)
+
+// Ends a test, printing its result
+//
+inline int TestResult(const char *Name)
+{
+	if (g_CheckFailures == 0)
+		printf("%s: passed\n", Name);
+	else
+		printf("%s: %d checks failed\n", Name, g_CheckFailures);
+	return g_CheckFailures == 0 ? 0 : 1;
+}
+#endif
@@ -0,0 +1,98 @@
+//  TimestampServiceBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of the timestamp service, in nanoseconds per call: Now,
+//  ToRecordTime reading the session mapping through its sequence
+//  counter, the same conversion under a lock as it was done before, and
+//  the wall-clock stamp it replaced. The latter is what
+//  (microsec_clock::local_time() - time_t_epoch).total_milliseconds()
+//  does on Linux: gettimeofday, localtime_r, and the broken-down local
+//  time turned back into milliseconds
+//
+//  ~~~~~~~~~~~~
+//
+#include "TimestampService.h"
+
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define BENCH_CALLS		10000000
+
+// Session mapping under a lock, as ToRecordTime read it before
+//
+typedef struct tagLockedMapping
+{
+	TimestampMapping Session;
+	std::mutex Lock;
+} LockedMapping;
+
+static INT64 LockedRecordTime(LockedMapping &Mapping, UINT64 Monotonic)
+{
+	TimestampMapping session;
+
+	{
+		std::lock_guard<std::mutex> lock(Mapping.Lock);
+		session = Mapping.Session;
+	}
+	return (session.Record + (INT64)(Monotonic - session.Monotonic)) / NS_PER_MS;
+}
+
+// Local time in milliseconds since the epoch, as stamped before
+//
+static INT64 LocalTimeMilliseconds()
+{
+	struct timeval tv;
+	struct tm local;
+
+	gettimeofday(&tv, NULL);
+	localtime_r(&tv.tv_sec, &local);
+	return (INT64)timegm(&local) * 1000 + tv.tv_usec / 1000;
+}
+
+// Times a call repeated BENCH_CALLS times, in nanoseconds per call. The
+// results are summed so that the calls are not optimized away
+//
+template <class Call>
+static double Time(Call call, INT64 *Sum)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < BENCH_CALLS; i++)
+		*Sum += call(i);
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_CALLS;
+}
+
+int main()
+{
+	TimestampService clock;
+	LockedMapping locked;
+	UINT64 host;
+	INT64 sum = 0;
+	double now, record, lockedRecord, getRecord, localTime;
+
+	clock.StartSession(LocalTimeMilliseconds() * NS_PER_MS);
+	locked.Session.Monotonic = clock.Now();
+	locked.Session.Utc = 0;
+	locked.Session.Record = clock.GetRecordTime() * NS_PER_MS;
+	locked.Session.Started = true;
+	host = clock.Now();
+
+	now = Time([&](int) { return (INT64)clock.Now(); }, &sum);
+	record = Time([&](int i) { return clock.ToRecordTime(host + i); }, &sum);
+	lockedRecord = Time([&](int i) { return LockedRecordTime(locked, host + i); }, &sum);
+	getRecord = Time([&](int) { return clock.GetRecordTime(); }, &sum);
+	localTime = Time([&](int) { return LocalTimeMilliseconds(); }, &sum);
+
+	printf("Now:                         %6.1f ns/call\n", now);
+	printf("ToRecordTime:                %6.1f ns/call\n", record);
+	printf("ToRecordTime under a lock:   %6.1f ns/call\n", lockedRecord);
+	printf("GetRecordTime:               %6.1f ns/call\n", getRecord);
+	printf("local_time (before):         %6.1f ns/call\n", localTime);
+	printf("(checksum %lld)\n", (long long)sum);
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+//  TimestampServiceTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the timestamp service with a wall clock stepping back and
+//  forth: the recorded times stay monotonic within a session and across
+//  sessions, and while other threads stamp samples during the new
+//  sessions
+//
+//  ~~~~~~~~~~~~
+//
+#include "TimestampService.h"
+#include "TestCheck.h"
+
+#include <atomic>
+#include <thread>
+
+#define HOUR_NS		(3600 * NS_PER_SECOND)
+
+// Wall clock of the tests, stepped by hand
+//
+static std::atomic<INT64> g_WallClock(1700000000 * NS_PER_SECOND);
+
+static INT64 ReadTestClock()
+{
+	return g_WallClock;
+}
+
+static void TestSteps()
+{
+	TimestampService clock(ReadTestClock);
+	INT64 last, stamp, recordNow;
+	bool monotonic = true;
+
+	// The first session is not held to the scale of the constructor's
+	//
+	clock.StartSession(5 * NS_PER_SECOND);
+	last = clock.GetRecordTime();
+	CHECK(last >= 5000 && last < 6000);
+
+	// The wall clock is not read within a session
+	//
+	for (int i = 0; i < 1000; i++)
+	{
+		g_WallClock += (i % 2 == 0) ? -HOUR_NS : HOUR_NS / 2;
+		stamp = clock.GetRecordTime();
+		monotonic = monotonic && stamp >= last;
+		last = stamp;
+	}
+	CHECK(monotonic);
+
+	// A session started after a step back keeps the previous scale, the
+	// UTC mapping following the wall clock
+	//
+	recordNow = last * NS_PER_MS - HOUR_NS;
+	clock.StartSession(recordNow);
+	stamp = clock.GetRecordTime();
+	CHECK(stamp >= last);
+	CHECK(stamp < last + 1000);
+	CHECK(clock.ToUtc(clock.Now()) - g_WallClock < NS_PER_SECOND);
+	last = stamp;
+
+	// A step forward is taken
+	//
+	recordNow = last * NS_PER_MS + HOUR_NS;
+	clock.StartSession(recordNow);
+	stamp = clock.GetRecordTime();
+	CHECK(stamp >= last + HOUR_NS / NS_PER_MS);
+	CHECK(stamp < last + HOUR_NS / NS_PER_MS + 1000);
+}
+
+// Sessions started over and over, stepping back and forth, while another
+// thread stamps samples as the Xbow and CAN threads do
+//
+static void TestConcurrentSessions()
+{
+	TimestampService clock(ReadTestClock);
+	std::atomic<bool> done(false);
+	std::atomic<UINT64> stamps(0), regressions(0);
+	INT64 recordNow;
+
+	clock.StartSession(0);
+	std::thread reader([&]()
+	{
+		INT64 last = clock.GetRecordTime(), stamp;
+		UINT64 host;
+
+		while (!done)
+		{
+			host = clock.Now();
+			stamp = clock.ToRecordTime(host);
+			if (stamp < last)
+				regressions++;
+			last = stamp;
+
+			stamp = clock.GetRecordTime();
+			if (stamp < last)
+				regressions++;
+			last = stamp;
+			stamps += 2;
+		}
+	});
+
+	for (int i = 0; i < 100000; i++)
+	{
+		recordNow = clock.GetRecordTime() * NS_PER_MS + ((i % 2 == 0) ? -HOUR_NS : HOUR_NS / 1000);
+		g_WallClock += (i % 2 == 0) ? -HOUR_NS : HOUR_NS;
+		clock.StartSession(recordNow);
+	}
+	done = true;
+	reader.join();
+
+	printf("%llu stamps during 100000 sessions, %llu going back\n", (unsigned long long)stamps, (unsigned long long)regressions);
+	CHECK(stamps > 0);
+	CHECK_EQUAL(0u, (UINT64)regressions);
+}
+
+int main()
+{
+	TestSteps();
+	TestConcurrentSessions();
+
+	return TestResult("TimestampServiceTest");
+}
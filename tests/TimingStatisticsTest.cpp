@@ -0,0 +1,284 @@
+//  TimingStatisticsTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the per-ID timing statistics on fixed period sequences: the
+//  running mean and variance against a two-pass computation, minimum and
+//  maximum, the log2 buckets of the jitter at their bounds, the rate,
+//  timestamps going backwards, the report, and the snapshots published
+//  every TIMING_PUBLISH_INTERVAL of frame time
+//
+//  ~~~~~~~~~~~~
+//
+#include "TimingStatistics.h"
+#include "TestCheck.h"
+
+#include <math.h>
+#include <random>
+#include <string.h>
+
+// Feeds the frames of a period sequence, the first one at Start
+//
+static TPCANTimestampFD Feed(TimingStatistics &Timing, DWORD ID, TPCANTimestampFD Start, const UINT64 *Periods, int Count)
+{
+	TPCANTimestampFD time = Start;
+
+	Timing.Update(ID, PCAN_MESSAGE_STANDARD, time);
+	for (int i = 0; i < Count; i++)
+		Timing.Update(ID, PCAN_MESSAGE_STANDARD, time += Periods[i]);
+
+	return time;
+}
+
+// Statistics of a message in the last published snapshot
+//
+static const PeriodStats* Find(const TimingSnapshot &Snapshot, DWORD ID)
+{
+	for (TimingSnapshot::const_iterator i = Snapshot.begin(); i != Snapshot.end(); ++i)
+		if (i->ID == ID)
+			return &*i;
+
+	return NULL;
+}
+
+static bool IsNear(double Expected, double Actual, double Tolerance)
+{
+	return fabs(Expected - Actual) <= Tolerance;
+}
+
+static void TestFixedPeriods()
+{
+	TimingStatistics timing;
+	const UINT64 steady[] = { 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000 };
+	const UINT64 alternating[] = { 1000, 3000, 1000, 3000, 2000 };
+	std::shared_ptr<const TimingSnapshot> snapshot;
+	const PeriodStats *stats;
+
+	Feed(timing, 0x100, 0, steady, 10);
+	Feed(timing, 0x200, 0, alternating, 5);
+	timing.Publish();
+	snapshot = timing.GetSnapshot();
+	CHECK_EQUAL((size_t)2, snapshot->size());
+
+	// 10 ms periods, 1 kHz
+	//
+	stats = Find(*snapshot, 0x100);
+	CHECK(stats != NULL);
+	if (stats != NULL)
+	{
+		CHECK_EQUAL(11ULL, stats->Count);
+		CHECK_EQUAL(0ULL, stats->FirstTime);
+		CHECK_EQUAL(10000ULL, stats->LastTime);
+		CHECK_EQUAL(1000ULL, stats->MinPeriod);
+		CHECK_EQUAL(1000ULL, stats->MaxPeriod);
+		CHECK_EQUAL(1000.0, stats->MeanPeriod);
+		CHECK_EQUAL(0.0, TimingStatistics::GetStdDeviation(*stats));
+		CHECK_EQUAL(1000.0, TimingStatistics::GetRate(*stats));
+		CHECK_EQUAL(10u, stats->Jitter[0]);
+	}
+
+	// Mean 2000, sample variance 4e6 / 4. The deviations from the mean
+	// before each period are 0, 2000, 1000, 1333 and 0 us
+	//
+	stats = Find(*snapshot, 0x200);
+	CHECK(stats != NULL);
+	if (stats != NULL)
+	{
+		CHECK_EQUAL(6ULL, stats->Count);
+		CHECK_EQUAL(1000ULL, stats->MinPeriod);
+		CHECK_EQUAL(3000ULL, stats->MaxPeriod);
+		CHECK(IsNear(2000.0, stats->MeanPeriod, 1e-9));
+		CHECK(IsNear(1000.0, TimingStatistics::GetStdDeviation(*stats), 1e-9));
+		CHECK(IsNear(500.0, TimingStatistics::GetRate(*stats), 1e-9));
+		CHECK_EQUAL(2u, stats->Jitter[0]);
+		CHECK_EQUAL(1u, stats->Jitter[10]);
+		CHECK_EQUAL(2u, stats->Jitter[11]);
+	}
+
+	// A single frame has no period
+	//
+	timing.Update(0x300, PCAN_MESSAGE_STANDARD, 50000);
+	timing.Publish();
+	stats = Find(*timing.GetSnapshot(), 0x300);
+	CHECK(stats != NULL && stats->Count == 1 && TimingStatistics::GetRate(*stats) == 0 && TimingStatistics::GetStdDeviation(*stats) == 0);
+}
+
+// The running mean and variance against a two-pass computation over
+// 100000 random periods
+//
+static void TestWelford()
+{
+	TimingStatistics timing;
+	std::mt19937 random(14);
+	std::uniform_int_distribution<int> jitter(-300, 300);
+	std::vector<UINT64> periods(100000);
+	double mean = 0, squares = 0, minimum = 1e9, maximum = 0;
+	const PeriodStats *stats;
+
+	for (size_t i = 0; i < periods.size(); i++)
+	{
+		periods[i] = (i % 7 == 0) ? 20000 : 10000 + jitter(random);
+		mean += (double)periods[i];
+		minimum = (periods[i] < minimum) ? (double)periods[i] : minimum;
+		maximum = (periods[i] > maximum) ? (double)periods[i] : maximum;
+	}
+	mean /= periods.size();
+	for (size_t i = 0; i < periods.size(); i++)
+		squares += ((double)periods[i] - mean) * ((double)periods[i] - mean);
+
+	Feed(timing, 0x18F00502, 123456, &periods[0], (int)periods.size());
+	timing.Publish();
+	stats = Find(*timing.GetSnapshot(), 0x18F00502);
+	CHECK(stats != NULL);
+	if (stats == NULL)
+		return;
+
+	CHECK_EQUAL((UINT64)periods.size() + 1, stats->Count);
+	CHECK(IsNear(mean, stats->MeanPeriod, mean * 1e-12));
+	CHECK(IsNear(sqrt(squares / (periods.size() - 1)), TimingStatistics::GetStdDeviation(*stats), 1e-6));
+	CHECK_EQUAL((UINT64)minimum, stats->MinPeriod);
+	CHECK_EQUAL((UINT64)maximum, stats->MaxPeriod);
+	CHECK(IsNear(1e6 / mean, TimingStatistics::GetRate(*stats), 1e-9));
+}
+
+// Bucket 0 counts deviations under 1 us, bucket k those in
+// [2^(k-1), 2^k) us and the last one all the larger ones
+//
+static void TestJitterBuckets()
+{
+	TimingStatistics timing;
+	const UINT64 deviations[] = { 0, 1, 2, 3, 4, 1023, 1024, 16383, 16384, 1000000 };
+	const int buckets[] = { 0, 1, 2, 2, 3, 10, 11, 14, 15, 15 };
+	const PeriodStats *stats;
+
+	// A period of 100 ms, then one longer by the deviation
+	//
+	for (int i = 0; i < 10; i++)
+	{
+		const UINT64 periods[] = { 100000, 100000 + deviations[i] };
+
+		Feed(timing, 0x400 + i, 0, periods, 2);
+	}
+	timing.Publish();
+
+	for (int i = 0; i < 10; i++)
+	{
+		stats = Find(*timing.GetSnapshot(), 0x400 + i);
+		CHECK(stats != NULL);
+		if (stats == NULL)
+			continue;
+
+		for (int j = 0; j < TIMING_JITTER_BUCKETS; j++)
+		{
+			DWORD expected = (j == 0 ? 1u : 0u) + (j == buckets[i] ? 1u : 0u);
+
+			if (stats->Jitter[j] != expected)
+				printf("Deviation %llu: bucket %d counts %u\n", (unsigned long long)deviations[i], j, (unsigned)stats->Jitter[j]);
+			CHECK_EQUAL(expected, stats->Jitter[j]);
+		}
+	}
+}
+
+static void TestBackwards()
+{
+	TimingStatistics timing;
+	const PeriodStats *stats;
+
+	// An adapter reset: the timestamp going back counts as no gap
+	//
+	timing.Update(0x100, PCAN_MESSAGE_STANDARD, 5000);
+	timing.Update(0x100, PCAN_MESSAGE_STANDARD, 6000);
+	timing.Update(0x100, PCAN_MESSAGE_STANDARD, 7000);
+	timing.Update(0x100, PCAN_MESSAGE_STANDARD, 1000);
+	timing.Publish();
+	stats = Find(*timing.GetSnapshot(), 0x100);
+	CHECK(stats != NULL);
+	if (stats == NULL)
+		return;
+	CHECK_EQUAL(4ULL, stats->Count);
+	CHECK_EQUAL(1000ULL, stats->LastTime);
+	CHECK_EQUAL(0ULL, stats->MinPeriod);
+	CHECK_EQUAL(1000ULL, stats->MaxPeriod);
+	CHECK(IsNear(2000.0 / 3, stats->MeanPeriod, 1e-9));
+
+	// Before the first timestamp again, no rate can be given
+	//
+	CHECK_EQUAL(0.0, TimingStatistics::GetRate(*stats));
+	timing.Update(0x100, PCAN_MESSAGE_STANDARD, 9000);
+	timing.Publish();
+	stats = Find(*timing.GetSnapshot(), 0x100);
+	CHECK(stats != NULL && IsNear(4 * 1e6 / 4000, TimingStatistics::GetRate(*stats), 1e-9));
+}
+
+static void TestReport()
+{
+	TimingStatistics timing;
+	const UINT64 periods[] = { 1000, 1000, 1000, 1000 };
+	std::string expected, report;
+
+	expected = "ID\tType\tCount\tRate\tMinPeriod\tMeanPeriod\tMaxPeriod\tStdDev"
+		"\tJitter<1us\tJitter<2us\tJitter<4us\tJitter<8us\tJitter<16us\tJitter<32us\tJitter<64us\tJitter<128us"
+		"\tJitter<256us\tJitter<512us\tJitter<1024us\tJitter<2048us\tJitter<4096us\tJitter<8192us\tJitter<16384us"
+		"\tJitter>=16384us\n";
+	CHECK(timing.GetReport() == expected);
+
+	Feed(timing, 0x301, 0, periods, 4);
+	timing.Update(0x18F00502, PCAN_MESSAGE_EXTENDED, 2500);
+	timing.Update(0x18F00502, PCAN_MESSAGE_EXTENDED, 2600);
+	timing.Publish();
+	expected += "301h\t00h\t5\t1000.000\t1000\t1000.0\t1000\t0.0\t4\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\n";
+	expected += "18F00502h\t02h\t2\t10000.000\t100\t100.0\t100\t0.0\t1\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\n";
+	report = timing.GetReport();
+	if (report != expected)
+		printf("%s", report.c_str());
+	CHECK(report == expected);
+}
+
+static void TestPublishInterval()
+{
+	TimingStatistics timing;
+	std::shared_ptr<const TimingSnapshot> first, snapshot;
+
+	// Nothing before the first frame, which is published at once
+	//
+	CHECK(timing.GetSnapshot()->empty());
+	timing.Update(0x100, PCAN_MESSAGE_STANDARD, 1000);
+	first = timing.GetSnapshot();
+	CHECK_EQUAL((size_t)1, first->size());
+
+	// Then not before TIMING_PUBLISH_INTERVAL of frame time
+	//
+	for (TPCANTimestampFD time = 2000; time < 1000 + TIMING_PUBLISH_INTERVAL; time += 1000)
+		timing.Update(0x100, PCAN_MESSAGE_STANDARD, time);
+	CHECK(timing.GetSnapshot() == first);
+	timing.Update(0x100, PCAN_MESSAGE_STANDARD, 1000 + TIMING_PUBLISH_INTERVAL);
+	snapshot = timing.GetSnapshot();
+	CHECK(snapshot != first);
+	CHECK_EQUAL((UINT64)TIMING_PUBLISH_INTERVAL / 1000 + 1, (*snapshot)[0].Count);
+
+	// A published snapshot is never changed
+	//
+	CHECK_EQUAL(1ULL, (*first)[0].Count);
+	timing.Update(0x200, PCAN_MESSAGE_STANDARD, 1000 + TIMING_PUBLISH_INTERVAL + 1);
+	CHECK_EQUAL((size_t)1, snapshot->size());
+
+	// A reset publishes an empty snapshot, the next frame another at once
+	//
+	timing.Reset();
+	CHECK(timing.GetSnapshot()->empty());
+	timing.Update(0x300, PCAN_MESSAGE_STANDARD, 500);
+	CHECK_EQUAL((size_t)1, timing.GetSnapshot()->size());
+	CHECK_EQUAL(0x300u, (*timing.GetSnapshot())[0].ID);
+}
+
+int main()
+{
+	TestFixedPeriods();
+	TestWelford();
+	TestJitterBuckets();
+	TestBackwards();
+	TestReport();
+	TestPublishInterval();
+
+	return TestResult("TimingStatisticsTest");
+}
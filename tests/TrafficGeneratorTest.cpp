@@ -0,0 +1,513 @@
+//  TrafficGeneratorTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the synthetic traffic through the decoders of the dialog:
+//  VBOX frames decoded by DecodeVBoxFrame and Xbow packets parsed by
+//  ParseXbowPacket, or cut out of the serial stream by the XbowFramer.
+//  The decoded values stay within the noise bounds of the run the
+//  generator describes, the corrupted packets fail their checksum and
+//  the dropouts lose whole epochs and packets, at the configured rates
+//
+//  ~~~~~~~~~~~~
+//
+#include "TrafficGenerator.h"
+#include "VBoxDecoder.h"
+#include "XbowParser.h"
+#include "TestCheck.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#define TEST_SECONDS		100
+#define TEST_UNTIL			(TEST_SECONDS * 1000000ULL)
+#define TEST_BATCH			1024
+
+// The run of the default configuration: a circle of 100 m at 20 m/s
+// starting at Melbourne, 30 m high
+//
+#define RUN_LATITUDE		-37.8136
+#define RUN_LONGITUDE		144.9631
+#define RUN_ALTITUDE		30.0
+#define METERS_PER_DEGREE	111320.0
+#define KNOTS_PER_MS		1.943844
+#define STANDARD_GRAVITY	9.80665
+#define RUN_PI				3.14159265358979323846
+
+// Deviation of a decoded value from the run, in noise sigmas
+//
+#define NOISE_BOUND			5.0
+
+// Errors of a decoded value, for their bound and their spread
+//
+class ErrorStats
+{
+	private:
+		const char *m_Name;
+		double m_Sigma;
+		double m_Quantum;
+		double m_Sum;
+		double m_Squares;
+		double m_Max;
+		UINT64 m_Count;
+		UINT64 m_OutOfBounds;
+
+	public:
+		ErrorStats(const char *Name, double Sigma, double Quantum)
+			: m_Name(Name), m_Sigma(Sigma), m_Quantum(Quantum), m_Sum(0), m_Squares(0), m_Max(0), m_Count(0), m_OutOfBounds(0)
+		{
+		}
+
+		void Add(double Error)
+		{
+			m_Sum += Error;
+			m_Squares += Error * Error;
+			m_Count++;
+			if (fabs(Error) > m_Max)
+				m_Max = fabs(Error);
+			if (fabs(Error) > NOISE_BOUND * m_Sigma + m_Quantum)
+				m_OutOfBounds++;
+		}
+
+		// Every error within the bound, centered, and spread as the noise
+		// once the rounding to the unit of the field is added
+		//
+		void Check() const
+		{
+			double mean = m_Sum / m_Count;
+			double rms = sqrt(m_Squares / m_Count);
+			double expected = sqrt(m_Sigma * m_Sigma + m_Quantum * m_Quantum / 12);
+
+			if (m_OutOfBounds > 0 || fabs(mean) > 0.1 * expected + m_Quantum / 2 || fabs(rms - expected) > 0.15 * expected)
+				printf("%s: %llu values, mean error %g, RMS %g for %g expected, max %g, %llu out of bounds\n", m_Name,
+					(unsigned long long)m_Count, mean, rms, expected, m_Max, (unsigned long long)m_OutOfBounds);
+			CHECK(m_Count > 0);
+			CHECK_EQUAL(0ULL, m_OutOfBounds);
+			CHECK(fabs(mean) <= 0.1 * expected + m_Quantum / 2);
+			CHECK(fabs(rms - expected) <= 0.15 * expected);
+		}
+};
+
+// Tells if a count of events out of Trials is within 4 sigmas of the
+// binomial count of a probability
+//
+static bool IsBinomial(UINT64 Count, UINT64 Trials, double Probability)
+{
+	double expected = Trials * Probability;
+	double sigma = sqrt(Trials * Probability * (1 - Probability));
+
+	if (fabs(Count - expected) > 4 * sigma)
+		printf("%llu events out of %llu, %.1f expected\n", (unsigned long long)Count, (unsigned long long)Trials, expected);
+	return fabs(Count - expected) <= 4 * sigma;
+}
+
+static double Difference(double Angle)
+{
+	Angle = fmod(Angle, 360);
+	return (Angle > 180) ? Angle - 360 : ((Angle < -180) ? Angle + 360 : Angle);
+}
+
+static TrafficConfig GetGPSConfig()
+{
+	TrafficConfig config = TrafficGenerator::GetDefaultConfig();
+
+	config.XbowRate = 0;
+	return config;
+}
+
+static TrafficConfig GetXbowConfig()
+{
+	TrafficConfig config = TrafficGenerator::GetDefaultConfig();
+
+	config.GPSRate = 0;
+	return config;
+}
+
+// Generates every CAN frame of the test span
+//
+static std::vector<TPCANMsgFDEntry> GenerateCAN(TrafficGenerator &Generator)
+{
+	std::vector<TPCANMsgFDEntry> entries;
+	TPCANMsgFDEntry batch[TEST_BATCH];
+	DWORD count;
+
+	while ((count = Generator.GenerateCAN(TEST_UNTIL, batch, TEST_BATCH)) > 0)
+		entries.insert(entries.end(), batch, batch + count);
+
+	return entries;
+}
+
+// Generates every Xbow packet of the test span
+//
+static std::vector<BYTE> GenerateXbow(TrafficGenerator &Generator)
+{
+	std::vector<BYTE> packets;
+	BYTE batch[TEST_BATCH * XBOW_PACKET_SIZE];
+	DWORD count;
+
+	while ((count = Generator.GenerateXbow(TEST_UNTIL, batch, TEST_BATCH)) > 0)
+		packets.insert(packets.end(), batch, batch + count * XBOW_PACKET_SIZE);
+
+	return packets;
+}
+
+static void TestVBoxValues()
+{
+	TrafficConfig config = GetGPSConfig();
+	std::vector<TPCANMsgFDEntry> entries;
+	double lateral = config.Speed * config.Speed / config.Radius / STANDARD_GRAVITY;
+	double metersPerMinute = METERS_PER_DEGREE / 60;
+	ErrorStats north("Latitude", 0.02, 1e-5 * metersPerMinute);
+	ErrorStats east("Longitude", 0.02, 1e-5 * metersPerMinute * cos(RUN_LATITUDE * RUN_PI / 180));
+	ErrorStats speed("Speed", 0.05, 0.01 / KNOTS_PER_MS);
+	ErrorStats heading("Heading", 0.2, 0.01);
+	ErrorStats altitude("Altitude", 0.1, 0.01);
+	ErrorStats verticalSpeed("Vertical speed", 0.02, 0.01);
+	ErrorStats longAcc("Longitudinal acceleration", 0.01, 0.01);
+	ErrorStats latAcc("Lateral acceleration", 0.01, 0.01);
+	UINT64 frames[VBOX_FRAME_COUNT] = {};
+	int badTimes = 0, badSats = 0, badDistances = 0, badStatus = 0;
+
+	config.Noise = 1;
+	{
+		TrafficGenerator generator(config);
+		entries = GenerateCAN(generator);
+	}
+	CHECK_EQUAL((size_t)TEST_SECONDS * 20 * VBOX_FRAME_COUNT, entries.size());
+
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const TPCANMsgFD &msg = entries[i].Msg;
+		VBoxData data;
+		DWORD index = msg.ID - VBOX_ID_FIRST;
+		double t, angle;
+
+		memset(&data, 0, sizeof(data));
+		CHECK(DecodeVBoxFrame(msg.ID, msg.DATA, GetLengthFromDLC(msg.DLC, true), &data));
+		if (index >= VBOX_FRAME_COUNT)
+			continue;
+		frames[index]++;
+
+		// The frames of an epoch all describe the time of its first one
+		//
+		t = (entries[i].Timestamp - index * VBOX_FRAME_GAP) / 1e6;
+		angle = config.Speed * t / config.Radius;
+		switch (index)
+		{
+			case 0:
+				badSats += (data.Sats < 10 - NOISE_BOUND || data.Sats > 10 + NOISE_BOUND);
+				badTimes += (fabs(data.Time - t * 100) > 1);
+				north.Add((data.Latitude / 6e6 - RUN_LATITUDE) * METERS_PER_DEGREE - config.Radius * sin(angle));
+				break;
+
+			case 1:
+				east.Add((data.Longitude / 6e6 - RUN_LONGITUDE) * METERS_PER_DEGREE * cos(RUN_LATITUDE * RUN_PI / 180) - config.Radius * (1 - cos(angle)));
+				speed.Add(data.Speed / 100.0 / KNOTS_PER_MS - config.Speed);
+				heading.Add(Difference(data.Heading / 100.0 - angle * 180 / RUN_PI));
+				break;
+
+			case 2:
+				altitude.Add(data.Altitude / 100.0 - RUN_ALTITUDE);
+				verticalSpeed.Add(data.VerticalSpeed / 100.0);
+				badStatus += (data.Status != 0x03);
+				break;
+
+			case 3:
+				longAcc.Add(data.LongAcc / 100.0);
+				latAcc.Add(data.LatAcc / 100.0 - lateral);
+				break;
+
+			default:
+				badDistances += (fabs(data.Distance - config.Speed * t * 12800) > 1);
+				break;
+		}
+	}
+
+	for (int i = 0; i < VBOX_FRAME_COUNT; i++)
+		CHECK_EQUAL((UINT64)TEST_SECONDS * 20, frames[i]);
+	CHECK_EQUAL(0, badSats);
+	CHECK_EQUAL(0, badTimes);
+	CHECK_EQUAL(0, badDistances);
+	CHECK_EQUAL(0, badStatus);
+	north.Check();
+	east.Check();
+	speed.Check();
+	heading.Check();
+	altitude.Check();
+	verticalSpeed.Check();
+	longAcc.Check();
+	latAcc.Check();
+}
+
+static void TestXbowValues()
+{
+	TrafficConfig config = GetXbowConfig();
+	std::vector<BYTE> packets;
+	double lateral = config.Speed * config.Speed / config.Radius / STANDARD_GRAVITY;
+	double yawRate = config.Speed / config.Radius * 180 / RUN_PI;
+	ErrorStats rollAngle("Roll angle", 0.1, XBOW_ANGLE_SCALE);
+	ErrorStats pitchAngle("Pitch angle", 0.1, XBOW_ANGLE_SCALE);
+	ErrorStats rollRate("Roll rate", 0.2, XBOW_RATE_SCALE);
+	ErrorStats pitchRate("Pitch rate", 0.2, XBOW_RATE_SCALE);
+	ErrorStats yaw("Yaw rate", 0.2, XBOW_RATE_SCALE);
+	ErrorStats accX("Acceleration X", 0.005, XBOW_ACC_SCALE);
+	ErrorStats accY("Acceleration Y", 0.005, XBOW_ACC_SCALE);
+	ErrorStats accZ("Acceleration Z", 0.005, XBOW_ACC_SCALE);
+	int invalid = 0, badTimes = 0, badTemperatures = 0;
+
+	config.Noise = 1;
+	{
+		TrafficGenerator generator(config);
+		packets = GenerateXbow(generator);
+	}
+	CHECK_EQUAL((size_t)TEST_SECONDS * 100 * XBOW_PACKET_SIZE, packets.size());
+
+	for (size_t i = 0; i < packets.size() / XBOW_PACKET_SIZE; i++)
+	{
+		XbowSample sample;
+		int expected = (int)(i * 10) & 0xFFFF;
+
+		if (!ParseXbowPacket(&packets[i * XBOW_PACKET_SIZE], &sample))
+		{
+			invalid++;
+			continue;
+		}
+
+		// The device timer counts milliseconds, a packet every 10 ms
+		//
+		badTimes += (sample.Time != expected && sample.Time != ((expected + 0xFFFF) & 0xFFFF));
+		badTemperatures += (fabs(GetXbowTemperature(sample.Temperature) - 25) > 0.1);
+		rollAngle.Add(GetXbowAngle(sample.RollAngle) - 2 * lateral);
+		pitchAngle.Add(GetXbowAngle(sample.PitchAngle));
+		rollRate.Add(GetXbowRate(sample.RollRate));
+		pitchRate.Add(GetXbowRate(sample.PitchRate));
+		yaw.Add(GetXbowRate(sample.YawRate) - yawRate);
+		accX.Add(GetXbowAcc(sample.AccX));
+		accY.Add(GetXbowAcc(sample.AccY) - lateral);
+		accZ.Add(GetXbowAcc(sample.AccZ) - 1);
+	}
+
+	CHECK_EQUAL(0, invalid);
+	CHECK_EQUAL(0, badTimes);
+	CHECK_EQUAL(0, badTemperatures);
+	rollAngle.Check();
+	pitchAngle.Check();
+	rollRate.Check();
+	pitchRate.Check();
+	yaw.Check();
+	accX.Check();
+	accY.Check();
+	accZ.Check();
+}
+
+// Without noise the run is the same whatever the random draws, so a
+// corrupted run is compared with a clean one frame by frame. The VBOX
+// frames carry no checksum, the changed ones are found by their bytes
+//
+static void TestCorruption()
+{
+	const double rate = 0.05;
+	TrafficConfig config = GetGPSConfig();
+	std::vector<TPCANMsgFDEntry> clean, corrupted;
+	UINT64 changed = 0, stated;
+
+	{
+		TrafficGenerator generator(config);
+		clean = GenerateCAN(generator);
+	}
+	config.CorruptionRate = rate;
+	{
+		TrafficGenerator generator(config);
+		corrupted = GenerateCAN(generator);
+		stated = generator.GetStatistics().Corrupted;
+	}
+	CHECK_EQUAL(clean.size(), corrupted.size());
+	for (size_t i = 0; i < clean.size() && i < corrupted.size(); i++)
+	{
+		CHECK_EQUAL(clean[i].Msg.ID, corrupted[i].Msg.ID);
+		changed += (memcmp(clean[i].Msg.DATA, corrupted[i].Msg.DATA, 8) != 0);
+	}
+	CHECK_EQUAL(stated, changed);
+	CHECK(IsBinomial(changed, clean.size(), rate));
+
+	// The corrupted Xbow packets fail their checksum. A byte changed so
+	// that the sum moves between 0 and 255 goes unseen, since the
+	// checksum is taken modulo 255
+	//
+	std::vector<BYTE> cleanPackets, corruptedPackets;
+	UINT64 failed = 0, unseen = 0, packets;
+
+	config = GetXbowConfig();
+	{
+		TrafficGenerator generator(config);
+		cleanPackets = GenerateXbow(generator);
+	}
+	config.CorruptionRate = rate;
+	{
+		TrafficGenerator generator(config);
+		corruptedPackets = GenerateXbow(generator);
+		stated = generator.GetStatistics().Corrupted;
+	}
+	CHECK_EQUAL(cleanPackets.size(), corruptedPackets.size());
+	packets = cleanPackets.size() / XBOW_PACKET_SIZE;
+	for (size_t i = 0; i < packets && i < corruptedPackets.size() / XBOW_PACKET_SIZE; i++)
+	{
+		XbowSample sample;
+
+		if (!ParseXbowPacket(&corruptedPackets[i * XBOW_PACKET_SIZE], &sample))
+			failed++;
+		else if (memcmp(&cleanPackets[i * XBOW_PACKET_SIZE], &corruptedPackets[i * XBOW_PACKET_SIZE], XBOW_PACKET_SIZE) != 0)
+			unseen++;
+	}
+	printf("%llu of %llu Xbow packets corrupted, %llu failing their checksum\n",
+		(unsigned long long)stated, (unsigned long long)packets, (unsigned long long)failed);
+	CHECK_EQUAL(stated, failed + unseen);
+	CHECK(unseen * 100 <= stated);
+	CHECK(IsBinomial(failed, packets, rate));
+
+	// Cut out of the serial stream, the same packets are lost. The bytes
+	// of a corrupted packet never frame a false one here
+	//
+	std::vector<BYTE> stream(corruptedPackets.size());
+	std::vector<BYTE> framed(TEST_BATCH * XBOW_PACKET_SIZE);
+	XbowFramer framer;
+	DWORD length, consumed, count, offset = 0;
+	UINT64 matched = 0, next = 0;
+
+	{
+		TrafficGenerator generator(config);
+		length = generator.GenerateXbowStream(TEST_UNTIL, &stream[0], (DWORD)stream.size());
+	}
+	CHECK_EQUAL((DWORD)stream.size(), length);
+	while (offset < length)
+	{
+		count = framer.Push(&stream[offset], (length - offset < 4096) ? length - offset : 4096, &framed[0], TEST_BATCH, &consumed);
+		offset += consumed;
+		for (DWORD i = 0; i < count; i++)
+		{
+			while (next < packets && memcmp(&framed[i * XBOW_PACKET_SIZE], &corruptedPackets[next * XBOW_PACKET_SIZE], XBOW_PACKET_SIZE) != 0)
+				next++;
+			if (next < packets)
+			{
+				matched++;
+				next++;
+			}
+		}
+	}
+	CHECK_EQUAL(framer.GetStats().Packets, matched);
+	CHECK_EQUAL(packets - failed, matched);
+}
+
+// Indexes of the epochs or packets received in order, from the time
+// fields. Returns the missing ones in runs
+//
+static void CountRuns(const std::vector<UINT64> &Indexes, UINT64 Expected, DWORD Length, UINT64 *Missing, UINT64 *Runs, int *BadRuns)
+{
+	UINT64 next = 0, run;
+
+	*Missing = 0;
+	*Runs = 0;
+	*BadRuns = 0;
+	for (size_t i = 0; i <= Indexes.size(); i++)
+	{
+		UINT64 index = (i < Indexes.size()) ? Indexes[i] : Expected;
+
+		if (index < next)
+		{
+			(*BadRuns)++;
+			continue;
+		}
+
+		// A dropout loses Length in a row, and a dropout may follow
+		// another at once; only the last one may be cut by the end
+		//
+		run = index - next;
+		if (run > 0)
+		{
+			*Missing += run;
+			*Runs += (run + Length - 1) / Length;
+			if (run % Length != 0 && i < Indexes.size())
+				(*BadRuns)++;
+		}
+		next = index + 1;
+	}
+}
+
+static void TestDropouts()
+{
+	const double rate = 0.02;
+	const DWORD length = 3;
+	TrafficConfig config = GetGPSConfig();
+	std::vector<TPCANMsgFDEntry> entries;
+	std::vector<UINT64> indexes;
+	UINT64 missing, runs, dropped;
+	int badRuns;
+
+	config.DropoutRate = rate;
+	config.DropoutLength = length;
+	{
+		TrafficGenerator generator(config);
+		entries = GenerateCAN(generator);
+		dropped = generator.GetStatistics().Dropped;
+	}
+
+	// Epochs every 50 ms, found back from the UTC time of their 0x301.
+	// Dropouts lose whole epochs
+	//
+	CHECK_EQUAL((size_t)0, entries.size() % VBOX_FRAME_COUNT);
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		VBoxData data;
+
+		CHECK_EQUAL(VBOX_ID_FIRST + (DWORD)(i % VBOX_FRAME_COUNT), entries[i].Msg.ID);
+		if (entries[i].Msg.ID == VBOX_ID_FIRST && DecodeVBoxFrame(entries[i].Msg.ID, entries[i].Msg.DATA, 8, &data))
+			indexes.push_back((data.Time + 2) / 5);
+	}
+	CountRuns(indexes, TEST_SECONDS * 20, length, &missing, &runs, &badRuns);
+	printf("%llu VBOX epochs of %u lost in %llu dropouts\n", (unsigned long long)missing, TEST_SECONDS * 20, (unsigned long long)runs);
+	CHECK_EQUAL(0, badRuns);
+	CHECK_EQUAL(dropped, missing * VBOX_FRAME_COUNT);
+	CHECK(IsBinomial(runs, indexes.size() + runs, rate));
+
+	// Packets every 10 ms, found back from the device timer
+	//
+	std::vector<BYTE> packets;
+	UINT64 base = 0;
+	WORD last = 0;
+
+	config = GetXbowConfig();
+	config.DropoutRate = rate;
+	config.DropoutLength = length;
+	{
+		TrafficGenerator generator(config);
+		packets = GenerateXbow(generator);
+		dropped = generator.GetStatistics().Dropped;
+	}
+	indexes.clear();
+	for (size_t i = 0; i < packets.size() / XBOW_PACKET_SIZE; i++)
+	{
+		XbowSample sample;
+
+		CHECK(ParseXbowPacket(&packets[i * XBOW_PACKET_SIZE], &sample));
+		if (sample.Time < last)
+			base += 0x10000;
+		last = sample.Time;
+		indexes.push_back((base + sample.Time + 5) / 10);
+	}
+	CountRuns(indexes, TEST_SECONDS * 100, length, &missing, &runs, &badRuns);
+	printf("%llu Xbow packets of %u lost in %llu dropouts\n", (unsigned long long)missing, TEST_SECONDS * 100, (unsigned long long)runs);
+	CHECK_EQUAL(0, badRuns);
+	CHECK_EQUAL(dropped, missing);
+	CHECK(IsBinomial(runs, indexes.size() + runs, rate));
+}
+
+int main()
+{
+	TestVBoxValues();
+	TestXbowValues();
+	TestCorruption();
+	TestDropouts();
+
+	return TestResult("TrafficGeneratorTest");
+}
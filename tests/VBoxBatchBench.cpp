@@ -0,0 +1,68 @@
+//  VBoxBatchBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of the VBOX batch decoder on 30 minutes of 100 Hz GPS
+//  frames, on each path supported, against DecodeVBoxFrame called frame
+//  by frame
+//
+//  ~~~~~~~~~~~~
+//
+#include "VBoxBatch.h"
+
+#include <chrono>
+#include <random>
+
+#define BENCH_FRAMES	(30 * 60 * 100 * VBOX_FRAME_COUNT)
+#define BENCH_RUNS		10
+
+static const char *PathNames[] = { "scalar", "SSSE3", "AVX2" };
+
+int main()
+{
+	std::mt19937 random(1);
+	std::vector<BYTE> data(BENCH_FRAMES * VBOX_FRAME_LENGTH);
+	std::chrono::steady_clock::time_point start;
+	double elapsed, decoding, check = 0;
+	VBoxData vbox;
+	VBoxBatch batch;
+
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (BYTE)random();
+
+	start = std::chrono::steady_clock::now();
+	for (int run = 0; run < BENCH_RUNS; run++)
+	{
+		for (int i = 0; i < BENCH_FRAMES; i++)
+		{
+			DecodeVBoxFrame(VBOX_ID_FIRST + i % VBOX_FRAME_COUNT, &data[i * VBOX_FRAME_LENGTH], VBOX_FRAME_LENGTH, &vbox);
+			check += vbox.Latitude;
+		}
+	}
+	elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	printf("DecodeVBoxFrame: %.2f ns/frame (raw only)\n", elapsed / BENCH_RUNS / BENCH_FRAMES);
+
+	for (int path = VBOX_BATCH_SCALAR; path <= VBoxBatch::GetSupportedPath(); path++)
+	{
+		batch.SetPath(path);
+		elapsed = decoding = 0;
+		for (int run = 0; run < BENCH_RUNS; run++)
+		{
+			start = std::chrono::steady_clock::now();
+			batch.Clear();
+			for (int i = 0; i < BENCH_FRAMES; i++)
+				batch.Add(VBOX_ID_FIRST + i % VBOX_FRAME_COUNT, &data[i * VBOX_FRAME_LENGTH], VBOX_FRAME_LENGTH, i);
+			elapsed += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+			start = std::chrono::steady_clock::now();
+			batch.Decode();
+			decoding += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			check += batch.GetBlock(VBOX_ID_FIRST).Value[2][0];
+		}
+		printf("VBoxBatch %s: Add %.2f ns/frame, Decode %.2f ns/frame (raw and scaled)\n", PathNames[path],
+			elapsed / BENCH_RUNS / BENCH_FRAMES, decoding / BENCH_RUNS / BENCH_FRAMES);
+	}
+
+	printf("(%g)\n", check);
+	return 0;
+}
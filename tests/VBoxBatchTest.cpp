@@ -0,0 +1,84 @@
+//  VBoxBatchTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the VBOX batch decoder: every path supported by the
+//  processor gives, for every field of every frame, the raw value of
+//  ExtractSignal and the scaled value of DecodeSignal. The block sizes
+//  go through the tails of the 4 and 8 frame vector loops
+//
+//  ~~~~~~~~~~~~
+//
+#include "VBoxBatch.h"
+#include "TestCheck.h"
+
+#include <random>
+
+static const char *PathNames[] = { "scalar", "SSSE3", "AVX2" };
+
+static void TestPath(int Path, size_t Frames, std::mt19937 &Random)
+{
+	const std::vector<SignalDescriptor> &signals = GetVBoxSignals();
+	std::vector<BYTE> data(Frames * VBOX_FRAME_LENGTH);
+	std::vector<DWORD> ids(Frames);
+	size_t rows[VBOX_FRAME_COUNT] = {};
+	VBoxBatch batch;
+	INT64 raw;
+	double value;
+	int mismatches = 0;
+
+	batch.SetPath(Path);
+	CHECK_EQUAL(Path, batch.GetPath());
+
+	// Random payloads, with the extreme values of the fields among them
+	//
+	for (size_t i = 0; i < Frames; i++)
+	{
+		ids[i] = VBOX_ID_FIRST + Random() % VBOX_FRAME_COUNT;
+		for (int j = 0; j < VBOX_FRAME_LENGTH; j++)
+			data[i * VBOX_FRAME_LENGTH + j] = (i % 7 == 0) ? 0xFF : (i % 11 == 0) ? 0x80 : (BYTE)Random();
+		CHECK(batch.Add(ids[i], &data[i * VBOX_FRAME_LENGTH], VBOX_FRAME_LENGTH, i));
+	}
+	batch.Decode();
+
+	for (size_t i = 0; i < Frames; i++)
+	{
+		const VBoxBlock &block = batch.GetBlock(ids[i]);
+		size_t row = rows[ids[i] - VBOX_ID_FIRST]++;
+		int first = (ids[i] - VBOX_ID_FIRST) * VBOX_BLOCK_FIELDS;
+
+		CHECK_EQUAL(i, block.Index[row]);
+		for (int j = 0; j < VBOX_BLOCK_FIELDS; j++)
+		{
+			ExtractSignal(signals[first + j], &data[i * VBOX_FRAME_LENGTH], VBOX_FRAME_LENGTH, &raw);
+			DecodeSignal(signals[first + j], &data[i * VBOX_FRAME_LENGTH], VBOX_FRAME_LENGTH, &value);
+			if (block.Raw[j][row] != (INT32)raw || block.Value[j][row] != value)
+				mismatches++;
+		}
+	}
+	if (mismatches != 0)
+		printf("%s path, %u frames: %d fields differ\n", PathNames[Path], (unsigned)Frames, mismatches);
+	CHECK_EQUAL(0, mismatches);
+}
+
+int main()
+{
+	std::mt19937 random(20);
+	VBoxBatch batch;
+
+	// Frames which are not complete VBOX frames are refused
+	//
+	BYTE data[VBOX_FRAME_LENGTH] = {};
+	CHECK(!batch.Add(0x300, data, VBOX_FRAME_LENGTH, 0));
+	CHECK(!batch.Add(0x301, data, VBOX_FRAME_LENGTH - 1, 0));
+
+	for (int path = VBOX_BATCH_SCALAR; path <= VBoxBatch::GetSupportedPath(); path++)
+	{
+		for (size_t frames = 0; frames < 120; frames++)
+			TestPath(path, frames, random);
+		TestPath(path, 100000, random);
+		printf("%s path checked\n", PathNames[path]);
+	}
+
+	return TestResult("VBoxBatchTest");
+}
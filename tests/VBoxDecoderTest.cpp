@@ -0,0 +1,255 @@
+﻿//  VBoxDecoderTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Differential test of the VBOX decoding against the text parse it
+//  replaced: every field of every frame, taken from DecodeVBoxFrame and
+//  from the VBoxBatch columns of every path, is the value the dialog
+//  used to display and record from the hex text of the frame. The speed
+//  sent over the network, read before from bytes 0-1 of the 0x302 frame
+//  (the high half of the longitude), is now its Speed field
+//
+//  ~~~~~~~~~~~~
+//
+#include "VBoxBatch.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <bitset>
+#include <random>
+#include <sstream>
+#include <string>
+
+// Fields of a frame, in the order of GetVBoxSignals, as int the way the
+// dialog wrote them, then the network speed
+//
+#define FIELD_COUNT		(VBOX_BLOCK_FIELDS + 1)
+
+static const char *FieldNames[VBOX_FRAME_COUNT][FIELD_COUNT] =
+{
+	{ "Sats", "Time", "Latitude", "" },
+	{ "Longitude", "Speed", "Heading", "NetworkSpeed" },
+	{ "Altitude", "VerticalSpeed", "Status", "" },
+	{ "TrigDistance", "LongAcc", "LatAcc", "" },
+	{ "Distance", "TrigTime", "TrigSpeed", "" },
+};
+
+// The baseline: HexTextToUnsigned of the dialog
+//
+static unsigned HexTextToUnsigned(const std::string &ToConvert)
+{
+	unsigned int x;
+	std::stringstream ss;
+	ss << std::hex << ToConvert;
+	ss >> x;
+
+	return x;
+}
+
+// The baseline: the frame rendered as in the GPS data column, the spaces
+// removed, then cut with CString::Mid as in DisplayGPSInformation and
+// GetGPSXbowInformation
+//
+static void ParseText(DWORD ID, const BYTE *Data, int Fields[FIELD_COUNT])
+{
+	const unsigned UNIT = 2;
+	char szByte[4];
+	std::string GPS;
+	std::string Altitude_WGS;
+	std::bitset<8> bitw(0);
+	int temp;
+
+	for (int i = 0; i < VBOX_FRAME_LENGTH; i++)
+	{
+		snprintf(szByte, sizeof(szByte), "%02X ", Data[i]);
+		GPS += szByte;
+	}
+	GPS.erase(std::remove(GPS.begin(), GPS.end(), ' '), GPS.end());
+
+	Fields[FIELD_COUNT - 1] = 0;
+	switch (ID)
+	{
+	case 0x301:
+		Fields[0] = HexTextToUnsigned(GPS.substr(0, UNIT));
+		Fields[1] = HexTextToUnsigned(GPS.substr(UNIT, 3 * UNIT));
+		Fields[2] = (int)HexTextToUnsigned(GPS.substr(4 * UNIT, 4 * UNIT));
+		break;
+	case 0x302:
+		Fields[0] = (int)HexTextToUnsigned(GPS.substr(0, 4 * UNIT));
+		Fields[1] = HexTextToUnsigned(GPS.substr(4 * UNIT, 2 * UNIT));
+		Fields[2] = HexTextToUnsigned(GPS.substr(6 * UNIT, 2 * UNIT));
+		Fields[3] = HexTextToUnsigned(GPS.substr(4 * UNIT, 2 * UNIT));
+		break;
+	case 0x303:
+		Altitude_WGS = GPS.substr(0, 3 * UNIT);
+		temp = HexTextToUnsigned(Altitude_WGS);
+		if (Altitude_WGS[0] >= '8')
+			temp -= (0xFFFFFF + 0x1);
+		Fields[0] = temp;
+		Fields[1] = (short signed)HexTextToUnsigned(GPS.substr(3 * UNIT, 2 * UNIT));
+		bitw = HexTextToUnsigned(GPS.substr(7 * UNIT, UNIT));
+		Fields[2] = (int)bitw.to_ulong();
+		break;
+	case 0x304:
+		Fields[0] = HexTextToUnsigned(GPS.substr(0, 4 * UNIT));
+		Fields[1] = (short signed)HexTextToUnsigned(GPS.substr(4 * UNIT, 2 * UNIT));
+		Fields[2] = (short signed)HexTextToUnsigned(GPS.substr(6 * UNIT, 2 * UNIT));
+		break;
+	case 0x305:
+		Fields[0] = HexTextToUnsigned(GPS.substr(0, 4 * UNIT));
+		Fields[1] = HexTextToUnsigned(GPS.substr(4 * UNIT, 2 * UNIT));
+		Fields[2] = HexTextToUnsigned(GPS.substr(6 * UNIT, 2 * UNIT));
+		break;
+	}
+}
+
+// The fields of DecodeVBoxFrame, in the same order
+//
+static void DecodeFields(DWORD ID, const BYTE *Data, int Fields[FIELD_COUNT])
+{
+	VBoxData vbox = {};
+
+	CHECK(DecodeVBoxFrame(ID, Data, VBOX_FRAME_LENGTH, &vbox));
+	CHECK_EQUAL(1u << (ID - VBOX_ID_FIRST), vbox.Received);
+
+	Fields[FIELD_COUNT - 1] = 0;
+	switch (ID)
+	{
+	case 0x301:
+		Fields[0] = vbox.Sats;
+		Fields[1] = vbox.Time;
+		Fields[2] = vbox.Latitude;
+		break;
+	case 0x302:
+		Fields[0] = vbox.Longitude;
+		Fields[1] = vbox.Speed;
+		Fields[2] = vbox.Heading;
+		Fields[3] = GetVBoxNetworkSpeed(vbox);
+		break;
+	case 0x303:
+		Fields[0] = vbox.Altitude;
+		Fields[1] = vbox.VerticalSpeed;
+		Fields[2] = vbox.Status;
+		break;
+	case 0x304:
+		Fields[0] = (int)vbox.TrigDistance;
+		Fields[1] = vbox.LongAcc;
+		Fields[2] = vbox.LatAcc;
+		break;
+	case 0x305:
+		Fields[0] = (int)vbox.Distance;
+		Fields[1] = vbox.TrigTime;
+		Fields[2] = vbox.TrigSpeed;
+		break;
+	}
+}
+
+// Counts of the fields differing, per ID and field
+//
+typedef struct tagMismatches
+{
+	size_t Frames;
+	size_t Count[VBOX_FRAME_COUNT][FIELD_COUNT];
+} Mismatches;
+
+static void Compare(DWORD ID, const int Baseline[FIELD_COUNT], const int Fields[FIELD_COUNT], int Count, Mismatches *Result)
+{
+	for (int j = 0; j < Count; j++)
+		if (Baseline[j] != Fields[j])
+			Result->Count[ID - VBOX_ID_FIRST][j]++;
+}
+
+static void Report(const char *Name, const Mismatches &Result)
+{
+	size_t total = 0;
+
+	for (int i = 0; i < VBOX_FRAME_COUNT; i++)
+	{
+		for (int j = 0; j < FIELD_COUNT; j++)
+		{
+			if (Result.Count[i][j] != 0)
+				printf("%s: 0x%X %s differs in %u frames\n", Name, VBOX_ID_FIRST + i, FieldNames[i][j], (unsigned)Result.Count[i][j]);
+			total += Result.Count[i][j];
+		}
+	}
+	printf("%s: %u frames, %u fields differ\n", Name, (unsigned)Result.Frames, (unsigned)total);
+	CHECK_EQUAL(0u, total);
+}
+
+// Frames of every ID: every combination of the edge bytes 00, 7F, 80
+// and FF, then random bytes
+//
+static void MakeFrames(std::vector<DWORD> &IDs, std::vector<BYTE> &Data)
+{
+	static const BYTE edges[] = { 0x00, 0x7F, 0x80, 0xFF };
+	std::mt19937 random(17);
+	BYTE frame[VBOX_FRAME_LENGTH];
+
+	for (DWORD id = VBOX_ID_FIRST; id <= VBOX_ID_LAST; id++)
+	{
+		for (unsigned combination = 0; combination < (1u << (2 * VBOX_FRAME_LENGTH)); combination++)
+		{
+			for (int j = 0; j < VBOX_FRAME_LENGTH; j++)
+				frame[j] = edges[(combination >> (2 * j)) & 3];
+			IDs.push_back(id);
+			Data.insert(Data.end(), frame, frame + VBOX_FRAME_LENGTH);
+		}
+		for (int i = 0; i < 20000; i++)
+		{
+			for (int j = 0; j < VBOX_FRAME_LENGTH; j++)
+				frame[j] = (BYTE)random();
+			IDs.push_back(id);
+			Data.insert(Data.end(), frame, frame + VBOX_FRAME_LENGTH);
+		}
+	}
+}
+
+int main()
+{
+	static const char *PathNames[] = { "scalar", "SSSE3", "AVX2" };
+	std::vector<DWORD> ids;
+	std::vector<BYTE> data;
+	std::vector<int> baseline;
+	int fields[FIELD_COUNT] = {};
+	Mismatches decoded = {};
+
+	MakeFrames(ids, data);
+	baseline.resize(ids.size() * FIELD_COUNT);
+
+	for (size_t i = 0; i < ids.size(); i++)
+	{
+		ParseText(ids[i], &data[i * VBOX_FRAME_LENGTH], &baseline[i * FIELD_COUNT]);
+		DecodeFields(ids[i], &data[i * VBOX_FRAME_LENGTH], fields);
+		Compare(ids[i], &baseline[i * FIELD_COUNT], fields, FIELD_COUNT, &decoded);
+		decoded.Frames++;
+	}
+	Report("DecodeVBoxFrame", decoded);
+
+	// The GPS.txt rows are written from the raw columns of the batch
+	//
+	for (int path = VBOX_BATCH_SCALAR; path <= VBoxBatch::GetSupportedPath(); path++)
+	{
+		VBoxBatch batch;
+		size_t rows[VBOX_FRAME_COUNT] = {};
+		Mismatches columns = {};
+
+		batch.SetPath(path);
+		for (size_t i = 0; i < ids.size(); i++)
+			batch.Add(ids[i], &data[i * VBOX_FRAME_LENGTH], VBOX_FRAME_LENGTH, i);
+		batch.Decode();
+
+		for (size_t i = 0; i < ids.size(); i++)
+		{
+			const VBoxBlock &block = batch.GetBlock(ids[i]);
+			size_t row = rows[ids[i] - VBOX_ID_FIRST]++;
+
+			for (int j = 0; j < VBOX_BLOCK_FIELDS; j++)
+				fields[j] = block.Raw[j][row];
+			Compare(ids[i], &baseline[i * FIELD_COUNT], fields, VBOX_BLOCK_FIELDS, &columns);
+			columns.Frames++;
+		}
+		Report(PathNames[path], columns);
+	}
+
+	return TestResult("VBoxDecoderTest");
+}
@@ -0,0 +1,185 @@
+//  VBoxDistanceTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the VBOX distance accumulator: wraps and resets of the
+//  counter, a trial resumed from a stored state, and 10-hour drives
+//  checked against the distance summed in integers
+//
+//  ~~~~~~~~~~~~
+//
+#include "VBoxDistance.h"
+#include "TestCheck.h"
+
+#include <random>
+
+static void TestFirstReading()
+{
+	VBoxDistanceAccumulator distance;
+
+	// The trial starts at the first counter, whatever its value
+	//
+	distance.Update(123456);
+	CHECK_EQUAL(0u, distance.GetCounts());
+	distance.Update(123456);
+	CHECK_EQUAL(0u, distance.GetCounts());
+	distance.Update(125000);
+	CHECK_EQUAL(1544u, distance.GetCounts());
+
+	distance.Reset();
+	CHECK_EQUAL(0u, distance.GetState().Readings);
+	distance.Update(7);
+	distance.Update(10);
+	CHECK_EQUAL(3u, distance.GetCounts());
+	CHECK_EQUAL((DWORD)VBOX_DISTANCE_MAX_STEP, distance.GetState().MaxStep);
+}
+
+static void TestWrap()
+{
+	VBoxDistanceAccumulator distance;
+
+	distance.Update(0xFFFFFF00);
+	distance.Update(0x00000100);
+	CHECK_EQUAL(0x200u, distance.GetCounts());
+	CHECK_EQUAL(1u, distance.GetState().Wraps);
+	CHECK_EQUAL(0u, distance.GetState().Resets);
+
+	// Through the wrap by exactly the longest step
+	//
+	distance.Reset();
+	distance.Update(0xFFFFFFFF - VBOX_DISTANCE_MAX_STEP + 1);
+	distance.Update(0);
+	CHECK_EQUAL((UINT64)VBOX_DISTANCE_MAX_STEP, distance.GetCounts());
+	CHECK_EQUAL(1u, distance.GetState().Wraps);
+}
+
+static void TestReset()
+{
+	VBoxDistanceAccumulator distance;
+
+	// Back from 5001000 to 300: the VBOX started again from zero
+	//
+	distance.Update(5000000);
+	distance.Update(5001000);
+	distance.Update(300);
+	CHECK_EQUAL(1300u, distance.GetCounts());
+	CHECK_EQUAL(1u, distance.GetState().Resets);
+	CHECK_EQUAL(0u, distance.GetState().Wraps);
+
+	// One count further through the wrap than the longest step
+	//
+	distance.Reset();
+	distance.Update(0xFFFFFFFF - VBOX_DISTANCE_MAX_STEP);
+	distance.Update(0);
+	CHECK_EQUAL(0u, distance.GetCounts());
+	CHECK_EQUAL(1u, distance.GetState().Resets);
+
+	// A smaller longest step makes the same readings a reset
+	//
+	VBoxDistanceAccumulator strict(0x100);
+	strict.Update(0xFFFFFF00);
+	strict.Update(0x00000100);
+	CHECK_EQUAL(0x100u, strict.GetCounts());
+	CHECK_EQUAL(1u, strict.GetState().Resets);
+}
+
+// Drives for 10 hours at 100 Hz, 0 to 60 m/s, dropping frames, and
+// compares the distance to the steps summed in 64-bit integers
+//
+static void TestLongDrive(unsigned Seed, int Resets)
+{
+	const UINT64 readings = 10ULL * 3600 * 100;
+	std::mt19937 random(Seed);
+	std::uniform_real_distribution<double> uniform(0, 1);
+	VBoxDistanceAccumulator distance;
+	DWORD counter = 0xF0000000, step;
+	UINT64 expected = 0, wraps = 0;
+	double speed = 20;
+	bool started = false;
+
+	for (UINT64 i = 0; i < readings; i++)
+	{
+		speed += (uniform(random) - 0.5) * 0.2;
+		speed = speed < 0 ? 0 : (speed > 60 ? 60 : speed);
+		step = (DWORD)(speed * VBOX_DISTANCE_COUNTS_PER_METER / 100 + 0.5);
+
+		if (Resets > 0 && i % (readings / (Resets + 1)) == 0 && i != 0)
+			counter = 0;
+		else
+		{
+			if (counter > 0xFFFFFFFF - step)
+				wraps++;
+			counter += step;
+			if (started)
+				expected += step;
+		}
+
+		// A dropped frame is only seen in the next reading
+		//
+		if (uniform(random) < 0.001)
+			continue;
+		distance.Update(counter);
+		started = true;
+	}
+
+	CHECK_EQUAL(expected, distance.GetCounts());
+	CHECK_EQUAL((UINT64)Resets, distance.GetState().Resets);
+	CHECK_EQUAL(wraps, distance.GetState().Wraps);
+	CHECK(distance.GetMeters() == (double)expected / VBOX_DISTANCE_COUNTS_PER_METER);
+	printf("10-hour drive: %.4f m, %llu wraps, %llu resets\n", distance.GetMeters(),
+		(unsigned long long)distance.GetState().Wraps, (unsigned long long)distance.GetState().Resets);
+}
+
+// Stops a trial halfway, stores its state as text and resumes it in
+// another accumulator: the distance is the one of the whole trial
+//
+static void TestResume()
+{
+	std::mt19937 random(1);
+	VBoxDistanceAccumulator whole, first, second;
+	VBoxDistanceState state;
+	std::string text;
+	DWORD counter = 0xFFF00000;
+
+	for (int i = 0; i < 200000; i++)
+	{
+		counter += random() % 3000;
+		whole.Update(counter);
+		if (i < 100000)
+			first.Update(counter);
+		else
+			second.Update(counter);
+
+		if (i == 99999)
+		{
+			text = FormatVBoxDistanceState(first.GetState());
+			memset(&state, 0, sizeof(state));
+			CHECK(ParseVBoxDistanceState(text.c_str(), &state));
+			second.SetState(state);
+		}
+	}
+
+	CHECK_EQUAL(whole.GetCounts(), second.GetCounts());
+	CHECK_EQUAL(whole.GetState().Wraps, second.GetState().Wraps);
+	CHECK_EQUAL(whole.GetState().Readings, second.GetState().Readings);
+	CHECK(memcmp(&whole.GetState(), &second.GetState(), sizeof(VBoxDistanceState)) == 0);
+
+	// A text which is not a state is refused
+	//
+	memset(&state, 0, sizeof(state));
+	CHECK(!ParseVBoxDistanceState("Counts\n1\t2\n", &state));
+	CHECK(!ParseVBoxDistanceState("", &state));
+	CHECK_EQUAL(0u, state.Counts);
+}
+
+int main()
+{
+	TestFirstReading();
+	TestWrap();
+	TestReset();
+	TestLongDrive(42, 0);
+	TestLongDrive(43, 2);
+	TestResume();
+
+	return TestResult("VBoxDistanceTest");
+}
@@ -0,0 +1,240 @@
+//  VBoxEpochTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the VBOX epoch assembler: complete cycles, frames lost at
+//  either end of a cycle, a 0x301 sent again, the timeout, and a minute
+//  of 100 Hz traffic with lost frames whose fixes are checked against
+//  the cycles sent
+//
+//  ~~~~~~~~~~~~
+//
+#include "VBoxEpoch.h"
+#include "TestCheck.h"
+
+#include <random>
+#include <vector>
+
+// Frame of a test stream. The row is the number of the cycle, so a fix
+// mixing two cycles is seen
+//
+typedef struct tagTestFrame
+{
+	DWORD ID;
+	size_t Cycle;
+	INT64 Time;
+} TestFrame;
+
+static std::vector<VBoxFix> Assemble(VBoxEpochAssembler &Assembler, const std::vector<TestFrame> &Frames)
+{
+	std::vector<VBoxFix> fixes;
+	VBoxFix fix;
+
+	for (size_t i = 0; i < Frames.size(); i++)
+	{
+		// The GPS time of a cycle is its number, in 1/100 s
+		//
+		if (Assembler.Add(Frames[i].ID, Frames[i].Cycle, Frames[i].Time, (DWORD)Frames[i].Cycle, &fix))
+			fixes.push_back(fix);
+	}
+	if (Assembler.Flush(&fix))
+		fixes.push_back(fix);
+
+	return fixes;
+}
+
+// Frames of a cycle at 100 Hz, except the IDs in Lost
+//
+static void AddCycle(std::vector<TestFrame> &Frames, size_t Cycle, DWORD Lost = 0)
+{
+	TestFrame frame;
+
+	for (DWORD id = VBOX_ID_FIRST; id <= VBOX_ID_LAST; id++)
+	{
+		if (Lost & (1 << (id - VBOX_ID_FIRST)))
+			continue;
+		frame.ID = id;
+		frame.Cycle = Cycle;
+		frame.Time = (INT64)Cycle * 10;
+		Frames.push_back(frame);
+	}
+}
+
+// Every frame of a fix comes from one cycle, the one of its GPS time
+//
+static bool IsOneCycle(const VBoxFix &Fix)
+{
+	size_t cycle = 0;
+	bool first = true;
+
+	for (DWORD id = VBOX_ID_FIRST; id <= VBOX_ID_LAST; id++)
+	{
+		if (!HasVBoxFrame(Fix, id))
+			continue;
+		if (!first && Fix.Row[id - VBOX_ID_FIRST] != cycle)
+			return false;
+		cycle = Fix.Row[id - VBOX_ID_FIRST];
+		first = false;
+	}
+
+	return !HasVBoxFrame(Fix, VBOX_ID_FIRST) || Fix.GPSTime == cycle;
+}
+
+static void TestCompleteCycles()
+{
+	VBoxEpochAssembler assembler;
+	std::vector<TestFrame> frames;
+	std::vector<VBoxFix> fixes;
+
+	for (size_t cycle = 1; cycle <= 3; cycle++)
+		AddCycle(frames, cycle);
+	frames.push_back(TestFrame());      // Not a VBOX frame, ignored
+
+	fixes = Assemble(assembler, frames);
+	CHECK_EQUAL(3u, fixes.size());
+	for (size_t i = 0; i < fixes.size(); i++)
+	{
+		CHECK_EQUAL((DWORD)VBOX_EPOCH_COMPLETE, fixes[i].Received);
+		CHECK_EQUAL((DWORD)(i + 1), fixes[i].GPSTime);
+		CHECK_EQUAL((INT64)(i + 1) * 10, fixes[i].FirstTime);
+		CHECK(IsOneCycle(fixes[i]));
+	}
+	CHECK_EQUAL(15u, assembler.GetStats().Frames);
+	CHECK_EQUAL(3u, assembler.GetStats().Complete);
+	CHECK_EQUAL(0u, assembler.GetStats().Incomplete);
+}
+
+static void TestLostFrames()
+{
+	VBoxEpochAssembler assembler;
+	std::vector<TestFrame> frames;
+	std::vector<VBoxFix> fixes;
+
+	// The frames are sent close enough for the timeout not to separate
+	// them: only the IDs and the GPS times do
+	//
+	assembler.SetTimeout(1000);
+	AddCycle(frames, 1);
+	AddCycle(frames, 2, 1 << 0);                 // 0x301 lost
+	AddCycle(frames, 3, 1 << 4);                 // 0x305 lost
+	AddCycle(frames, 4, (1 << 0) | (1 << 1));    // 0x301 and 0x302 lost
+	AddCycle(frames, 5, (1 << 3) | (1 << 4));    // 0x304 and 0x305 lost
+	AddCycle(frames, 6, 1 << 0);
+	AddCycle(frames, 7);
+
+	fixes = Assemble(assembler, frames);
+	CHECK_EQUAL(7u, fixes.size());
+	for (size_t i = 0; i < fixes.size(); i++)
+		CHECK(IsOneCycle(fixes[i]));
+	if (fixes.size() == 7)
+	{
+		CHECK_EQUAL((DWORD)VBOX_EPOCH_COMPLETE, fixes[0].Received);
+		CHECK_EQUAL((DWORD)0x1E, fixes[1].Received);
+		CHECK_EQUAL((DWORD)0x0F, fixes[2].Received);
+		CHECK_EQUAL((DWORD)0x1C, fixes[3].Received);
+		CHECK_EQUAL((DWORD)0x07, fixes[4].Received);
+		CHECK_EQUAL((DWORD)0x1E, fixes[5].Received);
+		CHECK_EQUAL((DWORD)VBOX_EPOCH_COMPLETE, fixes[6].Received);
+	}
+	CHECK_EQUAL(2u, assembler.GetStats().Complete);
+	CHECK_EQUAL(5u, assembler.GetStats().Incomplete);
+	CHECK_EQUAL(0u, assembler.GetStats().TimedOut);
+}
+
+static void TestRepeatedTime()
+{
+	VBoxEpochAssembler assembler;
+	std::vector<TestFrame> frames;
+	std::vector<VBoxFix> fixes;
+
+	// A 0x301 sent again after its complete fix, then within an epoch
+	//
+	AddCycle(frames, 1);
+	frames.push_back(frames[0]);
+	AddCycle(frames, 2, 1 << 4);
+	frames.push_back(frames[6]);
+	AddCycle(frames, 3);
+
+	fixes = Assemble(assembler, frames);
+	CHECK_EQUAL(3u, fixes.size());
+	for (size_t i = 0; i < fixes.size(); i++)
+	{
+		CHECK(IsOneCycle(fixes[i]));
+		CHECK_EQUAL((DWORD)(i + 1), fixes[i].GPSTime);
+	}
+	CHECK_EQUAL(2u, assembler.GetStats().Repeated);
+	CHECK_EQUAL(1u, assembler.GetStats().Incomplete);
+}
+
+static void TestTimeout()
+{
+	VBoxEpochAssembler assembler;
+	VBoxFix fix;
+
+	CHECK_EQUAL((INT64)VBOX_EPOCH_TIMEOUT, assembler.GetTimeout());
+	CHECK(!assembler.Add(0x301, 0, 100, 1, &fix));
+	CHECK(!assembler.Add(0x302, 0, 100 + VBOX_EPOCH_TIMEOUT, 0, &fix));
+
+	// Past the timeout, the 0x303 starts the next epoch
+	//
+	CHECK(assembler.Add(0x303, 1, 101 + VBOX_EPOCH_TIMEOUT, 0, &fix));
+	CHECK_EQUAL(0x03u, fix.Received);
+	CHECK_EQUAL(100, fix.FirstTime);
+	CHECK_EQUAL((INT64)100 + VBOX_EPOCH_TIMEOUT, fix.LastTime);
+	CHECK_EQUAL(1u, assembler.GetStats().TimedOut);
+
+	CHECK(assembler.Flush(&fix));
+	CHECK_EQUAL(0x04u, fix.Received);
+	CHECK(!assembler.Flush(&fix));
+	CHECK_EQUAL(2u, assembler.GetStats().Incomplete);
+
+	assembler.Reset();
+	CHECK_EQUAL(0u, assembler.GetStats().Frames);
+}
+
+// A minute of 100 Hz cycles losing 1% of the frames: one fix per cycle
+// with a frame received, each from that cycle only
+//
+static void TestLossyMinute()
+{
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> uniform(0, 1);
+	VBoxEpochAssembler assembler;
+	std::vector<TestFrame> frames;
+	std::vector<VBoxFix> fixes;
+	size_t sent = 0, incomplete = 0, mixed = 0;
+	DWORD lost;
+
+	for (size_t cycle = 1; cycle <= 6000; cycle++)
+	{
+		lost = 0;
+		for (int i = 0; i < VBOX_FRAME_COUNT; i++)
+			if (uniform(random) < 0.01)
+				lost |= 1 << i;
+		if (lost == VBOX_EPOCH_COMPLETE)
+			continue;
+		AddCycle(frames, cycle, lost);
+		sent++;
+		incomplete += (lost != 0);
+	}
+
+	fixes = Assemble(assembler, frames);
+	for (size_t i = 0; i < fixes.size(); i++)
+		mixed += !IsOneCycle(fixes[i]);
+	CHECK_EQUAL(sent, fixes.size());
+	CHECK_EQUAL(0u, mixed);
+	CHECK_EQUAL((UINT64)incomplete, assembler.GetStats().Incomplete);
+	CHECK_EQUAL((UINT64)frames.size(), assembler.GetStats().Frames);
+	printf("lossy minute: %u fixes, %u incomplete\n", (unsigned)fixes.size(), (unsigned)incomplete);
+}
+
+int main()
+{
+	TestCompleteCycles();
+	TestLostFrames();
+	TestRepeatedTime();
+	TestTimeout();
+	TestLossyMinute();
+
+	return TestResult("VBoxEpochTest");
+}
@@ -0,0 +1,125 @@
+//  WaitLatencyBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of the receive loop of the reader thread on a paced
+//  GeneratorSource: sleeping 1 ms between reads, waiting for messages
+//  with a 1 ms timeout as CANReadThreadFunc did, and blocking until
+//  messages are due or CancelWait is called. It reports the wake-up
+//  latency percentiles under traffic, and the wake-ups and CPU time of
+//  the thread with and without traffic
+//
+//  ~~~~~~~~~~~~
+//
+#include "GeneratorSource.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <time.h>
+
+#define BENCH_SECONDS		3
+
+enum WaitMode { WAIT_SLEEP, WAIT_POLL, WAIT_BLOCK };
+
+static const char *ModeNames[] = { "sleep 1 ms", "wait 1 ms", "blocking" };
+
+typedef struct tagWaitResult
+{
+	std::vector<double> Latencies;   // Due time to read time, in microseconds
+	UINT64 Wakeups;
+	double CPUSeconds;
+} WaitResult;
+
+static double GetThreadCPUTime()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void RunMode(WaitMode Mode, const TrafficConfig &Config, WaitResult *Result)
+{
+	TimestampService clock;
+	GeneratorSource source(&clock, Config, true);
+	std::atomic<bool> stop(false);
+	UINT64 start;
+
+	Result->Wakeups = 0;
+	Result->Latencies.clear();
+
+	start = clock.Now();
+	source.Initialize();
+	std::thread reader([&]()
+	{
+		TPCANMsgFDEntry entries[256];
+		DWORD count;
+		double cpu = GetThreadCPUTime();
+
+		while (!stop)
+		{
+			switch (Mode)
+			{
+			case WAIT_SLEEP:
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				break;
+			case WAIT_POLL:
+				source.WaitForMessages(1);
+				break;
+			case WAIT_BLOCK:
+				source.WaitForMessages(CAN_WAIT_INFINITE);
+				break;
+			}
+			Result->Wakeups++;
+
+			source.ReadBatch(entries, 256, &count);
+			for (DWORD i = 0; i < count; i++)
+				Result->Latencies.push_back((double)(clock.Now() - (start + entries[i].Timestamp * 1000)) / 1000);
+		}
+		Result->CPUSeconds = GetThreadCPUTime() - cpu;
+	});
+
+	std::this_thread::sleep_for(std::chrono::seconds(BENCH_SECONDS));
+	stop = true;
+	source.CancelWait();
+	reader.join();
+	source.Uninitialize();
+}
+
+static double Percentile(const std::vector<double> &Sorted, double Fraction)
+{
+	return Sorted.empty() ? 0 : Sorted[std::min(Sorted.size() - 1, (size_t)(Fraction * Sorted.size()))];
+}
+
+int main()
+{
+	TrafficConfig traffic = TrafficGenerator::GetDefaultConfig();
+	TrafficConfig idle = TrafficGenerator::GetDefaultConfig();
+	WaitResult result;
+
+	// 500 VBOX and 200 other frames per second, or nothing at all
+	//
+	traffic.GPSRate = 100;
+	traffic.XbowRate = 0;
+	traffic.BackgroundRate = 200;
+	traffic.BackgroundIDs = 20;
+	idle.GPSRate = 0;
+	idle.XbowRate = 0;
+
+	for (int mode = WAIT_SLEEP; mode <= WAIT_BLOCK; mode++)
+	{
+		RunMode((WaitMode)mode, traffic, &result);
+		std::sort(result.Latencies.begin(), result.Latencies.end());
+		printf("%-10s traffic: %u frames, latency p50 %.0f us, p99 %.0f us, p99.9 %.0f us, max %.0f us, %.0f wake-ups/s, CPU %.2f%%\n",
+			ModeNames[mode], (unsigned)result.Latencies.size(), Percentile(result.Latencies, 0.5), Percentile(result.Latencies, 0.99),
+			Percentile(result.Latencies, 0.999), result.Latencies.empty() ? 0 : result.Latencies.back(),
+			(double)result.Wakeups / BENCH_SECONDS, 100 * result.CPUSeconds / BENCH_SECONDS);
+
+		RunMode((WaitMode)mode, idle, &result);
+		printf("%-10s idle:    %.0f wake-ups/s, CPU %.3f%%\n", ModeNames[mode],
+			(double)result.Wakeups / BENCH_SECONDS, 100 * result.CPUSeconds / BENCH_SECONDS);
+	}
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+//  XbowFramerBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of the Xbow framer: throughput of a clean stream and of a
+//  stream with garbage and bad packets, pushed in chunks of 1 byte to
+//  4 kilobytes, the reads of the serial port
+//
+//  ~~~~~~~~~~~~
+//
+#include "XbowParser.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <vector>
+
+#define BENCH_PACKETS		500000
+#define BENCH_BUFFER		64
+
+static void MakeStream(std::mt19937 &Random, int BadPercent, std::vector<BYTE> *Stream)
+{
+	BYTE packet[XBOW_PACKET_SIZE];
+
+	for (int i = 0; i < BENCH_PACKETS; i++)
+	{
+		packet[0] = XBOW_HEADER;
+		for (int j = 1; j < XBOW_CHECKSUM; j++)
+			packet[j] = (BYTE)Random();
+		packet[XBOW_CHECKSUM] = GetXbowChecksum(packet);
+		if ((int)(Random() % 100) < BadPercent)
+		{
+			if (Random() % 2)
+				packet[XBOW_CHECKSUM] = (BYTE)((packet[XBOW_CHECKSUM] + 1) % 255);
+			else
+				for (int j = Random() % 16; j >= 0; j--)
+					Stream->push_back((BYTE)Random());
+		}
+		Stream->insert(Stream->end(), packet, packet + XBOW_PACKET_SIZE);
+	}
+}
+
+int main()
+{
+	static const DWORD chunks[] = { 1, 16, 256, 4096 };
+	static const int bad[] = { 0, 5 };
+	std::mt19937 random(22);
+	std::vector<BYTE> packets(BENCH_BUFFER * XBOW_PACKET_SIZE);
+	std::chrono::steady_clock::time_point start;
+
+	for (size_t b = 0; b < sizeof(bad) / sizeof(bad[0]); b++)
+	{
+		std::vector<BYTE> stream;
+
+		MakeStream(random, bad[b], &stream);
+		for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+		{
+			XbowFramer framer;
+			DWORD chunk, done, consumed;
+			UINT64 checksums = 0;
+			double seconds;
+
+			start = std::chrono::steady_clock::now();
+			for (size_t pos = 0; pos < stream.size(); pos += chunk)
+			{
+				chunk = (stream.size() - pos < chunks[c]) ? (DWORD)(stream.size() - pos) : chunks[c];
+				for (done = 0; done < chunk; done += consumed)
+				{
+					DWORD count = framer.Push(&stream[pos + done], chunk - done, &packets[0], BENCH_BUFFER, &consumed);
+
+					for (DWORD i = 0; i < count; i++)
+						checksums += packets[i * XBOW_PACKET_SIZE + XBOW_CHECKSUM];
+				}
+			}
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			printf("%d%% bad, chunks of %4lu bytes: %7.1f MB/s, %6.1f ns/packet, %llu packets, %llu bad bytes, %llu resyncs (%llu)\n",
+				bad[b], (unsigned long)chunks[c], stream.size() / seconds / 1e6, seconds * 1e9 / framer.GetStats().Packets,
+				(unsigned long long)framer.GetStats().Packets, (unsigned long long)framer.GetStats().BadBytes,
+				(unsigned long long)framer.GetStats().Resyncs, (unsigned long long)checksums);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,277 @@
+//  XbowFramerTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the Xbow framer on corrupted streams pushed in chunks of
+//  random sizes, one byte to a few kilobytes, into packet buffers of
+//  random sizes: garbage between the packets, packets with a wrong
+//  checksum, cut packets and single bytes lost or added. The packets and
+//  counts are checked against the ones expected by construction, and
+//  against a reference framing the whole stream in one pass
+//
+//  ~~~~~~~~~~~~
+//
+#include "XbowParser.h"
+#include "TestCheck.h"
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+#define TEST_EVENTS		50000
+
+// Counts expected of a stream built by construction
+//
+typedef struct tagExpectedStream
+{
+	std::vector<BYTE> Stream;
+	std::vector<BYTE> Packets;
+	XbowFramerStats Stats;
+} ExpectedStream;
+
+static BYTE RandomByte(std::mt19937 &Random, bool NoHeader)
+{
+	BYTE value = (BYTE)Random();
+
+	return (NoHeader && value == XBOW_HEADER) ? 0x00 : value;
+}
+
+static void AppendPacket(std::mt19937 &Random, bool NoHeader, std::vector<BYTE> *Stream, bool Valid)
+{
+	BYTE packet[XBOW_PACKET_SIZE];
+
+	packet[0] = XBOW_HEADER;
+	for (int i = 1; i < XBOW_CHECKSUM; i++)
+		packet[i] = RandomByte(Random, NoHeader);
+	packet[XBOW_CHECKSUM] = GetXbowChecksum(packet);
+	if (!Valid)
+		packet[XBOW_CHECKSUM] = (BYTE)((packet[XBOW_CHECKSUM] + 1) % 255);
+	Stream->insert(Stream->end(), packet, packet + XBOW_PACKET_SIZE);
+}
+
+// Frames the whole stream in one pass: a packet is taken at a header
+// byte if it is valid, any other byte is dropped
+//
+static void ReferenceFrame(const std::vector<BYTE> &Stream, std::vector<BYTE> *Packets, XbowFramerStats *Stats)
+{
+	size_t pos = 0;
+	bool synchronized = false;
+
+	memset(Stats, 0, sizeof(*Stats));
+	Packets->clear();
+	while (pos < Stream.size())
+	{
+		if (Stream[pos] == XBOW_HEADER && Stream.size() - pos < XBOW_PACKET_SIZE)
+			break;
+
+		if (Stream[pos] == XBOW_HEADER && IsXbowPacketValid(&Stream[pos]))
+		{
+			Packets->insert(Packets->end(), &Stream[pos], &Stream[pos] + XBOW_PACKET_SIZE);
+			Stats->Packets++;
+			synchronized = true;
+			pos += XBOW_PACKET_SIZE;
+		}
+		else
+		{
+			Stats->BadBytes++;
+			if (synchronized)
+				Stats->Resyncs++;
+			synchronized = false;
+			pos++;
+		}
+	}
+}
+
+// Pushes a stream in random chunks into random packet buffers
+//
+static void FrameInChunks(std::mt19937 &Random, const std::vector<BYTE> &Stream, XbowFramer *Framer, std::vector<BYTE> *Packets)
+{
+	BYTE buffer[16 * XBOW_PACKET_SIZE];
+	size_t pos = 0;
+	DWORD chunk, done, consumed, count;
+
+	Packets->clear();
+	while (pos < Stream.size())
+	{
+		switch (Random() % 4)
+		{
+			case 0: chunk = 1; break;
+			case 1: chunk = 1 + Random() % XBOW_PACKET_SIZE; break;
+			case 2: chunk = 1 + Random() % 300; break;
+			default: chunk = 1 + Random() % 4096; break;
+		}
+		if (chunk > Stream.size() - pos)
+			chunk = (DWORD)(Stream.size() - pos);
+
+		for (done = 0; done < chunk; done += consumed)
+		{
+			count = Framer->Push(&Stream[pos + done], chunk - done, buffer, 1 + Random() % 16, &consumed);
+			Packets->insert(Packets->end(), buffer, buffer + count * XBOW_PACKET_SIZE);
+		}
+		pos += chunk;
+	}
+}
+
+// Builds a stream whose packets and counts are known: no byte but the
+// headers is 0xFF, so the framer always finds the next real packet. Bad
+// events between two packets count one resync
+//
+static void MakeKnownStream(std::mt19937 &Random, bool SingleBytes, ExpectedStream *Expected)
+{
+	bool synchronized = false, bad;
+	int length;
+
+	memset(&Expected->Stats, 0, sizeof(Expected->Stats));
+	for (int i = 0; i < TEST_EVENTS; i++)
+	{
+		bad = true;
+		switch (SingleBytes ? (Random() % 2) * 3 : Random() % 4)
+		{
+			case 0:
+			case 1:
+				AppendPacket(Random, true, &Expected->Stream, true);
+				Expected->Packets.insert(Expected->Packets.end(), Expected->Stream.end() - XBOW_PACKET_SIZE, Expected->Stream.end());
+				Expected->Stats.Packets++;
+				synchronized = true;
+				bad = false;
+				break;
+			case 2:
+				AppendPacket(Random, true, &Expected->Stream, false);
+				Expected->Stats.BadBytes += XBOW_PACKET_SIZE;
+				break;
+			default:
+				length = SingleBytes ? 1 : 1 + Random() % 40;
+				for (int j = 0; j < length; j++)
+					Expected->Stream.push_back(RandomByte(Random, true));
+				Expected->Stats.BadBytes += length;
+				break;
+		}
+		if (bad && synchronized)
+		{
+			Expected->Stats.Resyncs++;
+			synchronized = false;
+		}
+	}
+}
+
+static void CheckStats(const XbowFramerStats &Expected, const XbowFramerStats &Actual)
+{
+	CHECK_EQUAL(Expected.Packets, Actual.Packets);
+	CHECK_EQUAL(Expected.BadBytes, Actual.BadBytes);
+	CHECK_EQUAL(Expected.Resyncs, Actual.Resyncs);
+}
+
+static void TestKnownStreams()
+{
+	std::mt19937 random(22);
+	std::vector<BYTE> packets, reference;
+	XbowFramerStats stats;
+
+	for (int singleBytes = 0; singleBytes < 2; singleBytes++)
+	{
+		ExpectedStream expected;
+		XbowFramer framer;
+
+		MakeKnownStream(random, singleBytes != 0, &expected);
+		FrameInChunks(random, expected.Stream, &framer, &packets);
+		CHECK(packets == expected.Packets);
+		CheckStats(expected.Stats, framer.GetStats());
+
+		ReferenceFrame(expected.Stream, &reference, &stats);
+		CHECK(reference == expected.Packets);
+		CheckStats(expected.Stats, stats);
+	}
+}
+
+// Any byte may be 0xFF, packets are cut and a header in the data may
+// start a false packet: the framer must find what the one-pass
+// reference finds
+//
+static void TestHostileStream()
+{
+	std::mt19937 random(2022);
+	std::vector<BYTE> stream, packets, reference;
+	XbowFramerStats stats;
+	XbowFramer framer;
+	UINT64 sent = 0;
+
+	for (int i = 0; i < TEST_EVENTS; i++)
+		switch (random() % 6)
+		{
+			case 0:
+			case 1:
+			case 2:
+				AppendPacket(random, false, &stream, true);
+				sent++;
+				break;
+			case 3:
+				AppendPacket(random, false, &stream, false);
+				break;
+			case 4:
+				AppendPacket(random, false, &stream, true);
+				stream.resize(stream.size() - 1 - random() % (XBOW_PACKET_SIZE - 1));
+				break;
+			default:
+				for (int j = random() % 8; j >= 0; j--)
+					stream.push_back((random() % 4 == 0) ? XBOW_HEADER : (BYTE)random());
+				break;
+		}
+
+	FrameInChunks(random, stream, &framer, &packets);
+	ReferenceFrame(stream, &reference, &stats);
+	CHECK(packets == reference);
+	CheckStats(stats, framer.GetStats());
+	for (size_t i = 0; i < packets.size(); i += XBOW_PACKET_SIZE)
+		CHECK(IsXbowPacketValid(&packets[i]));
+
+	// Few real packets are lost to the false ones
+	//
+	CHECK(framer.GetStats().Packets > sent * 95 / 100);
+	CHECK(framer.GetStats().Resyncs > 0);
+}
+
+static void TestResynchronize()
+{
+	std::mt19937 random(7);
+	std::vector<BYTE> stream;
+	BYTE buffer[4 * XBOW_PACKET_SIZE];
+	XbowFramer framer;
+	DWORD consumed;
+
+	CHECK(!framer.IsSynchronized());
+	AppendPacket(random, false, &stream, true);
+	AppendPacket(random, false, &stream, true);
+	AppendPacket(random, false, &stream, true);
+
+	CHECK_EQUAL(1u, framer.Push(&stream[0], XBOW_PACKET_SIZE + 10, buffer, 4, &consumed));
+	CHECK_EQUAL((DWORD)XBOW_PACKET_SIZE + 10, consumed);
+	CHECK(framer.IsSynchronized());
+
+	// The start of the second packet is dropped, the third found again
+	//
+	framer.Resynchronize();
+	CHECK(!framer.IsSynchronized());
+	CHECK_EQUAL(10u, framer.GetStats().BadBytes);
+	CHECK_EQUAL(1u, framer.GetStats().Resyncs);
+	CHECK_EQUAL(1u, framer.Push(&stream[XBOW_PACKET_SIZE + 10], 2 * XBOW_PACKET_SIZE - 10, buffer, 4, &consumed));
+	CHECK(memcmp(buffer, &stream[2 * XBOW_PACKET_SIZE], XBOW_PACKET_SIZE) == 0);
+	CHECK_EQUAL(22u, framer.GetStats().BadBytes);
+	CHECK(framer.IsSynchronized());
+
+	// A full packet buffer stops the chunk
+	//
+	framer.Reset();
+	CHECK_EQUAL(1u, framer.Push(&stream[0], (DWORD)stream.size(), buffer, 1, &consumed));
+	CHECK_EQUAL((DWORD)XBOW_PACKET_SIZE, consumed);
+	CHECK_EQUAL(2u, framer.Push(&stream[consumed], (DWORD)stream.size() - consumed, buffer, 4, &consumed));
+	CHECK_EQUAL(0u, framer.GetStats().BadBytes);
+}
+
+int main()
+{
+	TestKnownStreams();
+	TestHostileStream();
+	TestResynchronize();
+
+	return TestResult("XbowFramerTest");
+}
@@ -0,0 +1,74 @@
+//  XbowParserBench.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Benchmark of the Xbow packets read through the text path the dialog
+//  used, and through the parser into a reserved list of samples, on the
+//  same random packets
+//
+//  ~~~~~~~~~~~~
+//
+#include "XbowParser.h"
+#include "XbowTextPacket.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <vector>
+
+#define BENCH_PACKETS		300000
+
+int main()
+{
+	std::mt19937 random(21);
+	std::vector<BYTE> packets(BENCH_PACKETS * XBOW_PACKET_SIZE);
+	std::vector<std::string> texts;
+	std::vector<XbowTextSample> textSamples;
+	std::vector<XbowSample> samples;
+	std::chrono::steady_clock::time_point start;
+	XbowSample sample;
+	double text, parser;
+	int mismatches = 0;
+
+	for (int i = 0; i < BENCH_PACKETS; i++)
+	{
+		BYTE *packet = &packets[i * XBOW_PACKET_SIZE];
+
+		packet[0] = XBOW_HEADER;
+		for (int j = 1; j < XBOW_CHECKSUM; j++)
+			packet[j] = (BYTE)random();
+		packet[XBOW_CHECKSUM] = GetXbowChecksum(packet);
+	}
+
+	// The text was stored, then parsed for the display
+	//
+	texts.reserve(BENCH_PACKETS);
+	textSamples.reserve(BENCH_PACKETS);
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < BENCH_PACKETS; i++)
+		if (IsXbowPacketValid(&packets[i * XBOW_PACKET_SIZE]))
+		{
+			texts.push_back(FormatXbowText(&packets[i * XBOW_PACKET_SIZE]));
+			textSamples.push_back(ParseXbowText(texts.back()));
+		}
+	text = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_PACKETS;
+
+	samples.reserve(BENCH_PACKETS);
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < BENCH_PACKETS; i++)
+		if (ParseXbowPacket(&packets[i * XBOW_PACKET_SIZE], &sample))
+			samples.push_back(sample);
+	parser = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_PACKETS;
+
+	if (samples.size() != textSamples.size())
+		mismatches = BENCH_PACKETS;
+	else
+		for (size_t i = 0; i < samples.size(); i++)
+			if (!IsSameXbowSample(textSamples[i], samples[i]))
+				mismatches++;
+
+	printf("%d packets: text path %.0f ns/packet, parser %.1f ns/packet, %d mismatches\n",
+		BENCH_PACKETS, text, parser, mismatches);
+
+	return mismatches == 0 ? 0 : 1;
+}
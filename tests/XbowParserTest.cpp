@@ -0,0 +1,133 @@
+//  XbowParserTest.cpp
+//
+//  ~~~~~~~~~~~~
+//
+//  Tests of the Xbow packet parser: the checksum, the packets refused
+//  for their header or checksum, the fields against the text path the
+//  dialog used on random and edge packets, the scaled values against the
+//  formulas of the text path, and the packets built from the samples
+//
+//  ~~~~~~~~~~~~
+//
+#include "XbowParser.h"
+#include "XbowTextPacket.h"
+#include "TestCheck.h"
+
+#include <math.h>
+#include <random>
+#include <string.h>
+
+#define TEST_PACKETS	100000
+
+static void MakePacket(std::mt19937 &Random, BYTE *Packet)
+{
+	Packet[0] = XBOW_HEADER;
+	for (int i = 1; i < XBOW_CHECKSUM; i++)
+		Packet[i] = (BYTE)Random();
+	Packet[XBOW_CHECKSUM] = GetXbowChecksum(Packet);
+}
+
+static void TestValidation()
+{
+	BYTE packet[XBOW_PACKET_SIZE];
+	XbowSample sample, before;
+
+	// 20 bytes of 0x01, then of 0xFF: 0x13EC is 236 modulo 256, 236
+	// modulo 255 as well
+	//
+	memset(packet, 0x01, sizeof(packet));
+	CHECK_EQUAL(20, GetXbowChecksum(packet));
+	memset(packet, 0xFF, sizeof(packet));
+	CHECK_EQUAL(236, GetXbowChecksum(packet));
+	memset(packet, 0x00, sizeof(packet));
+	packet[1] = 0xFF;
+	CHECK_EQUAL(0, GetXbowChecksum(packet));
+
+	memset(packet, 0x01, sizeof(packet));
+	packet[0] = XBOW_HEADER;
+	packet[XBOW_CHECKSUM] = 20;
+	CHECK(ParseXbowPacket(packet, &sample));
+	CHECK_EQUAL(0x0101, sample.RollAngle);
+	CHECK_EQUAL(0x0101, sample.Time);
+
+	// A refused packet leaves the sample as it was
+	//
+	memset(&before, 0x5A, sizeof(before));
+	sample = before;
+	packet[0] = 0xFE;
+	CHECK(!ParseXbowPacket(packet, &sample));
+	CHECK(memcmp(&sample, &before, sizeof(sample)) == 0);
+	packet[0] = XBOW_HEADER;
+	for (int value = 0; value < 256; value++)
+	{
+		packet[XBOW_CHECKSUM] = (BYTE)value;
+		CHECK_EQUAL(value == 20, ParseXbowPacket(packet, &sample));
+	}
+	CHECK(memcmp(&sample, &before, sizeof(sample)) != 0);
+	sample = before;
+	packet[XBOW_CHECKSUM] = 20;
+	packet[XBOW_TIME] = 0x02;
+	CHECK(!ParseXbowPacket(packet, &sample));
+	CHECK(memcmp(&sample, &before, sizeof(sample)) == 0);
+}
+
+static void TestFields()
+{
+	std::mt19937 random(21);
+	BYTE packet[XBOW_PACKET_SIZE], packed[XBOW_PACKET_SIZE];
+	XbowSample sample;
+	int mismatches = 0;
+
+	CHECK_EQUAL((size_t)20, sizeof(XbowSample));
+
+	for (int i = 0; i < TEST_PACKETS; i++)
+	{
+		MakePacket(random, packet);
+
+		// Edge values of every field in the first packets
+		//
+		if (i < 4)
+		{
+			static const BYTE edges[4][2] = { { 0x80, 0x00 }, { 0x7F, 0xFF }, { 0xFF, 0xFF }, { 0x00, 0x00 } };
+
+			for (int j = XBOW_ROLL_ANGLE; j < XBOW_CHECKSUM; j += 2)
+			{
+				packet[j] = edges[i][0];
+				packet[j + 1] = edges[i][1];
+			}
+			packet[XBOW_CHECKSUM] = GetXbowChecksum(packet);
+		}
+
+		if (!ParseXbowPacket(packet, &sample) || !IsSameXbowSample(ParseXbowText(FormatXbowText(packet)), sample))
+		{
+			mismatches++;
+			continue;
+		}
+
+		PackXbowSample(sample, packed);
+		if (memcmp(packet, packed, sizeof(packet)) != 0)
+			mismatches++;
+
+		// Scales of the text path. The accelerations use the 6 g range
+		// of the display
+		//
+		if (GetXbowAngle(sample.RollAngle) != (double)sample.RollAngle * (180.0f) / pow(2, 15)
+			|| GetXbowRate(sample.YawRate) != (double)sample.YawRate * 200.0f * 1.5f / pow(2, 15)
+			|| GetXbowAcc(sample.AccZ) != (double)sample.AccZ * 4.0f * 1.5f / pow(2, 15)
+			|| fabs(GetXbowTemperature(sample.Temperature) - (((double)sample.Temperature * 5.0f / 4096.0f) - 1.375f) * 44.44f) > 1e-3)
+			mismatches++;
+	}
+	CHECK_EQUAL(0, mismatches);
+
+	CHECK_EQUAL(-180.0, GetXbowAngle(-32768));
+	CHECK_EQUAL(-300.0, GetXbowRate(-32768));
+	CHECK_EQUAL(-6.0, GetXbowAcc(-32768));
+}
+
+int main()
+{
+	TestValidation();
+	TestFields();
+
+	return TestResult("XbowParserTest");
+}
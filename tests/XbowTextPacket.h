@@ -0,0 +1,99 @@
+//  XbowTextPacket.h
+//
+//  ~~~~~~~~~~~~
+//
+//  The text path the dialog used for the Xbow packets before the parser:
+//  the packet formatted as hex text ("FF 01 .. 14") one byte at a time,
+//  the spaces removed, and every field cut out and read back through a
+//  stringstream. Kept as the reference of the parser tests and benchmark
+//
+//  ~~~~~~~~~~~~
+//
+#ifndef __XBOWTEXTPACKETH_
+#define __XBOWTEXTPACKETH_
+
+#include "XbowTypes.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+
+// Digits per byte of the text
+//
+#define XBOW_TEXT_UNIT			2
+
+// Fields read from the text, in the types the dialog used
+//
+typedef struct tagXbowTextSample
+{
+	short RollAngle, PitchAngle, RollRate, PitchRate, YawRate;
+	short AccX, AccY, AccZ;
+	unsigned Temperature, Time;
+} XbowTextSample;
+
+/// <summary>
+/// Formats a packet as the dialog did, with one Format call per byte
+/// </summary>
+inline std::string FormatXbowText(const BYTE *Packet)
+{
+	std::string text;
+	char byte[4];
+
+	snprintf(byte, sizeof(byte), "%02X ", Packet[0]);
+	text = byte;
+	for (int i = 1; i < XBOW_CHECKSUM; i++)
+	{
+		snprintf(byte, sizeof(byte), "%02X ", Packet[i]);
+		text += byte;
+	}
+	snprintf(byte, sizeof(byte), "%02X", Packet[XBOW_CHECKSUM]);
+	text += byte;
+
+	return text;
+}
+
+inline unsigned XbowHexTextToUnsigned(const std::string &Text)
+{
+	unsigned int x;
+	std::stringstream ss;
+
+	ss << std::hex << Text;
+	ss >> x;
+
+	return x;
+}
+
+/// <summary>
+/// Reads the fields of the text of a packet
+/// </summary>
+inline XbowTextSample ParseXbowText(std::string Text)
+{
+	XbowTextSample sample;
+
+	Text.erase(std::remove(Text.begin(), Text.end(), ' '), Text.end());
+	sample.RollAngle = (short)XbowHexTextToUnsigned(Text.substr(XBOW_ROLL_ANGLE * XBOW_TEXT_UNIT, 2 * XBOW_TEXT_UNIT));
+	sample.PitchAngle = (short)XbowHexTextToUnsigned(Text.substr(XBOW_PITCH_ANGLE * XBOW_TEXT_UNIT, 2 * XBOW_TEXT_UNIT));
+	sample.RollRate = (short)XbowHexTextToUnsigned(Text.substr(XBOW_ROLL_RATE * XBOW_TEXT_UNIT, 2 * XBOW_TEXT_UNIT));
+	sample.PitchRate = (short)XbowHexTextToUnsigned(Text.substr(XBOW_PITCH_RATE * XBOW_TEXT_UNIT, 2 * XBOW_TEXT_UNIT));
+	sample.YawRate = (short)XbowHexTextToUnsigned(Text.substr(XBOW_YAW_RATE * XBOW_TEXT_UNIT, 2 * XBOW_TEXT_UNIT));
+	sample.AccX = (short)XbowHexTextToUnsigned(Text.substr(XBOW_ACC_X * XBOW_TEXT_UNIT, 2 * XBOW_TEXT_UNIT));
+	sample.AccY = (short)XbowHexTextToUnsigned(Text.substr(XBOW_ACC_Y * XBOW_TEXT_UNIT, 2 * XBOW_TEXT_UNIT));
+	sample.AccZ = (short)XbowHexTextToUnsigned(Text.substr(XBOW_ACC_Z * XBOW_TEXT_UNIT, 2 * XBOW_TEXT_UNIT));
+	sample.Temperature = XbowHexTextToUnsigned(Text.substr(XBOW_TEMPERATURE * XBOW_TEXT_UNIT, 2 * XBOW_TEXT_UNIT));
+	sample.Time = XbowHexTextToUnsigned(Text.substr(XBOW_TIME * XBOW_TEXT_UNIT, 2 * XBOW_TEXT_UNIT));
+
+	return sample;
+}
+
+/// <summary>
+/// Tells if the fields of the parser are those of the text
+/// </summary>
+inline bool IsSameXbowSample(const XbowTextSample &Text, const XbowSample &Sample)
+{
+	return Text.RollAngle == Sample.RollAngle && Text.PitchAngle == Sample.PitchAngle
+		&& Text.RollRate == Sample.RollRate && Text.PitchRate == Sample.PitchRate && Text.YawRate == Sample.YawRate
+		&& Text.AccX == Sample.AccX && Text.AccY == Sample.AccY && Text.AccZ == Sample.AccZ
+		&& Text.Temperature == Sample.Temperature && Text.Time == Sample.Time;
+}
+#endif